@@ -335,6 +335,15 @@
 #define PIDEG 0.017453292519943295769236907684886
 #define DEGPI 57.295779513082320876798155633941
 
+//the SIMD code paths are enabled by the compiler target, the scalar code is used otherwise
+#if defined(__SSE2__) || defined(_M_X64) || (defined(_M_IX86_FP) && _M_IX86_FP >= 2)
+#   define wxGIS_USE_SSE2
+#endif
+
+#if defined(__AVX2__)
+#   define wxGIS_USE_AVX2
+#endif
+
 /*
    MSVC up to 6.0 needs to be explicitly told to export template instantiations
    used by the DLL clients, use this macro to do it like this:
@@ -25,6 +25,78 @@
 #include "wxgis/datasource/vectorop.h"
 #include "wxgis/carto/featurerenderer.h"
 
+#include <wx/msgqueue.h>
+
+#include <map>
+
+/** \def LOD_MAX_LEVELS featurelayer.h
+    \brief The maximum count of the scale bands stored in the geometry level of detail cache.
+*/
+#define LOD_MAX_LEVELS 6
+
+/** \def LOD_MAX_POINTS featurelayer.h
+    \brief The default maximum count of the vertices stored in the geometry level of detail cache (renderer/vector/lod_cache_points config key).
+*/
+#define LOD_MAX_POINTS 4000000
+
+/** @class wxGISGeometryLODCache
+
+    The cache of simplified geometries per scale band. The band is the power of two not greater than display pixel size in map units, the geometries simplified with this tolerance differ from the original less than one pixel. The simplified geometries are built on the first request.
+    The stored geometries are never shared: GetGeometry returns the clone, so the eviction and the callers do not change the same reference counter from different threads.
+
+    @library{carto}
+*/
+
+class WXDLLIMPEXP_GIS_CRT wxGISGeometryLODCache
+{
+public:
+    wxGISGeometryLODCache(void);
+    virtual ~wxGISGeometryLODCache(void);
+    static int GetLevel(double dfPixelSize);
+    virtual wxGISGeometry GetGeometry(const wxGISSpatialTreeData* pData, int nLevel);
+    virtual void Remove(long nFID);
+    virtual void Clear(void);
+    virtual void SetMaxPointCount(long nMaxPointCount);
+protected:
+    //the empty geometry marks the feature drawn by original geometry at this band
+    typedef std::map<long, wxGISGeometry> LODLEVEL;
+
+    virtual void RemoveLevel(std::map<int, LODLEVEL>::iterator it);
+protected:
+    std::map<int, LODLEVEL> m_mLevels;
+    long m_nPointCount, m_nMaxPointCount;
+    wxCriticalSection m_CritSect;
+};
+
+/** \struct FEATURELAYERBATCH featurelayer.h
+    \brief The batch of the dataset features to copy, project and add to the layer spatial tree. The geometries are read by the ingest thread.
+*/
+typedef struct _featurelayerbatch
+{
+    wxVector<long> anFIDs;
+    long nSequence; //the FIDs queued again by later batch are skipped
+} FEATURELAYERBATCH;
+
+class WXDLLIMPEXP_GIS_CRT wxGISFeatureLayer;
+
+/** @class wxGISFeatureLayerIngestThread
+
+    The thread adding the batches of dataset features to the reprojected layer spatial tree. The batches are received from the layer queue. The thread exits on NULL batch.
+
+    @library{carto}
+*/
+
+class wxGISFeatureLayerIngestThread : public wxThread
+{
+public:
+    wxGISFeatureLayerIngestThread(wxGISFeatureLayer* pLayer, wxMessageQueue<FEATURELAYERBATCH*> &Queue);
+    virtual ~wxGISFeatureLayerIngestThread();
+    virtual void *Entry();
+protected:
+    wxGISFeatureLayer* m_pLayer;
+    wxMessageQueue<FEATURELAYERBATCH*> &m_Queue;
+};
+
 /** @class wxGISFeatureLayer
     
     The class represent vector datasource in map.
@@ -36,6 +108,10 @@ class WXDLLIMPEXP_GIS_CRT wxGISFeatureLayer :
 	public wxGISLayer
 {
     DECLARE_CLASS(wxGISFeatureLayer)
+    enum
+    {
+        INGESTED_EVENT = wxID_HIGHEST + 1
+    };
 public:
 	wxGISFeatureLayer(const wxString &sName = _("new feature layer"), wxGISDataset* pwxGISDataset = NULL);
 	virtual ~wxGISFeatureLayer(void);
@@ -52,20 +128,49 @@ public:
     virtual wxGISSpatialTreeCursor SearchGeometry(const OGREnvelope &Env = OGREnvelope());
     virtual OGRwkbGeometryType GetGeometryType(void) const;
     virtual wxGISFeature GetFeatureByID (long nFID);
+    /** \fn wxGISGeometry GetDrawGeometry(const wxGISSpatialTreeData* pData, int nLODLevel)
+        \brief Get the geometry simplified for the scale band (see wxGISGeometryLODCache::GetLevel) or original geometry if the level of detail is switched off
+    */
+    virtual wxGISGeometry GetDrawGeometry(const wxGISSpatialTreeData* pData, int nLODLevel);
     //events
     void OnDSClosed(wxFeatureDSEvent& event);
     void OnDSFeaturesAdded(wxFeatureDSEvent& event);
     void OnDSFeatureAdded(wxFeatureDSEvent& event);
     void OnDSFeatureDeleted(wxFeatureDSEvent& event);
     void OnDSFeatureChanged(wxFeatureDSEvent& event);
+    void OnIngested(wxThreadEvent& event);
+    /** \fn void IngestBatch(FEATURELAYERBATCH* const pBatch)
+        \brief Copy and project the batch geometries and add the ones still queued by this batch to the layer spatial tree. Called from the ingest threads.
+    */
+    virtual void IngestBatch(FEATURELAYERBATCH* const pBatch);
 protected:
     //virtual void LoadGeometry(void);
 	virtual long GetPointsInGeometry(const wxGISGeometry& Geom) const;
+    virtual void StartIngestThreads(void);
+    virtual void StopIngestThreads(void);
+    /** \fn void QueueIngest(const wxVector<long> &anFIDs)
+        \brief Post the features which are not queued or added yet to the ingest threads (or ingest them here if no thread is running)
+    */
+    virtual void QueueIngest(const wxVector<long> &anFIDs);
+    /** \fn void DropIngestedFID(long nFID)
+        \brief Forget the queued and not drawn yet feature on delete or change. Called under the ingest lock.
+    */
+    virtual void DropIngestedFID(long nFID);
 protected:
     wxGISFeatureDataset* m_pwxGISFeatureDataset;
     wxGISFeatureRenderer* m_pFeatureRenderer;
     long m_nConnectionPointDSCookie;
 	wxGISSpatialTree* m_pSpatialTree;
+    wxGISGeometryLODCache m_oLODCache;
+    bool m_bUseLOD;
+    wxMessageQueue<FEATURELAYERBATCH*> m_IngestQueue;
+    wxVector<wxGISFeatureLayerIngestThread*> m_paIngestThreads;
+    wxCriticalSection m_IngestCritSect;
+    bool m_bIngestStopped;
+    std::map<long, long> m_mnQueuedFIDs; //FID to the batch sequence, posted to the ingest threads and not added to tree yet, the deleted and changed features are erased
+    long m_nIngestSequence;
+    wxGISSpatialTreeCursor m_IngestedCursor; //added to tree by the ingest threads and not drawn yet
+    OGREnvelope m_IngestedEnvelope; //the extent of the ingested geometries not merged to the layer extent yet
 private:
 	DECLARE_EVENT_TABLE()
 };
@@ -23,8 +23,50 @@
 #include "wxgis/carto/renderer.h"
 #include "wxgis/display/symbol.h"
 
+#include <limits.h>
+
 class wxGISFeatureLayer;
 
+/** \def LOD_LEVEL_NONE featurerenderer.h
+    \brief The level of detail value to draw the original geometries.
+*/
+#define LOD_LEVEL_NONE INT_MIN
+
+/** \def FEATURE_DRAW_BATCH_SIZE featurerenderer.h
+    \brief The count of features drawn under one display lock. The progress and cancel are checked between batches.
+*/
+#define FEATURE_DRAW_BATCH_SIZE 256
+
+/** \def FEATURE_PARALLEL_DRAW_MIN featurerenderer.h
+    \brief The minimum count of features to draw them by several threads.
+*/
+#define FEATURE_PARALLEL_DRAW_MIN 20000
+
+/** \def FEATURE_PARALLEL_DRAW_MEMORY featurerenderer.h
+    \brief The default memory limit in Mb for the offscreen displays and the geometries copies of the draw threads (renderer/vector/parallel_draw_memory config key). Each thread display has the screen size ARGB32 surface. If the geometries do not fit the rest of limit the features are drawn in one thread.
+*/
+#define FEATURE_PARALLEL_DRAW_MEMORY 256
+
+/** \class wxFeatureDrawThread featurerenderer.h
+    \brief The vector layer draw thread. Draw the geometries to own offscreen display.
+
+    The geometries are the copies owned by the thread, so no reference counter is shared with the layer spatial tree or other threads.
+*/
+
+class wxFeatureDrawThread : public wxThread
+{
+public:
+	wxFeatureDrawThread(wxGISSymbol* const pSymbol, wxGISDisplay* const pDisplay, ITrackCancel * const pTrackCancel = NULL);
+    virtual void *Entry();
+    virtual void OnExit();
+    virtual void AddGeometry(const wxGISGeometry &Geom);
+private:
+    wxVector<wxGISGeometry> m_aGeometries;
+    wxGISSymbol* m_pSymbol;
+    wxGISDisplay* m_pDisplay;
+    ITrackCancel* const m_pTrackCancel;
+};
+
 /** @class wxGISSimpleRenderer
   * 
   * The vector layer renderer
@@ -46,10 +88,15 @@ public:
 	virtual void Draw(const wxGISSpatialTreeCursor& Cursor, wxGISEnumDrawPhase DrawPhase, wxGISDisplay *pDisplay, ITrackCancel *pTrackCancel = NULL);
     virtual bool Apply(ITrackCancel* const pTrackCancel = NULL);
     virtual void FeatureChanged(const wxGISFeature &Feature);
+protected:
+    virtual bool DrawParallel(const wxGISSpatialTreeCursor& Cursor, int nLODLevel, wxGISDisplay *pDisplay, ITrackCancel *pTrackCancel = NULL);
+    virtual int GetLODLevel(wxGISDisplay *pDisplay) const;
 protected:
     wxGISFeatureLayer* m_pwxGISFeatureLayer;
 	wxGISSymbol* m_pSymbol;
     wxCriticalSection m_CritSect;
+    bool m_bParallelDraw;
+    int m_nParallelDrawMemory;
 };
 
 
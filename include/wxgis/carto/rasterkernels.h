@@ -0,0 +1,65 @@
+/******************************************************************************
+ * Project:  wxGIS
+ * Purpose:  Type-specialized raster resampling kernels.
+ * Author:   Dmitry Baryshnikov (aka Bishop), polimax@mail.ru
+ ******************************************************************************
+*   Copyright (C) 2014 Dmitry Baryshnikov
+*
+*    This program is free software: you can redistribute it and/or modify
+*    it under the terms of the GNU General Public License as published by
+*    the Free Software Foundation, either version 2 of the License, or
+*    (at your option) any later version.
+*
+*    This program is distributed in the hope that it will be useful,
+*    but WITHOUT ANY WARRANTY; without even the implied warranty of
+*    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+*    GNU General Public License for more details.
+*
+*    You should have received a copy of the GNU General Public License
+*    along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ ****************************************************************************/
+#pragma once
+
+#include "wxgis/carto/rasterrenderer.h"
+
+/** \def RASTER_KERNEL_SCRATCH_BANDS rasterkernels.h
+    \brief The count of byte rows in the scratch buffer passed to wxGISRasterRenderer::FillRow
+*/
+#define RASTER_KERNEL_SCRATCH_BANDS 6
+
+/** \fn bool ResampleRasterRows(const RAWPIXELDATA &, GDALDataType, int, wxGISEnumDrawQuality, unsigned char *, int, int, int, int, wxGISRasterRenderer* const, ITrackCancel* const)
+    \brief Resample output rows [nBegY, nEndY) to ARGB32 using the kernels specialized for source data type and band count.
+
+    The source samples are gathered to float rows (one per band) and passed to wxGISRasterRenderer::FillRow, which stretch and pack the whole row.
+    For nearest neighbour on Byte, UInt16 and Int16 data the raw samples are passed to wxGISRasterRenderer::FillRowLUT if the renderer has lookup tables for them.
+    Only Byte, UInt16, Int16 and Float32 data with 1, 3 or 4 bands and grey scale or RGBA renderers are supported.
+
+    \return false if there is no specialized kernel for the input, the caller should use the reference interpolation functions
+*/
+bool ResampleRasterRows(const RAWPIXELDATA &stPixelData, GDALDataType eSrcType, int nBandCount, wxGISEnumDrawQuality eQuality, unsigned char *pOutputData, int nOutXSize, int nOutYSize, int nBegY, int nEndY, wxGISRasterRenderer* const pRasterRenderer, ITrackCancel* const pTrackCancel = NULL);
+
+/** \fn void StretchRow(const float *, unsigned char *, int, float, float, bool, bool)
+    \brief Linear stretch y = M * (x - DX) of the row to the 0 - 255 range.
+
+    If bClamp is false the values are truncated to byte as the (unsigned char) cast do.
+*/
+void StretchRow(const float *pfInput, unsigned char *pOutput, int nCount, float fM, float fDX, bool bClamp, bool bInvert);
+
+/** \fn void NoDataMaskRow(const float *, unsigned char *, int, double)
+    \brief Set the mask byte to 0xFF for each value equal to the nodata, to 0 otherwise
+
+    The values are compared in double by IsDoubleEquil as wxGISStretch::IsNoData do, so the row and pixel paths mask the same values.
+*/
+void NoDataMaskRow(const float *pfInput, unsigned char *pMask, int nCount, double dfNoData);
+
+/** \fn void PackARGB32Row(const unsigned char *, const unsigned char *, const unsigned char *, const unsigned char *, const unsigned char *, wxUint32, unsigned char *, int)
+    \brief Interleave the byte rows to the cairo ARGB32 pixels.
+
+    If pA is NULL the alpha is 255. If pMask is not NULL the masked pixels are set to nNoDataColor.
+*/
+void PackARGB32Row(const unsigned char *pR, const unsigned char *pG, const unsigned char *pB, const unsigned char *pA, const unsigned char *pMask, wxUint32 nNoDataColor, unsigned char *pOutput, int nCount);
+
+/** \fn void LookupRow(const unsigned char *, const wxUint16 *, unsigned char *, int)
+    \brief Map the sample indexes to the bytes through the lookup table
+*/
+void LookupRow(const unsigned char *pLUT, const wxUint16 *pnInput, unsigned char *pOutput, int nCount);
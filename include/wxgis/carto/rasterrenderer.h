@@ -24,6 +24,8 @@
 
 #include "wxgis/carto/stretch.h"
 
+#include <wx/msgqueue.h>
+
 /** \enum wxGISEnumRendererType rasterrenderer.h
     \brief A renderer color interpretation type
 */
@@ -50,6 +52,16 @@ typedef struct _rawpixeldata
 	OGREnvelope stWorldBounds;
 }RAWPIXELDATA;
 
+/** \typedef _rasterlut rasterrenderer.h
+    \brief The copy of the band stretch lookup tables owned by one resample job
+*/
+
+typedef struct _rasterlut
+{
+	wxVector<unsigned char> aLUT[4];
+	wxVector<unsigned char> aNoDataLUT[4];
+}RASTERLUT;
+
 class wxGISRasterRenderer;
 
 inline double BiCubicKernel(double x)
@@ -80,31 +92,66 @@ static void BicubicInterpolation(void *pInputData, int nInputXSize, int nInputYS
 // static void OnHalfQuadBilinearInterpolation(const unsigned char* pOrigData, unsigned char* pDestData, int nYbeg, int nYend, int nOrigWidth, int nOrigHeight, int nDestWidth, double rWRatio, double rHRatio, double rDeltaX, double rDeltaY, ITrackCancel* pTrackCancel);
 // static void OnFourQuadBilinearInterpolation(const unsigned char* pOrigData, unsigned char* pDestData, int nYbeg, int nYend, int nOrigWidth, int nOrigHeight, int nDestWidth, double rWRatio, double rHRatio, double rDeltaX, double rDeltaY, ITrackCancel* pTrackCancel);
 
+/** \typedef _rasterdrawjob rasterrenderer.h
+    \brief The rows of the output surface to resample by the raster draw pool thread
+*/
+
+typedef struct _rasterdrawjob
+{
+	RAWPIXELDATA *pstPixelData;
+	GDALDataType eSrcType;
+	int nBandCount;
+	unsigned char *pTransformData;
+	wxGISEnumDrawQuality eQuality;
+	int nOutXSize, nOutYSize;
+	int nBegY, nEndY;
+	wxGISRasterRenderer *pRasterRenderer;
+	ITrackCancel *pTrackCancel;
+	wxSemaphore *pDone;
+}RASTERDRAWJOB;
+
 /** \class wxRasterDrawThread rasterrenderer.h
-    \brief The raster layer draw thread
+    \brief The raster layer draw thread. The thread resamples the jobs from the pool queue until NULL job received.
 */
 
 class wxRasterDrawThread : public wxThread
 {
-    friend class wxGISRasterRenderer;
 public:
-	wxRasterDrawThread(RAWPIXELDATA &stPixelData, GDALDataType eSrcType, int nBandCount, unsigned char *pTransformData, wxGISEnumDrawQuality eQuality, int nOutXSize, int nOutYSize, int nBegY, int nEndY, wxGISRasterRenderer *pRasterRenderer, ITrackCancel * const pTrackCancel = NULL);
+	wxRasterDrawThread(wxMessageQueue<RASTERDRAWJOB*> &Queue);
     virtual void *Entry();
     virtual void OnExit();
+    static void DrawRows(const RASTERDRAWJOB &stJob);
 private:
-    ITrackCancel* const m_pTrackCancel;
-	wxGISRasterRenderer *m_pRasterRenderer;
-	RAWPIXELDATA &m_stPixelData;
-	GDALDataType m_eSrcType;
-	unsigned char *m_pTransformData;
-	wxGISEnumDrawQuality m_eQuality;
-	int m_nOutXSize;
-	int m_nOutYSize;
-	int m_nBegY;
-	int m_nEndY;
-	int m_nBandCount;
+	wxMessageQueue<RASTERDRAWJOB*> &m_Queue;
+};
+
+/** \class wxGISRasterDrawPool rasterrenderer.h
+    \brief The persistent pool of raster draw threads.
+
+    The tiled draw renders many small surfaces, so the threads are created once and the surface rows are queued to them.
+*/
+
+class wxGISRasterDrawPool
+{
+public:
+	wxGISRasterDrawPool(int nThreadCount);
+	virtual ~wxGISRasterDrawPool(void);
+    /** \fn void Draw(wxVector<RASTERDRAWJOB> &paJobs)
+     *  \brief Resample the jobs by the pool threads and wait them to finish. If the pool has no threads, the jobs are resampled in calling thread.
+     */
+    virtual void Draw(wxVector<RASTERDRAWJOB> &paJobs);
+    virtual size_t GetThreadCount(void) const {return m_paThreads.size();};
+protected:
+    wxVector<wxRasterDrawThread*> m_paThreads;
+    wxMessageQueue<RASTERDRAWJOB*> m_Queue;
 };
 
+/** \fn wxGISRasterDrawPool* const GetRasterDrawPool(void)
+    \brief Global raster draw pool getter. The pool is created on first call with CPU count threads.
+ */
+
+wxGISRasterDrawPool* const GetRasterDrawPool(void);
+
 /** \class wxGISRasterRenderer rasterrenderer.h
     \brief The base class for renderers
 */
@@ -124,8 +171,35 @@ public:
     virtual wxGISEnumRasterRendererType GetRasterRenderType(void) const {return enumGISRasterRenderTypeNone;};
     virtual wxGISEnumRendererType GetType(void) const {return enumGISRenderTypeRaster;};
 	virtual void FillPixel(unsigned char* pOutputData, const double *pSrcValR, const double *pSrcValG, const double *pSrcValB, const double *pSrcValA) = 0;
+    /** \fn virtual void FillRow(unsigned char*, const float* const*, int, int, unsigned char*)
+        \brief Fill the ARGB32 output row from the resampled band rows.
+
+        Used by the type-specialized resample kernels for grey scale and RGBA render types. The default implementation calls FillPixel for each pixel.
+        \param papfSrcBands The band rows, nBandCount rows nCount values each
+        \param pScratch The buffer of RASTER_KERNEL_SCRATCH_BANDS * nCount bytes to use during fill
+    */
+	virtual void FillRow(unsigned char* pOutputData, const float* const* papfSrcBands, int nBandCount, int nCount, unsigned char* pScratch);
+    /** \fn virtual bool PrepareLUT(GDALDataType, RASTERLUT &)
+        \brief Copy the stretch lookup tables for the source data type.
+
+        The tables are copied under the stretch lock, so the stretch may be changed while the job uses the copy.
+        \return true if FillRowLUT can be used for this data type
+    */
+    virtual bool PrepareLUT(GDALDataType eSrcType, RASTERLUT &stLUT) {return false;};
+    /** \fn virtual void FillRowLUT(unsigned char*, const wxUint16* const*, int, int, const RASTERLUT &, unsigned char*)
+        \brief Fill the ARGB32 output row from the raw 8 or 16 bit band rows using the lookup tables copied by PrepareLUT.
+    */
+	virtual void FillRowLUT(unsigned char* pOutputData, const wxUint16* const* papnSrcBands, int nBandCount, int nCount, const RASTERLUT &stLUT, unsigned char* pScratch) {};
+    virtual bool UseRowKernels(void) const {return m_bUseRowKernels;};
+    /** \fn virtual wxString GetSettingsKey(void) const
+        \brief The string describing all settings which change the rendered pixels. Used in the raster tile cache keys.
+    */
+    virtual wxString GetSettingsKey(void) const;
 protected:
 	virtual bool Draw(RAWPIXELDATA &stPixelData, wxGISEnumDrawPhase DrawPhase, wxGISDisplay* const pDisplay, ITrackCancel * const pTrackCancel = NULL);
+	virtual bool DrawTiles(const OGREnvelope &stDrawBounds, wxGISEnumDrawPhase DrawPhase, wxGISDisplay* const pDisplay, ITrackCancel * const pTrackCancel = NULL);
+	virtual bool GetPixelData(RAWPIXELDATA &stPixelData, const OGREnvelope &stDrawBounds, double dOutWidth, double dOutHeight);
+	virtual cairo_surface_t* RenderPixelData(RAWPIXELDATA &stPixelData, ITrackCancel * const pTrackCancel = NULL);
     virtual short GetBandCount() const = 0;
 protected:
 	wxColour m_oNoDataColor;
@@ -134,6 +208,9 @@ protected:
 	wxGISEnumDrawQuality m_eQuality;
     wxGISColorTable m_mColorTable;
     unsigned short m_nTileSizeX, m_nTileSizeY; 
+    bool m_bUseRowKernels;
+    bool m_bUseTileCache;
+    wxString m_sDatasetKey;
 };
 
 /** \class wxGISRasterRGBARenderer rasterrenderer.h
@@ -151,7 +228,11 @@ public:
 	virtual bool CanRender(wxGISLayer* const pwxGISLayer) const;
 	virtual int *GetBandsCombination(int *pnBandCount);
 	virtual void FillPixel(unsigned char* pOutputData, const double *pSrcValR, const double *pSrcValG, const double *pSrcValB, const double *pSrcValA);
+	virtual void FillRow(unsigned char* pOutputData, const float* const* papfSrcBands, int nBandCount, int nCount, unsigned char* pScratch);
+	virtual bool PrepareLUT(GDALDataType eSrcType, RASTERLUT &stLUT);
+	virtual void FillRowLUT(unsigned char* pOutputData, const wxUint16* const* papnSrcBands, int nBandCount, int nCount, const RASTERLUT &stLUT, unsigned char* pScratch);
     virtual wxGISEnumRasterRendererType GetRasterRenderType(void) const {return enumGISRasterRenderTypeRGBA;};
+    virtual wxString GetSettingsKey(void) const;
 protected:
 	virtual void OnFillStats(void);
     virtual short GetBandCount() const;
@@ -179,6 +260,7 @@ public:
 	virtual int *GetBandsCombination(int *pnBandCount);
 	virtual void FillPixel(unsigned char* pOutputData, const double *pSrcValR, const double *pSrcValG, const double *pSrcValB, const double *pSrcValA);
     virtual wxGISEnumRasterRendererType GetRasterRenderType(void) const {return enumGISRasterRenderTypeIndexed;};
+    virtual wxString GetSettingsKey(void) const;
     //virtual const wxColor *GetColorByIndex(long nIndex);
 protected:
 	virtual void OnFillColorTable(void);
@@ -204,7 +286,11 @@ public:
 	virtual ~wxGISRasterGreyScaleRenderer(void);
 	virtual int *GetBandsCombination(int *pnBandCount);
 	virtual void FillPixel(unsigned char* pOutputData, const double *pSrcValR, const double *pSrcValG, const double *pSrcValB, const double *pSrcValA);
+	virtual void FillRow(unsigned char* pOutputData, const float* const* papfSrcBands, int nBandCount, int nCount, unsigned char* pScratch);
+	virtual bool PrepareLUT(GDALDataType eSrcType, RASTERLUT &stLUT);
+	virtual void FillRowLUT(unsigned char* pOutputData, const wxUint16* const* papnSrcBands, int nBandCount, int nCount, const RASTERLUT &stLUT, unsigned char* pScratch);
     virtual wxGISEnumRasterRendererType GetRasterRenderType(void) const {return enumGISRasterRenderTypeGreyScale;};
+    virtual wxString GetSettingsKey(void) const;
 protected:
 	virtual void OnFillStats(void);
     virtual short GetBandCount() const;
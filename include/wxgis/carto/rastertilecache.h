@@ -0,0 +1,118 @@
+/******************************************************************************
+ * Project:  wxGIS
+ * Purpose:  wxGISRasterTileCache class. Rendered raster tiles cache.
+ * Author:   Dmitry Baryshnikov (aka Bishop), polimax@mail.ru
+ ******************************************************************************
+*   Copyright (C) 2014 Dmitry Baryshnikov
+*
+*    This program is free software: you can redistribute it and/or modify
+*    it under the terms of the GNU General Public License as published by
+*    the Free Software Foundation, either version 2 of the License, or
+*    (at your option) any later version.
+*
+*    This program is distributed in the hope that it will be useful,
+*    but WITHOUT ANY WARRANTY; without even the implied warranty of
+*    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+*    GNU General Public License for more details.
+*
+*    You should have received a copy of the GNU General Public License
+*    along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ ****************************************************************************/
+#pragma once
+
+#include "wxgis/carto/carto.h"
+
+#include <list>
+#include <map>
+
+/** \def RASTER_TILE_LEVEL_STEPS rastertilecache.h
+    \brief The count of zoom levels per scale doubling.
+
+    The tile scale is 2^(level / RASTER_TILE_LEVEL_STEPS), so it differs from the display scale less than one pixel per tile.
+*/
+#define RASTER_TILE_LEVEL_STEPS 65536
+
+/** \def RASTER_TILE_SPILL_SIZE rastertilecache.h
+    \brief The default size limit of the tile spill directory in Mb (renderer/raster/tile_cache_dir_size config key).
+*/
+#define RASTER_TILE_SPILL_SIZE 1024
+
+/** \class wxGISRasterTileCache rastertilecache.h
+    \brief The LRU cache of rendered ARGB32 raster tiles.
+
+    The tiles are keyed by the string built of dataset, renderer settings, zoom level, tile x/y and rotation.
+    The tiles above the memory budget are evicted to the spill directory (if set) and loaded back on next request.
+    The spill directory is trimmed to own size limit by removing the oldest tile files.
+    All methods are thread safe. The tile files are written and read outside the cache lock, so the memory hits are not blocked by the disk.
+*/
+
+class WXDLLIMPEXP_GIS_CRT wxGISRasterTileCache
+{
+public:
+	wxGISRasterTileCache(size_t nMemoryBudget, const wxString &sSpillDir = wxEmptyString, wxULongLong nSpillBudget = wxULongLong(RASTER_TILE_SPILL_SIZE) * 1024 * 1024);
+	virtual ~wxGISRasterTileCache(void);
+    /** \fn cairo_surface_t* GetTile(const wxString &sKey, OGREnvelope &stEnvelope)
+     *  \brief Get the tile from memory or spill directory.
+     *  \param sKey The tile key
+     *  \param stEnvelope The world bounds of the tile surface
+     *  \return The referenced surface (the caller should destroy it) or NULL
+     */
+    virtual cairo_surface_t* GetTile(const wxString &sKey, OGREnvelope &stEnvelope);
+    /** \fn void PutTile(const wxString &sKey, cairo_surface_t* pSurface, const OGREnvelope &stEnvelope)
+     *  \brief Put the ARGB32 image surface to the cache. The cache takes own reference to the surface.
+     */
+    virtual void PutTile(const wxString &sKey, cairo_surface_t* pSurface, const OGREnvelope &stEnvelope);
+    virtual void Clear(void);
+    virtual void SetMemoryBudget(size_t nMemoryBudget);
+    virtual size_t GetMemoryBudget(void) const {return m_nMemoryBudget;};
+    /** \fn void SetSpillDir(const wxString &sSpillDir)
+     *  \brief Set the spill directory. The directory is created if not exist, the temporary files left in it are removed and the existing tiles are counted in the spill size limit.
+     */
+    virtual void SetSpillDir(const wxString &sSpillDir);
+    virtual wxString GetSpillDir(void) const;
+    virtual void SetSpillBudget(wxULongLong nSpillBudget);
+    virtual wxULongLong GetSpillBudget(void) const;
+protected:
+    typedef struct _tileentry
+    {
+        cairo_surface_t* pSurface;
+        OGREnvelope stEnvelope;
+        size_t nSize;
+        std::list<wxString>::iterator itLRU;
+    } TILEENTRY;
+
+    typedef struct _evictedtile
+    {
+        wxString sKey;
+        cairo_surface_t* pSurface;
+        OGREnvelope stEnvelope;
+    } EVICTEDTILE;
+
+    /** \fn void Evict(wxVector<EVICTEDTILE> &astEvicted)
+     *  \brief Remove the least recently used tiles above the memory budget. Called under the cache lock, the removed tiles are returned to spill them after the lock released.
+     */
+    virtual void Evict(wxVector<EVICTEDTILE> &astEvicted);
+    /** \fn void SpillEvicted(wxVector<EVICTEDTILE> &astEvicted)
+     *  \brief Write the evicted tiles to the spill directory and destroy their surfaces. Called without the cache lock.
+     */
+    virtual void SpillEvicted(wxVector<EVICTEDTILE> &astEvicted);
+    virtual wxString GetSpillPath(const wxString &sSpillDir, const wxString &sKey) const;
+    virtual bool Spill(const wxString &sPath, const EVICTEDTILE &stTile, wxULongLong &nFileSize);
+    virtual cairo_surface_t* LoadSpilled(const wxString &sPath, const wxString &sKey, OGREnvelope &stEnvelope);
+    virtual void TrimSpillDir(const wxString &sSpillDir);
+    virtual void Insert(const wxString &sKey, cairo_surface_t* pSurface, const OGREnvelope &stEnvelope, wxVector<EVICTEDTILE> &astEvicted);
+protected:
+    std::map<wxString, TILEENTRY> m_mTiles;
+    std::list<wxString> m_lLRU;
+    size_t m_nMemoryBudget, m_nMemoryUsed;
+    wxString m_sSpillDir;
+    wxCriticalSection m_CritSect;
+    wxULongLong m_nSpillBudget, m_nSpillUsed;
+    wxCriticalSection m_SpillCritSect; //the spill directory size and trim
+};
+
+/** \fn wxGISRasterTileCache* const GetRasterTileCache(void)
+    \brief Global raster tile cache getter. The cache is created on first call using the renderer/raster/tile_cache_size (Mb), renderer/raster/tile_cache_dir and renderer/raster/tile_cache_dir_size (Mb) config keys.
+ */
+
+WXDLLIMPEXP_GIS_CRT wxGISRasterTileCache* const GetRasterTileCache(void);
@@ -55,7 +55,9 @@ public:
 	wxGISStretch(double dfMin = 0.0, double dfMax = 255.0, double dfMean = 127.5, double dfStdDev = DEFAULT_STDDEV, double dfNoData = NOTNODATA);
 	virtual ~wxGISStretch(void);
 	virtual unsigned char GetValue(const double *pdfInput);
+	virtual void GetValues(const float *pfInput, unsigned char *pOutput, int nCount);
     virtual bool IsNoData(const double& cVal);
+    virtual void GetNoDataMask(const float *pfInput, unsigned char *pMask, int nCount);
     virtual void SetNoData(double dfNoData);
     virtual double GetNoData(void);
     virtual void SetInvert(bool bInvert);
@@ -63,9 +65,21 @@ public:
     virtual void SetStdDevParam(double dfStdDevParam);
     virtual double GetStdDevParam(void);
     virtual void SetStats(double dfMin = 0.0, double dfMax = 255.0, double dfMean = 127.5, double dfStdDev = DEFAULT_STDDEV);
+    virtual wxString GetKey(void) const;
+    /** \fn bool CopyLUT(GDALDataType eDT, wxVector<unsigned char> &aLUT, wxVector<unsigned char> &aNoDataLUT)
+     *  \brief Copy the lookup tables from the sample value to the output byte and to the nodata flag (0xFF for nodata, 0 otherwise).
+     *  \param eDT The sample data type
+     *  \return false if the data type is not Byte, UInt16 or Int16
+     *
+     *  The tables have 256 entries for Byte and 65536 entries for 16 bit types indexed by the sample bits.
+     *  They are rebuilt on the first call after the stats, stretch parameters, invert or nodata change.
+     *  The tables are copied under the lock as the setters may be called from other thread during the draw.
+     */
+    virtual bool CopyLUT(GDALDataType eDT, wxVector<unsigned char> &aLUT, wxVector<unsigned char> &aNoDataLUT);
 protected:
     virtual void RecalcEquation(void);
     virtual void CalcEquation(double dfMin, double dfMax);
+    virtual bool BuildLUT(GDALDataType eDT);
     //AdjastBritnessContrast
 protected:
     double m_dfNoData;
@@ -78,6 +92,10 @@ protected:
     wxGISEnumRasterStretch m_eType;
 protected:
     double m_dfM, m_dfDX;
+    wxVector<unsigned char> m_aLUT, m_aNoDataLUT;
+    GDALDataType m_eLUTType;
+    bool m_bLUTDirty;
+    wxCriticalSection m_LUTCritSect;
 };
 
 //TODO: esriRasterStretchStatsTypeEnum Constants
@@ -118,6 +118,10 @@ public:
 	virtual wxGxObjectList SimpleSearch(const wxString &sText, ITrackCancel* const pTrackCancel);
 	//wxGxNGWService
 	virtual wxGISCurl GetCurl();
+	/** \fn void AppendAuthHeader(wxGISCurlMulti &curl) const
+	 *  \brief Append the authorization header to the concurrent requests as in GetCurl
+	 */
+	virtual void AppendAuthHeader(wxGISCurlMulti &curl) const;
 	virtual wxString GetLogin() const;
 	virtual wxString GetPassword() const;
 	virtual wxString GetURL() const;
@@ -167,6 +171,10 @@ public:
 	static wxString MakeKey(const wxString& sInputStr);
 	static wxJSONValue MakeMetadata(wxGISDataset* const pDSet);
 	virtual bool FillPermissions();
+	/** \fn void FillPermissions(wxGxNGWService *pService, const wxVector<wxGxNGWResource*> &apResources)
+	 *  \brief Get the permissions of several resources by concurrent requests
+	 */
+	static void FillPermissions(wxGxNGWService *pService, const wxVector<wxGxNGWResource*> &apResources);
 	virtual const wxString& GetResourceName() const;
 	virtual const wxString& GetResourceKey() const;
 	virtual const wxString& GetResourceDescription() const;
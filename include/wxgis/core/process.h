@@ -68,6 +68,8 @@ public:
 
     The process class which stores the application execution data.
 
+    On unix the process output is read by the one reader thread shared by all processes. The thread waits the output of all pipes by poll() and passes the complete lines to ProcessInput. On other platforms the process reads the output by own thread.
+
     @library{core}
  */
 class WXDLLIMPEXP_GIS_CORE wxGISProcess :
@@ -93,9 +95,14 @@ protected:
     virtual long Execute(void) = 0;
     virtual void UpdatePercent(const wxString &sPercentData);
     virtual void AddInfo(wxGISEnumMessageType eType, const wxString &sInfoData) = 0;
+    //output reading
+    virtual bool StartReadInput(void);
+    virtual bool AttachToReader(void);
+    virtual void DetachFromReader(bool bFlush = false);
 protected:
     IGISProcessParent* m_pParent;
     wxCriticalSection m_ExitLock;
+    bool m_bAttachedToReader;
     //
 	wxDateTime m_dtBeg;
 	wxDateTime m_dtEstEnd;
@@ -0,0 +1,157 @@
+/******************************************************************************
+ * Project:  wxGIS
+ * Purpose:  wxGISAttributeIndex class. Hash and sorted index of table field.
+ * Author:   Dmitry Baryshnikov (aka Bishop), polimax@mail.ru
+ ******************************************************************************
+*   Copyright (C) 2014 Dmitry Baryshnikov
+*
+*    This program is free software: you can redistribute it and/or modify
+*    it under the terms of the GNU General Public License as published by
+*    the Free Software Foundation, either version 2 of the License, or
+*    (at your option) any later version.
+*
+*    This program is distributed in the hope that it will be useful,
+*    but WITHOUT ANY WARRANTY; without even the implied warranty of
+*    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+*    GNU General Public License for more details.
+*
+*    You should have received a copy of the GNU General Public License
+*    along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ ****************************************************************************/
+#pragma once
+
+#include "wxgis/datasource/columnfilter.h"
+
+#include <set>
+
+/** \def ATTRIBUTE_INDEX_AUTO_LOOKUPS attrindex.h
+    \brief The index is created by Search on this lookup of the same field
+*/
+#define ATTRIBUTE_INDEX_AUTO_LOOKUPS 2
+
+typedef struct _attribute_index_value
+{
+    double dfValue;     //OFTInteger, OFTReal
+    CPLString sValue;   //OFTString
+} ATTRIBUTEINDEXVALUE;
+
+typedef struct _attribute_index_item
+{
+    ATTRIBUTEINDEXVALUE Value;
+    long nFID;
+} ATTRIBUTEINDEXITEM;
+
+class wxGISCPLStringHash
+{
+public:
+    wxGISCPLStringHash() {}
+    unsigned long operator()(const CPLString &sKey) const { return wxStringHash::stringHash(sKey.c_str()); }
+    wxGISCPLStringHash& operator=(const wxGISCPLStringHash&) { return *this; }
+};
+
+class wxGISCPLStringEqual
+{
+public:
+    wxGISCPLStringEqual() {}
+    bool operator()(const CPLString &a, const CPLString &b) const { return a == b; }
+    wxGISCPLStringEqual& operator=(const wxGISCPLStringEqual&) { return *this; }
+};
+
+/** @class wxGISAttributeIndexLess
+
+    The order of the sorted index items: the value (byte order for strings), then FID, so each item has its own place in the set.
+
+    @library{datasource}
+*/
+
+class wxGISAttributeIndexLess
+{
+public:
+    wxGISAttributeIndexLess(bool bNumeric = true) : m_bNumeric(bNumeric) {};
+    bool operator()(const ATTRIBUTEINDEXITEM &a, const ATTRIBUTEINDEXITEM &b) const
+    {
+        if(m_bNumeric)
+        {
+            if(a.Value.dfValue != b.Value.dfValue)
+                return a.Value.dfValue < b.Value.dfValue;
+        }
+        else
+        {
+            int nCmp = strcmp(a.Value.sValue, b.Value.sValue);
+            if(nCmp != 0)
+                return nCmp < 0;
+        }
+        return a.nFID < b.nFID;
+    }
+protected:
+    bool m_bNumeric;
+};
+
+typedef std::set<ATTRIBUTEINDEXITEM, wxGISAttributeIndexLess> wxGISAttributeSortedIndex;
+
+WX_DECLARE_HASH_MAP(CPLString, wxVector<long>, wxGISCPLStringHash, wxGISCPLStringEqual, wxGISAttributeHashIndex);
+WX_DECLARE_HASH_MAP(long, ATTRIBUTEINDEXVALUE, wxIntegerHash, wxIntegerEqual, wxGISAttributeFIDValueMap);
+
+/** @class wxGISAttributeIndex
+
+    The index of one table field values. The hash index (value to FIDs) is used for equality and is kept up to date on each change,
+    the sorted set for ranges and ordering is created on first request and then updated in place in O(log n).
+
+    The null values are not indexed. The strings are keyed and ordered by their exact bytes, so the equality is case sensitive
+    as in wxGISColumnStoreFilter and in the driver SQL the uncached tables pass the clause to.
+    The class has no lock of its own, the owning wxGISTable calls it under its critical section.
+
+    @library{datasource}
+*/
+
+class WXDLLIMPEXP_GIS_DS wxGISAttributeIndex
+{
+public:
+    wxGISAttributeIndex(int nField, OGRFieldType eType);
+    virtual ~wxGISAttributeIndex(void);
+    virtual int GetField(void) const;
+    virtual void Clear(void);
+    virtual size_t GetCount(void) const;
+    /** \fn void Add(long nFID, OGRFeature* const poFeature)
+     *  \brief Add the field value of the feature. The previous FID value should be removed before.
+     */
+    virtual void Add(long nFID, OGRFeature* const poFeature);
+    virtual void Remove(long nFID);
+    /** \fn bool Fill(const wxGISFeatureColumnStore* pStore, ITrackCancel* const pTrackCancel)
+     *  \brief Add all rows of the store reading the field column directly
+     *  \return false if cancelled
+     */
+    virtual bool Fill(const wxGISFeatureColumnStore* pStore, ITrackCancel* const pTrackCancel = NULL);
+    /** \fn bool Fill(OGRLayer* const poLayer, ITrackCancel* const pTrackCancel)
+     *  \brief Add all layer features. The layer reading is reset.
+     *  \return false if cancelled
+     */
+    virtual bool Fill(OGRLayer* const poLayer, ITrackCancel* const pTrackCancel = NULL);
+    /** \fn void Find(wxGISEnumFilterOperator eOp, double dfValue, const char* pszValue, wxVector<long> &anFIDs)
+     *  \brief Append the FIDs which field value compared with the literal is true
+     *  \param eOp The compare operator
+     *  \param dfValue The literal for the numeric field
+     *  \param pszValue The literal for the string field
+     *  \param anFIDs The output FIDs
+     */
+    virtual void Find(wxGISEnumFilterOperator eOp, double dfValue, const char* pszValue, wxVector<long> &anFIDs);
+    /** \fn void GetOrderedFIDs(bool bAscending, wxVector<long> &anFIDs)
+     *  \brief Get the FIDs ordered by the field value (null values are skipped)
+     *
+     *  Not used by the datasource itself, it is for the callers reading the rows ordered by a field (e.g. the sorted table view).
+     *  The index is not locked, so the call should be made under the owning table critical section as wxGISTable::SelectByIndex does.
+     */
+    virtual void GetOrderedFIDs(bool bAscending, wxVector<long> &anFIDs);
+    static bool IsSupportedType(OGRFieldType eType);
+protected:
+    virtual void Add(long nFID, const ATTRIBUTEINDEXVALUE &Value);
+    virtual CPLString GetKey(const ATTRIBUTEINDEXVALUE &Value) const;
+    virtual void Sort(void);
+protected:
+    int m_nField;
+    bool m_bNumeric;
+    wxGISAttributeHashIndex m_mHash;
+    wxGISAttributeFIDValueMap m_mFIDValues;
+    wxGISAttributeSortedIndex m_oSorted;
+    bool m_bSorted;
+};
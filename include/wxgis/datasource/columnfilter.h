@@ -0,0 +1,165 @@
+/******************************************************************************
+ * Project:  wxGIS
+ * Purpose:  wxGISColumnStoreFilter class. Attribute filter over column store.
+ * Author:   Dmitry Baryshnikov (aka Bishop), polimax@mail.ru
+ ******************************************************************************
+*   Copyright (C) 2014 Dmitry Baryshnikov
+*
+*    This program is free software: you can redistribute it and/or modify
+*    it under the terms of the GNU General Public License as published by
+*    the Free Software Foundation, either version 2 of the License, or
+*    (at your option) any later version.
+*
+*    This program is distributed in the hope that it will be useful,
+*    but WITHOUT ANY WARRANTY; without even the implied warranty of
+*    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+*    GNU General Public License for more details.
+*
+*    You should have received a copy of the GNU General Public License
+*    along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ ****************************************************************************/
+#pragma once
+
+#include "wxgis/datasource/columnstore.h"
+
+/** \def COLUMN_FILTER_BATCH_WORDS columnfilter.h
+    \brief The count of 32 bit mask words evaluated at once (2048 rows)
+*/
+#define COLUMN_FILTER_BATCH_WORDS 64
+
+/** \def COLUMN_FILTER_FID columnfilter.h
+    \brief The field index of FID special field
+*/
+#define COLUMN_FILTER_FID -1
+
+class wxGISAttributeIndex;
+
+/** \enum wxGISEnumFilterNodeType columnfilter.h
+    \brief The filter expression node type
+*/
+enum wxGISEnumFilterNodeType
+{
+    enumGISFilterNodeAnd = 0,
+    enumGISFilterNodeOr,
+    enumGISFilterNodeNot,
+    enumGISFilterNodeCompare,
+    enumGISFilterNodeIn,
+    enumGISFilterNodeLike,
+    enumGISFilterNodeIsNull
+};
+
+/** \enum wxGISEnumFilterOperator columnfilter.h
+    \brief The filter comparison operator
+*/
+enum wxGISEnumFilterOperator
+{
+    enumGISFilterOpEQ = 0,
+    enumGISFilterOpNE,
+    enumGISFilterOpLT,
+    enumGISFilterOpLE,
+    enumGISFilterOpGT,
+    enumGISFilterOpGE
+};
+
+/** \enum wxGISEnumFilterTokenType columnfilter.h
+    \brief The where clause token type
+*/
+enum wxGISEnumFilterTokenType
+{
+    enumGISFilterTokenEnd = 0,
+    enumGISFilterTokenIdentifier,
+    enumGISFilterTokenString,
+    enumGISFilterTokenNumber,
+    enumGISFilterTokenOperator,
+    enumGISFilterTokenOpen,
+    enumGISFilterTokenClose,
+    enumGISFilterTokenComma
+};
+
+/** @class wxGISColumnStoreFilter
+
+    The attribute filter evaluated over wxGISFeatureColumnStore columns without creating the features.
+
+    The OGR SQL where clause subset is supported: comparisons (=, <>, !=, <, <=, >, >=), AND, OR, NOT, IN, LIKE, BETWEEN and IS [NOT] NULL
+    between field (or FID) and literal. The string comparisons (including IN) are case sensitive byte comparisons as in the driver SQL,
+    only LIKE is case insensitive as in OGR SQL.
+    The NULL values follow SQL three-valued logic. If Parse returns false the clause should be passed to OGR.
+
+    @library{datasource}
+*/
+
+class WXDLLIMPEXP_GIS_DS wxGISColumnStoreFilter
+{
+public:
+    wxGISColumnStoreFilter(void);
+    virtual ~wxGISColumnStoreFilter(void);
+    /** \fn bool Parse(const wxString &sWhereClause, OGRFeatureDefn* const poDefn)
+     *  \brief Parse the where clause
+     *  \param sWhereClause The where clause
+     *  \param poDefn The definition to find fields
+     *  \return true if the clause is supported by this filter
+     */
+    virtual bool Parse(const wxString &sWhereClause, OGRFeatureDefn* const poDefn);
+    virtual bool IsOk(void) const;
+    /** \fn bool Evaluate(const wxGISFeatureColumnStore* pStore, wxVector<wxUint32> &anRowMask, ITrackCancel* const pTrackCancel) const
+     *  \brief Evaluate the filter over all rows of the store
+     *  \param pStore The store created with the same definition as in Parse
+     *  \param anRowMask The result bits, one bit per row, 32 rows in each item. The deleted rows are never set.
+     *  \param pTrackCancel The cancel tracker or NULL
+     *  \return false if cancelled
+     */
+    virtual bool Evaluate(const wxGISFeatureColumnStore* pStore, wxVector<wxUint32> &anRowMask, ITrackCancel* const pTrackCancel = NULL) const;
+    /** \fn bool GetIndexField(int &nField) const
+     *  \brief Get the field if the clause is the comparisons or IN of one field combined by AND and OR, so the attribute index can be used
+     */
+    virtual bool GetIndexField(int &nField) const;
+    /** \fn void Select(wxGISAttributeIndex* const pIndex, wxVector<long> &anFIDs) const
+     *  \brief Get the sorted FIDs matching the clause from the index of the GetIndexField field
+     */
+    virtual void Select(wxGISAttributeIndex* const pIndex, wxVector<long> &anFIDs) const;
+protected:
+    typedef struct _node
+    {
+        wxGISEnumFilterNodeType eType;
+        wxGISEnumFilterOperator eOp;
+        int nField;
+        wxVector<double> adfValues;
+        wxVector<CPLString> asValues;
+        struct _node* pLeft;
+        struct _node* pRight;
+    } NODE;
+
+    typedef struct _token
+    {
+        wxGISEnumFilterTokenType eType;
+        CPLString sValue;
+        double dfValue;
+        bool bQuoted;
+    } TOKEN;
+
+    virtual void DeleteNode(NODE* pNode);
+    virtual NODE* CreateNode(wxGISEnumFilterNodeType eType, NODE* pLeft = NULL, NODE* pRight = NULL);
+    //tokenizer
+    virtual bool Tokenize(const char* pszClause);
+    bool IsKeyword(const char* pszKeyword) const;
+    //recursive descent parser
+    virtual NODE* ParseOr(void);
+    virtual NODE* ParseAnd(void);
+    virtual NODE* ParseNot(void);
+    virtual NODE* ParsePredicate(void);
+    virtual bool ParseField(int &nField);
+    virtual bool ParseOperator(wxGISEnumFilterOperator &eOp);
+    virtual bool ParseLiteral(int nField, NODE* pNode);
+    //evaluation
+    virtual void EvaluateNode(const NODE* pNode, const wxGISFeatureColumnStore* pStore, size_t nFirstWord, size_t nWords, wxUint32* panTrue, wxUint32* panUnknown) const;
+    virtual wxUint32 EvaluateRows(const NODE* pNode, const wxGISFeatureColumnStore* pStore, size_t nFirstRow, size_t nRows, wxUint32 nSet) const;
+    static bool Like(const char* pszInput, const char* pszPattern);
+    //attribute index
+    virtual bool GetNodeField(const NODE* pNode, int &nField) const;
+    virtual void SelectNode(const NODE* pNode, wxGISAttributeIndex* const pIndex, wxVector<long> &anFIDs) const;
+protected:
+    NODE* m_pRoot;
+    OGRFeatureDefn* m_poDefn;
+    wxVector<TOKEN> m_astTokens;
+    size_t m_nToken;
+};
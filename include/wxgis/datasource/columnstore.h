@@ -0,0 +1,148 @@
+/******************************************************************************
+ * Project:  wxGIS
+ * Purpose:  wxGISFeatureColumnStore class. Column oriented in memory features storage.
+ * Author:   Dmitry Baryshnikov (aka Bishop), polimax@mail.ru
+ ******************************************************************************
+*   Copyright (C) 2014 Dmitry Baryshnikov
+*
+*    This program is free software: you can redistribute it and/or modify
+*    it under the terms of the GNU General Public License as published by
+*    the Free Software Foundation, either version 2 of the License, or
+*    (at your option) any later version.
+*
+*    This program is distributed in the hope that it will be useful,
+*    but WITHOUT ANY WARRANTY; without even the implied warranty of
+*    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+*    GNU General Public License for more details.
+*
+*    You should have received a copy of the GNU General Public License
+*    along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ ****************************************************************************/
+#pragma once
+
+#include "wxgis/datasource/gdalinh.h"
+
+#include <wx/hashmap.h>
+
+WX_DECLARE_HASH_MAP(long, size_t, wxIntegerHash, wxIntegerEqual, wxGISFIDRowMap);
+
+/** \def COLUMN_STORE_DENSE_FID_GAP columnstore.h
+    \brief The FID to row index is the array if FID range is less than row count multiplied by this value, otherwise the hash map.
+*/
+#define COLUMN_STORE_DENSE_FID_GAP 4
+
+/** \def COLUMN_STORE_COMPACT_SIZE columnstore.h
+    \brief The strings or geometry buffer is compacted if the unused bytes are more than this size and more than half of the buffer.
+*/
+#define COLUMN_STORE_COMPACT_SIZE 1048576
+
+/** @class wxGISFeatureColumnStore
+
+    The in memory features storage. Each field is stored in own typed array (integer, 64 bit integer, real, date and time as OGRField
+    or offset in the strings arena for strings and binary data), the geometries are stored as WKB in one buffer. The wxGISFeature is created on request and is not cached.
+    The list fields are not stored, the layers having them are not cached in the store (see IsSupported).
+
+    The changed rows are rewritten in place, the previous strings and geometry bytes of the changed and deleted rows are counted
+    and the buffer is compacted when they exceed COLUMN_STORE_COMPACT_SIZE and half of the buffer. The created geometries
+    have the spatial reference set by SetSpatialReference or taken from the first added geometry having it.
+
+    @library{datasource}
+*/
+
+class WXDLLIMPEXP_GIS_DS wxGISFeatureColumnStore
+{
+public:
+    wxGISFeatureColumnStore(OGRFeatureDefn* const poDefn, const wxFontEncoding &oEncoding, bool bRecodeToSystem);
+    virtual ~wxGISFeatureColumnStore(void);
+    /** \fn static bool IsSupported(OGRFeatureDefn* const poDefn)
+     *  \brief Check if all field types of definition are stored without loss
+     */
+    static bool IsSupported(OGRFeatureDefn* const poDefn);
+    virtual void Clear(void);
+    virtual size_t GetRowCount(void) const;
+    /** \fn void Add(OGRFeature* poFeature)
+     *  \brief Copy the feature values to the storage. The caller still own the feature.
+     */
+    virtual void Add(OGRFeature* const poFeature);
+    /** \fn void Set(OGRFeature* poFeature)
+     *  \brief Replace the row with the same FID or add the new one
+     */
+    virtual void Set(OGRFeature* const poFeature);
+    virtual void Delete(long nFID);
+    virtual bool HasFID(long nFID) const;
+    /** \fn long GetRow(long nFID) const
+     *  \brief Get the row index of FID or wxNOT_FOUND
+     */
+    virtual long GetRow(long nFID) const;
+    virtual long GetFID(size_t nRow) const;
+    /** \fn wxGISFeature GetFeature(size_t nRow) const
+     *  \brief Create the feature from the row values. Returns empty feature for the deleted row.
+     */
+    virtual wxGISFeature GetFeature(size_t nRow) const;
+    virtual wxGISFeature GetFeatureByID(long nFID) const;
+    virtual OGRFeatureDefn* const GetDefinition(void) const { return m_poDefn; };
+    /** \fn void SetSpatialReference(OGRSpatialReference* const poSpatialRef)
+     *  \brief Set the spatial reference assigned to the geometries created by GetFeature. The store keeps the reference.
+     */
+    virtual void SetSpatialReference(OGRSpatialReference* const poSpatialRef);
+    //direct column access for the filters
+    int GetColumnCount(void) const { return (int)m_astColumns.size(); };
+    OGRFieldType GetColumnType(int nField) const { return m_astColumns[nField].eType; };
+    /** \fn const wxUint32* GetSetMask(int nField) const
+     *  \brief The field set bits, one bit per row, 32 rows in each item
+     */
+    const wxUint32* GetSetMask(int nField) const { return m_astColumns[nField].anSetMask.empty() ? NULL : &m_astColumns[nField].anSetMask[0]; };
+    const int* GetIntegerValues(int nField) const { return m_astColumns[nField].anValues.empty() ? NULL : &m_astColumns[nField].anValues[0]; };
+    const double* GetRealValues(int nField) const { return m_astColumns[nField].adfValues.empty() ? NULL : &m_astColumns[nField].adfValues[0]; };
+    const char* GetString(int nField, size_t nRow) const { return &m_achStrings[m_astColumns[nField].anOffsets[nRow]]; };
+    const long* GetFIDs(void) const { return m_anFIDs.empty() ? NULL : &m_anFIDs[0]; };
+protected:
+    typedef struct _column
+    {
+        OGRFieldType eType;
+        wxVector<int> anValues;         //OFTInteger
+        wxVector<GIntBig> anValues64;   //OFTInteger64
+        wxVector<double> adfValues;     //OFTReal
+        wxVector<OGRField> astRawValues;//OFTDate, OFTTime, OFTDateTime
+        wxVector<size_t> anOffsets;     //OFTString and OFTBinary in arena
+        wxVector<size_t> anSizes;       //OFTBinary byte count
+        wxVector<wxUint32> anSetMask;   //bit per row, the field is set
+    } COLUMN;
+
+    virtual void SetRow(size_t nRow, OGRFeature* const poFeature);
+    virtual size_t AddString(const char* pszValue);
+    virtual size_t AddBytes(const void* pData, size_t nSize);
+    virtual void SetFIDRow(long nFID, size_t nRow);
+    virtual void RemoveFIDRow(long nFID);
+    /** \fn void ReleaseRow(size_t nRow)
+     *  \brief Count the row strings and geometry bytes as unused before the row is rewritten or deleted
+     */
+    virtual void ReleaseRow(size_t nRow);
+    virtual void CompactStrings(void);
+    virtual void CompactWKB(void);
+    virtual void CompactIfNeeded(void);
+    inline bool IsSet(const COLUMN &stColumn, size_t nRow) const
+    {
+        return (stColumn.anSetMask[nRow >> 5] & (1U << (nRow & 31))) != 0;
+    }
+protected:
+    OGRFeatureDefn* m_poDefn;
+    wxFontEncoding m_Encoding;
+    bool m_bRecodeToSystem;
+
+    wxVector<COLUMN> m_astColumns;
+    wxVector<long> m_anFIDs;            //wxNOT_FOUND for deleted rows
+    wxVector<size_t> m_anStyleOffsets;
+    wxVector<char> m_achStrings;
+    wxVector<size_t> m_anWKBOffsets;
+    wxVector<size_t> m_anWKBSizes;
+    wxVector<unsigned char> m_abyWKB;
+    size_t m_nUnusedStrings, m_nUnusedWKB;
+    OGRSpatialReference* m_poSpatialRef;
+
+    //FID to row index
+    long m_nMinFID;
+    wxVector<long> m_anFIDRows;
+    wxGISFIDRowMap m_mFIDRows;
+    bool m_bDenseFID;
+};
@@ -20,11 +20,17 @@
  ****************************************************************************/
 #pragma once
 
-#include "wxgis/datasource/gdalinh.h"
+#include "wxgis/datasource/columnstore.h"
 
 #include <list>
 
 class wxGISTable;
+class wxGISTableCached;
+
+/** \def FEATURE_STREAM_BATCH_SIZE cursor.h
+    \brief The default count of features fetched by feature stream at once
+*/
+#define FEATURE_STREAM_BATCH_SIZE 256
 
 /** \class wxFeatureCursor cursor.h
     \brief The class represents an array of OGRFeatures, received by some selection.
@@ -76,3 +82,107 @@ protected:
 	std::list<wxGISFeature> m_olFeatures;
     wxGISTable* m_pFeatureDataSet;
 };
+
+/** \class wxFeatureStream cursor.h
+    \brief The pull based features stream. The features are fetched from the source by batches on request, so the memory does not depend on the result size.
+
+    The stream keep the dataset reference. The source (layer reading, cached rows) should not be changed while the stream is used.
+    The caller own the stream pointer.
+*/
+
+class WXDLLIMPEXP_GIS_DS wxFeatureStream
+{
+public:
+    wxFeatureStream(wxGISTable* pFeatureDataSet, size_t nBatchSize = FEATURE_STREAM_BATCH_SIZE);
+    virtual ~wxFeatureStream(void);
+    /** \fn wxGISFeature Next(void)
+     *  \brief Get the next feature
+     *  \return The feature or empty feature at the end of stream
+     */
+    virtual wxGISFeature Next(void);
+    /** \fn size_t NextBatch(wxVector<wxGISFeature> &aFeatures)
+     *  \brief Get up to batch size next features
+     *  \return The features count or 0 at the end of stream
+     */
+    virtual size_t NextBatch(wxVector<wxGISFeature> &aFeatures);
+    /** \fn void Stop(void)
+     *  \brief Stop the stream and release the source before the end
+     */
+    virtual void Stop(void);
+    virtual bool IsStopped(void) const;
+    /** \fn size_t GetPosition(void) const
+     *  \brief The count of returned features (for progress)
+     */
+    virtual size_t GetPosition(void) const;
+    virtual wxGISTable* GetDataset() const;
+protected:
+    virtual size_t Fetch(wxVector<wxGISFeature> &aFeatures, size_t nCount) = 0;
+    virtual void Release(void);
+protected:
+    wxGISTable* m_pFeatureDataSet;
+    size_t m_nBatchSize;
+    size_t m_nBatchPos;
+    size_t m_nPosition;
+    wxVector<wxGISFeature> m_aBatch;
+    bool m_bStopped;
+};
+
+/** \class wxFeatureLayerStream cursor.h
+    \brief The stream of OGR layer features. The attribute filter is set to the layer while the stream is not stopped, then the dataset filter is set back.
+*/
+
+class WXDLLIMPEXP_GIS_DS wxFeatureLayerStream : public wxFeatureStream
+{
+public:
+    wxFeatureLayerStream(wxGISTable* pFeatureDataSet, OGRLayer* poLayer, const wxString &sWhereClause, size_t nBatchSize = FEATURE_STREAM_BATCH_SIZE);
+    virtual ~wxFeatureLayerStream(void);
+protected:
+    virtual size_t Fetch(wxVector<wxGISFeature> &aFeatures, size_t nCount);
+    virtual void Release(void);
+protected:
+    OGRLayer* m_poLayer;
+    bool m_bHasFilter;
+    long m_nNextFID;
+};
+
+/** \class wxFeatureFIDStream cursor.h
+    \brief The stream of the dataset features by FID list
+*/
+
+class WXDLLIMPEXP_GIS_DS wxFeatureFIDStream : public wxFeatureStream
+{
+public:
+    wxFeatureFIDStream(wxGISTable* pFeatureDataSet, const wxVector<long> &anFIDs, size_t nBatchSize = FEATURE_STREAM_BATCH_SIZE);
+    virtual ~wxFeatureFIDStream(void);
+protected:
+    virtual size_t Fetch(wxVector<wxGISFeature> &aFeatures, size_t nCount);
+protected:
+    wxVector<long> m_anFIDs;
+    size_t m_nFIDPos;
+};
+
+/** \class wxFeatureStoreStream cursor.h
+    \brief The stream of the column store rows. The features are created only for the rows returned.
+
+    The stream ends if the dataset deletes its column store (recache, close), the store is used only while the dataset store revision is the same.
+*/
+
+class WXDLLIMPEXP_GIS_DS wxFeatureStoreStream : public wxFeatureStream
+{
+public:
+    /** \fn wxFeatureStoreStream(wxGISTableCached* pFeatureDataSet, const wxVector<wxUint32>* panRowMask, size_t nBatchSize)
+     *  \brief The constructor. Should be called under the dataset lock.
+     *  \param pFeatureDataSet The dataset with column store
+     *  \param panRowMask The rows bits to return or NULL for all rows
+     */
+    wxFeatureStoreStream(wxGISTableCached* pFeatureDataSet, const wxVector<wxUint32>* panRowMask = NULL, size_t nBatchSize = FEATURE_STREAM_BATCH_SIZE);
+    virtual ~wxFeatureStoreStream(void);
+protected:
+    virtual size_t Fetch(wxVector<wxGISFeature> &aFeatures, size_t nCount);
+protected:
+    wxGISTableCached* m_pTableCached;
+    long m_nStoreRevision;
+    wxVector<wxUint32> m_anRowMask;
+    bool m_bHasMask;
+    size_t m_nRow;
+};
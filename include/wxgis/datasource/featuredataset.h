@@ -61,6 +61,10 @@ public:
     virtual OGRErr SetFilter(const wxGISSpatialFilter &SpaFilter = wxGISNullSpatialFilter);
     virtual wxFeatureCursor Search(const wxGISSpatialFilter &SpaFilter, bool bOnlyFirst = false, ITrackCancel* const pTrackCancel = NULL);
  	virtual wxGISSpatialTreeCursor SearchGeometry(const OGREnvelope &Env);
+    /** \fn wxGISGeometry CopyGeometry(long nFID)
+     *  \brief Get the copy of the feature geometry owned by caller. The cached feature is not referenced out of the dataset lock, so it can be called from the worker threads.
+     */
+    virtual wxGISGeometry CopyGeometry(long nFID);
 protected:
     virtual void SetInternalValues(void);
  	virtual bool IsContainer() const;
@@ -106,16 +110,47 @@ public:
 	virtual OGRErr DeleteFeature(long nFID);
     virtual OGRErr StoreFeature(wxGISFeature &Feature);
     virtual OGRErr SetFeature(const wxGISFeature &Feature);
+    //wxGISFeatureDataset
+    virtual wxGISGeometry CopyGeometry(long nFID);
+protected:
+    virtual bool FillAttributeIndex(wxGISAttributeIndex* const pIndex, ITrackCancel* const pTrackCancel);
 protected:
     std::map<long, wxGISFeature> m_omFeatures;
+    wxGISFeatureColumnStore* m_pColumnStore;
+    bool m_bUseColumnStore;
 };
 
 
 #ifdef wxGIS_USE_CURL
+
+/** \def NGW_FEATURE_PAGE_SIZE featuredataset.h
+    \brief The count of features requested from NextGIS Web at once (wxGISCommon/ngw/feature_page_size)
+*/
+#define NGW_FEATURE_PAGE_SIZE 1000
+
+/** \def NGW_EDIT_BATCH_SIZE featuredataset.h
+    \brief The count of features sent to NextGIS Web in one request in transaction (wxGISCommon/ngw/edit_batch_size)
+*/
+#define NGW_EDIT_BATCH_SIZE 100
+
+/** \enum wxGISEnumNGWEditType featuredataset.h
+    \brief The queued edit type
+*/
+enum wxGISEnumNGWEditType
+{
+    enumGISNGWEditCreate = 0,
+    enumGISNGWEditUpdate,
+    enumGISNGWEditDelete
+};
+
 /** @class wxGISNGWFeatureDataset
 
     A NextGIS Web FeatureDataset class.
 
+    Between StartTransaction and CommitTransaction the edits are queued and sent by batches of several features in concurrent requests.
+    The features are changed in the local copy only after the server accepted them. The edits already sent can not be rolled back.
+    The edits of failed requests stay queued and are sent again with the next batch or commit. If the commit failed the transaction stays open to commit again or roll back.
+
     @library{datasource}
 */
 
@@ -132,13 +167,39 @@ public:
     virtual OGRErr DeleteFeature(long nFID);
     virtual OGRErr StoreFeature(wxGISFeature &Feature);
     virtual OGRErr SetFeature(const wxGISFeature &Feature);
+    virtual OGRErr CommitTransaction(void);
+    virtual OGRErr StartTransaction(void);
+    virtual OGRErr RollbackTransaction(void);
 protected:
     wxString FeatureToPayload(const wxGISFeature &Feature);
+    wxJSONValue FeatureToJSON(const wxGISFeature &Feature);
+    /** \fn OGRErr FlushEdits(void)
+     *  \brief Send the queued edits to the server and apply them to the local copy. The edits of failed requests are kept in queue.
+     */
+    virtual OGRErr FlushEdits(void);
+    virtual void ReportFailedEdits(size_t nFirst, size_t nLast, long nHTTPCode, const wxString &sResponse);
+    virtual OGRErr QueueEdit(wxGISEnumNGWEditType eType, const wxGISFeature &Feature, long nFID);
+    /** \fn OGRFeature* JSONToFeature(const wxJSONValue &JSONFeature)
+     *  \brief Create the layer feature from NGW feature JSON. The caller should destroy it.
+     */
+    OGRFeature* JSONToFeature(const wxJSONValue &JSONFeature);
 protected:
     wxString m_sAuth;
     long m_nResourceId;
     wxString m_sURL;
 
+    typedef struct _ngw_edit
+    {
+        wxGISEnumNGWEditType eType;
+        wxGISFeature Feature;
+        long nFID;
+    } NGWEDIT;
+
+    bool m_bBatchEdit;
+    wxVector<NGWEDIT> m_astEdits;
+    size_t m_nFailedEdits; //the count of edits kept in queue by the last flush
+    int m_nEditBatchSize;
+    int m_nMaxConnections;
 };
 
 #endif // wxGIS_USE_CURL
\ No newline at end of file
@@ -35,6 +35,7 @@
     #define CreateOGRCompatibleDataSource(path, options) Create( path, 0, 0, 0, GDT_Unknown, options );
     #define GetOGRCompatibleDriverName GetDescription
     #define GetOGRCompatibleDatasourceName GetDriverName
+    #define DeleteOGRCompatibleDataSource(path) Delete( path ) == CE_None
 #else
     #define OGRCompatibleDataSource OGRDataSource
     #define OGRCompatibleClose(x) OGRDataSource::DestroyDataSource(x)
@@ -43,6 +44,7 @@
     #define CreateOGRCompatibleDataSource(path, options) CreateDataSource( path, options )
     #define GetOGRCompatibleDriverName GetName
     #define GetOGRCompatibleDatasourceName GetName
+    #define DeleteOGRCompatibleDataSource(path) DeleteDataSource( path ) == OGRERR_NONE
 #endif // GDAL_VERSION_NUM
 
 #define wxGISEQUAL(a,b) ( (const char*)a == NULL ? 0 : EQUAL(a,b) )
@@ -139,6 +141,7 @@ public:
     //get
     const char* GetFieldAsChar(int nField) const;
     OGRField* GetRawField(int nField) const;
+    bool IsFieldSet(int nField) const;
     wxString GetFieldAsString(int nField) const;
     wxString GetFieldAsString(const wxString &sFieldName) const;
     wxDateTime GetFieldAsDateTime(int nField) const;
@@ -160,6 +163,7 @@ public:
     wxString GetFieldName(int nIndex) const;
     int GetFieldCount(void) const;
     long GetFID(void) const;
+    wxGISFeature Clone(void) const;
     //set
     OGRErr SetFID(long nFID);
     void SetField(int nIndex, int nValue);
@@ -417,3 +421,58 @@ protected:
 };
 
 extern WXDLLIMPEXP_DATA_GIS_DS(wxGISGeometry) wxNullGeometry;
+
+/** \def COORD_TRANSFORM_CACHE_SIZE gdalinh.h
+    \brief The count of spatial reference pairs kept in wxGISCoordinateTransformationCache
+*/
+#define COORD_TRANSFORM_CACHE_SIZE 32
+
+/** @class wxGISCoordinateTransformationCache
+
+    The process wide cache of coordinate transformations keyed by the source and the target OGRSpatialReference pointers.
+    The cache holds the references to both spatial references, so the pointers can not be reused while cached.
+    The transformation is not thread safe, so each one is used by one thread at a time and the concurrent threads get own instances.
+
+    @library{datasource}
+*/
+
+class WXDLLIMPEXP_GIS_DS wxGISCoordinateTransformationCache
+{
+public:
+    /** \fn bool Transform(OGRGeometry* poGeom, OGRSpatialReference* poDstSRS)
+     *  \brief Transform the geometry from its spatial reference to the target one as OGRGeometry::transformTo
+     */
+    static bool Transform(OGRGeometry* poGeom, OGRSpatialReference* poDstSRS);
+    /** \fn size_t Transform(wxVector<wxGISGeometry> &aGeometries, OGRSpatialReference* poDstSRS)
+     *  \brief Transform the coordinates of all geometries with the same spatial reference by one call.
+     *  \param aGeometries The geometries to transform. The geometries failed to transform are replaced by invalid one.
+     *  \param poDstSRS The target spatial reference
+     *  \return The count of transformed geometries
+     */
+    static size_t Transform(wxVector<wxGISGeometry> &aGeometries, OGRSpatialReference* poDstSRS);
+    /** \fn OGRCoordinateTransformation* Acquire(OGRSpatialReference* poSrcSRS, OGRSpatialReference* poDstSRS)
+     *  \brief Get the cached or new transformation for exclusive use. The transformation should be returned by Release.
+     *  \return The transformation or NULL if the spatial references can not be transformed
+     */
+    static OGRCoordinateTransformation* Acquire(OGRSpatialReference* poSrcSRS, OGRSpatialReference* poDstSRS);
+    static void Release(OGRCoordinateTransformation* poCT);
+    static void Clear(void);
+protected:
+    typedef struct _transformation
+    {
+        OGRSpatialReference* poSrcSRS;
+        OGRSpatialReference* poDstSRS;
+        OGRCoordinateTransformation* poCT;  //NULL if creation failed
+        bool bInUse;
+    } TRANSFORMATION;
+
+    /** \fn void Purge(size_t nMaxCount)
+     *  \brief Remove the unused transformations if the cache size reached the max count. The lock should be entered.
+     */
+    static void Purge(size_t nMaxCount);
+    static bool GetPoints(OGRGeometry* poGeom, wxVector<double> &adfX, wxVector<double> &adfY, wxVector<double> &adfZ);
+    static void SetPoints(OGRGeometry* poGeom, const wxVector<double> &adfX, const wxVector<double> &adfY, const wxVector<double> &adfZ, size_t &nPoint);
+protected:
+    static wxCriticalSection m_CritSect;
+    static wxVector<TRANSFORMATION> m_astTransformations;
+};
@@ -0,0 +1,120 @@
+/******************************************************************************
+ * Project:  wxGIS
+ * Purpose:  wxGISSpatialIndexFile class. The spatial tree items stored on disk.
+ * Author:   Dmitry Baryshnikov (aka Bishop), polimax@mail.ru
+ ******************************************************************************
+*   Copyright (C) 2014 Dmitry Baryshnikov
+*
+*    This program is free software: you can redistribute it and/or modify
+*    it under the terms of the GNU General Public License as published by
+*    the Free Software Foundation, either version 2 of the License, or
+*    (at your option) any later version.
+*
+*    This program is distributed in the hope that it will be useful,
+*    but WITHOUT ANY WARRANTY; without even the implied warranty of
+*    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+*    GNU General Public License for more details.
+*
+*    You should have received a copy of the GNU General Public License
+*    along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ ****************************************************************************/
+#pragma once
+
+#include "wxgis/datasource/spatialtree.h"
+
+#if GDAL_VERSION_NUM >= 1110000
+#include "cpl_virtualmem.h"
+#endif
+
+/** \def SPATIAL_INDEX_FILE_EXT spatialindexfile.h
+    \brief The spatial index sidecar file extension
+*/
+#define SPATIAL_INDEX_FILE_EXT wxT("wxsidx")
+/** \def SPATIAL_INDEX_CACHE_SIZE spatialindexfile.h
+    \brief The default size limit of the sidecar files directory in megabytes
+*/
+#define SPATIAL_INDEX_CACHE_SIZE 512
+
+class wxGISSpatialIndexFile;
+
+/** @class wxGISSpatialIndexFileData
+
+    The spatial tree item which geometry is read from the spatial index file on first request.
+
+    @library{datasource}
+*/
+
+class WXDLLIMPEXP_GIS_DS wxGISSpatialIndexFileData : public wxGISSpatialTreeData
+{
+public:
+    wxGISSpatialIndexFileData(wxGISSpatialIndexFile* const pIndexFile, long nFID, const OGREnvelope &Env, const GByte* pabyWKB, size_t nWKBSize);
+    virtual ~wxGISSpatialIndexFileData();
+	virtual wxGISGeometry GetGeometry(void) const;
+	virtual void SetGeometry(const wxGISGeometry &oGeom);
+    virtual OGREnvelope GetEnvelope(void) const;
+    virtual wxGISSpatialTreeData* Clone() const;
+protected:
+    wxGISSpatialIndexFile* m_pIndexFile;
+    OGREnvelope m_Env;
+    const GByte* m_pabyWKB; //NULL after the geometry is created
+    size_t m_nWKBSize;
+};
+
+/** @class wxGISSpatialIndexFile
+
+    The sidecar file with FID, envelope and WKB of each spatial tree item.
+
+    The file is mapped read only (or read at once if memory mapping is not available) and the items are created without reading the source dataset.
+    The file header stores the source key (path, layer name, modification time and size), the file is valid only for the same key.
+    The items geometries are created on first request and reference the file memory, so the file object should outlive the items.
+
+    @library{datasource}
+*/
+
+class WXDLLIMPEXP_GIS_DS wxGISSpatialIndexFile
+{
+public:
+    wxGISSpatialIndexFile(const wxGISSpatialReference &SpatialReference);
+    virtual ~wxGISSpatialIndexFile(void);
+    /** \fn bool Open(const wxString &sPath, const wxString &sSourceKey)
+     *  \brief Map the file and check the header.
+     *  \param sPath The sidecar file path
+     *  \param sSourceKey The source key the file should be created for
+     *  \return true if the file is valid
+     */
+    virtual bool Open(const wxString &sPath, const wxString &sSourceKey);
+    virtual bool IsOpened(void) const;
+    virtual size_t GetItemCount(void) const;
+    /** \fn wxGISSpatialTreeData* CreateItem(size_t nIndex)
+     *  \brief Create the spatial tree item. The caller own the returned pointer.
+     */
+    virtual wxGISSpatialTreeData* CreateItem(size_t nIndex);
+    virtual wxGISGeometry CreateGeometry(const GByte* pabyWKB, size_t nWKBSize) const;
+    wxCriticalSection &GetLock(void) { return m_CritSect; };
+    /** \fn static bool Create(const wxString &sPath, const wxString &sSourceKey, const wxGISSpatialTreeCursor &Cursor, wxThread* const pThread)
+     *  \brief Write the spatial tree items to the sidecar file. The file is written to the temporary file and renamed on success.
+     *  \param pThread The thread to test the cancel or NULL
+     */
+    static bool Create(const wxString &sPath, const wxString &sSourceKey, const wxGISSpatialTreeCursor &Cursor, wxThread* const pThread = NULL);
+    /** \fn static void CleanUp(const wxString &sDir, wxULongLong nMaxSize, const wxString &sKeepPath)
+     *  \brief Remove the least recently used sidecar files and the left temporary files until the directory size is not greater than the limit.
+     *  \param sDir The sidecar files directory
+     *  \param nMaxSize The directory size limit in bytes
+     *  \param sKeepPath The file which should not be removed (just created or opened) or empty string
+     */
+    static void CleanUp(const wxString &sDir, wxULongLong nMaxSize, const wxString &sKeepPath = wxEmptyString);
+protected:
+    virtual void Close(void);
+protected:
+    VSILFILE* m_fp;
+#if GDAL_VERSION_NUM >= 1110000
+    CPLVirtualMem* m_pVirtualMem;
+#endif
+    GByte* m_pabyData;
+    bool m_bOwnData;
+    size_t m_nDataSize;
+    size_t m_nItemCount;
+    const GByte* m_pabyRecords;
+    wxGISSpatialReference m_SpatialReference;
+    wxCriticalSection m_CritSect;
+};
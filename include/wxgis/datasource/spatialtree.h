@@ -25,8 +25,10 @@
 
 #include "wx/thread.h"
 #include <wx/list.h>
+#include <wx/msgqueue.h>
 
 class wxGISFeatureDataset;
+class wxGISSpatialIndexFile;
 
 /** @class wxGISSpatialTreeData
 
@@ -44,6 +46,7 @@ public:
 	virtual long GetFID(void) const;
 	virtual wxGISGeometry GetGeometry(void) const;
 	virtual void SetGeometry(const wxGISGeometry &oGeom);
+    virtual OGREnvelope GetEnvelope(void) const;
     virtual wxGISSpatialTreeData* Clone() const;
 protected:
     wxGISGeometry m_Geom;
@@ -54,6 +57,34 @@ WX_DEFINE_ARRAY_WITH_DECL_PTR(wxGISSpatialTreeData*, wxGISSpatialTreeCursor, cla
 
 extern WXDLLIMPEXP_DATA_GIS_DS(wxGISSpatialTreeCursor) wxNullSpatialTreeCursor;
 
+/** \struct PRELOADBATCH spatialtree.h
+    \brief The batch of spatial tree items passed to the projection thread.
+*/
+typedef struct _preloadbatch
+{
+    wxVector<wxGISSpatialTreeData*> paData;
+    wxVector<bool> abShared; //the item geometry is shared with the buffered feature and should be copied before project
+} PRELOADBATCH;
+
+/** @class wxGISGeometryProjectThread
+
+    The thread projecting the geometries of spatial tree items batches. The batches are received from input queue and posted to output queue. The thread exits on NULL batch.
+
+    @library{datasource}
+*/
+
+class wxGISGeometryProjectThread : public wxThread
+{
+public:
+    wxGISGeometryProjectThread(wxMessageQueue<PRELOADBATCH*> &InQueue, wxMessageQueue<PRELOADBATCH*> &OutQueue, OGRCoordinateTransformation* poCT);
+    virtual ~wxGISGeometryProjectThread();
+    virtual void *Entry();
+protected:
+    wxMessageQueue<PRELOADBATCH*> &m_InQueue;
+    wxMessageQueue<PRELOADBATCH*> &m_OutQueue;
+    OGRCoordinateTransformation* m_poCT;
+};
+
 /** @class wxGISSpatialTree
 
     A abstract class for spatial tree implementations.
@@ -77,17 +108,39 @@ public:
     virtual wxGISSpatialTreeCursor Search(const OGREnvelope& env) = 0;
     virtual void Insert(wxGISSpatialTreeData* pData) = 0;
     virtual bool HasFID(long nFID) const = 0;
+    /** \fn void BeginBulkLoad(void)
+        \brief The tree may collect the inserted items and build the index at once in EndBulkLoad. Called before the full scan of dataset.
+    */
+    virtual void BeginBulkLoad(void);
+    virtual void EndBulkLoad(void);
 protected:
     virtual wxThread::ExitCode Entry();
+    /** \fn wxString GetIndexFileKey(void) const
+        \brief The source key (path, layer name, modification time and size) of spatial index file or empty string if the dataset is not a file or the tree is projected or filtered.
+    */
+    virtual wxString GetIndexFileKey(void) const;
+    virtual wxString GetIndexFilePath(void) const;
+    virtual bool LoadIndexFile(void);
+    virtual bool SaveIndexFile(void);
+    virtual void StartProjectThreads(wxVector<wxGISGeometryProjectThread*> &paThreads, wxMessageQueue<PRELOADBATCH*> &InQueue, wxMessageQueue<PRELOADBATCH*> &OutQueue);
+    virtual void StopProjectThreads(wxVector<wxGISGeometryProjectThread*> &paThreads, wxMessageQueue<PRELOADBATCH*> &InQueue, wxMessageQueue<PRELOADBATCH*> &OutQueue, PRELOADBATCH* &pBatch, size_t &nBatchesInWork);
+    /** \fn size_t AddProjectedBatches(wxMessageQueue<PRELOADBATCH*> &OutQueue, size_t nMaxCount, bool bWait)
+        \brief Insert the items of projected batches to the tree and post wxDS_FEATURES_ADDED for each batch.
+        \param bWait Wait for the first batch if no batch is ready
+        \return The count of added batches
+    */
+    virtual size_t AddProjectedBatches(wxMessageQueue<PRELOADBATCH*> &OutQueue, size_t nMaxCount, bool bWait);
 protected:
     wxGISFeatureDataset* m_pDSet;
     long m_nReadPos;
     short m_nPreloadItemCount;
 protected:
     bool m_bIsLoaded;
-   	wxCriticalSection m_CritSect;
+   	mutable wxCriticalSection m_CritSect;
     wxGISSpatialReference m_SpatialReference;
     ITrackCancel* m_pTrackCancel;
+    wxGISSpatialIndexFile* m_pIndexFile;
+    bool m_bUseIndexFile;
 };
 
 /** @fn wxGISSpatialTree* CreateSpatialTree(void)
@@ -103,6 +156,15 @@ WXDLLIMPEXP_GIS_DS wxGISSpatialTree* CreateSpatialTree(wxGISFeatureDataset *pDS)
 #define RTREE_REINSERT_P 0.30
 #define RTREE_CHOOSE_SUBTREE_P 32
 
+/** \def RTREE_BULK_CHUNK_SIZE spatialtree.h
+    \brief The count of items loaded in bulk which are packed to the searchable subtree until the end of bulk load.
+*/
+#define RTREE_BULK_CHUNK_SIZE 4096
+/** \def RTREE_BULK_INSERT_RATIO spatialtree.h
+    \brief The items loaded in bulk to the not empty tree are inserted one by one if the tree has more items in this ratio, otherwise the whole tree is packed again.
+*/
+#define RTREE_BULK_INSERT_RATIO 4
+
 /** @class wxGISRTreeNode
 
     The node for storing other nodes or geodata.
@@ -132,13 +194,23 @@ public:
     } SPLIT_DIR;
 protected:
     void Search(wxGISSpatialTreeCursor &Cursor, const OGREnvelope& env);
+    /** \fn void PackBounds(void)
+        \brief Copy the children bounds to the contiguous MinX, MaxX, MinY, MaxY arrays and the leaf data pointers to the array to test them in Search without touching the children.
+    */
+    void PackBounds(void);
+    /** \fn void SetPackDirty(void)
+        \brief Mark the packed bounds of node to rebuild, the parents are marked to find the node in PackDirty.
+    */
+    void SetPackDirty(void);
+    /** \fn void PackDirty(void)
+        \brief Rebuild the packed bounds of changed nodes of subtree. Called at the end of insert or delete, so Search only reads them.
+    */
+    void PackDirty(void);
     void GetAll(wxGISSpatialTreeCursor &Cursor);
-    bool Remove(long nFID);
-    bool HasFID(long nFID) const;
     double GetArea() const;
     void StretchBounds(const OGREnvelope &Env);
     wxGISRTreeNode* ChooseSubtree(const OGREnvelope &Env, enumChooseSubteeType eType);
-    OGREnvelope GetBounds() const;
+    const OGREnvelope &GetBounds() const;
     size_t GetCount() const;
     bool GetHasLeaves() const;
     void SetHasLeaves(bool bHasLeaves);
@@ -171,15 +243,17 @@ protected:
 
 	    bool operator() (const wxGISRTreeNode * const n1, const wxGISRTreeNode * const n2) const
 	    {
-            OGREnvelope IntersectEnv = n1->GetBounds();
-            IntersectEnv.Intersect(m_Env);
-            double dfArea1 = fabs((IntersectEnv.MaxX - IntersectEnv.MinX) * (IntersectEnv.MaxY - IntersectEnv.MinY));
-            IntersectEnv = n2->GetBounds();
-            IntersectEnv.Intersect(m_Env);
-            double dfArea2 = fabs((IntersectEnv.MaxX - IntersectEnv.MinX) * (IntersectEnv.MaxY - IntersectEnv.MinY));
-
-		    return dfArea1 < dfArea2;
+		    return GetIntersectArea(n1->GetBounds()) < GetIntersectArea(n2->GetBounds());
 	    }
+
+        double GetIntersectArea(const OGREnvelope &Env) const
+        {
+            double dfWidth = wxMin(Env.MaxX, m_Env.MaxX) - wxMax(Env.MinX, m_Env.MinX);
+            double dfHeight = wxMin(Env.MaxY, m_Env.MaxY) - wxMax(Env.MinY, m_Env.MinY);
+            if(dfWidth < 0 || dfHeight < 0)
+                return 0;
+            return dfWidth * dfHeight;
+        }
     };
 
     struct SortBoundedItemsByDistanceFromCenter : public std::binary_function< const wxGISRTreeNode * const, const wxGISRTreeNode * const, bool >
@@ -193,21 +267,37 @@ protected:
 
         bool operator() (const wxGISRTreeNode * const n1, const wxGISRTreeNode * const n2) const
         {
-            OGREnvelope OtherEnv = n1->GetBounds();
+            const OGREnvelope &OtherEnv1 = n1->GetBounds();
             double dfXO, dfYO;
-            dfXO = (OtherEnv.MaxX - OtherEnv.MinX) / 2;
-            dfYO = (OtherEnv.MaxY - OtherEnv.MinY) / 2;
+            dfXO = (OtherEnv1.MaxX - OtherEnv1.MinX) / 2;
+            dfYO = (OtherEnv1.MaxY - OtherEnv1.MinY) / 2;
             double dfDist1 = /*std::sqrt*/((dfX - dfXO) * (dfX - dfXO) + (dfY - dfYO) * (dfY - dfYO));
 
-            OtherEnv = n2->GetBounds();
-            dfXO = (OtherEnv.MaxX - OtherEnv.MinX) / 2;
-            dfYO = (OtherEnv.MaxY - OtherEnv.MinY) / 2;
+            const OGREnvelope &OtherEnv2 = n2->GetBounds();
+            dfXO = (OtherEnv2.MaxX - OtherEnv2.MinX) / 2;
+            dfYO = (OtherEnv2.MaxY - OtherEnv2.MinY) / 2;
             double dfDist2 = /*std::sqrt*/((dfX - dfXO) * (dfX - dfXO) + (dfY - dfYO) * (dfY - dfYO));
 
             return dfDist1 < dfDist2;
         }
     };
 
+    struct SortBoundedItemsByCenter : public std::binary_function< const wxGISRTreeNode * const, const wxGISRTreeNode * const, bool >
+    {
+        const bool m_bIsX;
+        explicit SortBoundedItemsByCenter (const bool bIsX) : m_bIsX(bIsX) {}
+
+        bool operator() (const wxGISRTreeNode * const n1, const wxGISRTreeNode * const n2) const
+        {
+            //the doubled centers are compared
+            const OGREnvelope &Env1 = n1->GetBounds();
+            const OGREnvelope &Env2 = n2->GetBounds();
+            if(m_bIsX)
+                return Env1.MinX + Env1.MaxX < Env2.MinX + Env2.MaxX;
+            return Env1.MinY + Env1.MaxY < Env2.MinY + Env2.MaxY;
+        }
+    };
+
     struct SortBoundedItemsByEdge : public std::binary_function< const wxGISRTreeNode * const, const wxGISRTreeNode * const, bool >
     {
         const bool m_bIsX;
@@ -216,8 +306,8 @@ protected:
 
         bool operator() (const wxGISRTreeNode * const n1, const wxGISRTreeNode * const n2) const
         {
-            OGREnvelope Env1 = n1->GetBounds();
-            OGREnvelope Env2 = n2->GetBounds();
+            const OGREnvelope &Env1 = n1->GetBounds();
+            const OGREnvelope &Env2 = n2->GetBounds();
             if(m_bIsX)
             {
                 if(m_bIsMin)
@@ -250,8 +340,16 @@ protected:
     wxVector<wxGISRTreeNode*> m_paNodes;
     wxGISSpatialTreeData* m_pData;
     bool m_bHasLeaves;
+    //packed children bounds (MinX, MaxX, MinY, MaxY arrays one after another) and leaf data
+    wxVector<double> m_adfBounds;
+    wxVector<wxGISSpatialTreeData*> m_paPackedData;
+    bool m_bPackDirty; //the children or their bounds changed after the last PackBounds
+    bool m_bSubtreeDirty; //the node or some node of the subtree has the packed bounds to rebuild
+    wxGISRTreeNode* m_pParent;
 };
 
+WX_DECLARE_HASH_MAP(long, wxGISRTreeNode*, wxIntegerHash, wxIntegerEqual, wxGISRTreeFIDMap);
+
 /** @class wxGISRTree
 
     The wxGIS R-Tree implementation. R-trees are tree data structures used for spatial access methods, i.e., for indexing multi-dimensional information such as geographical coordinates, rectangles or polygons. The R-tree was proposed by Antonin Guttman in 1984 and has found significant use in both theoretical and applied contexts.
@@ -269,22 +367,46 @@ public:
     virtual wxGISSpatialTreeCursor Search(const OGREnvelope& env);
     virtual void Insert( wxGISSpatialTreeData* pData);
     virtual bool HasFID(long nFID) const;
+    virtual void BeginBulkLoad(void);
+    virtual void EndBulkLoad(void);
 protected:
+    virtual wxGISRTreeNode* BulkLoad(wxVector<wxGISRTreeNode*> &paNodes);
     virtual wxGISRTreeNode* ChooseSubtree(wxGISRTreeNode* pNode, const OGREnvelope &Env);
     virtual wxGISRTreeNode* InsertInternal(wxGISRTreeNode* pInsertNode, wxGISRTreeNode * pStartNode, bool bIsFirstInsert = true);
     virtual wxGISRTreeNode* OverflowTreatment(wxGISRTreeNode* pNode, bool bIsFirstInsert);
     virtual void Reinsert(wxGISRTreeNode* pNode);
     virtual wxGISRTreeNode* Split(wxGISRTreeNode* pNode);
+    /** \fn void RemoveNode(wxGISRTreeNode* pNode)
+        \brief Detach the data node from its parent and delete the parent nodes became empty. The data node is kept in removed nodes array as the search cursors may point to its data.
+    */
+    virtual void RemoveNode(wxGISRTreeNode* pNode);
+    /** \fn void DetachLeaves(wxGISRTreeNode* pNode, wxVector<wxGISRTreeNode*> &paNodes)
+        \brief Move the data nodes of the subtree to the array and delete the upper nodes of the subtree except the pNode.
+    */
+    virtual void DetachLeaves(wxGISRTreeNode* pNode, wxVector<wxGISRTreeNode*> &paNodes);
 protected:
     wxGISRTreeNode* m_pRoot;
     unsigned short m_nMaxChildItems;
     unsigned short m_nMinChildItems;
+    bool m_bBulkLoad;
+    wxVector<wxGISRTreeNode*> m_paBulkNodes;
+    wxVector<wxGISRTreeNode*> m_paBulkChunks;
+    size_t m_nItemCount;
+    wxGISRTreeFIDMap m_mFIDIndex;
+    wxVector<wxGISRTreeNode*> m_paRemovedNodes;
 };
 
 #include "cpl_quad_tree.h"
 
 void GetGeometryBoundsFunc(const void* hFeature, CPLRectObj* pBounds);
 
+WX_DECLARE_HASH_MAP(long, size_t, wxIntegerHash, wxIntegerEqual, wxGISFIDIndexMap);
+
+/** \def QUADTREE_COMPACT_MIN spatialtree.h
+    \brief The minimum count of removed items to rebuild the quad tree. The tree is rebuilt if removed items are more than quarter of all items.
+*/
+#define QUADTREE_COMPACT_MIN 1024
+
 
 /** \class wxGISQuadTree
 
@@ -306,8 +428,12 @@ public:
 protected:
     void CreateQuadTree();
     void DestroyQuadTree();
+    void Compact();
 protected:
     CPLQuadTree* m_pQuadTree;
     wxGISSpatialTreeCursor m_Cursor;
     OGREnvelope m_Envelope;
+    wxGISFIDIndexMap m_mFIDIndex;
+    size_t m_nRemovedCount;
+    wxVector<wxGISSpatialTreeData*> m_paRemovedData;
 };
@@ -24,6 +24,8 @@
 #include "wxgis/datasource/cursor.h"
 #include "wxgis/datasource/filter.h"
 #include "wxgis/datasource/spatialtree.h"
+#include "wxgis/datasource/columnstore.h"
+#include "wxgis/datasource/attrindex.h"
 #include "wxgis/core/pointer.h"
 
 /** @class wxGISTable
@@ -40,6 +42,8 @@ class WXDLLIMPEXP_GIS_DS wxGISTable :
 {
     DECLARE_CLASS(wxGISTable)
     friend class wxGISSpatialTree;
+    friend class wxFeatureLayerStream;
+    friend class wxFeatureStoreStream;
 public:
 	wxGISTable(const CPLString &sPath, int nSubType, OGRLayer* poLayer = NULL, OGRCompatibleDataSource* poDS = NULL);
 	virtual ~wxGISTable(void);
@@ -84,15 +88,40 @@ public:
     virtual wxString GetFieldName(int nIndex) const;
     //
     virtual wxFeatureCursor Search(const wxGISQueryFilter &QFilter = wxGISNullQueryFilter, bool bOnlyFirst = false, ITrackCancel* const pTrackCancel = NULL);
+    /** \fn wxFeatureStream* SearchStream(const wxGISQueryFilter &QFilter, size_t nBatchSize, ITrackCancel* const pTrackCancel)
+     *  \brief Create the stream of features matching the filter. The features are read by batches while the stream is consumed.
+     *  \param QFilter The attribute filter
+     *  \param nBatchSize The count of features fetched at once
+     *  \param pTrackCancel The cancel tracker or NULL
+     *  \return The stream (the caller own the pointer) or NULL
+     */
+    virtual wxFeatureStream* SearchStream(const wxGISQueryFilter &QFilter = wxGISNullQueryFilter, size_t nBatchSize = FEATURE_STREAM_BATCH_SIZE, ITrackCancel* const pTrackCancel = NULL);
     virtual OGRErr SetFilter(const wxGISQueryFilter &QFilter = wxGISNullQueryFilter);
     virtual OGRErr SetIgnoredFields(const wxArrayString &saIgnoredFields);
 	virtual OGRCompatibleDataSource* const GetDataSourceRef(void) const {return m_poDS;};
     virtual OGRLayer* const GetLayerRef(int iLayer = 0) const {return m_poLayer;};
 	virtual OGRFeatureDefn* const GetDefinition(void);
 	virtual OGRFeatureDefn* const GetDefinition(void) const;
+    //attribute indexes
+    /** \fn wxGISAttributeIndex* const GetAttributeIndex(int nField, bool bCreate, ITrackCancel* const pTrackCancel)
+     *  \brief Get the field index. The index is owned by table and updated by StoreFeature, SetFeature and DeleteFeature.
+     *  \param nField The field index
+     *  \param bCreate Create the index if not exist (full scan)
+     *  \param pTrackCancel The cancel tracker or NULL
+     *  \return The index or NULL if the index not exist or the field type is not supported
+     */
+    virtual wxGISAttributeIndex* const GetAttributeIndex(int nField, bool bCreate = true, ITrackCancel* const pTrackCancel = NULL);
+    virtual void DeleteAttributeIndexes(void);
 protected:
     virtual void SetInternalValues(void);
  	virtual bool IsContainer() const;
+    virtual bool FillAttributeIndex(wxGISAttributeIndex* const pIndex, ITrackCancel* const pTrackCancel);
+    virtual void UpdateAttributeIndexes(long nFID, OGRFeature* const poFeature);
+    /** \fn bool SelectByIndex(const wxGISQueryFilter &QFilter, wxVector<long> &anFIDs, ITrackCancel* const pTrackCancel)
+     *  \brief Get the FIDs from the attribute index if the where clause is the compare of one field
+     *  \return false if index cannot be used
+     */
+    virtual bool SelectByIndex(const wxGISQueryFilter &QFilter, wxVector<long> &anFIDs, ITrackCancel* const pTrackCancel);
 protected:
 	OGRCompatibleDataSource* m_poDS;
 	OGRLayer* m_poLayer;
@@ -106,6 +135,10 @@ protected:
     bool m_bOLCFastFeatureCount;
     bool m_bHasFID;
     bool m_bHasFilter;
+    wxString m_sFilter;
+
+    std::map<int, wxGISAttributeIndex*> m_omAttributeIndexes;
+    std::map<int, int> m_omAttributeLookups;
 };
 
 //#define MAXSTRINGSTORE 1000000
@@ -122,6 +155,7 @@ class WXDLLIMPEXP_GIS_DS wxGISTableCached :
     public wxGISTable
 {
     DECLARE_CLASS(wxGISTableCached)
+    friend class wxFeatureStoreStream;
 public:
 	wxGISTableCached(const CPLString &sPath, int nSubType, OGRLayer* poLayer = NULL, OGRCompatibleDataSource* poDS = NULL);
 	virtual ~wxGISTableCached(void);
@@ -140,9 +174,18 @@ public:
 	virtual OGRErr DeleteFeature(long nFID);
     virtual OGRErr StoreFeature(wxGISFeature &Feature);
     virtual OGRErr SetFeature(const wxGISFeature &Feature);
-    virtual wxFeatureCursor Search(const wxGISQueryFilter &QFilter = wxGISNullQueryFilter, bool bOnlyFirst = false, ITrackCancel* const pTrackCancel = NULL);
+    virtual wxFeatureStream* SearchStream(const wxGISQueryFilter &QFilter = wxGISNullQueryFilter, size_t nBatchSize = FEATURE_STREAM_BATCH_SIZE, ITrackCancel* const pTrackCancel = NULL);
+protected:
+    virtual bool FillAttributeIndex(wxGISAttributeIndex* const pIndex, ITrackCancel* const pTrackCancel);
+    /** \fn void DeleteColumnStore(void)
+     *  \brief Delete the column store. The open store streams see the new revision and end.
+     */
+    virtual void DeleteColumnStore(void);
 protected:
     std::map<long, wxGISFeature> m_omFeatures;
+    wxGISFeatureColumnStore* m_pColumnStore;
+    long m_nColumnStoreRevision;
+    bool m_bUseColumnStore;
     bool m_bIsCaching;
 };
 
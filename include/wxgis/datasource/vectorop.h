@@ -97,3 +97,11 @@ WXDLLIMPEXP_GIS_DS void MoveEnvelope(OGREnvelope &MoveEnv, const OGREnvelope &En
  *  \return Geometry
  */
 WXDLLIMPEXP_GIS_DS wxGISGeometry EnvelopeToGeometry(const OGREnvelope &Env, const wxGISSpatialReference &SpaRef = wxNullSpatialReference);
+
+/** \fn wxGISGeometry SimplifyGeometry(const wxGISGeometry &Geom, double dfTolerance)
+ *  \brief Simplify the lines and polygon rings by Douglas-Peucker algorithm.
+ *  \param Geom Input geometry
+ *  \param dfTolerance The maximum distance of removed vertex from the simplified line
+ *  \return The 2D simplified geometry, or the input geometry if it cannot be simplified
+ */
+WXDLLIMPEXP_GIS_DS wxGISGeometry SimplifyGeometry(const wxGISGeometry &Geom, double dfTolerance);
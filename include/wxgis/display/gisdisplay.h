@@ -44,6 +44,12 @@ class WXDLLIMPEXP_GIS_DSP wxGISDisplay
 {
 public:
 	wxGISDisplay(void);
+    /** \fn wxGISDisplay(wxGISDisplay* const pParentDisplay)
+        \brief Create the offscreen display with one transparent cache and the bounds, rotation and transform of the parent display.
+
+        Used by the worker threads to draw the part of layer in parallel. The result is painted to the parent display by MergeDisplay.
+    */
+	wxGISDisplay(wxGISDisplay* const pParentDisplay);
 	virtual ~wxGISDisplay(void);
 	//
 	virtual size_t AddCache(void);
@@ -58,6 +64,7 @@ public:
 	virtual void SetUpperCachesDerty(size_t nFromCacheNo, bool bIsDerty = true);
 	virtual bool IsDerty(void) const;
     virtual size_t GetCacheCount(void) const {return m_saLayerCaches.size();};
+    virtual wxSize GetCacheSize(void) const {return wxSize(m_nMax_X, m_nMax_Y);};
     virtual void ClearCache(size_t nCacheId);
 
 	//frame
@@ -95,6 +102,10 @@ public:
 	virtual bool DrawPointFast(double dX, double dY, double dOffsetX = 0, double dOffsetY = 0);
 	virtual bool DrawLine(OGRRawPoint* pOGRRawPoints, int nPointCount, bool bOwn = true, double dOffsetX = 0, double dOffsetY = 0, bool bIsRing = false);
 	virtual void DrawRaster(cairo_surface_t *surface, const OGREnvelope& Envelope, bool bDrawEnvelope = false);
+    /** \fn void MergeDisplay(wxGISDisplay* const pDisplay)
+        \brief Paint the current cache of the offscreen display over the current cache
+    */
+	virtual void MergeDisplay(wxGISDisplay* const pDisplay);
 
 	virtual OGREnvelope TransformRect(wxRect &rect);
 	//Testing
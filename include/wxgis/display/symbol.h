@@ -40,9 +40,11 @@ class WXDLLIMPEXP_GIS_DSP wxGISSymbol :
 public:
     wxGISSymbol();
     wxGISSymbol(const wxGISColor& Color);
+    wxGISSymbol(const wxGISSymbol& Symbol);
     virtual ~wxGISSymbol();
     virtual void SetupDisplay(wxGISDisplay* const pDisplay);
     virtual void Draw(const wxGISGeometry &Geometry, int nLevel = 0) = 0;
+    virtual wxGISSymbol* Clone() const = 0;
     virtual wxGISColor GetColor() const;
     virtual void SetColor(const wxGISColor& Color);
 protected:
@@ -44,6 +44,10 @@ enum wxGISEnumGISSkipGeometry
 /**
     Copy rows from one format (file) to another.
 
+    The features are stored in transactions of wxGISCommon/gp/copy_batch_size features (the caller should not start the transaction).
+    The fields of the same type and encoding are copied as raw OGRField values.
+    The features of big feature dataset are created (projected, coerced and recoded) by several threads and stored in the source order.
+
     @return True if success, false otherwise
 
     @library{gp}
@@ -27,6 +27,8 @@
 #include <curl/curl.h>
 #include <stdlib.h>
 #include <wx/file.h>
+#include <string>
+#include <map>
 
 typedef struct _perform_result
 {
@@ -37,6 +39,48 @@ typedef struct _perform_result
 	long nHTTPCode;
 } PERFORMRESULT;
 
+/** \def CURL_POOL_MAX_FREE_HANDLES curl.h
+    \brief The max count of the free cURL handles kept in wxGISCurlPool
+*/
+#define CURL_POOL_MAX_FREE_HANDLES 8
+
+/** @class wxGISCurlPool
+
+    The process wide pool of cURL handles. The easy handles are reused, so their connections stay alive.
+    For each host the share is created to use the same DNS cache, SSL sessions and (libcurl 7.57 and later) connections by all handles.
+
+    @library{net}
+  */
+
+class WXDLLIMPEXP_GIS_NET wxGISCurlPool
+{
+public:
+    /** \fn CURL* GetHandle(void)
+     *  \brief Get the free handle or create new one. The handle should be returned by ReleaseHandle.
+     */
+    static CURL* GetHandle(void);
+    static void ReleaseHandle(CURL* pCurl);
+    /** \fn void SetShare(CURL* pCurl, const wxString &sURL)
+     *  \brief Attach the share of URL host to the handle. The handle should not be in use.
+     */
+    static void SetShare(CURL* pCurl, const wxString &sURL);
+    static void Cleanup(void);
+protected:
+    typedef struct _share
+    {
+        CURLSH* pShare;
+        wxCriticalSection aLocks[CURL_LOCK_DATA_LAST];
+    } SHARE;
+
+    static void LockShare(CURL *pCurl, curl_lock_data eData, curl_lock_access eAccess, void *pUserPtr);
+    static void UnlockShare(CURL *pCurl, curl_lock_data eData, void *pUserPtr);
+    static wxString GetHost(const wxString &sURL);
+protected:
+    static wxCriticalSection m_CritSect;
+    static wxVector<CURL*> m_paFreeHandles;
+    static std::map<wxString, SHARE*> m_mShares;
+};
+
 /** @class wxGISCurl
 
     A smart class for cURL handler
@@ -202,4 +246,87 @@ protected:
     }
 };
 
+/** \def CURL_MULTI_MAX_CONNECTIONS curl.h
+    \brief The default count of concurrent requests of wxGISCurlMulti (wxGISCommon/curl/max_connections)
+*/
+#define CURL_MULTI_MAX_CONNECTIONS 4
+
+/** \def CURL_MULTI_RETRY_COUNT curl.h
+    \brief The default count of wxGISCurlMulti request repeats (wxGISCommon/curl/retry_count). The idempotent requests are repeated on connection error or 5xx code, POST and PATCH only if the request was not sent.
+*/
+#define CURL_MULTI_RETRY_COUNT 2
+
+/** \enum wxGISEnumHTTPMethod curl.h
+    \brief The HTTP request method
+*/
+enum wxGISEnumHTTPMethod
+{
+    enumGISHTTPGet = 0,
+    enumGISHTTPPost,
+    enumGISHTTPPut,
+    enumGISHTTPPatch,
+    enumGISHTTPDelete
+};
+
+/** @class wxGISCurlMulti
+
+    The set of HTTP requests performed concurrently by cURL multi interface. The easy handles are taken from wxGISCurlPool and share the connections of the host with the other requests.
+    The headers, proxy and timeouts are the same as in wxGISCurl.
+
+    @library{net}
+  */
+
+class WXDLLIMPEXP_GIS_NET wxGISCurlMulti
+{
+public:
+    wxGISCurlMulti(void);
+    virtual ~wxGISCurlMulti(void);
+    bool IsOk() const;
+    virtual void AppendHeader(const wxString & sHeadStr);
+    /** \fn size_t Add(wxGISEnumHTTPMethod eMethod, const wxString & sURL, const wxString & sPostData)
+     *  \brief Add the request to perform
+     *  \return The request index to get result
+     */
+    virtual size_t Add(wxGISEnumHTTPMethod eMethod, const wxString & sURL, const wxString & sPostData = wxEmptyString);
+    /** \fn bool Perform(ITrackCancel* const pTrackCancel)
+     *  \brief Perform the added requests which are not done yet. The failed requests are repeated if CanRetry returns true.
+     *  \return false if cancelled
+     */
+    virtual bool Perform(ITrackCancel* const pTrackCancel = NULL);
+    virtual size_t GetCount(void) const;
+    virtual PERFORMRESULT GetResult(size_t nIndex) const;
+    virtual void Clear(void);
+    virtual int GetMaxConnections(void) const { return m_nMaxConnections; };
+protected:
+    typedef struct _request
+    {
+        wxGISEnumHTTPMethod eMethod;
+        std::string sURL;
+        std::string sPostData;
+        std::string sHead;
+        std::string sBody;
+        CURL* pCurl;
+        int nTry;
+        bool bDone;
+        PERFORMRESULT stResult;
+    } REQUEST;
+
+    virtual CURL* StartRequest(REQUEST &stRequest);
+    virtual void FinishRequest(REQUEST &stRequest, long nHTTPCode, CURLcode eCode);
+    /** \fn bool CanRetry(const REQUEST &stRequest, long nHTTPCode, CURLcode eCode) const
+     *  \brief The GET, PUT and DELETE requests may be repeated on any connection error or 5xx code. The POST and PATCH requests are not idempotent (e.g. NGW creates the features by PATCH) and are repeated only if the connection was not established, as the server may have applied the timed out or failed request.
+     */
+    virtual bool CanRetry(const REQUEST &stRequest, long nHTTPCode, CURLcode eCode) const;
+    static size_t WriteData(void *ptr, size_t size, size_t nmemb, void *data);
+protected:
+    CURLM* m_pMulti;
+    wxVector<CURL*> m_paFreeHandles;
+    wxVector<REQUEST> m_astRequests;
+    struct curl_slist *m_pSList;
+    wxString m_sProxy;
+    int m_nDNSCacheTimeout, m_nTimeout, m_nConnTimeout;
+    bool m_bSSLVerify;
+    int m_nMaxConnections, m_nRetryCount;
+};
+
 #endif //wxGIS_USE_CURL
@@ -27,9 +27,14 @@
 
 #include <wx/dynarray.h>
 #include <wx/thread.h>
+
+#include <map>
+
 #define SUBTSKDIR wxT("subtasks")
+#define TASK_SAVE_DELAY 1000 //ms
 
 class wxGISTaskBase;
+class wxGISTask;
 WX_DECLARE_HASH_MAP( int, wxGISTaskBase*, wxIntegerHash, wxIntegerEqual, wxGISTaskMap );
 
 enum wxGISEnumTaskChangeType{
@@ -41,6 +46,41 @@ enum wxGISEnumTaskChangeType{
 };
 
 
+/** @class wxGISTaskStoreWriter
+
+    The write-behind storage of the task configs. The configs stored to the same path are joined and written by the thread once in the delay. The config is written to the temporary file and renamed. The config equal to the last written one is not rewritten.
+
+    @library{gp}
+*/
+
+class wxGISTaskStoreWriter :
+    public wxThread
+{
+public:
+    wxGISTaskStoreWriter(int nDelay = TASK_SAVE_DELAY);
+    virtual ~wxGISTaskStoreWriter(void);
+    virtual bool Store(const wxString &sPath, const wxString &sJSONText);
+    virtual void Forget(const wxString &sPath);
+    virtual void Flush(void);
+    virtual void Shutdown(void);
+    static bool Write(const wxString &sPath, const wxString &sJSONText);
+    static wxGISTaskStoreWriter* const GetWriter(bool bCreate = true);
+    static void Cleanup(void);
+protected:
+    virtual ExitCode Entry();
+protected:
+    std::map<wxString, wxString> m_mPending, m_mWritten;
+    wxCriticalSection m_CritSect;
+    //held while the files are written
+    wxCriticalSection m_WriteCritSect;
+    wxSemaphore m_Wakeup;
+    int m_nDelay;
+    bool m_bExit;
+    static wxGISTaskStoreWriter* m_pWriter;
+    static wxCriticalSection m_WriterCritSect;
+    static bool m_bShutdown;
+};
+
 /** @class wxGISTaskBase
 
     The base task class.
@@ -63,6 +103,9 @@ public:
     //start/stop
     virtual void OnDestroy(void);
     virtual void StartNextQueredTask(void);
+    //scheduling index, the calls are passed to the category
+    virtual void UpdateTaskIndex(wxGISTask* const pTask);
+    virtual void RemoveFromTaskIndex(wxGISTask* const pTask);
     //sorage
     virtual wxString GetNewStorePath(const wxString &sAddToName, const wxString &sSubDir = wxEmptyString );
     virtual wxString GetStorePath() const;
@@ -88,8 +131,6 @@ protected:
     wxGISTaskMap m_omSubTasks;
 };
 
-class wxGISTask;
-
 WX_DEFINE_ARRAY(wxGISTask *, wxGISQueredTasksArray);
 
 /** @class wxGISTask
@@ -127,6 +168,12 @@ public:
     virtual void OnTerminate(int pid, int status);
     virtual int GetRunningTaskCount(void) const;
     virtual void GetQueredTasks(wxGISQueredTasksArray &oaTasks);
+    virtual void GetLeafTasks(wxGISQueredTasksArray &oaTasks);
+    virtual bool HasSubTasks(void) const {return !m_omSubTasks.empty();};
+    /** \fn long GetSubTasksRevision(void) const
+        \brief The revision is changed each time the subtasks are created or loaded.
+    */
+    virtual long GetSubTasksRevision(void) const {return m_nSubTasksRevision;};
     virtual void ChangeTask(wxDword eChangeType, wxGISEnumMessageType eMessageType = enumGISMessageUnknown, const wxString &sInfoData = wxEmptyString);
     //
     virtual long Execute(void);
@@ -153,6 +200,7 @@ protected:
     virtual wxJSONValue GetStoreConfig(void);
     virtual void LoadSubTasks(const wxJSONValue& subtasks);
     virtual void OnTaskChanged(int nId);
+    virtual void OnStateChanged(void);
 protected:
     wxString m_sDescription;
     int m_nGroupId;
@@ -165,6 +213,7 @@ protected:
     //wxVector<MESSAGE> m_staMessages;
 
     bool m_bSubTasksLoaded;
+    long m_nSubTasksRevision;
     wxJSONValue m_SubTasksDesc;
 };
 
@@ -208,6 +257,8 @@ private:
 
     The tasks category class.
 
+    The category indexes the leaf tasks for the scheduling: the quered tasks are kept in the priority heap and the running tasks are counted per group id. The outdated heap items are skipped on extraction.
+
     @libray{gp}
 */
 
@@ -235,13 +286,55 @@ public:
 //    wxString GetTaskConfigPath(const wxString& sCatName);
 //    bool SetMaxExecTasks(int nMaxTaskExec, wxString &sErrMsg);
     virtual void StartNextQueredTask(void);
+    virtual void UpdateTaskIndex(wxGISTask* const pTask);
+    virtual void RemoveFromTaskIndex(wxGISTask* const pTask);
     virtual void SendNetMessage(wxGISNetCommand eCmd, wxGISNetCommandState eCmdState, wxGISMessagePriority ePrio, const wxJSONValue &val, const wxString &sMsg, long nMessageId = wxNOT_FOUND, int nUserId = wxNOT_FOUND);
     virtual void NetMessage(wxGISNetCommand eCmd, wxGISNetCommandState eCmdState, const wxJSONValue &val, long nMessageId = wxNOT_FOUND, int nUserId = wxNOT_FOUND);
     virtual void NetCommand(wxGISNetCommandState eCmdState, const wxJSONValue &val, long nMessageId = wxNOT_FOUND, int nUserId = wxNOT_FOUND);
 protected:
     virtual wxJSONValue GetStoreConfig(void);
     virtual wxGISTask* const GetQueredTask(void);
+    virtual void IndexTask(wxGISTask* const pTask);
+    virtual void UpdateLeafIndex(wxGISTask* const pTask);
+    virtual void UnindexTask(wxGISTask* const pTask);
+    virtual void RebuildQueredHeap(void);
+protected:
+    typedef struct _taskindex
+    {
+        wxGISEnumTaskStateType eState;
+        int nGroupId;
+        long nPriority;
+        long nStamp;
+    } TASKINDEX;
+
+    typedef struct _queredtask
+    {
+        long nPriority;
+        long nStamp;
+        wxGISTask* pTask;
+        //the heap top is the lowerest priority value (the high priority), the earlier stamp wins on equal priorities
+        bool operator<(const struct _queredtask &other) const
+        {
+            if(nPriority != other.nPriority)
+                return nPriority > other.nPriority;
+            return nStamp > other.nStamp;
+        }
+    } QUEREDTASK;
+
+    typedef struct _parentindex
+    {
+        long nRevision;
+        long nPriority;
+    } PARENTINDEX;
 protected:
     wxGISTaskManager* m_pTaskManager;
     wxCriticalSection m_CritSect;
+    std::map<wxGISTask*, TASKINDEX> m_mTaskIndex;
+    std::map<wxGISTask*, PARENTINDEX> m_mParentIndex;
+    //the heap of quered tasks per group id, the tasks without group are in wxNOT_FOUND heap
+    std::map<int, wxVector<QUEREDTASK> > m_mQueredHeaps;
+    size_t m_nQueredHeapSize;
+    std::map<int, int> m_mnRunningGroups;
+    int m_nRunningTaskCount, m_nQueredTaskCount;
+    long m_nIndexStamp;
 };
@@ -20,10 +20,202 @@
  ****************************************************************************/
 #include "wxgis/carto/featurelayer.h"
 #include "wxgis/carto/mxevent.h"
+#include "wxgis/core/config.h"
+#include "wxgis/core/app.h"
 
 #define STEP 3.0
 #define NOCACHEVAL 2000
 
+//----------------------------------------------------------------------------
+// wxGISGeometryLODCache
+//----------------------------------------------------------------------------
+
+static long GetPointCount(const OGRGeometry* pGeom)
+{
+    if(NULL == pGeom)
+        return 0;
+
+    switch(wkbFlatten(pGeom->getGeometryType()))
+    {
+    case wkbLineString:
+    case wkbLinearRing:
+        return ((const OGRLineString*)pGeom)->getNumPoints();
+    case wkbPolygon:
+        {
+            const OGRPolygon* pPoly = (const OGRPolygon*)pGeom;
+            long nPointCount = GetPointCount(pPoly->getExteriorRing());
+            for(int i = 0; i < pPoly->getNumInteriorRings(); ++i)
+                nPointCount += GetPointCount(pPoly->getInteriorRing(i));
+            return nPointCount;
+        }
+    case wkbMultiPoint:
+    case wkbMultiPolygon:
+    case wkbMultiLineString:
+    case wkbGeometryCollection:
+        {
+            const OGRGeometryCollection* pGeometryCollection = (const OGRGeometryCollection*)pGeom;
+            long nPointCount(0);
+            for(int i = 0; i < pGeometryCollection->getNumGeometries(); ++i)
+                nPointCount += GetPointCount(pGeometryCollection->getGeometryRef(i));
+            return nPointCount;
+        }
+    default:
+        return 1;
+    }
+}
+
+wxGISGeometryLODCache::wxGISGeometryLODCache(void)
+{
+    m_nPointCount = 0;
+    m_nMaxPointCount = LOD_MAX_POINTS;
+}
+
+wxGISGeometryLODCache::~wxGISGeometryLODCache(void)
+{
+}
+
+int wxGISGeometryLODCache::GetLevel(double dfPixelSize)
+{
+    if(dfPixelSize <= 0)
+        return LOD_LEVEL_NONE;
+    return (int)floor(log(dfPixelSize) / log(2.0));
+}
+
+wxGISGeometry wxGISGeometryLODCache::GetGeometry(const wxGISSpatialTreeData* pData, int nLevel)
+{
+    long nFID = pData->GetFID();
+    if(nFID == wxNOT_FOUND)
+        return pData->GetGeometry();
+
+    {
+        wxCriticalSectionLocker locker(m_CritSect);
+        std::map<int, LODLEVEL>::const_iterator itLevel = m_mLevels.find(nLevel);
+        if(itLevel != m_mLevels.end())
+        {
+            LODLEVEL::const_iterator it = itLevel->second.find(nFID);
+            if(it != itLevel->second.end())
+                return it->second.IsOk() ? it->second.Clone() : pData->GetGeometry();
+        }
+    }
+
+    //simplify outside the lock, the draw threads request different features
+    wxGISGeometry Geom = pData->GetGeometry();
+    wxGISGeometry SimpleGeom;
+    long nSimplePointCount(0);
+    OGRwkbGeometryType eType = wkbFlatten(Geom.GetType());
+    if(eType != wkbPoint && eType != wkbMultiPoint)
+    {
+        SimpleGeom = SimplifyGeometry(Geom, ldexp(1.0, nLevel));
+        //not store the copy if most vertices are needed at this scale
+        OGRGeometry* pSimpleGeom = SimpleGeom;
+        OGRGeometry* pGeom = Geom;
+        nSimplePointCount = GetPointCount(pSimpleGeom);
+        if(pSimpleGeom == pGeom || nSimplePointCount * 2 > GetPointCount(pGeom))
+        {
+            SimpleGeom = wxGISGeometry();
+            nSimplePointCount = 0;
+        }
+    }
+
+    wxCriticalSectionLocker locker(m_CritSect);
+    if(m_mLevels.find(nLevel) == m_mLevels.end() && m_mLevels.size() >= LOD_MAX_LEVELS)
+    {
+        //remove the band most far from the requested one
+        std::map<int, LODLEVEL>::iterator itFar = m_mLevels.begin();
+        if(abs(m_mLevels.rbegin()->first - nLevel) > abs(itFar->first - nLevel))
+            itFar = --m_mLevels.end();
+        RemoveLevel(itFar);
+    }
+
+    //free the other bands to keep the vertices count in limit, the requested band is not stored more if it is full
+    while(m_nPointCount + nSimplePointCount > m_nMaxPointCount && !m_mLevels.empty())
+    {
+        std::map<int, LODLEVEL>::iterator itFar = m_mLevels.begin();
+        if(abs(m_mLevels.rbegin()->first - nLevel) > abs(itFar->first - nLevel))
+            itFar = --m_mLevels.end();
+        if(itFar->first == nLevel)
+            break;
+        RemoveLevel(itFar);
+    }
+
+    if(m_nPointCount + nSimplePointCount <= m_nMaxPointCount)
+    {
+        LODLEVEL &Level = m_mLevels[nLevel];
+        if(Level.find(nFID) == Level.end())
+        {
+            //the cache keeps the own clone, the simplified geometry is returned to the caller
+            Level[nFID] = SimpleGeom.IsOk() ? SimpleGeom.Clone() : wxGISGeometry();
+            m_nPointCount += nSimplePointCount;
+        }
+    }
+
+    return SimpleGeom.IsOk() ? SimpleGeom : Geom;
+}
+
+void wxGISGeometryLODCache::RemoveLevel(std::map<int, LODLEVEL>::iterator it)
+{
+    for(LODLEVEL::const_iterator itGeom = it->second.begin(); itGeom != it->second.end(); ++itGeom)
+    {
+        if(itGeom->second.IsOk())
+            m_nPointCount -= GetPointCount(itGeom->second);
+    }
+    m_mLevels.erase(it);
+}
+
+void wxGISGeometryLODCache::Remove(long nFID)
+{
+    wxCriticalSectionLocker locker(m_CritSect);
+    for(std::map<int, LODLEVEL>::iterator it = m_mLevels.begin(); it != m_mLevels.end(); ++it)
+    {
+        LODLEVEL::iterator itGeom = it->second.find(nFID);
+        if(itGeom == it->second.end())
+            continue;
+        if(itGeom->second.IsOk())
+            m_nPointCount -= GetPointCount(itGeom->second);
+        it->second.erase(itGeom);
+    }
+}
+
+void wxGISGeometryLODCache::Clear(void)
+{
+    wxCriticalSectionLocker locker(m_CritSect);
+    m_mLevels.clear();
+    m_nPointCount = 0;
+}
+
+void wxGISGeometryLODCache::SetMaxPointCount(long nMaxPointCount)
+{
+    wxCriticalSectionLocker locker(m_CritSect);
+    m_nMaxPointCount = nMaxPointCount;
+}
+
+
+//----------------------------------------------------------------------------
+// wxGISFeatureLayerIngestThread
+//----------------------------------------------------------------------------
+
+wxGISFeatureLayerIngestThread::wxGISFeatureLayerIngestThread(wxGISFeatureLayer* pLayer, wxMessageQueue<FEATURELAYERBATCH*> &Queue) : wxThread(wxTHREAD_JOINABLE), m_Queue(Queue)
+{
+    m_pLayer = pLayer;
+}
+
+wxGISFeatureLayerIngestThread::~wxGISFeatureLayerIngestThread()
+{
+}
+
+void *wxGISFeatureLayerIngestThread::Entry()
+{
+    while(true)
+    {
+        FEATURELAYERBATCH* pBatch(NULL);
+        if(m_Queue.Receive(pBatch) != wxMSGQUEUE_NO_ERROR || pBatch == NULL)
+            break;
+
+        m_pLayer->IngestBatch(pBatch);
+        wxDELETE(pBatch);
+    }
+    return NULL;
+}
 
 //----------------------------------------------------------------------------
 // wxGISFeatureLayer
@@ -37,6 +229,7 @@ BEGIN_EVENT_TABLE(wxGISFeatureLayer, wxGISLayer)
 	EVT_DS_FEATURE_ADDED(wxGISFeatureLayer::OnDSFeatureAdded)
 	EVT_DS_FEATURE_DELETED(wxGISFeatureLayer::OnDSFeatureDeleted)
 	EVT_DS_FEATURE_CHANGED(wxGISFeatureLayer::OnDSFeatureChanged)
+    EVT_THREAD(INGESTED_EVENT, wxGISFeatureLayer::OnIngested)
 END_EVENT_TABLE()
 
 wxGISFeatureLayer::wxGISFeatureLayer(const wxString &sName, wxGISDataset* pwxGISDataset) : wxGISLayer(sName, pwxGISDataset)
@@ -57,10 +250,22 @@ wxGISFeatureLayer::wxGISFeatureLayer(const wxString &sName, wxGISDataset* pwxGIS
         m_nConnectionPointDSCookie = m_pwxGISFeatureDataset->Advise(this);
 	}
     m_pSpatialTree = NULL;
+    m_bIngestStopped = false;
+    m_nIngestSequence = 0;
+
+    m_bUseLOD = true;
+    wxGISAppConfig oConfig = GetConfig();
+    if(oConfig.IsOk())
+    {
+        wxString sAppName = GetApplication()->GetAppName();
+        m_bUseLOD = oConfig.ReadBool(enumGISHKCU, sAppName + wxString(wxT("/renderer/vector/lod")), m_bUseLOD);
+        m_oLODCache.SetMaxPointCount(oConfig.ReadInt(enumGISHKCU, sAppName + wxString(wxT("/renderer/vector/lod_cache_points")), LOD_MAX_POINTS));
+    }
 }
 
 wxGISFeatureLayer::~wxGISFeatureLayer(void)
 {
+    StopIngestThreads();
     if (m_nConnectionPointDSCookie != wxNOT_FOUND && NULL != m_pwxGISFeatureDataset)
     {
         m_pwxGISFeatureDataset->Unadvise(m_nConnectionPointDSCookie);
@@ -219,6 +424,13 @@ long wxGISFeatureLayer::GetPointsInGeometry(const wxGISGeometry& Geom) const
 	}
 }
 
+wxGISGeometry wxGISFeatureLayer::GetDrawGeometry(const wxGISSpatialTreeData* pData, int nLODLevel)
+{
+    if(!m_bUseLOD || nLODLevel == LOD_LEVEL_NONE)
+        return pData->GetGeometry();
+    return m_oLODCache.GetGeometry(pData, nLODLevel);
+}
+
 wxGISSpatialTreeCursor wxGISFeatureLayer::SearchGeometry(const OGREnvelope &Env)
 {
     wxGISSpatialTreeCursor Cursor;
@@ -256,6 +468,8 @@ wxGISSpatialTreeCursor wxGISFeatureLayer::Idetify(const wxGISGeometry &Geom)
 
 void wxGISFeatureLayer::OnDSClosed(wxFeatureDSEvent& event)
 {
+    StopIngestThreads();
+    m_oLODCache.Clear();
     wxDELETE(m_pSpatialTree);
     wxMxMapViewEvent wxMxMapViewEvent_(wxMXMAP_LAYER_DS_CLOSED, GetId());
     AddEvent(wxMxMapViewEvent_);
@@ -264,62 +478,225 @@ void wxGISFeatureLayer::OnDSClosed(wxFeatureDSEvent& event)
 void wxGISFeatureLayer::OnDSFeaturesAdded(wxFeatureDSEvent& event)
 {
     wxCHECK_RET(m_pFeatureRenderer, wxT("The current renderer point is NULL"));
-    //if reprojected - add to quadtree and draw from it
+    //if reprojected - the ingest threads add to quadtree and the added features are drawn in OnIngested
     if(m_pSpatialTree)
     {
+        //only FIDs are passed, the ingest threads copy the geometries from the dataset
         wxGISSpatialTreeCursor Cursor = event.GetCursor();
-        wxGISSpatialTreeCursor retCursor; 
-
+        wxVector<long> anFIDs;
+        anFIDs.reserve(Cursor.size());
         wxGISSpatialTreeCursor::const_iterator iter;
         for(iter = Cursor.begin(); iter != Cursor.end(); ++iter)
-        {    
-            wxGISSpatialTreeData *current = *iter;
-            wxGISGeometry Geom(current->GetGeometry().Copy());
-            if(Geom.Project(m_SpatialReference))
-            {
-                long nOid = current->GetFID();
-                if(!m_pSpatialTree->HasFID(nOid))
-                {
-                    wxGISSpatialTreeData *pNewItem = new wxGISSpatialTreeData(Geom, nOid);
-                    retCursor.push_back(pNewItem);
+        {
+            anFIDs.push_back((*iter)->GetFID());
+        }
+        QueueIngest(anFIDs);
+        return;
+    }
 
-                    m_pSpatialTree->Insert(pNewItem);
-                }
-            }
+    m_pFeatureRenderer->Draw(event.GetCursor(), wxGISDPGeography, m_pDisplay);
+    //send event that layer is changed and redraw needed to upper layers and whole map
+    wxMxMapViewEvent wxMxMapViewEvent_(wxMXMAP_LAYER_LOADING, GetId());
+    AddEvent(wxMxMapViewEvent_);
+}
+
+void wxGISFeatureLayer::QueueIngest(const wxVector<long> &anFIDs)
+{
+    if(anFIDs.empty())
+        return;
+
+    StartIngestThreads();
+
+    FEATURELAYERBATCH* pBatch = new FEATURELAYERBATCH;
+    pBatch->anFIDs.reserve(anFIDs.size());
+    {
+        wxCriticalSectionLocker locker(m_IngestCritSect);
+        pBatch->nSequence = ++m_nIngestSequence;
+        for(size_t i = 0; i < anFIDs.size(); ++i)
+        {
+            long nFID = anFIDs[i];
+            if(m_pSpatialTree->HasFID(nFID) || m_mnQueuedFIDs.find(nFID) != m_mnQueuedFIDs.end())
+                continue;
+            m_mnQueuedFIDs[nFID] = pBatch->nSequence;
+            pBatch->anFIDs.push_back(nFID);
         }
+    }
 
-        m_pFeatureRenderer->Draw(retCursor, wxGISDPGeography, m_pDisplay);
+    if(pBatch->anFIDs.empty())
+    {
+        wxDELETE(pBatch);
+    }
+    else if(m_paIngestThreads.empty())
+    {
+        IngestBatch(pBatch);
+        wxDELETE(pBatch);
     }
     else
     {
-        m_pFeatureRenderer->Draw(event.GetCursor(), wxGISDPGeography, m_pDisplay);
+        m_IngestQueue.Post(pBatch);
     }
-    //send event that layer is changed and redraw needed to upper layers and whole map
+}
+
+void wxGISFeatureLayer::IngestBatch(FEATURELAYERBATCH* const pBatch)
+{
+    wxCHECK_RET(pBatch, wxT("The input batch pointer is NULL"));
+
+    //the geometries are copied by the dataset under its lock, so this thread owns them
+    wxVector<wxGISGeometry> aGeometries;
+    aGeometries.reserve(pBatch->anFIDs.size());
+    for(size_t i = 0; i < pBatch->anFIDs.size(); ++i)
+    {
+        aGeometries.push_back(m_pwxGISFeatureDataset->CopyGeometry(pBatch->anFIDs[i]));
+    }
+
+    //the failed geometries are replaced by invalid ones
+    wxGISCoordinateTransformationCache::Transform(aGeometries, m_SpatialReference);
+
+    //the tree items are created before adding as the batch must not hold the references to the tree geometries
+    OGREnvelope Env;
+    wxVector<wxGISSpatialTreeData*> paData(pBatch->anFIDs.size(), NULL);
+    for(size_t i = 0; i < pBatch->anFIDs.size(); ++i)
+    {
+        if(!aGeometries[i].IsOk())
+            continue;
+        paData[i] = new wxGISSpatialTreeData(aGeometries[i], pBatch->anFIDs[i]);
+        if(Env.IsInit())
+            Env.Merge(aGeometries[i].GetEnvelope());
+        else
+            Env = aGeometries[i].GetEnvelope();
+    }
+    aGeometries.clear();
+
+    bool bNotify = false;
+    {
+        wxCriticalSectionLocker locker(m_IngestCritSect);
+        for(size_t i = 0; i < pBatch->anFIDs.size(); ++i)
+        {
+            //the features deleted after posting are not queued any more, the changed ones are queued again by the later batch
+            std::map<long, long>::iterator it = m_mnQueuedFIDs.find(pBatch->anFIDs[i]);
+            if(m_bIngestStopped || NULL == m_pSpatialTree || it == m_mnQueuedFIDs.end() || it->second != pBatch->nSequence || NULL == paData[i])
+            {
+                wxDELETE(paData[i]);
+                continue;
+            }
+            m_mnQueuedFIDs.erase(it);
+            m_pSpatialTree->Insert(paData[i]);
+            bNotify = bNotify || m_IngestedCursor.empty();
+            m_IngestedCursor.push_back(paData[i]);
+        }
+        if(m_IngestedEnvelope.IsInit())
+            m_IngestedEnvelope.Merge(Env);
+        else
+            m_IngestedEnvelope = Env;
+    }
+
+    //the added features are drawn by the layer thread, one event for all not drawn batches
+    if(bNotify)
+    {
+        wxThreadEvent event(wxEVT_THREAD, INGESTED_EVENT);
+        wxQueueEvent(this, event.Clone());
+    }
+}
+
+void wxGISFeatureLayer::OnIngested(wxThreadEvent& event)
+{
+    wxGISSpatialTreeCursor Cursor;
+    OGREnvelope Env;
+    {
+        wxCriticalSectionLocker locker(m_IngestCritSect);
+        Cursor = m_IngestedCursor;
+        m_IngestedCursor.Clear();
+        Env = m_IngestedEnvelope;
+        m_IngestedEnvelope = OGREnvelope();
+    }
+
+    //the layer extent is changed in this thread only
+    if(Env.IsInit())
+    {
+        if(m_FullEnvelope.IsInit())
+            m_FullEnvelope.Merge(Env);
+        else
+            m_FullEnvelope = Env;
+    }
+
+    if(Cursor.empty() || NULL == m_pFeatureRenderer || NULL == m_pDisplay)
+        return;
+
+    m_pFeatureRenderer->Draw(Cursor, wxGISDPGeography, m_pDisplay);
     wxMxMapViewEvent wxMxMapViewEvent_(wxMXMAP_LAYER_LOADING, GetId());
     AddEvent(wxMxMapViewEvent_);
 }
 
-void wxGISFeatureLayer::OnDSFeatureAdded(wxFeatureDSEvent& event)
+void wxGISFeatureLayer::DropIngestedFID(long nFID)
 {
-    wxGISFeature Feature = m_pwxGISFeatureDataset->GetFeatureByID(event.GetFID());
-    if(m_pSpatialTree)
+    m_mnQueuedFIDs.erase(nFID);
+    for(size_t i = m_IngestedCursor.size(); i > 0; --i)
     {
-        wxGISGeometry Geom(Feature.GetGeometry().Copy());
-        bool bProj = Geom.Project(m_SpatialReference);
+        if(m_IngestedCursor[i - 1]->GetFID() == nFID)
+            m_IngestedCursor.RemoveAt(i - 1);
+    }
+}
 
-        if(!m_pSpatialTree->HasFID(Feature.GetFID()))
+void wxGISFeatureLayer::StartIngestThreads(void)
+{
+    if(!m_paIngestThreads.empty())
+        return;
+
+    int nThreadCount = wxThread::GetCPUCount() - 1;
+    if(nThreadCount < 1)
+        nThreadCount = 1;
+    for(int i = 0; i < nThreadCount; ++i)
+    {
+        wxGISFeatureLayerIngestThread *thread = new wxGISFeatureLayerIngestThread(this, m_IngestQueue);
+        if(::CreateAndRunThread(thread, wxT("wxGISFeatureLayerIngestThread"), wxT("FeatureLayerIngestThread")))
         {
-            m_pSpatialTree->Insert(Geom, Feature.GetFID());
+            m_paIngestThreads.push_back(thread);
         }
-
-        if(bProj)
+        else
         {
-            if(m_FullEnvelope.IsInit())
-                m_FullEnvelope.Merge(Geom.GetEnvelope());
-            else
-                m_FullEnvelope = Geom.GetEnvelope();
+            wxDELETE(thread);
+            break;
         }
     }
+}
+
+void wxGISFeatureLayer::StopIngestThreads(void)
+{
+    if(m_paIngestThreads.empty())
+        return;
+
+    {
+        wxCriticalSectionLocker locker(m_IngestCritSect);
+        m_bIngestStopped = true;
+    }
+
+    //the queued batches are skipped, each thread exits on own NULL batch
+    for(size_t i = 0; i < m_paIngestThreads.size(); ++i)
+    {
+        m_IngestQueue.Post(NULL);
+    }
+    for(size_t i = 0; i < m_paIngestThreads.size(); ++i)
+    {
+        wgDELETE(m_paIngestThreads[i], Wait());
+    }
+    m_paIngestThreads.clear();
+
+    wxCriticalSectionLocker locker(m_IngestCritSect);
+    m_bIngestStopped = false;
+    m_mnQueuedFIDs.clear();
+    m_IngestedCursor.Clear();
+    m_IngestedEnvelope = OGREnvelope();
+}
+
+void wxGISFeatureLayer::OnDSFeatureAdded(wxFeatureDSEvent& event)
+{
+    wxGISFeature Feature = m_pwxGISFeatureDataset->GetFeatureByID(event.GetFID());
+    if(m_pSpatialTree)
+    {
+        //the ingest thread copies and projects the geometry, adds it to the tree and extent and draws it
+        wxVector<long> anFIDs(1, event.GetFID());
+        QueueIngest(anFIDs);
+    }
     else
     {
         if(m_FullEnvelope.IsInit())
@@ -340,8 +717,11 @@ void wxGISFeatureLayer::OnDSFeatureAdded(wxFeatureDSEvent& event)
 
 void wxGISFeatureLayer::OnDSFeatureDeleted(wxFeatureDSEvent& event)
 {
+    m_oLODCache.Remove(event.GetFID());
     if(m_pSpatialTree)
     {
+        wxCriticalSectionLocker locker(m_IngestCritSect);
+        DropIngestedFID(event.GetFID());
         m_pSpatialTree->Remove(event.GetFID());
     }
 
@@ -352,21 +732,18 @@ void wxGISFeatureLayer::OnDSFeatureDeleted(wxFeatureDSEvent& event)
 void wxGISFeatureLayer::OnDSFeatureChanged(wxFeatureDSEvent& event)
 {
     //wxLogDebug(wxT("changed: %d"), event.GetFID());
+    m_oLODCache.Remove(event.GetFID());
     wxGISFeature Feature = m_pwxGISFeatureDataset->GetFeatureByID(event.GetFID());
     if(m_pSpatialTree)
     {
-        wxGISGeometry Geom(Feature.GetGeometry().Copy());
-        bool bProj = Geom.Project(m_SpatialReference);
-
-        m_pSpatialTree->Change(Geom, Feature.GetFID());
-
-        if(bProj)
+        //the old geometry is removed here, the new one is added by the ingest thread
         {
-            if(m_FullEnvelope.IsInit())
-                m_FullEnvelope.Merge(Geom.GetEnvelope());
-            else
-                m_FullEnvelope = Geom.GetEnvelope();
+            wxCriticalSectionLocker locker(m_IngestCritSect);
+            DropIngestedFID(event.GetFID());
+            m_pSpatialTree->Remove(event.GetFID());
         }
+        wxVector<long> anFIDs(1, event.GetFID());
+        QueueIngest(anFIDs);
     }
     else
     {
@@ -390,8 +767,11 @@ void wxGISFeatureLayer::SetSpatialReference(const wxGISSpatialReference &Spatial
 {
     if(m_SpatialReference->IsSame(SpatialReference))
         return;
+    //the ingest threads project to the layer spatial reference
+    StopIngestThreads();
     m_SpatialReference = SpatialReference;
     m_FullEnvelope = m_pwxGISFeatureDataset->GetEnvelope();
+    m_oLODCache.Clear();
     //delete previous quadtree
     if(m_pSpatialTree)
     {
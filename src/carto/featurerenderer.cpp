@@ -21,6 +21,42 @@
 #include "wxgis/carto/featurerenderer.h"
 #include "wxgis/carto/featurelayer.h"
 #include "wxgis/display/displayop.h"
+#include "wxgis/core/config.h"
+#include "wxgis/core/app.h"
+
+//-----------------------------------------------------------------------------
+// wxFeatureDrawThread
+//-----------------------------------------------------------------------------
+
+wxFeatureDrawThread::wxFeatureDrawThread(wxGISSymbol* const pSymbol, wxGISDisplay* const pDisplay, ITrackCancel * const pTrackCancel) : wxThread(wxTHREAD_JOINABLE), m_pTrackCancel(pTrackCancel)
+{
+    m_pSymbol = pSymbol;
+    m_pDisplay = pDisplay;
+}
+
+void wxFeatureDrawThread::AddGeometry(const wxGISGeometry &Geom)
+{
+    m_aGeometries.push_back(Geom);
+}
+
+void *wxFeatureDrawThread::Entry()
+{
+    m_pSymbol->SetupDisplay(m_pDisplay);
+
+    for(size_t i = 0; i < m_aGeometries.size(); ++i)
+    {
+        m_pSymbol->Draw(m_aGeometries[i]);
+
+		if(i % FEATURE_DRAW_BATCH_SIZE == 0 && m_pTrackCancel && !m_pTrackCancel->Continue())
+			break;
+    }
+
+    return (wxThread::ExitCode)wxTHREAD_NO_ERROR;
+}
+
+void wxFeatureDrawThread::OnExit()
+{
+}
 
 //-----------------------------------------------------------------------------
 // wxGISFeatureRenderer
@@ -31,6 +67,17 @@ IMPLEMENT_CLASS(wxGISFeatureRenderer, wxGISRenderer)
 wxGISFeatureRenderer::wxGISFeatureRenderer(wxGISLayer* pwxGISLayer) : wxGISRenderer(pwxGISLayer)
 {
     m_pSymbol = NULL;
+    m_bParallelDraw = true;
+    m_nParallelDrawMemory = FEATURE_PARALLEL_DRAW_MEMORY;
+
+    wxGISAppConfig oConfig = GetConfig();
+    if(oConfig.IsOk())
+    {
+        wxString sAppName = GetApplication()->GetAppName();
+        m_bParallelDraw = oConfig.ReadBool(enumGISHKCU, sAppName + wxString(wxT("/renderer/vector/parallel_draw")), m_bParallelDraw);
+        m_nParallelDrawMemory = oConfig.ReadInt(enumGISHKCU, sAppName + wxString(wxT("/renderer/vector/parallel_draw_memory")), m_nParallelDrawMemory);
+    }
+
     m_pwxGISFeatureLayer = wxDynamicCast(m_pwxGISLayer, wxGISFeatureLayer);
 
     if(!m_pwxGISFeatureLayer)
@@ -163,39 +210,184 @@ void wxGISFeatureRenderer::Draw(const wxGISSpatialTreeCursor& Cursor, wxGISEnumD
         pProgress->SetRange(Cursor.size());
     }
 
-    wxGISSpatialTreeCursor::const_iterator iter;
-    for(iter = Cursor.begin(); iter != Cursor.end(); ++iter)
+    int nLODLevel = GetLODLevel(pDisplay);
+
+    if(m_bParallelDraw && DrawPhase == wxGISDPGeography && Cursor.size() >= FEATURE_PARALLEL_DRAW_MIN && DrawParallel(Cursor, nLODLevel, pDisplay, pTrackCancel))
     {
         if (NULL != pProgress)
         {
-            pProgress->SetValue(nCounter++);
+            pProgress->SetValue(Cursor.size());
         }
+        return;
+    }
 
-        if (m_pSymbol == NULL)
-            break;
-
-        wxGISSpatialTreeData *current = *iter;
-        if(!current)
-            continue;
+    wxGISSpatialTreeCursor::const_iterator iter = Cursor.begin();
+    while(iter != Cursor.end())
+    {
+        //the display lock is taken once per features batch, the symbols locks inside are recursive and not contended
+        {
+            wxCriticalSectionLocker lock(pDisplay->GetLock());
+            for(int nBatch = 0; nBatch < FEATURE_DRAW_BATCH_SIZE && iter != Cursor.end(); ++nBatch, ++iter)
+            {
+                nCounter++;
+
+                wxGISSpatialTreeData *current = *iter;
+                if(!current)
+                    continue;
+
+                switch(DrawPhase)
+		        {
+		        case wxGISDPGeography:
+                    m_pSymbol->Draw(nLODLevel == LOD_LEVEL_NONE ? current->GetGeometry() : m_pwxGISFeatureLayer->GetDrawGeometry(current, nLODLevel));
+			        break;
+		        case wxGISDPAnnotation:
+			        break;
+		        case wxGISDPSelection:
+			        break;
+		        default:
+			        break;
+		        }
+            }
+        }
 
-        switch(DrawPhase)
-		{
-		case wxGISDPGeography:
-            m_pSymbol->Draw(current->GetGeometry());
-			break;
-		case wxGISDPAnnotation:
-			break;
-		case wxGISDPSelection:
-			break;
-		default:
-			break;
-		}
+        if (NULL != pProgress)
+        {
+            pProgress->SetValue(nCounter);
+        }
 
 		if(pTrackCancel && !pTrackCancel->Continue())
 			break;
 	}
 }
 
+int wxGISFeatureRenderer::GetLODLevel(wxGISDisplay *pDisplay) const
+{
+    //the features from events may be drawn before layer set
+    if(NULL == m_pwxGISFeatureLayer)
+        return LOD_LEVEL_NONE;
+    double dX = 1.0, dY = 1.0;
+    pDisplay->DC2WorldDist(&dX, &dY, false);
+    return wxGISGeometryLODCache::GetLevel(wxMin(fabs(dX), fabs(dY)));
+}
+
+bool wxGISFeatureRenderer::DrawParallel(const wxGISSpatialTreeCursor& Cursor, int nLODLevel, wxGISDisplay *pDisplay, ITrackCancel *pTrackCancel)
+{
+    int CPUCount = wxThread::GetCPUCount();
+
+    //each thread display has own screen size surface, limit the threads count by memory
+    wxSize szCache = pDisplay->GetCacheSize();
+    wxLongLong nSurfaceSize = wxLongLong(szCache.GetWidth()) * szCache.GetHeight() * 4;
+    wxLongLong nMaxMemory = wxLongLong(m_nParallelDrawMemory) * 1024 * 1024;
+    if(nSurfaceSize > 0 && nSurfaceSize * CPUCount > nMaxMemory)
+        CPUCount = (nMaxMemory / nSurfaceSize).ToLong();
+    if(CPUCount < 2)
+        return false;
+
+    //the geometries given to the threads are the own copies, they share the memory limit with the surfaces
+    wxLongLong nGeometryMemory = nMaxMemory - nSurfaceSize * CPUCount;
+
+    //each thread draws the continuous part of cursor by own symbol copy to own display, so the draw order is kept on merge
+    wxVector<wxFeatureDrawThread*> threadarray;
+    wxVector<wxGISDisplay*> displayarray;
+    wxVector<wxGISSymbol*> symbolarray;
+    size_t nPartSize = Cursor.size() / CPUCount;
+    size_t nBeg(0), nEnd;
+    bool bFitMemory = true;
+    for(int i = 0; i < CPUCount && bFitMemory; ++i)
+    {
+        if(i == CPUCount - 1)
+            nEnd = Cursor.size();
+        else
+            nEnd = nPartSize * (i + 1);
+
+        wxGISSymbol* pSymbol = m_pSymbol->Clone();
+        pSymbol->Reference();
+        wxGISDisplay* pThreadDisplay = new wxGISDisplay(pDisplay);
+        symbolarray.push_back(pSymbol);
+        displayarray.push_back(pThreadDisplay);
+
+        wxFeatureDrawThread *thread = new wxFeatureDrawThread(pSymbol, pThreadDisplay, pTrackCancel);
+        threadarray.push_back(thread);
+        for(size_t j = nBeg; j < nEnd; ++j)
+        {
+            wxGISSpatialTreeData *current = Cursor[j];
+            if(!current)
+                continue;
+
+            //the simplified geometry from LOD cache is already the copy, only the spatial tree geometry is shared and should be cloned
+            wxGISGeometry Geom = current->GetGeometry();
+            if(nLODLevel != LOD_LEVEL_NONE)
+            {
+                wxGISGeometry DrawGeom = m_pwxGISFeatureLayer->GetDrawGeometry(current, nLODLevel);
+                OGRGeometry* pDrawGeom = DrawGeom;
+                OGRGeometry* pGeom = Geom;
+                Geom = pDrawGeom == pGeom ? Geom.Clone() : DrawGeom;
+            }
+            else
+            {
+                Geom = Geom.Clone();
+            }
+
+            OGRGeometry* pGeom = Geom;
+            if(NULL == pGeom)
+                continue;
+
+            nGeometryMemory -= pGeom->WkbSize();
+            if(nGeometryMemory < 0)
+            {
+                bFitMemory = false;
+                break;
+            }
+            thread->AddGeometry(Geom);
+        }
+        nBeg = nEnd;
+    }
+
+    if(!bFitMemory)
+    {
+        //the threads are not run yet, the features are drawn one by one in the caller thread
+        for(size_t i = 0; i < threadarray.size(); ++i)
+        {
+            wxDELETE(threadarray[i]);
+            wxDELETE(displayarray[i]);
+            wsDELETE(symbolarray[i]);
+        }
+        return false;
+    }
+
+    wxVector<wxFeatureDrawThread*> runarray;
+    for(size_t i = 0; i < threadarray.size(); ++i)
+    {
+        if(CreateAndRunThread(threadarray[i], wxT("wxFeatureDrawThread"), wxT("FeatureDrawThread")))
+        {
+            runarray.push_back(threadarray[i]);
+        }
+        else
+        {
+            //draw the part here to not lose it
+            threadarray[i]->Entry();
+            delete threadarray[i];
+        }
+    }
+
+    for(size_t i = 0; i < runarray.size(); ++i)
+    {
+        wgDELETE(runarray[i], Wait());
+    }
+
+    for(size_t i = 0; i < displayarray.size(); ++i)
+    {
+        pDisplay->MergeDisplay(displayarray[i]);
+        wxDELETE(displayarray[i]);
+        wsDELETE(symbolarray[i]);
+    }
+
+    //restore the symbol display
+    m_pSymbol->SetupDisplay(pDisplay);
+
+    return true;
+}
+
 bool wxGISFeatureRenderer::Apply(ITrackCancel* const pTrackCancel)
 {
     return true;
@@ -0,0 +1,536 @@
+/******************************************************************************
+ * Project:  wxGIS
+ * Purpose:  Type-specialized raster resampling kernels.
+ * Author:   Dmitry Baryshnikov (aka Bishop), polimax@mail.ru
+ ******************************************************************************
+*   Copyright (C) 2014 Dmitry Baryshnikov
+*
+*    This program is free software: you can redistribute it and/or modify
+*    it under the terms of the GNU General Public License as published by
+*    the Free Software Foundation, either version 2 of the License, or
+*    (at your option) any later version.
+*
+*    This program is distributed in the hope that it will be useful,
+*    but WITHOUT ANY WARRANTY; without even the implied warranty of
+*    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+*    GNU General Public License for more details.
+*
+*    You should have received a copy of the GNU General Public License
+*    along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ ****************************************************************************/
+#include "wxgis/carto/rasterkernels.h"
+
+#ifdef wxGIS_USE_SSE2
+#include <emmintrin.h>
+#endif
+#ifdef wxGIS_USE_AVX2
+#include <immintrin.h>
+#endif
+
+//-----------------------------------
+// Row functions
+//-----------------------------------
+
+void StretchRow(const float *pfInput, unsigned char *pOutput, int nCount, float fM, float fDX, bool bClamp, bool bInvert)
+{
+    int i = 0;
+#ifdef wxGIS_USE_SSE2
+    const __m128i mInvert = _mm_set1_epi8(bInvert ? (char)0xFF : 0);
+    const __m128i mLowByte = _mm_set1_epi32(0xFF);
+#ifdef wxGIS_USE_AVX2
+    const __m256 mM8 = _mm256_set1_ps(fM);
+    const __m256 mDX8 = _mm256_set1_ps(fDX);
+    const __m256 mZero8 = _mm256_setzero_ps();
+    const __m256 mMax8 = _mm256_set1_ps(255.0f);
+    for(; i + 16 <= nCount; i += 16)
+    {
+        __m256 v0 = _mm256_loadu_ps(pfInput + i);
+        __m256 v1 = _mm256_loadu_ps(pfInput + i + 8);
+        __m256i n0, n1;
+        if(bClamp)
+        {
+            v0 = _mm256_min_ps(_mm256_max_ps(_mm256_mul_ps(_mm256_sub_ps(v0, mDX8), mM8), mZero8), mMax8);
+            v1 = _mm256_min_ps(_mm256_max_ps(_mm256_mul_ps(_mm256_sub_ps(v1, mDX8), mM8), mZero8), mMax8);
+            n0 = _mm256_cvttps_epi32(v0);
+            n1 = _mm256_cvttps_epi32(v1);
+        }
+        else
+        {
+            n0 = _mm256_and_si256(_mm256_cvttps_epi32(v0), _mm256_set1_epi32(0xFF));
+            n1 = _mm256_and_si256(_mm256_cvttps_epi32(v1), _mm256_set1_epi32(0xFF));
+        }
+        __m128i w0 = _mm_packs_epi32(_mm256_castsi256_si128(n0), _mm256_extracti128_si256(n0, 1));
+        __m128i w1 = _mm_packs_epi32(_mm256_castsi256_si128(n1), _mm256_extracti128_si256(n1, 1));
+        _mm_storeu_si128((__m128i*)(pOutput + i), _mm_xor_si128(_mm_packus_epi16(w0, w1), mInvert));
+    }
+#endif
+    const __m128 mM = _mm_set1_ps(fM);
+    const __m128 mDX = _mm_set1_ps(fDX);
+    const __m128 mZero = _mm_setzero_ps();
+    const __m128 mMax = _mm_set1_ps(255.0f);
+    for(; i + 16 <= nCount; i += 16)
+    {
+        __m128i an[4];
+        for(int j = 0; j < 4; ++j)
+        {
+            __m128 v = _mm_loadu_ps(pfInput + i + j * 4);
+            if(bClamp)
+                an[j] = _mm_cvttps_epi32(_mm_min_ps(_mm_max_ps(_mm_mul_ps(_mm_sub_ps(v, mDX), mM), mZero), mMax));
+            else
+                an[j] = _mm_and_si128(_mm_cvttps_epi32(v), mLowByte);
+        }
+        __m128i w0 = _mm_packs_epi32(an[0], an[1]);
+        __m128i w1 = _mm_packs_epi32(an[2], an[3]);
+        _mm_storeu_si128((__m128i*)(pOutput + i), _mm_xor_si128(_mm_packus_epi16(w0, w1), mInvert));
+    }
+#endif
+    for(; i < nCount; ++i)
+    {
+        unsigned char cOutput;
+        if(bClamp)
+        {
+            float fVal = fM * (pfInput[i] - fDX);
+            if(fVal < 0)
+                cOutput = 0;
+            else if(fVal > 255)
+                cOutput = 255;
+            else
+                cOutput = (unsigned char)fVal;
+        }
+        else
+        {
+            cOutput = (unsigned char)((int)pfInput[i] & 0xFF);
+        }
+        pOutput[i] = bInvert ? 255 - cOutput : cOutput;
+    }
+}
+
+void NoDataMaskRow(const float *pfInput, unsigned char *pMask, int nCount, double dfNoData)
+{
+    int i = 0;
+#ifdef wxGIS_USE_SSE2
+    //the same test as IsDoubleEquil: -EPSILON < value - nodata <= EPSILON in double
+    const __m128d mNoData = _mm_set1_pd(dfNoData);
+    const __m128d mEpsilon = _mm_set1_pd(EPSILON);
+    const __m128d mNegEpsilon = _mm_set1_pd(-EPSILON);
+    for(; i + 4 <= nCount; i += 4)
+    {
+        __m128 mInput = _mm_loadu_ps(pfInput + i);
+        __m128d mDiffLo = _mm_sub_pd(_mm_cvtps_pd(mInput), mNoData);
+        __m128d mDiffHi = _mm_sub_pd(_mm_cvtps_pd(_mm_movehl_ps(mInput, mInput)), mNoData);
+        int nMask = _mm_movemask_pd(_mm_and_pd(_mm_cmpgt_pd(mDiffLo, mNegEpsilon), _mm_cmple_pd(mDiffLo, mEpsilon)));
+        nMask |= _mm_movemask_pd(_mm_and_pd(_mm_cmpgt_pd(mDiffHi, mNegEpsilon), _mm_cmple_pd(mDiffHi, mEpsilon))) << 2;
+        pMask[i] = nMask & 1 ? 0xFF : 0;
+        pMask[i + 1] = nMask & 2 ? 0xFF : 0;
+        pMask[i + 2] = nMask & 4 ? 0xFF : 0;
+        pMask[i + 3] = nMask & 8 ? 0xFF : 0;
+    }
+#endif
+    for(; i < nCount; ++i)
+    {
+        pMask[i] = IsDoubleEquil((double)pfInput[i], dfNoData) ? 0xFF : 0;
+    }
+}
+
+void PackARGB32Row(const unsigned char *pR, const unsigned char *pG, const unsigned char *pB, const unsigned char *pA, const unsigned char *pMask, wxUint32 nNoDataColor, unsigned char *pOutput, int nCount)
+{
+    int i = 0;
+#ifdef wxGIS_USE_SSE2
+    //the cairo ARGB32 is native endian 32 bit word, so in memory it is B, G, R, A on x86
+    const __m128i mOpaque = _mm_set1_epi8((char)0xFF);
+    const __m128i mNoData = _mm_set1_epi32((int)nNoDataColor);
+    for(; i + 16 <= nCount; i += 16)
+    {
+        __m128i r = _mm_loadu_si128((const __m128i*)(pR + i));
+        __m128i g = _mm_loadu_si128((const __m128i*)(pG + i));
+        __m128i b = _mm_loadu_si128((const __m128i*)(pB + i));
+        __m128i a = pA == NULL ? mOpaque : _mm_loadu_si128((const __m128i*)(pA + i));
+
+        __m128i bg_lo = _mm_unpacklo_epi8(b, g);
+        __m128i bg_hi = _mm_unpackhi_epi8(b, g);
+        __m128i ra_lo = _mm_unpacklo_epi8(r, a);
+        __m128i ra_hi = _mm_unpackhi_epi8(r, a);
+
+        __m128i ap[4];
+        ap[0] = _mm_unpacklo_epi16(bg_lo, ra_lo);
+        ap[1] = _mm_unpackhi_epi16(bg_lo, ra_lo);
+        ap[2] = _mm_unpacklo_epi16(bg_hi, ra_hi);
+        ap[3] = _mm_unpackhi_epi16(bg_hi, ra_hi);
+
+        if(pMask)
+        {
+            __m128i m = _mm_loadu_si128((const __m128i*)(pMask + i));
+            __m128i m_lo = _mm_unpacklo_epi8(m, m);
+            __m128i m_hi = _mm_unpackhi_epi8(m, m);
+            __m128i am[4];
+            am[0] = _mm_unpacklo_epi16(m_lo, m_lo);
+            am[1] = _mm_unpackhi_epi16(m_lo, m_lo);
+            am[2] = _mm_unpacklo_epi16(m_hi, m_hi);
+            am[3] = _mm_unpackhi_epi16(m_hi, m_hi);
+            for(int j = 0; j < 4; ++j)
+                ap[j] = _mm_or_si128(_mm_andnot_si128(am[j], ap[j]), _mm_and_si128(am[j], mNoData));
+        }
+
+        for(int j = 0; j < 4; ++j)
+            _mm_storeu_si128((__m128i*)(pOutput + (i + j * 4) * 4), ap[j]);
+    }
+#endif
+    wxUint32 *pnOutput = (wxUint32 *)pOutput;
+    for(; i < nCount; ++i)
+    {
+        if(pMask && pMask[i])
+        {
+            pnOutput[i] = nNoDataColor;
+        }
+        else
+        {
+            wxUint32 nA = pA == NULL ? 255 : pA[i];
+            pnOutput[i] = (nA << 24) | ((wxUint32)pR[i] << 16) | ((wxUint32)pG[i] << 8) | (wxUint32)pB[i];
+        }
+    }
+}
+
+void LookupRow(const unsigned char *pLUT, const wxUint16 *pnInput, unsigned char *pOutput, int nCount)
+{
+    int i = 0;
+    for(; i + 4 <= nCount; i += 4)
+    {
+        pOutput[i] = pLUT[pnInput[i]];
+        pOutput[i + 1] = pLUT[pnInput[i + 1]];
+        pOutput[i + 2] = pLUT[pnInput[i + 2]];
+        pOutput[i + 3] = pLUT[pnInput[i + 3]];
+    }
+    for(; i < nCount; ++i)
+        pOutput[i] = pLUT[pnInput[i]];
+}
+
+//-----------------------------------
+// Resample kernels
+//-----------------------------------
+
+/** \class wxGISRowBuffer rasterkernels.cpp
+    \brief The per call buffers: float row for each band and the byte scratch for FillRow
+*/
+
+class wxGISRowBuffer
+{
+public:
+    wxGISRowBuffer(int nBandCount, int nCount)
+    {
+        m_pfData = (float*)CPLMalloc(sizeof(float) * nBandCount * nCount);
+        for(int i = 0; i < 4; ++i)
+            m_apfBands[i] = i < nBandCount ? m_pfData + i * nCount : NULL;
+        m_pScratch = (unsigned char*)CPLMalloc(RASTER_KERNEL_SCRATCH_BANDS * nCount + 16);
+    }
+    ~wxGISRowBuffer()
+    {
+        CPLFree(m_pfData);
+        CPLFree(m_pScratch);
+    }
+    float *Band(int nBand) { return m_apfBands[nBand]; };
+    const float* const* Bands() const { return m_apfBands; };
+    unsigned char *Scratch() { return m_pScratch; };
+protected:
+    float *m_pfData;
+    float *m_apfBands[4];
+    unsigned char *m_pScratch;
+};
+
+inline int ClampIndex(int nVal, int nMax)
+{
+    return nVal < 0 ? 0 : nVal > nMax ? nMax : nVal;
+}
+
+template<typename T, int nBands> static void NearestNeighbourRows(const RAWPIXELDATA &stPixelData, unsigned char *pOutputData, int nOutXSize, int nOutYSize, int nBegY, int nEndY, wxGISRasterRenderer* const pRasterRenderer, ITrackCancel* const pTrackCancel)
+{
+    const T *pInput = (const T *)stPixelData.pPixelData;
+    double dXRatio = stPixelData.dPixelDataWidth / nOutXSize;
+    double dYRatio = stPixelData.dPixelDataHeight / nOutYSize;
+    int nScanLine = stPixelData.nPixelDataWidth * nBands;
+
+    //the source column offsets are the same for each row
+    wxVector<int> anXOffset(nOutXSize);
+    for(int nDestPixX = 0; nDestPixX < nOutXSize; ++nDestPixX)
+        anXOffset[nDestPixX] = (int)(dXRatio * double(nDestPixX) + stPixelData.dPixelDeltaX) * nBands;
+
+    wxGISRowBuffer oBuffer(nBands, nOutXSize);
+    for(int nDestPixY = nBegY; nDestPixY < nEndY; ++nDestPixY)
+    {
+        int nOrigPixY = (int)(dYRatio * double(nDestPixY) + stPixelData.dPixelDeltaY);
+        const T *pScanLine = pInput + nOrigPixY * nScanLine;
+        for(int nBand = 0; nBand < nBands; ++nBand)
+        {
+            float *pfRow = oBuffer.Band(nBand);
+            const T *pSrc = pScanLine + nBand;
+            for(int nDestPixX = 0; nDestPixX < nOutXSize; ++nDestPixX)
+                pfRow[nDestPixX] = (float)pSrc[anXOffset[nDestPixX]];
+        }
+
+        pRasterRenderer->FillRow(pOutputData, oBuffer.Bands(), nBands, nOutXSize, oBuffer.Scratch());
+        pOutputData += nOutXSize * 4;//ARGB32
+
+        if(pTrackCancel && !pTrackCancel->Continue())
+            return;
+    }
+}
+
+template<typename T, int nBands> static void NearestNeighbourLUTRows(const RAWPIXELDATA &stPixelData, const RASTERLUT &stLUT, unsigned char *pOutputData, int nOutXSize, int nOutYSize, int nBegY, int nEndY, wxGISRasterRenderer* const pRasterRenderer, ITrackCancel* const pTrackCancel)
+{
+    const T *pInput = (const T *)stPixelData.pPixelData;
+    double dXRatio = stPixelData.dPixelDataWidth / nOutXSize;
+    double dYRatio = stPixelData.dPixelDataHeight / nOutYSize;
+    int nScanLine = stPixelData.nPixelDataWidth * nBands;
+
+    wxVector<int> anXOffset(nOutXSize);
+    for(int nDestPixX = 0; nDestPixX < nOutXSize; ++nDestPixX)
+        anXOffset[nDestPixX] = (int)(dXRatio * double(nDestPixX) + stPixelData.dPixelDeltaX) * nBands;
+
+    //the sample bits are the lookup table index
+    wxVector<wxUint16> anData(nBands * nOutXSize);
+    const wxUint16 *apnBands[4] = {NULL, NULL, NULL, NULL};
+    for(int nBand = 0; nBand < nBands; ++nBand)
+        apnBands[nBand] = &anData[nBand * nOutXSize];
+    unsigned char *pScratch = (unsigned char*)CPLMalloc(RASTER_KERNEL_SCRATCH_BANDS * nOutXSize + 16);
+
+    for(int nDestPixY = nBegY; nDestPixY < nEndY; ++nDestPixY)
+    {
+        int nOrigPixY = (int)(dYRatio * double(nDestPixY) + stPixelData.dPixelDeltaY);
+        const T *pScanLine = pInput + nOrigPixY * nScanLine;
+        for(int nBand = 0; nBand < nBands; ++nBand)
+        {
+            wxUint16 *pnRow = &anData[nBand * nOutXSize];
+            const T *pSrc = pScanLine + nBand;
+            for(int nDestPixX = 0; nDestPixX < nOutXSize; ++nDestPixX)
+                pnRow[nDestPixX] = (wxUint16)pSrc[anXOffset[nDestPixX]];
+        }
+
+        pRasterRenderer->FillRowLUT(pOutputData, apnBands, nBands, nOutXSize, stLUT, pScratch);
+        pOutputData += nOutXSize * 4;//ARGB32
+
+        if(pTrackCancel && !pTrackCancel->Continue())
+            break;
+    }
+
+    CPLFree(pScratch);
+}
+
+template<typename T, int nBands> static void BilinearRows(const RAWPIXELDATA &stPixelData, unsigned char *pOutputData, int nOutXSize, int nOutYSize, int nBegY, int nEndY, wxGISRasterRenderer* const pRasterRenderer, ITrackCancel* const pTrackCancel)
+{
+    const T *pInput = (const T *)stPixelData.pPixelData;
+    double dXRatio = stPixelData.dPixelDataWidth / nOutXSize;
+    double dYRatio = stPixelData.dPixelDataHeight / nOutYSize;
+    int nInputXSize = stPixelData.nPixelDataWidth;
+    int srcpixymax = stPixelData.nPixelDataHeight - 1;
+    int srcpixxmax = nInputXSize - 1;
+
+    //precompute the two source columns and the weight for each output column
+    wxVector<int> anX1(nOutXSize), anX2(nOutXSize);
+    wxVector<float> afDX(nOutXSize);
+    for(int nDestPixX = 0; nDestPixX < nOutXSize; ++nDestPixX)
+    {
+        double srcpixx = dXRatio * double(nDestPixX) + stPixelData.dPixelDeltaX;
+        int srcpixx1 = (int)(srcpixx);
+        int srcpixx2 = ( srcpixx1 == srcpixxmax ) ? srcpixx1 : srcpixx1 + 1;
+        afDX[nDestPixX] = float(srcpixx - srcpixx1);
+        anX1[nDestPixX] = ClampIndex(srcpixx1, srcpixxmax) * nBands;
+        anX2[nDestPixX] = ClampIndex(srcpixx2, srcpixxmax) * nBands;
+    }
+
+    wxGISRowBuffer oBuffer(nBands, nOutXSize);
+    for(int nDestPixY = nBegY; nDestPixY < nEndY; ++nDestPixY)
+    {
+        double srcpixy = dYRatio * double(nDestPixY) + stPixelData.dPixelDeltaY;
+        int srcpixy1 = (int)(srcpixy);
+        int srcpixy2 = ( srcpixy1 == srcpixymax ) ? srcpixy1 : srcpixy1 + 1;
+        float dy = float(srcpixy - srcpixy1);
+        float dy1 = 1.0f - dy;
+
+        const T *pLine1 = pInput + ClampIndex(srcpixy1, srcpixymax) * nInputXSize * nBands;
+        const T *pLine2 = pInput + ClampIndex(srcpixy2, srcpixymax) * nInputXSize * nBands;
+
+        for(int nBand = 0; nBand < nBands; ++nBand)
+        {
+            float *pfRow = oBuffer.Band(nBand);
+            const T *pSrc1 = pLine1 + nBand;
+            const T *pSrc2 = pLine2 + nBand;
+            for(int nDestPixX = 0; nDestPixX < nOutXSize; ++nDestPixX)
+            {
+                float dx = afDX[nDestPixX];
+                float dx1 = 1.0f - dx;
+                int x1 = anX1[nDestPixX], x2 = anX2[nDestPixX];
+                //first line
+                float f1 = (float)pSrc1[x1] * dx1 + (float)pSrc1[x2] * dx;
+                //second line
+                float f2 = (float)pSrc2[x1] * dx1 + (float)pSrc2[x2] * dx;
+                pfRow[nDestPixX] = f1 * dy1 + f2 * dy;
+            }
+        }
+
+        pRasterRenderer->FillRow(pOutputData, oBuffer.Bands(), nBands, nOutXSize, oBuffer.Scratch());
+        pOutputData += nOutXSize * 4;//ARGB32
+
+        if(pTrackCancel && !pTrackCancel->Continue())
+            return;
+    }
+}
+
+template<typename T, int nBands> static void BicubicRows(const RAWPIXELDATA &stPixelData, unsigned char *pOutputData, int nOutXSize, int nOutYSize, int nBegY, int nEndY, wxGISRasterRenderer* const pRasterRenderer, ITrackCancel* const pTrackCancel)
+{
+    const T *pInput = (const T *)stPixelData.pPixelData;
+    double dXRatio = stPixelData.dPixelDataWidth / nOutXSize;
+    double dYRatio = stPixelData.dPixelDataHeight / nOutYSize;
+    int nInputXSize = stPixelData.nPixelDataWidth;
+    int nInputYSize = stPixelData.nPixelDataHeight;
+
+    //precompute four source columns and the kernel weights for each output column
+    wxVector<int> anX(nOutXSize * 4);
+    wxVector<float> afWX(nOutXSize * 4);
+    for(int nDestPixX = 0; nDestPixX < nOutXSize; ++nDestPixX)
+    {
+        double srcpixx = dXRatio * double(nDestPixX) + stPixelData.dPixelDeltaX;
+        double dx = srcpixx - (int)srcpixx;
+        for(int i = -1; i <= 2; ++i)
+        {
+            int x_offset = srcpixx + i < 0.0 ? 0 : srcpixx + i >= nInputXSize ? nInputXSize - 1 : (int)(srcpixx + i);
+            anX[nDestPixX * 4 + i + 1] = x_offset * nBands;
+            afWX[nDestPixX * 4 + i + 1] = (float)BiCubicKernel(i - dx);
+        }
+    }
+
+    wxGISRowBuffer oBuffer(nBands, nOutXSize);
+    for(int nDestPixY = nBegY; nDestPixY < nEndY; ++nDestPixY)
+    {
+        double srcpixy = dYRatio * double(nDestPixY) + stPixelData.dPixelDeltaY;
+        double dy = srcpixy - (int)srcpixy;
+
+        const T *apLine[4];
+        float afWY[4];
+        for(int k = -1; k <= 2; ++k)
+        {
+            int y_offset = srcpixy + k < 0.0 ? 0 : srcpixy + k >= nInputYSize ? nInputYSize - 1 : (int)(srcpixy + k);
+            apLine[k + 1] = pInput + y_offset * nInputXSize * nBands;
+            afWY[k + 1] = (float)BiCubicKernel(k - dy);
+        }
+
+        for(int nBand = 0; nBand < nBands; ++nBand)
+        {
+            float *pfRow = oBuffer.Band(nBand);
+            for(int nDestPixX = 0; nDestPixX < nOutXSize; ++nDestPixX)
+            {
+                const int *pnX = &anX[nDestPixX * 4];
+                const float *pfWX = &afWX[nDestPixX * 4];
+                float fSum = 0;
+                for(int k = 0; k < 4; ++k)
+                {
+                    const T *pSrc = apLine[k] + nBand;
+                    float fLine = (float)pSrc[pnX[0]] * pfWX[0] + (float)pSrc[pnX[1]] * pfWX[1] + (float)pSrc[pnX[2]] * pfWX[2] + (float)pSrc[pnX[3]] * pfWX[3];
+                    fSum += fLine * afWY[k];
+                }
+                pfRow[nDestPixX] = fSum;
+            }
+        }
+
+        pRasterRenderer->FillRow(pOutputData, oBuffer.Bands(), nBands, nOutXSize, oBuffer.Scratch());
+        pOutputData += nOutXSize * 4;//ARGB32
+
+        if(pTrackCancel && !pTrackCancel->Continue())
+            return;
+    }
+}
+
+template<typename T, int nBands> static void ResampleRows(const RAWPIXELDATA &stPixelData, wxGISEnumDrawQuality eQuality, unsigned char *pOutputData, int nOutXSize, int nOutYSize, int nBegY, int nEndY, wxGISRasterRenderer* const pRasterRenderer, ITrackCancel* const pTrackCancel)
+{
+    switch(eQuality)
+    {
+    case enumGISQualityBilinear:
+        BilinearRows<T, nBands>(stPixelData, pOutputData, nOutXSize, nOutYSize, nBegY, nEndY, pRasterRenderer, pTrackCancel);
+        break;
+    case enumGISQualityBicubic:
+        BicubicRows<T, nBands>(stPixelData, pOutputData, nOutXSize, nOutYSize, nBegY, nEndY, pRasterRenderer, pTrackCancel);
+        break;
+    case enumGISQualityNearest:
+    default:
+        NearestNeighbourRows<T, nBands>(stPixelData, pOutputData, nOutXSize, nOutYSize, nBegY, nEndY, pRasterRenderer, pTrackCancel);
+        break;
+    };
+}
+
+template<typename T> static bool ResampleRows(const RAWPIXELDATA &stPixelData, int nBandCount, wxGISEnumDrawQuality eQuality, unsigned char *pOutputData, int nOutXSize, int nOutYSize, int nBegY, int nEndY, wxGISRasterRenderer* const pRasterRenderer, ITrackCancel* const pTrackCancel)
+{
+    switch(nBandCount)
+    {
+    case 1:
+        ResampleRows<T, 1>(stPixelData, eQuality, pOutputData, nOutXSize, nOutYSize, nBegY, nEndY, pRasterRenderer, pTrackCancel);
+        return true;
+    case 3:
+        ResampleRows<T, 3>(stPixelData, eQuality, pOutputData, nOutXSize, nOutYSize, nBegY, nEndY, pRasterRenderer, pTrackCancel);
+        return true;
+    case 4:
+        ResampleRows<T, 4>(stPixelData, eQuality, pOutputData, nOutXSize, nOutYSize, nBegY, nEndY, pRasterRenderer, pTrackCancel);
+        return true;
+    default:
+        return false;
+    };
+}
+
+template<typename T> static bool ResampleLUTRows(const RAWPIXELDATA &stPixelData, const RASTERLUT &stLUT, int nBandCount, unsigned char *pOutputData, int nOutXSize, int nOutYSize, int nBegY, int nEndY, wxGISRasterRenderer* const pRasterRenderer, ITrackCancel* const pTrackCancel)
+{
+    switch(nBandCount)
+    {
+    case 1:
+        NearestNeighbourLUTRows<T, 1>(stPixelData, stLUT, pOutputData, nOutXSize, nOutYSize, nBegY, nEndY, pRasterRenderer, pTrackCancel);
+        return true;
+    case 3:
+        NearestNeighbourLUTRows<T, 3>(stPixelData, stLUT, pOutputData, nOutXSize, nOutYSize, nBegY, nEndY, pRasterRenderer, pTrackCancel);
+        return true;
+    case 4:
+        NearestNeighbourLUTRows<T, 4>(stPixelData, stLUT, pOutputData, nOutXSize, nOutYSize, nBegY, nEndY, pRasterRenderer, pTrackCancel);
+        return true;
+    default:
+        return false;
+    };
+}
+
+bool ResampleRasterRows(const RAWPIXELDATA &stPixelData, GDALDataType eSrcType, int nBandCount, wxGISEnumDrawQuality eQuality, unsigned char *pOutputData, int nOutXSize, int nOutYSize, int nBegY, int nEndY, wxGISRasterRenderer* const pRasterRenderer, ITrackCancel* const pTrackCancel)
+{
+    if(nEndY > nOutYSize || pRasterRenderer == NULL || stPixelData.pPixelData == NULL)
+        return false;
+
+    //indexed and packed colors are interpolated after the color lookup, so use reference path for them
+    wxGISEnumRasterRendererType eType = pRasterRenderer->GetRasterRenderType();
+    if(eType != enumGISRasterRenderTypeGreyScale && eType != enumGISRasterRenderTypeRGBA)
+        return false;
+
+    //integer samples at nearest neighbour are mapped by the renderer lookup tables
+    //the tables are copied per job, so the stretch changed during the draw does not touch them
+    RASTERLUT stLUT;
+    if(eQuality == enumGISQualityNearest && pRasterRenderer->PrepareLUT(eSrcType, stLUT))
+    {
+        switch(eSrcType)
+        {
+        case GDT_Byte:
+            return ResampleLUTRows<GByte>(stPixelData, stLUT, nBandCount, pOutputData, nOutXSize, nOutYSize, nBegY, nEndY, pRasterRenderer, pTrackCancel);
+        case GDT_UInt16:
+            return ResampleLUTRows<GUInt16>(stPixelData, stLUT, nBandCount, pOutputData, nOutXSize, nOutYSize, nBegY, nEndY, pRasterRenderer, pTrackCancel);
+        case GDT_Int16:
+            return ResampleLUTRows<GInt16>(stPixelData, stLUT, nBandCount, pOutputData, nOutXSize, nOutYSize, nBegY, nEndY, pRasterRenderer, pTrackCancel);
+        default:
+            break;
+        };
+    }
+
+    switch(eSrcType)
+    {
+    case GDT_Byte:
+        return ResampleRows<GByte>(stPixelData, nBandCount, eQuality, pOutputData, nOutXSize, nOutYSize, nBegY, nEndY, pRasterRenderer, pTrackCancel);
+    case GDT_UInt16:
+        return ResampleRows<GUInt16>(stPixelData, nBandCount, eQuality, pOutputData, nOutXSize, nOutYSize, nBegY, nEndY, pRasterRenderer, pTrackCancel);
+    case GDT_Int16:
+        return ResampleRows<GInt16>(stPixelData, nBandCount, eQuality, pOutputData, nOutXSize, nOutYSize, nBegY, nEndY, pRasterRenderer, pTrackCancel);
+    case GDT_Float32:
+        return ResampleRows<float>(stPixelData, nBandCount, eQuality, pOutputData, nOutXSize, nOutYSize, nBegY, nEndY, pRasterRenderer, pTrackCancel);
+    default:
+        //Int32, UInt32 and Float64 lose precision in float rows, complex types are not supported
+        return false;
+    };
+}
@@ -19,11 +19,15 @@
 *    along with this program.  If not, see <http://www.gnu.org/licenses/>.
  ****************************************************************************/
 #include "wxgis/carto/rasterrenderer.h"
+#include "wxgis/carto/rasterkernels.h"
+#include "wxgis/carto/rastertilecache.h"
 #include "wxgis/carto/rasterlayer.h"
 #include "wxgis/core/config.h"
 #include "wxgis/core/app.h"
 #include "wxgis/display/displayop.h"
 
+#include <wx/filename.h>
+
 //-----------------------------------
 // Interpolation functions
 //-----------------------------------
@@ -506,28 +510,43 @@ void BicubicInterpolation(void *pInputData, int nInputXSize, int nInputYSize, do
 // wxRasterDrawThread
 //-----------------------------------
 
-wxRasterDrawThread::wxRasterDrawThread(RAWPIXELDATA &stPixelData, GDALDataType eSrcType, int nBandCount, unsigned char *pTransformData, wxGISEnumDrawQuality eQuality, int nOutXSize, int nOutYSize, int nBegY, int nEndY, wxGISRasterRenderer *pRasterRenderer, ITrackCancel * const pTrackCancel) : wxThread(wxTHREAD_JOINABLE), m_stPixelData(stPixelData), m_pTrackCancel(pTrackCancel)
+wxRasterDrawThread::wxRasterDrawThread(wxMessageQueue<RASTERDRAWJOB*> &Queue) : wxThread(wxTHREAD_JOINABLE), m_Queue(Queue)
 {
-    m_eSrcType = eSrcType;
-    m_pTransformData = pTransformData;
-    m_nBandCount = nBandCount;
-    m_eQuality = eQuality;
-    m_nOutXSize = nOutXSize;
-    m_nOutYSize = nOutYSize;
-    m_nBegY = nBegY;
-    m_nEndY = nEndY;
-    m_pRasterRenderer = pRasterRenderer;
 }
 
 void *wxRasterDrawThread::Entry()
 {
-    switch(m_eQuality)
+    RASTERDRAWJOB* pJob = NULL;
+    while(m_Queue.Receive(pJob) == wxMSGQUEUE_NO_ERROR)
+    {
+        //NULL job is the stop signal
+        if(pJob == NULL)
+            break;
+        DrawRows(*pJob);
+        pJob->pDone->Post();
+    }
+
+    return (wxThread::ExitCode)wxTHREAD_NO_ERROR;
+}
+
+void wxRasterDrawThread::OnExit()
+{
+}
+
+void wxRasterDrawThread::DrawRows(const RASTERDRAWJOB &stJob)
+{
+    const RAWPIXELDATA &stPixelData = *stJob.pstPixelData;
+    //try the type-specialized kernels first, the interpolation functions below are the reference path
+    if(stJob.pRasterRenderer->UseRowKernels() && ResampleRasterRows(stPixelData, stJob.eSrcType, stJob.nBandCount, stJob.eQuality, stJob.pTransformData, stJob.nOutXSize, stJob.nOutYSize, stJob.nBegY, stJob.nEndY, stJob.pRasterRenderer, stJob.pTrackCancel))
+        return;
+
+    switch(stJob.eQuality)
     {
     case enumGISQualityBilinear:
-        BilinearInterpolation(m_stPixelData.pPixelData, m_stPixelData.nPixelDataWidth, m_stPixelData.nPixelDataHeight, m_stPixelData.dPixelDataWidth, m_stPixelData.dPixelDataHeight, m_stPixelData.dPixelDeltaX, m_stPixelData.dPixelDeltaY, m_eSrcType, m_pTransformData, m_nOutXSize, m_nOutYSize, m_nBegY, m_nEndY, m_nBandCount, m_pRasterRenderer, m_pTrackCancel);
+        BilinearInterpolation(stPixelData.pPixelData, stPixelData.nPixelDataWidth, stPixelData.nPixelDataHeight, stPixelData.dPixelDataWidth, stPixelData.dPixelDataHeight, stPixelData.dPixelDeltaX, stPixelData.dPixelDeltaY, stJob.eSrcType, stJob.pTransformData, stJob.nOutXSize, stJob.nOutYSize, stJob.nBegY, stJob.nEndY, stJob.nBandCount, stJob.pRasterRenderer, stJob.pTrackCancel);
         break;
     case enumGISQualityBicubic:
-        BicubicInterpolation(m_stPixelData.pPixelData, m_stPixelData.nPixelDataWidth, m_stPixelData.nPixelDataHeight, m_stPixelData.dPixelDataWidth, m_stPixelData.dPixelDataHeight, m_stPixelData.dPixelDeltaX, m_stPixelData.dPixelDeltaY, m_eSrcType, m_pTransformData, m_nOutXSize, m_nOutYSize, m_nBegY, m_nEndY, m_nBandCount, m_pRasterRenderer, m_pTrackCancel);
+        BicubicInterpolation(stPixelData.pPixelData, stPixelData.nPixelDataWidth, stPixelData.nPixelDataHeight, stPixelData.dPixelDataWidth, stPixelData.dPixelDataHeight, stPixelData.dPixelDeltaX, stPixelData.dPixelDeltaY, stJob.eSrcType, stJob.pTransformData, stJob.nOutXSize, stJob.nOutYSize, stJob.nBegY, stJob.nEndY, stJob.nBandCount, stJob.pRasterRenderer, stJob.pTrackCancel);
         break;
     //case enumGISQualityHalfBilinear:
     //	OnHalfBilinearInterpolation(m_pOrigData, m_pDestData, m_nYbeg, m_nYend, m_nOrigX, m_nOrigY, m_nDestX,  rWRatio, rHRatio, m_rDeltaX, m_rDeltaY, m_pTrackCancel);
@@ -537,15 +556,81 @@ void *wxRasterDrawThread::Entry()
     //	break;
     case enumGISQualityNearest:
     default:
-        NearestNeighbourInterpolation(m_stPixelData.pPixelData, m_stPixelData.nPixelDataWidth, m_stPixelData.dPixelDataWidth, m_stPixelData.dPixelDataHeight, m_stPixelData.dPixelDeltaX, m_stPixelData.dPixelDeltaY, m_eSrcType, m_pTransformData, m_nOutXSize, m_nOutYSize, m_nBegY, m_nEndY, m_nBandCount, m_pRasterRenderer, m_pTrackCancel);
+        NearestNeighbourInterpolation(stPixelData.pPixelData, stPixelData.nPixelDataWidth, stPixelData.dPixelDataWidth, stPixelData.dPixelDataHeight, stPixelData.dPixelDeltaX, stPixelData.dPixelDeltaY, stJob.eSrcType, stJob.pTransformData, stJob.nOutXSize, stJob.nOutYSize, stJob.nBegY, stJob.nEndY, stJob.nBandCount, stJob.pRasterRenderer, stJob.pTrackCancel);
         break;
     };
+}
 
-    return (wxThread::ExitCode)wxTHREAD_NO_ERROR;
+//-----------------------------------
+// wxGISRasterDrawPool
+//-----------------------------------
+
+static wxGISRasterDrawPool *g_pRasterDrawPool( NULL );
+static wxCriticalSection g_RasterDrawPoolCritSect;
+
+wxGISRasterDrawPool* const GetRasterDrawPool(void)
+{
+    wxCriticalSectionLocker locker(g_RasterDrawPoolCritSect);
+    if(g_pRasterDrawPool == NULL)
+        g_pRasterDrawPool = new wxGISRasterDrawPool(wxThread::GetCPUCount());
+	return g_pRasterDrawPool;
 }
 
-void wxRasterDrawThread::OnExit()
+/** \class wxGISRasterDrawPoolModule rasterrenderer.cpp
+    \brief Stop the raster draw pool threads on program exit
+*/
+
+class wxGISRasterDrawPoolModule : public wxModule
 {
+    DECLARE_DYNAMIC_CLASS(wxGISRasterDrawPoolModule)
+public:
+    virtual bool OnInit() { return true; };
+    virtual void OnExit()
+    {
+        wxCriticalSectionLocker locker(g_RasterDrawPoolCritSect);
+        wxDELETE(g_pRasterDrawPool);
+    };
+};
+
+IMPLEMENT_DYNAMIC_CLASS(wxGISRasterDrawPoolModule, wxModule)
+
+wxGISRasterDrawPool::wxGISRasterDrawPool(int nThreadCount)
+{
+    for(int i = 0; i < nThreadCount; ++i)
+    {
+        wxRasterDrawThread *thread = new wxRasterDrawThread(m_Queue);
+        if(CreateAndRunThread(thread, wxT("wxRasterDrawThread"), wxT("RasterDrawThread")))
+            m_paThreads.push_back(thread);
+    }
+}
+
+wxGISRasterDrawPool::~wxGISRasterDrawPool(void)
+{
+    for(size_t i = 0; i < m_paThreads.size(); ++i)
+        m_Queue.Post(NULL);
+    for(size_t i = 0; i < m_paThreads.size(); ++i)
+    {
+        wgDELETE(m_paThreads[i], Wait());
+    }
+}
+
+void wxGISRasterDrawPool::Draw(wxVector<RASTERDRAWJOB> &paJobs)
+{
+    if(m_paThreads.empty())
+    {
+        for(size_t i = 0; i < paJobs.size(); ++i)
+            wxRasterDrawThread::DrawRows(paJobs[i]);
+        return;
+    }
+
+    wxSemaphore Done;
+    for(size_t i = 0; i < paJobs.size(); ++i)
+    {
+        paJobs[i].pDone = &Done;
+        m_Queue.Post(&paJobs[i]);
+    }
+    for(size_t i = 0; i < paJobs.size(); ++i)
+        Done.Wait();
 }
 
 //-----------------------------------
@@ -557,6 +642,9 @@ IMPLEMENT_ABSTRACT_CLASS(wxGISRasterRenderer, wxGISRenderer)
 wxGISRasterRenderer::wxGISRasterRenderer(wxGISLayer* pwxGISLayer) : wxGISRenderer(pwxGISLayer)
 {
     m_nTileSizeX = m_nTileSizeY = 256;
+    m_bUseRowKernels = true;
+    //the rendered tiles are reused on pan and on return to the same zoom, the tile_cache config key disables it
+    m_bUseTileCache = true;
     wxGISAppConfig oConfig = GetConfig();
 
     if(oConfig.IsOk())
@@ -567,6 +655,8 @@ wxGISRasterRenderer::wxGISRasterRenderer(wxGISLayer* pwxGISLayer) : wxGISRendere
         //TODO: tiled draw
         m_nTileSizeX = oConfig.ReadInt(enumGISHKCU, sAppName + wxString(wxT("/renderer/raster/tile_size_x")), m_nTileSizeX);
         m_nTileSizeY = oConfig.ReadInt(enumGISHKCU, sAppName + wxString(wxT("/renderer/raster/tile_size_y")), m_nTileSizeY);
+        m_bUseRowKernels = oConfig.ReadBool(enumGISHKCU, sAppName + wxString(wxT("/renderer/raster/row_kernels")), m_bUseRowKernels);
+        m_bUseTileCache = oConfig.ReadBool(enumGISHKCU, sAppName + wxString(wxT("/renderer/raster/tile_cache")), m_bUseTileCache);
     }
     else
         m_eQuality = enumGISQualityBilinear;
@@ -576,6 +666,18 @@ wxGISRasterRenderer::wxGISRasterRenderer(wxGISLayer* pwxGISLayer) : wxGISRendere
         m_pwxGISRasterDataset = wxDynamicCast(pwxGISLayer->GetDataset(), wxGISRasterDataset);
     else
         m_pwxGISRasterDataset = NULL;
+
+    //the tiles of changed file should not be taken from the spill directory
+    if(m_pwxGISRasterDataset)
+    {
+        wxString sPath(m_pwxGISRasterDataset->GetPath(), wxConvUTF8);
+        m_sDatasetKey = sPath;
+        wxFileName oFileName(sPath);
+        if(oFileName.FileExists())
+        {
+            m_sDatasetKey += wxString::Format(wxT(";%ld;%s"), (long)oFileName.GetModificationTime().GetTicks(), oFileName.GetSize().ToString().c_str());
+        }
+    }
 }
 
 wxGISRasterRenderer::~wxGISRasterRenderer(void)
@@ -626,6 +728,29 @@ bool wxGISRasterRenderer::Draw(wxGISEnumDrawPhase DrawPhase, wxGISDisplay* const
         stDrawBounds = stRasterExtent;
 
 
+    if(m_bUseTileCache)
+        return DrawTiles(stDrawBounds, DrawPhase, pDisplay, pTrackCancel);
+
+    //width & height of extent
+    double dOutWidth = stDrawBounds.MaxX - stDrawBounds.MinX;
+    double dOutHeight = stDrawBounds.MaxY - stDrawBounds.MinY;
+
+    //get width & height in pixels of draw area
+    pDisplay->World2DCDist(&dOutWidth, &dOutHeight, false);
+    dOutWidth = abs(dOutWidth);
+    dOutHeight = abs(dOutHeight);
+
+    RAWPIXELDATA stPixelData;
+    if(!GetPixelData(stPixelData, stDrawBounds, dOutWidth, dOutHeight))
+        return false;
+
+    bool bRes = Draw(stPixelData, DrawPhase, pDisplay, pTrackCancel);
+    CPLFree (stPixelData.pPixelData);
+    return bRes;
+}
+
+bool wxGISRasterRenderer::GetPixelData(RAWPIXELDATA &stPixelData, const OGREnvelope &stDrawBounds, double dOutWidth, double dOutHeight)
+{
     GDALDataset* pRaster = m_pwxGISRasterDataset->GetRaster();
     //create inverse geo transform to get pixel data
     double adfGeoTransform[6] = { 0, 0, 0, 0, 0, 0 };
@@ -641,15 +766,6 @@ bool wxGISRasterRenderer::Draw(wxGISEnumDrawPhase DrawPhase, wxGISDisplay* const
         int nRes = GDALInvGeoTransform( adfGeoTransform, adfReverseGeoTransform );
     }
 
-    //width & height of extent
-    double dOutWidth = stDrawBounds.MaxX - stDrawBounds.MinX;
-    double dOutHeight = stDrawBounds.MaxY - stDrawBounds.MinY;
-
-    //get width & height in pixels of draw area
-    pDisplay->World2DCDist(&dOutWidth, &dOutHeight, false);
-    dOutWidth = abs(dOutWidth);
-    dOutHeight = abs(dOutHeight);
-
     //round float pixel to int using ceil
     int nOutWidth = ceil(dOutWidth);
     int nOutHeight = ceil(dOutHeight);
@@ -686,16 +802,21 @@ bool wxGISRasterRenderer::Draw(wxGISEnumDrawPhase DrawPhase, wxGISDisplay* const
     double dWidth = stPixelBounds.MaxX - stPixelBounds.MinX;
     double dHeight = stPixelBounds.MaxY - stPixelBounds.MinY;
 
-    int nWidth = ceil(dWidth);
-    int nHeight = ceil(dHeight);
+    //round the pixel bounds, not the size, so the adjacent areas read the same source pixels
     int nMinX = floor(stPixelBounds.MinX);
     int nMinY = floor(stPixelBounds.MinY);
+    int nMaxX = ceil(stPixelBounds.MaxX);
+    int nMaxY = ceil(stPixelBounds.MaxY);
 
     //correct data
-    if(nWidth > nXSize) nWidth = nXSize;
-    if(nHeight > nYSize) nHeight = nYSize;
     if(nMinX < 0) nMinX = 0;
     if(nMinY < 0) nMinY = 0;
+    if(nMaxX > nXSize) nMaxX = nXSize;
+    if(nMaxY > nYSize) nMaxY = nYSize;
+    int nWidth = nMaxX - nMinX;
+    int nHeight = nMaxY - nMinY;
+    if(nWidth <= 0 || nHeight <= 0)
+        return false;
 
     GDALDataType eDT = m_pwxGISRasterDataset->GetDataType();
     int nDataSize = GDALGetDataTypeSize(eDT) / 8;
@@ -704,18 +825,12 @@ bool wxGISRasterRenderer::Draw(wxGISEnumDrawPhase DrawPhase, wxGISDisplay* const
     int nBandCount(0);
     int *panBands = GetBandsCombination(&nBandCount);
 
-    RAWPIXELDATA stPixelData;
     stPixelData.pPixelData = NULL;
     stPixelData.nOutputWidth = stPixelData.nOutputHeight = -1;
     //stPixelData.nPixelDataWidth = stPixelData.nPixelDataHeight = -1;
 
     if( nOutWidth > nWidth && nOutHeight > nHeight ) // not scale
     {
-        //increase little in data
-        //nWidth += 2; nHeight += 2;
-        if(nWidth > nXSize) nWidth = nXSize;
-        if(nHeight > nYSize) nHeight = nYSize;
-
         stPixelData.dPixelDeltaX = stPixelBounds.MinX - double(nMinX);// - 0.5;
         stPixelData.dPixelDeltaY = stPixelBounds.MinY - double(nMinY);// - 0.5;
         stPixelData.dPixelDataWidth = dWidth;
@@ -737,9 +852,6 @@ bool wxGISRasterRenderer::Draw(wxGISEnumDrawPhase DrawPhase, wxGISDisplay* const
         int nOverview = GDALBandGetBestOverviewLevel(pRaster->GetRasterBand(panBands[0]), nMinXTmp, nMinYTmp, nOutWidthOv, nOutHeightOv, nOutWidth, nOutHeight);
         if (nOverview >= 0)
         {
-            stPixelData.dPixelDeltaX = stPixelData.dPixelDeltaY = 0;
-            stPixelData.dPixelDataWidth = nOutWidthOv;
-            stPixelData.dPixelDataHeight = nOutHeightOv;
             stPixelData.nPixelDataWidth = nOutWidthOv;
             stPixelData.nPixelDataHeight = nOutHeightOv;
             stPixelData.nOutputWidth = nOutWidth;
@@ -747,16 +859,22 @@ bool wxGISRasterRenderer::Draw(wxGISEnumDrawPhase DrawPhase, wxGISDisplay* const
         }
         else
         {
-            stPixelData.dPixelDeltaX = stPixelData.dPixelDeltaY = 0;
-            stPixelData.dPixelDataWidth = nOutWidth;
-            stPixelData.dPixelDataHeight = nOutHeight;
             stPixelData.nPixelDataWidth = nOutWidth;
             stPixelData.nPixelDataHeight = nOutHeight;
         }
+        //the read window is wider than the draw bounds by the rounding, keep the subpixel offset in the read buffer pixels
+        double dRatioX = double(stPixelData.nPixelDataWidth) / nWidth;
+        double dRatioY = double(stPixelData.nPixelDataHeight) / nHeight;
+        stPixelData.dPixelDeltaX = (stPixelBounds.MinX - double(nMinX)) * dRatioX;
+        stPixelData.dPixelDeltaY = (stPixelBounds.MinY - double(nMinY)) * dRatioY;
+        stPixelData.dPixelDataWidth = dWidth * dRatioX;
+        stPixelData.dPixelDataHeight = dHeight * dRatioY;
     }
 
     data = CPLMalloc (stPixelData.nPixelDataWidth * stPixelData.nPixelDataHeight * nDataSize * nBandCount);
-    if(!m_pwxGISRasterDataset->GetPixelData(data, nMinX, nMinY, nWidth, nHeight, stPixelData.nPixelDataWidth, stPixelData.nPixelDataHeight, eDT, nBandCount, panBands))
+    bool bRes = m_pwxGISRasterDataset->GetPixelData(data, nMinX, nMinY, nWidth, nHeight, stPixelData.nPixelDataWidth, stPixelData.nPixelDataHeight, eDT, nBandCount, panBands);
+    wxDELETEA(panBands);
+    if(!bRes)
     {
         CPLFree (data);
         return false;
@@ -764,13 +882,10 @@ bool wxGISRasterRenderer::Draw(wxGISEnumDrawPhase DrawPhase, wxGISDisplay* const
 
     stPixelData.pPixelData = data;
     stPixelData.stWorldBounds = stDrawBounds;
-
-    bool bRes = Draw(stPixelData, DrawPhase, pDisplay, pTrackCancel);
-    CPLFree (data);
-    return bRes;
+    return true;
 }
 
-bool wxGISRasterRenderer::Draw(RAWPIXELDATA &stPixelData, wxGISEnumDrawPhase DrawPhase, wxGISDisplay * const pDisplay, ITrackCancel * const pTrackCancel)
+cairo_surface_t* wxGISRasterRenderer::RenderPixelData(RAWPIXELDATA &stPixelData, ITrackCancel * const pTrackCancel)
 {
     bool bScale = false;
     int nOutXSize, nOutYSize;
@@ -786,55 +901,174 @@ bool wxGISRasterRenderer::Draw(RAWPIXELDATA &stPixelData, wxGISEnumDrawPhase Dra
         nOutYSize = stPixelData.nOutputHeight;
     }
 
-    int stride = cairo_format_stride_for_width (CAIRO_FORMAT_ARGB32, nOutXSize);
-    if(stride == -1)
+    cairo_surface_t *surface = cairo_image_surface_create (CAIRO_FORMAT_ARGB32, nOutXSize, nOutYSize);
+    if(cairo_surface_status(surface) != CAIRO_STATUS_SUCCESS)
     {
         if(pTrackCancel)
-            pTrackCancel->PutMessage(_("cairo_format_stride_for_width failed"), wxNOT_FOUND, enumGISMessageError);
-        return false;
+            pTrackCancel->PutMessage(_("cairo_image_surface_create failed"), wxNOT_FOUND, enumGISMessageError);
+        cairo_surface_destroy(surface);
+        return NULL;
     }
-    unsigned char *pTransformPixelData = (unsigned char *)CPLMalloc (stride * nOutYSize);
-
-    cairo_surface_t *surface;
-    surface = cairo_image_surface_create_for_data (pTransformPixelData, CAIRO_FORMAT_ARGB32, nOutXSize, nOutYSize, stride);
-
-    //TODO: more parts
-    int CPUCount = wxThread::GetCPUCount();//1;//
-    wxVector<wxRasterDrawThread*> threadarray;
-    int nPartSize = nOutYSize / CPUCount;
+    cairo_surface_flush(surface);
+    //ARGB32 stride is 4 * width, the draw threads rely on it
+    unsigned char *pTransformPixelData = cairo_image_surface_get_data(surface);
+
+    //split the rows between the pool threads
+    wxGISRasterDrawPool* pPool = GetRasterDrawPool();
+    int nPartCount = wxMax(int(pPool->GetThreadCount()), 1);
+    if(nPartCount > nOutYSize)
+        nPartCount = nOutYSize;
+    wxVector<RASTERDRAWJOB> paJobs;
+    int nPartSize = nOutYSize / nPartCount;
     int nBegY(0), nEndY;
-    for(int i = 0; i < CPUCount; ++i)
+    for(int i = 0; i < nPartCount; ++i)
     {
-        if(i == CPUCount - 1)
+        if(i == nPartCount - 1)
             nEndY = nOutYSize;
         else
             nEndY = nPartSize * (i + 1);
 
-        unsigned char* pDestInputData = pTransformPixelData + (nBegY * 4 * nOutXSize);
-        wxRasterDrawThread *thread = new wxRasterDrawThread(stPixelData, m_pwxGISRasterDataset->GetDataType(), GetBandCount(), pDestInputData, bScale == true ? m_eQuality : enumGISQualityNearest, nOutXSize, nOutYSize, nBegY, nEndY, this, pTrackCancel);
-        if(CreateAndRunThread(thread, wxT("wxRasterDrawThread"), wxT("RasterDrawThread")))
-            threadarray.push_back(thread);
+        RASTERDRAWJOB stJob = {&stPixelData, m_pwxGISRasterDataset->GetDataType(), GetBandCount(), pTransformPixelData + (nBegY * 4 * nOutXSize), bScale == true ? m_eQuality : enumGISQualityNearest, nOutXSize, nOutYSize, nBegY, nEndY, this, pTrackCancel, NULL};
+        paJobs.push_back(stJob);
         nBegY = nEndY;
     }
+    pPool->Draw(paJobs);
 
-    for(size_t i = 0; i < threadarray.size(); ++i)
-    {
-        wgDELETE(threadarray[i], Wait());
+    cairo_surface_mark_dirty(surface);
+    return surface;
+}
 
-        cairo_surface_mark_dirty(surface);
-        pDisplay->DrawRaster(surface, stPixelData.stWorldBounds);
-        cairo_surface_flush(surface);
-    }
-    ///////////////////////////////////////////////////////////////////////////////////////////////////////////
-    //pDisplay->DrawRaster(surface, stPixelData.stWorldBounds);
+bool wxGISRasterRenderer::Draw(RAWPIXELDATA &stPixelData, wxGISEnumDrawPhase DrawPhase, wxGISDisplay * const pDisplay, ITrackCancel * const pTrackCancel)
+{
+    cairo_surface_t *surface = RenderPixelData(stPixelData, pTrackCancel);
+    if(surface == NULL)
+        return false;
 
+    pDisplay->DrawRaster(surface, stPixelData.stWorldBounds);
     cairo_surface_destroy(surface);
 
-    CPLFree((void*)pTransformPixelData);
+    return true;
+}
+
+bool wxGISRasterRenderer::DrawTiles(const OGREnvelope &stDrawBounds, wxGISEnumDrawPhase DrawPhase, wxGISDisplay* const pDisplay, ITrackCancel* const pTrackCancel)
+{
+    wxGISRasterTileCache* pTileCache = GetRasterTileCache();
+
+    //display pixels per world unit
+    double dScaleX = 1.0, dScaleY = 1.0;
+    pDisplay->World2DCDist(&dScaleX, &dScaleY, false);
+    double dScale = fabs(dScaleX);
+    if(dScale <= 0)
+        return false;
+
+    //snap the scale to the pyramid level
+    long nLevel = (long)floor(log(dScale) / log(2.0) * RASTER_TILE_LEVEL_STEPS + 0.5);
+    double dTileScale = pow(2.0, double(nLevel) / RASTER_TILE_LEVEL_STEPS);
+    double dTileWorldX = double(m_nTileSizeX) / dTileScale;
+    double dTileWorldY = double(m_nTileSizeY) / dTileScale;
+
+    OGREnvelope stRasterExtent = m_pwxGISRasterDataset->GetEnvelope();
+    wxString sKeyPrefix = wxString::Format(wxT("%s|%s|%ld|%dx%d|%.6f"), m_sDatasetKey.c_str(), GetSettingsKey().c_str(), nLevel, m_nTileSizeX, m_nTileSizeY, pDisplay->GetRotate());
+
+    double dMinTileX = floor(stDrawBounds.MinX / dTileWorldX), dMaxTileX = floor(stDrawBounds.MaxX / dTileWorldX);
+    double dMinTileY = floor(stDrawBounds.MinY / dTileWorldY), dMaxTileY = floor(stDrawBounds.MaxY / dTileWorldY);
+
+    for(double dTileY = dMaxTileY; dTileY >= dMinTileY; dTileY -= 1.0)
+    {
+        for(double dTileX = dMinTileX; dTileX <= dMaxTileX; dTileX += 1.0)
+        {
+            if(pTrackCancel && !pTrackCancel->Continue())
+                return false;
+
+            wxString sKey = sKeyPrefix + wxString::Format(wxT("|%.0f|%.0f"), dTileX, dTileY);
+            OGREnvelope stTileBounds;
+            cairo_surface_t *surface = pTileCache->GetTile(sKey, stTileBounds);
+            if(surface == NULL)
+            {
+                //render only the part of tile covered by raster
+                stTileBounds.MinX = dTileX * dTileWorldX;
+                stTileBounds.MaxX = stTileBounds.MinX + dTileWorldX;
+                stTileBounds.MinY = dTileY * dTileWorldY;
+                stTileBounds.MaxY = stTileBounds.MinY + dTileWorldY;
+                if(!stTileBounds.Intersects(stRasterExtent))
+                    continue;
+                stTileBounds.Intersect(stRasterExtent);
+                if(!stTileBounds.IsInit())
+                    continue;
+
+                //snap the tile to the global pixel grid of the level, so the adjacent tiles do not overlap or leave gaps
+                double dPixMinX = floor(stTileBounds.MinX * dTileScale + 0.5);
+                double dPixMaxX = floor(stTileBounds.MaxX * dTileScale + 0.5);
+                double dPixMinY = floor(stTileBounds.MinY * dTileScale + 0.5);
+                double dPixMaxY = floor(stTileBounds.MaxY * dTileScale + 0.5);
+                double dOutWidth = dPixMaxX - dPixMinX;
+                double dOutHeight = dPixMaxY - dPixMinY;
+                if(dOutWidth < 1.0 || dOutHeight < 1.0)
+                    continue;
+                stTileBounds.MinX = dPixMinX / dTileScale;
+                stTileBounds.MaxX = dPixMaxX / dTileScale;
+                stTileBounds.MinY = dPixMinY / dTileScale;
+                stTileBounds.MaxY = dPixMaxY / dTileScale;
+
+                RAWPIXELDATA stPixelData;
+                if(!GetPixelData(stPixelData, stTileBounds, dOutWidth, dOutHeight))
+                    continue;
+                surface = RenderPixelData(stPixelData, pTrackCancel);
+                CPLFree (stPixelData.pPixelData);
+                if(surface == NULL)
+                    continue;
+
+                //not store the partially drawn tiles
+                if(pTrackCancel && !pTrackCancel->Continue())
+                {
+                    cairo_surface_destroy(surface);
+                    return false;
+                }
+                pTileCache->PutTile(sKey, surface, stTileBounds);
+            }
+
+            pDisplay->DrawRaster(surface, stTileBounds);
+            cairo_surface_destroy(surface);
+        }
+    }
 
     return true;
 }
 
+wxString wxGISRasterRenderer::GetSettingsKey(void) const
+{
+    return wxString::Format(wxT("q%d;nd%02x%02x%02x%02x"), m_eQuality, m_oNoDataColor.Red(), m_oNoDataColor.Green(), m_oNoDataColor.Blue(), m_oNoDataColor.Alpha());
+}
+
+void wxGISRasterRenderer::FillRow(unsigned char* pOutputData, const float* const* papfSrcBands, int nBandCount, int nCount, unsigned char* pScratch)
+{
+    double dfR, dfG, dfB, dfA;
+    for(int i = 0; i < nCount; ++i)
+    {
+        dfR = papfSrcBands[0][i];
+        switch(nBandCount)
+        {
+        case 1:
+            FillPixel(pOutputData, &dfR, NULL, NULL, NULL);
+            break;
+        case 3:
+            dfG = papfSrcBands[1][i];
+            dfB = papfSrcBands[2][i];
+            FillPixel(pOutputData, &dfR, &dfG, &dfB, NULL);
+            break;
+        case 4:
+            dfG = papfSrcBands[1][i];
+            dfB = papfSrcBands[2][i];
+            dfA = papfSrcBands[3][i];
+            FillPixel(pOutputData, &dfR, &dfG, &dfB, &dfA);
+            break;
+        default:
+            break;
+        };
+        pOutputData += 4;//ARGB32
+    }
+}
+
 //-----------------------------------
 // wxGISRasterRGBARenderer
 //-----------------------------------
@@ -1012,6 +1246,14 @@ short wxGISRasterRGBARenderer::GetBandCount() const
     return m_nAlphaBand == -1 ? 3 : 4;
 }
 
+wxString wxGISRasterRGBARenderer::GetSettingsKey(void) const
+{
+    wxString sKey = wxGISRasterRenderer::GetSettingsKey() + wxString::Format(wxT(";b%d,%d,%d,%d;%d"), m_nRedBand, m_nGreenBand, m_nBlueBand, m_nAlphaBand, m_bNodataNewBehaviour);
+    for(size_t i = 0; i < 4; ++i)
+        sKey += wxT(";") + m_paStretch[i]->GetKey();
+    return sKey;
+}
+
 void wxGISRasterRGBARenderer::FillPixel(unsigned char* pOutputData, const double *pSrcValR, const double *pSrcValG, const double *pSrcValB, const double *pSrcValA)
 {
     if(pSrcValR == NULL)
@@ -1089,6 +1331,110 @@ void wxGISRasterRGBARenderer::FillPixel(unsigned char* pOutputData, const double
 
 }
 
+void wxGISRasterRGBARenderer::FillRow(unsigned char* pOutputData, const float* const* papfSrcBands, int nBandCount, int nCount, unsigned char* pScratch)
+{
+    unsigned char *pR = pScratch;
+    unsigned char *pG = pR + nCount;
+    unsigned char *pB = pG + nCount;
+    unsigned char *pA = pB + nCount;
+    unsigned char *pMask = pA + nCount;
+    unsigned char *pBandMask = pMask + nCount;
+
+    const float *pfR = papfSrcBands[0];
+    const float *pfG = pfR, *pfB = pfR;
+
+    m_paStretch[0]->GetValues(pfR, pR, nCount);
+    if(nBandCount > 2)
+    {
+        pfG = papfSrcBands[1];
+        pfB = papfSrcBands[2];
+        m_paStretch[1]->GetValues(pfG, pG, nCount);
+        m_paStretch[2]->GetValues(pfB, pB, nCount);
+    }
+    else
+    {
+        pG = pB = pR;
+    }
+
+    //check for nodata
+    m_paStretch[0]->GetNoDataMask(pfR, pMask, nCount);
+    m_paStretch[1]->GetNoDataMask(pfG, pBandMask, nCount);
+    for(int i = 0; i < nCount; ++i)
+        pMask[i] = m_bNodataNewBehaviour ? pMask[i] & pBandMask[i] : pMask[i] | pBandMask[i];
+    m_paStretch[2]->GetNoDataMask(pfB, pBandMask, nCount);
+    for(int i = 0; i < nCount; ++i)
+        pMask[i] = m_bNodataNewBehaviour ? pMask[i] & pBandMask[i] : pMask[i] | pBandMask[i];
+
+    if(nBandCount > 3)
+    {
+        m_paStretch[3]->GetValues(papfSrcBands[3], pA, nCount);
+        //full transparant
+        for(int i = 0; i < nCount; ++i)
+            if(pA[i] == 0)
+                pMask[i] = 0xFF;
+    }
+
+    wxUint32 nNoDataColor = ((wxUint32)m_oNoDataColor.Alpha() << 24) | ((wxUint32)m_oNoDataColor.Red() << 16) | ((wxUint32)m_oNoDataColor.Green() << 8) | (wxUint32)m_oNoDataColor.Blue();
+    PackARGB32Row(pR, pG, pB, nBandCount > 3 ? pA : NULL, pMask, nNoDataColor, pOutputData, nCount);
+}
+
+bool wxGISRasterRGBARenderer::PrepareLUT(GDALDataType eSrcType, RASTERLUT &stLUT)
+{
+    for(short i = 0; i < GetBandCount(); ++i)
+    {
+        if(!m_paStretch[i]->CopyLUT(eSrcType, stLUT.aLUT[i], stLUT.aNoDataLUT[i]))
+            return false;
+    }
+    return true;
+}
+
+void wxGISRasterRGBARenderer::FillRowLUT(unsigned char* pOutputData, const wxUint16* const* papnSrcBands, int nBandCount, int nCount, const RASTERLUT &stLUT, unsigned char* pScratch)
+{
+    unsigned char *pR = pScratch;
+    unsigned char *pG = pR + nCount;
+    unsigned char *pB = pG + nCount;
+    unsigned char *pA = pB + nCount;
+    unsigned char *pMask = pA + nCount;
+    unsigned char *pBandMask = pMask + nCount;
+
+    const wxUint16 *pnR = papnSrcBands[0];
+    const wxUint16 *pnG = pnR, *pnB = pnR;
+
+    LookupRow(&stLUT.aLUT[0][0], pnR, pR, nCount);
+    if(nBandCount > 2)
+    {
+        pnG = papnSrcBands[1];
+        pnB = papnSrcBands[2];
+        LookupRow(&stLUT.aLUT[1][0], pnG, pG, nCount);
+        LookupRow(&stLUT.aLUT[2][0], pnB, pB, nCount);
+    }
+    else
+    {
+        pG = pB = pR;
+    }
+
+    //check for nodata
+    LookupRow(&stLUT.aNoDataLUT[0][0], pnR, pMask, nCount);
+    LookupRow(&stLUT.aNoDataLUT[1][0], pnG, pBandMask, nCount);
+    for(int i = 0; i < nCount; ++i)
+        pMask[i] = m_bNodataNewBehaviour ? pMask[i] & pBandMask[i] : pMask[i] | pBandMask[i];
+    LookupRow(&stLUT.aNoDataLUT[2][0], pnB, pBandMask, nCount);
+    for(int i = 0; i < nCount; ++i)
+        pMask[i] = m_bNodataNewBehaviour ? pMask[i] & pBandMask[i] : pMask[i] | pBandMask[i];
+
+    if(nBandCount > 3)
+    {
+        LookupRow(&stLUT.aLUT[3][0], papnSrcBands[3], pA, nCount);
+        //full transparant
+        for(int i = 0; i < nCount; ++i)
+            if(pA[i] == 0)
+                pMask[i] = 0xFF;
+    }
+
+    wxUint32 nNoDataColor = ((wxUint32)m_oNoDataColor.Alpha() << 24) | ((wxUint32)m_oNoDataColor.Red() << 16) | ((wxUint32)m_oNoDataColor.Green() << 8) | (wxUint32)m_oNoDataColor.Blue();
+    PackARGB32Row(pR, pG, pB, nBandCount > 3 ? pA : NULL, pMask, nNoDataColor, pOutputData, nCount);
+}
+
 //-----------------------------------
 // wxGISRasterRasterColormapRenderer
 //-----------------------------------
@@ -1152,6 +1498,11 @@ short wxGISRasterRasterColormapRenderer::GetBandCount() const
     return 1;
 }
 
+wxString wxGISRasterRasterColormapRenderer::GetSettingsKey(void) const
+{
+    return wxGISRasterRenderer::GetSettingsKey() + wxString::Format(wxT(";b%d"), m_nBandNumber);
+}
+
 void wxGISRasterRasterColormapRenderer::OnFillColorTable(void)
 {
     GDALDataset* poGDALDataset = m_pwxGISRasterDataset->GetMainRaster();
@@ -1365,6 +1716,11 @@ short wxGISRasterGreyScaleRenderer::GetBandCount() const
     return 1;
 }
 
+wxString wxGISRasterGreyScaleRenderer::GetSettingsKey(void) const
+{
+    return wxGISRasterRenderer::GetSettingsKey() + wxString::Format(wxT(";t%d;b%d;"), GetRasterRenderType(), m_nBand) + m_oStretch.GetKey();
+}
+
 void wxGISRasterGreyScaleRenderer::FillPixel(unsigned char* pOutputData, const double *pSrcValR, const double *pSrcValG, const double *pSrcValB, const double *pSrcValA)
 {
     if(pSrcValR == NULL)
@@ -1394,6 +1750,36 @@ void wxGISRasterGreyScaleRenderer::FillPixel(unsigned char* pOutputData, const d
     }
 }
 
+void wxGISRasterGreyScaleRenderer::FillRow(unsigned char* pOutputData, const float* const* papfSrcBands, int nBandCount, int nCount, unsigned char* pScratch)
+{
+    unsigned char *pR = pScratch;
+    unsigned char *pMask = pR + nCount;
+
+    m_oStretch.GetValues(papfSrcBands[0], pR, nCount);
+    //check for nodata
+    m_oStretch.GetNoDataMask(papfSrcBands[0], pMask, nCount);
+
+    wxUint32 nNoDataColor = ((wxUint32)m_oNoDataColor.Alpha() << 24) | ((wxUint32)m_oNoDataColor.Red() << 16) | ((wxUint32)m_oNoDataColor.Green() << 8) | (wxUint32)m_oNoDataColor.Blue();
+    PackARGB32Row(pR, pR, pR, NULL, pMask, nNoDataColor, pOutputData, nCount);
+}
+
+bool wxGISRasterGreyScaleRenderer::PrepareLUT(GDALDataType eSrcType, RASTERLUT &stLUT)
+{
+    return m_oStretch.CopyLUT(eSrcType, stLUT.aLUT[0], stLUT.aNoDataLUT[0]);
+}
+
+void wxGISRasterGreyScaleRenderer::FillRowLUT(unsigned char* pOutputData, const wxUint16* const* papnSrcBands, int nBandCount, int nCount, const RASTERLUT &stLUT, unsigned char* pScratch)
+{
+    unsigned char *pR = pScratch;
+    unsigned char *pMask = pR + nCount;
+
+    LookupRow(&stLUT.aLUT[0][0], papnSrcBands[0], pR, nCount);
+    //check for nodata
+    LookupRow(&stLUT.aNoDataLUT[0][0], papnSrcBands[0], pMask, nCount);
+
+    wxUint32 nNoDataColor = ((wxUint32)m_oNoDataColor.Alpha() << 24) | ((wxUint32)m_oNoDataColor.Red() << 16) | ((wxUint32)m_oNoDataColor.Green() << 8) | (wxUint32)m_oNoDataColor.Blue();
+    PackARGB32Row(pR, pR, pR, NULL, pMask, nNoDataColor, pOutputData, nCount);
+}
 
 //-----------------------------------
 // wxGISRasterPackedRGBARenderer
@@ -0,0 +1,457 @@
+/******************************************************************************
+ * Project:  wxGIS
+ * Purpose:  wxGISRasterTileCache class. Rendered raster tiles cache.
+ * Author:   Dmitry Baryshnikov (aka Bishop), polimax@mail.ru
+ ******************************************************************************
+*   Copyright (C) 2014 Dmitry Baryshnikov
+*
+*    This program is free software: you can redistribute it and/or modify
+*    it under the terms of the GNU General Public License as published by
+*    the Free Software Foundation, either version 2 of the License, or
+*    (at your option) any later version.
+*
+*    This program is distributed in the hope that it will be useful,
+*    but WITHOUT ANY WARRANTY; without even the implied warranty of
+*    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+*    GNU General Public License for more details.
+*
+*    You should have received a copy of the GNU General Public License
+*    along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ ****************************************************************************/
+#include "wxgis/carto/rastertilecache.h"
+#include "wxgis/core/config.h"
+#include "wxgis/core/app.h"
+
+#include <wx/file.h>
+#include <wx/dir.h>
+#include <wx/module.h>
+
+#include <algorithm>
+
+#define TILE_FILE_MAGIC "WXGISTL1"
+
+static wxGISRasterTileCache *g_pRasterTileCache( NULL );
+static wxCriticalSection g_RasterTileCacheCritSect;
+
+extern WXDLLIMPEXP_GIS_CRT wxGISRasterTileCache* const GetRasterTileCache(void)
+{
+    wxCriticalSectionLocker locker(g_RasterTileCacheCritSect);
+    if(g_pRasterTileCache == NULL)
+    {
+        int nSizeMb = 128;
+        int nSpillSizeMb = RASTER_TILE_SPILL_SIZE;
+        wxString sSpillDir;
+        wxGISAppConfig oConfig = GetConfig();
+        if(oConfig.IsOk())
+        {
+            wxString sAppName = GetApplication()->GetAppName();
+            nSizeMb = oConfig.ReadInt(enumGISHKCU, sAppName + wxString(wxT("/renderer/raster/tile_cache_size")), nSizeMb);
+            sSpillDir = oConfig.Read(enumGISHKCU, sAppName + wxString(wxT("/renderer/raster/tile_cache_dir")), sSpillDir);
+            nSpillSizeMb = oConfig.ReadInt(enumGISHKCU, sAppName + wxString(wxT("/renderer/raster/tile_cache_dir_size")), nSpillSizeMb);
+        }
+        g_pRasterTileCache = new wxGISRasterTileCache(size_t(nSizeMb) * 1024 * 1024, sSpillDir, wxULongLong(nSpillSizeMb) * 1024 * 1024);
+    }
+	return g_pRasterTileCache;
+}
+
+/** \class wxGISRasterTileCacheModule rastertilecache.cpp
+    \brief Destroy the global raster tile cache on program exit
+*/
+
+class wxGISRasterTileCacheModule : public wxModule
+{
+    DECLARE_DYNAMIC_CLASS(wxGISRasterTileCacheModule)
+public:
+    virtual bool OnInit() { return true; };
+    virtual void OnExit()
+    {
+        wxCriticalSectionLocker locker(g_RasterTileCacheCritSect);
+        wxDELETE(g_pRasterTileCache);
+    };
+};
+
+IMPLEMENT_DYNAMIC_CLASS(wxGISRasterTileCacheModule, wxModule)
+
+//----------------------------------------------------------------------------
+// wxGISRasterTileCache
+//----------------------------------------------------------------------------
+
+typedef struct _tilefileinfo
+{
+    wxString sPath;
+    wxULongLong nSize;
+    time_t nTime;
+    bool operator<(const _tilefileinfo &other) const { return nTime < other.nTime; }
+} TILEFILEINFO;
+
+wxGISRasterTileCache::wxGISRasterTileCache(size_t nMemoryBudget, const wxString &sSpillDir, wxULongLong nSpillBudget)
+{
+    m_nMemoryBudget = nMemoryBudget;
+    m_nMemoryUsed = 0;
+    m_nSpillBudget = nSpillBudget;
+    m_nSpillUsed = 0;
+    SetSpillDir(sSpillDir);
+}
+
+wxGISRasterTileCache::~wxGISRasterTileCache(void)
+{
+    Clear();
+}
+
+cairo_surface_t* wxGISRasterTileCache::GetTile(const wxString &sKey, OGREnvelope &stEnvelope)
+{
+    wxString sSpillDir;
+    {
+        wxCriticalSectionLocker locker(m_CritSect);
+        std::map<wxString, TILEENTRY>::iterator it = m_mTiles.find(sKey);
+        if(it != m_mTiles.end())
+        {
+            //move to the head of LRU list
+            m_lLRU.splice(m_lLRU.begin(), m_lLRU, it->second.itLRU);
+            stEnvelope = it->second.stEnvelope;
+            return cairo_surface_reference(it->second.pSurface);
+        }
+        sSpillDir = m_sSpillDir;
+    }
+
+    if(sSpillDir.IsEmpty())
+        return NULL;
+
+    //read the file without the lock, the other thread may load the same tile, the last inserted one is kept
+    cairo_surface_t* pSurface = LoadSpilled(GetSpillPath(sSpillDir, sKey), sKey, stEnvelope);
+    if(pSurface == NULL)
+        return NULL;
+
+    wxVector<EVICTEDTILE> astEvicted;
+    {
+        wxCriticalSectionLocker locker(m_CritSect);
+        Insert(sKey, pSurface, stEnvelope, astEvicted);
+        cairo_surface_reference(pSurface);
+    }
+    SpillEvicted(astEvicted);
+    return pSurface;
+}
+
+void wxGISRasterTileCache::PutTile(const wxString &sKey, cairo_surface_t* pSurface, const OGREnvelope &stEnvelope)
+{
+    wxCHECK_RET(pSurface, wxT("Tile surface pointer is NULL"));
+    wxVector<EVICTEDTILE> astEvicted;
+    {
+        wxCriticalSectionLocker locker(m_CritSect);
+        Insert(sKey, cairo_surface_reference(pSurface), stEnvelope, astEvicted);
+    }
+    SpillEvicted(astEvicted);
+}
+
+void wxGISRasterTileCache::Insert(const wxString &sKey, cairo_surface_t* pSurface, const OGREnvelope &stEnvelope, wxVector<EVICTEDTILE> &astEvicted)
+{
+    std::map<wxString, TILEENTRY>::iterator it = m_mTiles.find(sKey);
+    if(it != m_mTiles.end())
+    {
+        m_nMemoryUsed -= it->second.nSize;
+        cairo_surface_destroy(it->second.pSurface);
+        m_lLRU.erase(it->second.itLRU);
+        m_mTiles.erase(it);
+    }
+
+    TILEENTRY stEntry;
+    stEntry.pSurface = pSurface;
+    stEntry.stEnvelope = stEnvelope;
+    stEntry.nSize = size_t(cairo_image_surface_get_stride(pSurface)) * cairo_image_surface_get_height(pSurface);
+    m_lLRU.push_front(sKey);
+    stEntry.itLRU = m_lLRU.begin();
+    m_mTiles[sKey] = stEntry;
+    m_nMemoryUsed += stEntry.nSize;
+
+    Evict(astEvicted);
+}
+
+void wxGISRasterTileCache::Evict(wxVector<EVICTEDTILE> &astEvicted)
+{
+    //keep at least the last inserted tile
+    while(m_nMemoryUsed > m_nMemoryBudget && m_lLRU.size() > 1)
+    {
+        wxString sKey = m_lLRU.back();
+        m_lLRU.pop_back();
+        std::map<wxString, TILEENTRY>::iterator it = m_mTiles.find(sKey);
+        if(it == m_mTiles.end())
+            continue;
+        m_nMemoryUsed -= it->second.nSize;
+        if(m_sSpillDir.IsEmpty())
+        {
+            cairo_surface_destroy(it->second.pSurface);
+        }
+        else
+        {
+            EVICTEDTILE stTile;
+            stTile.sKey = sKey;
+            stTile.pSurface = it->second.pSurface;
+            stTile.stEnvelope = it->second.stEnvelope;
+            astEvicted.push_back(stTile);
+        }
+        m_mTiles.erase(it);
+    }
+}
+
+void wxGISRasterTileCache::SpillEvicted(wxVector<EVICTEDTILE> &astEvicted)
+{
+    if(astEvicted.empty())
+        return;
+
+    wxString sSpillDir = GetSpillDir();
+    bool bTrim = false;
+    for(size_t i = 0; i < astEvicted.size(); ++i)
+    {
+        if(!sSpillDir.IsEmpty())
+        {
+            wxULongLong nFileSize = 0;
+            if(Spill(GetSpillPath(sSpillDir, astEvicted[i].sKey), astEvicted[i], nFileSize))
+            {
+                wxCriticalSectionLocker locker(m_SpillCritSect);
+                m_nSpillUsed += nFileSize;
+                bTrim = bTrim || m_nSpillUsed > m_nSpillBudget;
+            }
+        }
+        cairo_surface_destroy(astEvicted[i].pSurface);
+    }
+    astEvicted.clear();
+
+    if(bTrim)
+        TrimSpillDir(sSpillDir);
+}
+
+void wxGISRasterTileCache::Clear(void)
+{
+    wxCriticalSectionLocker locker(m_CritSect);
+    for(std::map<wxString, TILEENTRY>::iterator it = m_mTiles.begin(); it != m_mTiles.end(); ++it)
+        cairo_surface_destroy(it->second.pSurface);
+    m_mTiles.clear();
+    m_lLRU.clear();
+    m_nMemoryUsed = 0;
+}
+
+void wxGISRasterTileCache::SetMemoryBudget(size_t nMemoryBudget)
+{
+    wxVector<EVICTEDTILE> astEvicted;
+    {
+        wxCriticalSectionLocker locker(m_CritSect);
+        m_nMemoryBudget = nMemoryBudget;
+        Evict(astEvicted);
+    }
+    SpillEvicted(astEvicted);
+}
+
+void wxGISRasterTileCache::SetSpillDir(const wxString &sSpillDir)
+{
+    wxString sDir = sSpillDir;
+    if(!sDir.IsEmpty() && !wxFileName::DirExists(sDir))
+    {
+        if(!wxFileName::Mkdir(sDir, 0755, wxPATH_MKDIR_FULL))
+        {
+            wxLogError(_("Failed to create the raster tile cache directory %s"), sDir.c_str());
+            sDir.Clear();
+        }
+    }
+
+    //count the tiles of previous sessions, the keys have the source modification time so they are still valid
+    wxULongLong nSpillUsed = 0;
+    if(!sDir.IsEmpty())
+    {
+        wxArrayString saFiles;
+        wxDir::GetAllFiles(sDir, &saFiles, wxT("*.tile*"), wxDIR_FILES);
+        for(size_t i = 0; i < saFiles.GetCount(); ++i)
+        {
+            wxFileName oFileName(saFiles[i]);
+            if(oFileName.GetExt().IsSameAs(wxT("tmp"), false))
+            {
+                wxRemoveFile(saFiles[i]);
+                continue;
+            }
+            wxULongLong nSize = oFileName.GetSize();
+            if(nSize != wxInvalidSize)
+                nSpillUsed += nSize;
+        }
+    }
+
+    {
+        wxCriticalSectionLocker locker(m_CritSect);
+        m_sSpillDir = sDir;
+    }
+
+    bool bTrim;
+    {
+        wxCriticalSectionLocker locker(m_SpillCritSect);
+        m_nSpillUsed = nSpillUsed;
+        bTrim = m_nSpillUsed > m_nSpillBudget;
+    }
+    if(bTrim)
+        TrimSpillDir(sDir);
+}
+
+wxString wxGISRasterTileCache::GetSpillDir(void) const
+{
+    wxCriticalSectionLocker locker(const_cast<wxGISRasterTileCache*>(this)->m_CritSect);
+    return m_sSpillDir;
+}
+
+void wxGISRasterTileCache::SetSpillBudget(wxULongLong nSpillBudget)
+{
+    bool bTrim;
+    {
+        wxCriticalSectionLocker locker(m_SpillCritSect);
+        m_nSpillBudget = nSpillBudget;
+        bTrim = m_nSpillUsed > m_nSpillBudget;
+    }
+    if(bTrim)
+        TrimSpillDir(GetSpillDir());
+}
+
+wxULongLong wxGISRasterTileCache::GetSpillBudget(void) const
+{
+    wxCriticalSectionLocker locker(const_cast<wxGISRasterTileCache*>(this)->m_SpillCritSect);
+    return m_nSpillBudget;
+}
+
+void wxGISRasterTileCache::TrimSpillDir(const wxString &sSpillDir)
+{
+    if(sSpillDir.IsEmpty())
+        return;
+
+    //one thread trims, the others continue to spill
+    wxCriticalSectionLocker locker(m_SpillCritSect);
+    if(m_nSpillUsed <= m_nSpillBudget)
+        return;
+
+    wxArrayString saFiles;
+    wxDir::GetAllFiles(sSpillDir, &saFiles, wxT("*.tile"), wxDIR_FILES);
+    wxVector<TILEFILEINFO> astFiles;
+    wxULongLong nSpillUsed = 0;
+    for(size_t i = 0; i < saFiles.GetCount(); ++i)
+    {
+        wxFileName oFileName(saFiles[i]);
+        TILEFILEINFO stInfo;
+        stInfo.sPath = saFiles[i];
+        stInfo.nSize = oFileName.GetSize();
+        if(stInfo.nSize == wxInvalidSize)
+            continue;
+        stInfo.nTime = oFileName.GetModificationTime().GetTicks();
+        nSpillUsed += stInfo.nSize;
+        astFiles.push_back(stInfo);
+    }
+
+    //remove the oldest tiles down to 3/4 of the limit, so the directory is not scanned on each spill
+    std::sort(astFiles.begin(), astFiles.end());
+    wxULongLong nTarget = m_nSpillBudget - m_nSpillBudget / 4;
+    for(size_t i = 0; i < astFiles.size() && nSpillUsed > nTarget; ++i)
+    {
+        if(wxRemoveFile(astFiles[i].sPath))
+            nSpillUsed -= astFiles[i].nSize;
+    }
+    m_nSpillUsed = nSpillUsed;
+}
+
+wxString wxGISRasterTileCache::GetSpillPath(const wxString &sSpillDir, const wxString &sKey) const
+{
+    //FNV-1a hash of the key, the full key is stored in the file to check collisions
+    wxCharBuffer buf = sKey.ToUTF8();
+    wxUint32 nHash1 = 2166136261U, nHash2 = 84696351U;
+    for(const char *p = buf.data(); *p; ++p)
+    {
+        nHash1 = (nHash1 ^ (unsigned char)*p) * 16777619U;
+        nHash2 = (nHash2 ^ (unsigned char)*p) * 16777619U;
+    }
+    wxFileName oFileName(sSpillDir, wxString::Format(wxT("%08x%08x"), nHash1, nHash2), wxT("tile"));
+    return oFileName.GetFullPath();
+}
+
+bool wxGISRasterTileCache::Spill(const wxString &sPath, const EVICTEDTILE &stTile, wxULongLong &nFileSize)
+{
+    if(wxFileName::FileExists(sPath))
+        return false;
+
+    cairo_surface_flush(stTile.pSurface);
+    int nWidth = cairo_image_surface_get_width(stTile.pSurface);
+    int nHeight = cairo_image_surface_get_height(stTile.pSurface);
+    int nStride = cairo_image_surface_get_stride(stTile.pSurface);
+    unsigned char *pData = cairo_image_surface_get_data(stTile.pSurface);
+    if(pData == NULL)
+        return false;
+
+    //write to temp file and rename to not leave the partial tiles, the other thread may spill the same tile
+    wxString sTmpPath = sPath + wxString::Format(wxT(".%lu.tmp"), (unsigned long)wxThread::GetCurrentId());
+    wxFile oFile;
+    if(!oFile.Create(sTmpPath, true))
+        return false;
+
+    wxCharBuffer buf = stTile.sKey.ToUTF8();
+    wxUint32 nKeyLen = strlen(buf.data());
+    double adfEnv[4] = {stTile.stEnvelope.MinX, stTile.stEnvelope.MinY, stTile.stEnvelope.MaxX, stTile.stEnvelope.MaxY};
+    wxInt32 anSize[3] = {nWidth, nHeight, nStride};
+
+    bool bRes = oFile.Write(TILE_FILE_MAGIC, 8) == 8;
+    bRes = bRes && oFile.Write(&nKeyLen, sizeof(nKeyLen)) == sizeof(nKeyLen);
+    bRes = bRes && oFile.Write(buf.data(), nKeyLen) == nKeyLen;
+    bRes = bRes && oFile.Write(adfEnv, sizeof(adfEnv)) == sizeof(adfEnv);
+    bRes = bRes && oFile.Write(anSize, sizeof(anSize)) == sizeof(anSize);
+    bRes = bRes && oFile.Write(pData, size_t(nStride) * nHeight) == size_t(nStride) * nHeight;
+    oFile.Close();
+
+    if(!bRes || !wxRenameFile(sTmpPath, sPath, true))
+    {
+        wxRemoveFile(sTmpPath);
+        return false;
+    }
+    nFileSize = wxULongLong(8 + sizeof(nKeyLen) + nKeyLen + sizeof(adfEnv) + sizeof(anSize)) + wxULongLong(size_t(nStride) * nHeight);
+    return true;
+}
+
+cairo_surface_t* wxGISRasterTileCache::LoadSpilled(const wxString &sPath, const wxString &sKey, OGREnvelope &stEnvelope)
+{
+    if(!wxFileName::FileExists(sPath))
+        return NULL;
+
+    wxFile oFile(sPath);
+    if(!oFile.IsOpened())
+        return NULL;
+
+    char szMagic[8];
+    wxUint32 nKeyLen;
+    if(oFile.Read(szMagic, 8) != 8 || strncmp(szMagic, TILE_FILE_MAGIC, 8) != 0)
+        return NULL;
+    if(oFile.Read(&nKeyLen, sizeof(nKeyLen)) != sizeof(nKeyLen) || nKeyLen > 65536)
+        return NULL;
+
+    wxCharBuffer buf = sKey.ToUTF8();
+    if(nKeyLen != strlen(buf.data()))
+        return NULL;
+    wxCharBuffer bufStored(nKeyLen);
+    if(oFile.Read(bufStored.data(), nKeyLen) != nKeyLen || strncmp(bufStored.data(), buf.data(), nKeyLen) != 0)
+        return NULL;
+
+    double adfEnv[4];
+    wxInt32 anSize[3];
+    if(oFile.Read(adfEnv, sizeof(adfEnv)) != sizeof(adfEnv) || oFile.Read(anSize, sizeof(anSize)) != sizeof(anSize))
+        return NULL;
+
+    cairo_surface_t* pSurface = cairo_image_surface_create(CAIRO_FORMAT_ARGB32, anSize[0], anSize[1]);
+    if(cairo_surface_status(pSurface) != CAIRO_STATUS_SUCCESS || cairo_image_surface_get_stride(pSurface) != anSize[2])
+    {
+        cairo_surface_destroy(pSurface);
+        return NULL;
+    }
+
+    cairo_surface_flush(pSurface);
+    size_t nDataSize = size_t(anSize[2]) * anSize[1];
+    if(oFile.Read(cairo_image_surface_get_data(pSurface), nDataSize) != nDataSize)
+    {
+        cairo_surface_destroy(pSurface);
+        return NULL;
+    }
+    cairo_surface_mark_dirty(pSurface);
+
+    stEnvelope.MinX = adfEnv[0];
+    stEnvelope.MinY = adfEnv[1];
+    stEnvelope.MaxX = adfEnv[2];
+    stEnvelope.MaxY = adfEnv[3];
+    return pSurface;
+}
@@ -20,6 +20,7 @@
  ****************************************************************************/
 
 #include "wxgis/carto/stretch.h"
+#include "wxgis/carto/rasterkernels.h"
 
 #include "wxgis/core/config.h"
 #include "wxgis/core/app.h"
@@ -49,6 +50,8 @@ wxGISStretch::wxGISStretch(double dfMin, double dfMax, double dfMean, double dfS
     m_dfStdDev = dfStdDev;
     m_dfNoData = dfNoData;
     m_bInvert = false;
+    m_eLUTType = GDT_Unknown;
+    m_bLUTDirty = true;
 
     RecalcEquation();
 }
@@ -83,14 +86,34 @@ unsigned char wxGISStretch::GetValue(const double *pdfInput)
 	return cOutput;
 }
 
+void wxGISStretch::GetValues(const float *pfInput, unsigned char *pOutput, int nCount)
+{
+    switch(m_eType)
+    {
+    case enumGISRasterStretchNone:
+        StretchRow(pfInput, pOutput, nCount, 1.0f, 0.0f, false, m_bInvert);
+        break;
+    case enumGISRasterStretchStdDev:
+        StretchRow(pfInput, pOutput, nCount, (float)m_dfM, (float)m_dfDX, true, m_bInvert);
+        break;
+    };
+}
+
 bool wxGISStretch::IsNoData(const double& cVal)
 {
     return IsDoubleEquil(cVal, m_dfNoData);
 }
 
+void wxGISStretch::GetNoDataMask(const float *pfInput, unsigned char *pMask, int nCount)
+{
+    NoDataMaskRow(pfInput, pMask, nCount, m_dfNoData);
+}
+
 void wxGISStretch::SetNoData(double dfNoData)
 {
+    wxCriticalSectionLocker locker(m_LUTCritSect);
     m_dfNoData = dfNoData;
+    m_bLUTDirty = true;
 }
 
 double wxGISStretch::GetNoData(void)
@@ -100,7 +123,9 @@ double wxGISStretch::GetNoData(void)
 
 void wxGISStretch::SetInvert(bool bInvert)
 {
+    wxCriticalSectionLocker locker(m_LUTCritSect);
     m_bInvert = bInvert;
+    m_bLUTDirty = true;
 }
 
 bool wxGISStretch::GetInvert(void)
@@ -110,6 +135,7 @@ bool wxGISStretch::GetInvert(void)
 
 void wxGISStretch::SetStdDevParam(double dfStdDevParam)
 {
+    wxCriticalSectionLocker locker(m_LUTCritSect);
     m_dfStdDevParam = dfStdDevParam;
     RecalcEquation();
 }
@@ -121,6 +147,7 @@ double wxGISStretch::GetStdDevParam(void)
 
 void wxGISStretch::SetStats(double dfMin, double dfMax, double dfMean, double dfStdDev)
 {
+    wxCriticalSectionLocker locker(m_LUTCritSect);
     m_dfMin = dfMin;
     m_dfMax = dfMax;
     m_dfMean = dfMean;
@@ -130,8 +157,14 @@ void wxGISStretch::SetStats(double dfMin, double dfMax, double dfMean, double df
     RecalcEquation();
 }
 
+wxString wxGISStretch::GetKey(void) const
+{
+    return wxString::Format(wxT("s%d,%.10g,%.10g,%d,%.10g"), m_eType, m_dfM, m_dfDX, m_bInvert, m_dfNoData);
+}
+
 void wxGISStretch::RecalcEquation(void)
 {
+    m_bLUTDirty = true;
     switch(m_eType)
     {
     case enumGISRasterStretchStdDev:
@@ -158,3 +191,47 @@ void wxGISStretch::CalcEquation(double dfMin, double dfMax)
     m_dfM = 255.0 / (dfMax - dfMin);
     m_dfDX = dfMin;
 }
+
+bool wxGISStretch::CopyLUT(GDALDataType eDT, wxVector<unsigned char> &aLUT, wxVector<unsigned char> &aNoDataLUT)
+{
+    wxCriticalSectionLocker locker(m_LUTCritSect);
+    if(!BuildLUT(eDT))
+        return false;
+    aLUT = m_aLUT;
+    aNoDataLUT = m_aNoDataLUT;
+    return true;
+}
+
+bool wxGISStretch::BuildLUT(GDALDataType eDT)
+{
+    if(!m_bLUTDirty && m_eLUTType == eDT)
+        return true;
+
+    size_t nSize;
+    switch(eDT)
+    {
+    case GDT_Byte:
+        nSize = 256;
+        break;
+    case GDT_UInt16:
+    case GDT_Int16:
+        nSize = 65536;
+        break;
+    default:
+        return false;
+    };
+
+    m_aLUT.resize(nSize);
+    m_aNoDataLUT.resize(nSize);
+    for(size_t i = 0; i < nSize; ++i)
+    {
+        //Int16 samples are indexed by bits, so 0x8000 - 0xFFFF are negative values
+        double dfVal = eDT == GDT_Int16 ? (double)(GInt16)(GUInt16)i : (double)i;
+        m_aLUT[i] = GetValue(&dfVal);
+        m_aNoDataLUT[i] = IsNoData(dfVal) ? 0xFF : 0;
+    }
+
+    m_eLUTType = eDT;
+    m_bLUTDirty = false;
+    return true;
+}
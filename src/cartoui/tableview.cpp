@@ -172,31 +172,27 @@ void wxGISGridTable::FillForPos(int nRow)
         wxMilliSleep(350);
     }
 
+    //the positioned fetch moves the dataset reading to the page start, so the jump does not read the rows before
     wxGISFeature Feature = m_pGISDataset->GetFeature(nBeg);
-    if (Feature.IsOk())
-        m_moFeatures[nBeg] = Feature;
-    else
-        m_nRows--;
-
-    int nEndPos = nBeg + FILL_STEP;
-    if (nEndPos > m_nRows )
-        nEndPos = m_nRows;
+    long nEndPos = wxMin(nBeg + FILL_STEP, long(m_nRows));
+    long nCount = 0;
+    for (long i = nBeg; i < nEndPos && Feature.IsOk(); ++i)
+    {
+        m_moFeatures[i] = Feature;
+        nCount++;
+        if (i + 1 < nEndPos)
+            Feature = m_pGISDataset->Next();
+    }
 
-    for (long i = nBeg + 1; i < nEndPos; ++i)
+    //the dataset is ended before the rows count returned by dataset
+    if (nBeg + nCount < nEndPos)
     {
-        Feature = m_pGISDataset->Next();
-        if (Feature.IsOk())
-        {
-            m_moFeatures[i] = Feature;
-        }
-        else
+        int nDeleted = m_nRows - (nBeg + nCount);
+        m_nRows -= nDeleted;
+        if(GetView())
         {
-            m_nRows--;
-            if(GetView())
-			{
-				wxGridTableMessage msg(this, wxGRIDTABLE_NOTIFY_ROWS_DELETED, m_nRows, 1);
-				GetView()->ProcessTableMessage(msg);
-			}
+            wxGridTableMessage msg(this, wxGRIDTABLE_NOTIFY_ROWS_DELETED, m_nRows, nDeleted);
+            GetView()->ProcessTableMessage(msg);
         }
     }
 }
@@ -23,6 +23,7 @@
 #include "wxgis/catalog/gxobjectfactory.h"
 #include "wxgis/core/format.h"
 #include "wxgis/catalog/gxfolder.h"
+#include "wxgis/datasource/gdalinh.h"
 
 #include "gdal_priv.h"
 #include "ogr_api.h"
@@ -53,6 +54,7 @@ wxGxCatalog::~wxGxCatalog(void)
 {
     wxDELETE(m_pWatcher);
 
+    wxGISCoordinateTransformationCache::Clear();
     GDALDestroyDriverManager();
     OGRCleanupAll();
 }
@@ -372,6 +372,11 @@ wxGISCurl wxGxNGWService::GetCurl()
     return curl;
 }
 
+void wxGxNGWService::AppendAuthHeader(wxGISCurlMulti &curl) const
+{
+    curl.AppendHeader(wxT("Cookie:") + m_sAuthCookie);
+}
+
 wxString wxGxNGWService::GetLogin() const
 {
 	return m_sLogin;
@@ -727,6 +732,40 @@ bool wxGxNGWResource::FillPermissions()
 	return false;	
 }
 
+void wxGxNGWResource::FillPermissions(wxGxNGWService *pService, const wxVector<wxGxNGWResource*> &apResources)
+{
+    if(NULL == pService || apResources.empty())
+        return;
+
+    wxGISCurlMulti curl;
+    if (!curl.IsOk())
+    {
+        wxGISLogError(_("cURL initialize failed."), wxT("Error in FillPermissions"), wxT("wxGxNGWResource"), NULL);
+        return;
+    }
+    pService->AppendAuthHeader(curl);
+
+    for(size_t i = 0; i < apResources.size(); ++i)
+    {
+        curl.Add(enumGISHTTPGet, pService->GetURL() + wxString::Format(wxT("/api/resource/%d/permission"), apResources[i]->GetRemoteId()));
+    }
+    curl.Perform();
+
+    wxJSONReader reader;
+    for(size_t i = 0; i < apResources.size(); ++i)
+    {
+        PERFORMRESULT res = curl.GetResult(i);
+        if(res.IsValid && res.nHTTPCode < 400)
+        {
+            reader.Parse(res.sBody, &apResources[i]->m_oPermissions);
+        }
+        else
+        {
+            apResources[i]->ReportError(res.nHTTPCode, res.sBody);
+        }
+    }
+}
+
 bool wxGxNGWResource::MoveResource(int nResourceId)
 {
 	wxGISCurl curl = m_pService->GetCurl();
@@ -1311,10 +1350,6 @@ wxGxObject* wxGxNGWResourceGroup::AddResource(const wxJSONValue &Data)
         break;	
     }
 	
-	wxGxNGWResource* pGxNGWResource = dynamic_cast<wxGxNGWResource*>(pReturnObj);
-	if(pGxNGWResource)
-		pGxNGWResource->FillPermissions();
-	
 	return pReturnObj;
 }
 
@@ -1544,10 +1579,15 @@ void wxGxNGWResourceGroup::LoadChildren(void)
         return;
 		
 	
+	//the permissions of all children are requested at once
+	wxVector<wxGxNGWResource*> apResources;
 	for (wxNGWResourceDataMap::const_iterator it = m_moJSONData.begin(); it != m_moJSONData.end(); ++it)
 	{
-		AddResource(it->second);
+		wxGxNGWResource* pGxNGWResource = dynamic_cast<wxGxNGWResource*>(AddResource(it->second));
+		if(pGxNGWResource)
+			apResources.push_back(pGxNGWResource);
     }
+	wxGxNGWResource::FillPermissions(m_pService, apResources);
 }
 
 wxGxObject* wxGxNGWResourceGroup::GetObjectByResourceId(long nResourceId)
@@ -1579,6 +1619,9 @@ wxGxObject* wxGxNGWResourceGroup::GetObjectByResourceId(long nResourceId)
 void wxGxNGWResourceGroup::AddObject(int nRemoteId, const wxString &sName)
 {
 	wxGxObject* pObj = AddResource(m_moJSONData[nRemoteId]);
+	wxGxNGWResource* pGxNGWResource = dynamic_cast<wxGxNGWResource*>(pObj);
+	if(pGxNGWResource)
+		pGxNGWResource->FillPermissions();
 	if(NULL != pObj)
 	{
 		wxGIS_GXCATALOG_EVENT_ID(ObjectAdded, pObj->GetId());
@@ -436,10 +436,6 @@ wxGxObject* wxGxNGWResourceGroupUI::AddResource(const wxJSONValue& Data)
     } break;
     }
 
-    wxGxNGWResource* pGxNGWResource = dynamic_cast<wxGxNGWResource*>(pReturnObj);
-    if (pGxNGWResource)
-        pGxNGWResource->FillPermissions();
-
     return pReturnObj;
 }
 
@@ -22,8 +22,21 @@
 #include "wxgis/core/process.h"
 
 #include <wx/txtstrm.h>
+#include <wx/wfstream.h>
+#include <wx/module.h>
+
+#ifdef __UNIX__
+#include <poll.h>
+#include <unistd.h>
+#include <fcntl.h>
+#include <errno.h>
+
+#include <map>
+#include <string>
+#endif // __UNIX__
 
 #define READ_LINE_DELAY 350
+#define READER_BUFFER_SIZE 4096
 
 //------------------------------------------------------------------------------
 // Class wxGISProcess
@@ -138,6 +151,270 @@ bool wxGISThreadHelper::WaitThreadDelete(int nWait)
     return true;
 }
 
+#ifdef __UNIX__
+
+//------------------------------------------------------------------------------
+// Class wxGISProcessReader
+//------------------------------------------------------------------------------
+
+/** @class wxGISProcessReader
+
+    The reader of child processes output. The thread waits for the output of all registered pipes by poll(), splits it to lines and passes the complete lines to the processes. The wakeup pipe interrupts the waiting on pipes set change and exit.
+
+    @library{core}
+ */
+
+class wxGISProcessReader : public wxThread
+{
+public:
+    wxGISProcessReader(void);
+    virtual ~wxGISProcessReader(void);
+    virtual bool Init(void);
+    virtual bool Add(wxGISProcess* const pProcess, int nFD);
+    virtual void Remove(wxGISProcess* const pProcess, bool bFlush);
+    virtual void Shutdown(void);
+    static wxGISProcessReader* const GetReader(bool bCreate = true);
+    static void Cleanup(void);
+protected:
+    virtual ExitCode Entry();
+    virtual void Wakeup(void);
+    virtual void Read(wxGISProcess* const pProcess);
+protected:
+    typedef struct _processpipe
+    {
+        int nFD;
+        std::string sBuffer;
+        bool bEOF;
+    } PROCESSPIPE;
+    std::map<wxGISProcess*, PROCESSPIPE> m_mPipes;
+    wxCriticalSection m_CritSect;
+    //held while the lines are passed to the process, so process cannot be removed meanwhile
+    wxCriticalSection m_DispatchCritSect;
+    int m_anWakeupPipe[2];
+    bool m_bExit;
+    static wxGISProcessReader* m_pReader;
+    static wxCriticalSection m_ReaderCritSect;
+};
+
+wxGISProcessReader* wxGISProcessReader::m_pReader = NULL;
+wxCriticalSection wxGISProcessReader::m_ReaderCritSect;
+
+wxGISProcessReader::wxGISProcessReader(void) : wxThread(wxTHREAD_JOINABLE)
+{
+    m_anWakeupPipe[0] = m_anWakeupPipe[1] = wxNOT_FOUND;
+    m_bExit = false;
+}
+
+wxGISProcessReader::~wxGISProcessReader(void)
+{
+    if(m_anWakeupPipe[0] != wxNOT_FOUND)
+        close(m_anWakeupPipe[0]);
+    if(m_anWakeupPipe[1] != wxNOT_FOUND)
+        close(m_anWakeupPipe[1]);
+}
+
+bool wxGISProcessReader::Init(void)
+{
+    if(pipe(m_anWakeupPipe) != 0)
+    {
+        m_anWakeupPipe[0] = m_anWakeupPipe[1] = wxNOT_FOUND;
+        wxLogError(_("wxGISProcessReader: Can't create the wakeup pipe"));
+        return false;
+    }
+    fcntl(m_anWakeupPipe[0], F_SETFL, fcntl(m_anWakeupPipe[0], F_GETFL) | O_NONBLOCK);
+    fcntl(m_anWakeupPipe[1], F_SETFL, fcntl(m_anWakeupPipe[1], F_GETFL) | O_NONBLOCK);
+    return true;
+}
+
+wxGISProcessReader* const wxGISProcessReader::GetReader(bool bCreate)
+{
+    wxCriticalSectionLocker locker(m_ReaderCritSect);
+    if(NULL == m_pReader && bCreate)
+    {
+        wxGISProcessReader* pReader = new wxGISProcessReader();
+        if(!pReader->Init() || !::CreateAndRunThread(pReader, wxT("wxGISProcessReader"), wxT("ProcessReader")))
+        {
+            wxDELETE(pReader);
+            return NULL;
+        }
+        m_pReader = pReader;
+    }
+    return m_pReader;
+}
+
+void wxGISProcessReader::Cleanup(void)
+{
+    wxCriticalSectionLocker locker(m_ReaderCritSect);
+    if(NULL != m_pReader)
+    {
+        m_pReader->Shutdown();
+        wgDELETE(m_pReader, Wait());
+    }
+}
+
+bool wxGISProcessReader::Add(wxGISProcess* const pProcess, int nFD)
+{
+    wxCHECK_MSG(pProcess, false, wxT("Input process pointer is null"));
+    if(nFD < 0)
+        return false;
+
+    //the reader never blocks on pipe, read returns EAGAIN if no more data
+    fcntl(nFD, F_SETFL, fcntl(nFD, F_GETFL) | O_NONBLOCK);
+
+    {
+        wxCriticalSectionLocker locker(m_CritSect);
+        PROCESSPIPE stPipe = {nFD, std::string(), false};
+        m_mPipes[pProcess] = stPipe;
+    }
+    Wakeup();
+    return true;
+}
+
+void wxGISProcessReader::Remove(wxGISProcess* const pProcess, bool bFlush)
+{
+    wxCriticalSectionLocker dispatch(m_DispatchCritSect);
+    //pass the rest of output, eg. after the process terminated
+    if(bFlush)
+        Read(pProcess);
+
+    {
+        wxCriticalSectionLocker locker(m_CritSect);
+        m_mPipes.erase(pProcess);
+    }
+    Wakeup();
+}
+
+void wxGISProcessReader::Shutdown(void)
+{
+    m_bExit = true;
+    Wakeup();
+}
+
+void wxGISProcessReader::Wakeup(void)
+{
+    char c = 0;
+    if(write(m_anWakeupPipe[1], &c, 1) < 0)
+    {
+        //the pipe is full, so the reader is already waked up
+    }
+}
+
+void wxGISProcessReader::Read(wxGISProcess* const pProcess)
+{
+    PROCESSPIPE* pPipe = NULL;
+    {
+        wxCriticalSectionLocker locker(m_CritSect);
+        std::map<wxGISProcess*, PROCESSPIPE>::iterator it = m_mPipes.find(pProcess);
+        if(it == m_mPipes.end() || it->second.bEOF)
+            return;
+        pPipe = &it->second;
+    }
+
+    char szBuffer[READER_BUFFER_SIZE];
+    while(true)
+    {
+        ssize_t nRead = read(pPipe->nFD, szBuffer, READER_BUFFER_SIZE);
+        if(nRead > 0)
+        {
+            pPipe->sBuffer.append(szBuffer, nRead);
+            continue;
+        }
+        if(nRead < 0 && errno == EINTR)
+            continue;
+        if(nRead == 0 || errno != EAGAIN)
+        {
+            //the last line may be without line feed
+            pPipe->bEOF = true;
+            pPipe->sBuffer.append(1, '\n');
+        }
+        break;
+    }
+
+    //pass the complete lines, the partial line stay in buffer until the rest will come
+    size_t nBeg = 0, nEnd;
+    while((nEnd = pPipe->sBuffer.find('\n', nBeg)) != std::string::npos)
+    {
+        size_t nLen = nEnd - nBeg;
+        if(nLen > 0 && pPipe->sBuffer[nBeg + nLen - 1] == '\r')
+            nLen--;
+        wxString sLine(pPipe->sBuffer.c_str() + nBeg, *wxConvCurrent, nLen);
+        nBeg = nEnd + 1;
+        if (!sLine.IsEmpty())
+            pProcess->ProcessInput(sLine);
+    }
+    pPipe->sBuffer.erase(0, nBeg);
+}
+
+wxThread::ExitCode wxGISProcessReader::Entry()
+{
+    wxVector<struct pollfd> astPollFDs;
+    wxVector<wxGISProcess*> apProcesses;
+    while(!m_bExit && !TestDestroy())
+    {
+        astPollFDs.clear();
+        apProcesses.clear();
+
+        struct pollfd stWakeup = {m_anWakeupPipe[0], POLLIN, 0};
+        astPollFDs.push_back(stWakeup);
+        {
+            wxCriticalSectionLocker locker(m_CritSect);
+            for(std::map<wxGISProcess*, PROCESSPIPE>::const_iterator it = m_mPipes.begin(); it != m_mPipes.end(); ++it)
+            {
+                if(it->second.bEOF)
+                    continue;
+                struct pollfd stPipe = {it->second.nFD, POLLIN, 0};
+                astPollFDs.push_back(stPipe);
+                apProcesses.push_back(it->first);
+            }
+        }
+
+        //wait until output comes or the pipes set changes
+        int nRes = poll(&astPollFDs[0], astPollFDs.size(), -1);
+        if(nRes < 0)
+        {
+            if(errno == EINTR)
+                continue;
+            wxLogError(_("wxGISProcessReader: Wait for the processes output failed"));
+            break;
+        }
+
+        if(astPollFDs[0].revents & POLLIN)
+        {
+            char szBuffer[64];
+            while(read(m_anWakeupPipe[0], szBuffer, sizeof(szBuffer)) > 0);
+        }
+
+        for(size_t i = 1; i < astPollFDs.size(); ++i)
+        {
+            if(astPollFDs[i].revents == 0)
+                continue;
+            wxCriticalSectionLocker dispatch(m_DispatchCritSect);
+            Read(apProcesses[i - 1]);
+        }
+    }
+    return (wxThread::ExitCode)wxTHREAD_NO_ERROR;
+}
+
+/** @class wxGISProcessReaderModule
+
+    The module to stop the processes output reader on exit.
+
+    @library{core}
+  */
+
+class wxGISProcessReaderModule : public wxModule
+{
+    DECLARE_DYNAMIC_CLASS(wxGISProcessReaderModule)
+public:
+    wxGISProcessReaderModule(void) {};
+    virtual bool OnInit(void) { return true; };
+    virtual void OnExit(void) { wxGISProcessReader::Cleanup(); };
+};
+
+IMPLEMENT_DYNAMIC_CLASS(wxGISProcessReaderModule, wxModule)
+
+#endif // __UNIX__
+
 //------------------------------------------------------------------------------
 // Class wxGISProcess
 //------------------------------------------------------------------------------
@@ -145,6 +422,7 @@ bool wxGISThreadHelper::WaitThreadDelete(int nWait)
 wxGISProcess::wxGISProcess(IGISProcessParent* pParent, wxThreadKind kind) : wxProcess(wxPROCESS_REDIRECT), wxGISThreadHelper(kind)
 {
     m_pParent = pParent;
+    m_bAttachedToReader = false;
     m_dtBeg = wxDateTime::Now();
     m_dtEstEnd = wxDateTime::Now();
     m_pid = 0;
@@ -152,6 +430,7 @@ wxGISProcess::wxGISProcess(IGISProcessParent* pParent, wxThreadKind kind) : wxPr
 
 wxGISProcess::~wxGISProcess(void)
 {
+    DetachFromReader();
 }
 
 bool wxGISProcess::Start()
@@ -166,10 +445,10 @@ bool wxGISProcess::Start()
 	m_nState = enumGISTaskWork;
 	m_dtBeg = wxDateTime::Now();
     m_dfDone = 0;
-	//create and start read thread stdin
+	//start read stdin
 	if(IsInputOpened())
 	{
-        return CreateAndRunThread();
+        return StartReadInput();
 	}
 
     //start err thread ?
@@ -178,6 +457,7 @@ bool wxGISProcess::Start()
 
 void wxGISProcess::OnTerminate(int pid, int status)
 {
+    DetachFromReader(true);
     DestroyThreadAsync();
     if(m_nState == enumGISTaskPaused)//process paused
     {
@@ -203,6 +483,9 @@ void wxGISProcess::Stop(void)
     if (m_nState == enumGISTaskDone || m_nState == enumGISTaskError)
         return;
 
+    //the reader may wait for ProcessInput which is locked by m_ExitLock
+    DetachFromReader();
+
     wxCriticalSectionLocker lock(m_ExitLock);
 
 	if(m_nState == enumGISTaskWork)
@@ -330,5 +613,44 @@ wxThread::ExitCode wxGISProcess::Entry()
     return (wxThread::ExitCode)wxTHREAD_NO_ERROR;
 }
 
+bool wxGISProcess::StartReadInput(void)
+{
+    if(AttachToReader())
+        return true;
+    return CreateAndRunThread();
+}
+
+bool wxGISProcess::AttachToReader(void)
+{
+#ifdef __UNIX__
+    if(m_bAttachedToReader)
+        return true;
+
+    //the unix pipe stream is the file stream
+    wxFileInputStream* pStream = dynamic_cast<wxFileInputStream*>(GetInputStream());
+    if(NULL == pStream || NULL == pStream->GetFile() || !pStream->GetFile()->IsOpened())
+        return false;
+
+    wxGISProcessReader* const pReader = wxGISProcessReader::GetReader();
+    if(NULL == pReader || !pReader->Add(this, pStream->GetFile()->fd()))
+        return false;
 
+    m_bAttachedToReader = true;
+    return true;
+#else
+    return false;
+#endif // __UNIX__
+}
 
+void wxGISProcess::DetachFromReader(bool bFlush)
+{
+#ifdef __UNIX__
+    if(!m_bAttachedToReader)
+        return;
+    m_bAttachedToReader = false;
+
+    wxGISProcessReader* const pReader = wxGISProcessReader::GetReader(false);
+    if(NULL != pReader)
+        pReader->Remove(this, bFlush);
+#endif // __UNIX__
+}
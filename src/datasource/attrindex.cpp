@@ -0,0 +1,281 @@
+/******************************************************************************
+ * Project:  wxGIS
+ * Purpose:  wxGISAttributeIndex class. Hash and sorted index of table field.
+ * Author:   Dmitry Baryshnikov (aka Bishop), polimax@mail.ru
+ ******************************************************************************
+*   Copyright (C) 2014 Dmitry Baryshnikov
+*
+*    This program is free software: you can redistribute it and/or modify
+*    it under the terms of the GNU General Public License as published by
+*    the Free Software Foundation, either version 2 of the License, or
+*    (at your option) any later version.
+*
+*    This program is distributed in the hope that it will be useful,
+*    but WITHOUT ANY WARRANTY; without even the implied warranty of
+*    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+*    GNU General Public License for more details.
+*
+*    You should have received a copy of the GNU General Public License
+*    along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ ****************************************************************************/
+#include "wxgis/datasource/attrindex.h"
+
+#include <limits.h>
+
+//-----------------------------------------------------------------------------
+// wxGISAttributeIndex
+//-----------------------------------------------------------------------------
+
+wxGISAttributeIndex::wxGISAttributeIndex(int nField, OGRFieldType eType) : m_oSorted(wxGISAttributeIndexLess(eType == OFTInteger || eType == OFTReal))
+{
+    m_nField = nField;
+    m_bNumeric = eType == OFTInteger || eType == OFTReal;
+    m_bSorted = false;
+}
+
+wxGISAttributeIndex::~wxGISAttributeIndex(void)
+{
+}
+
+bool wxGISAttributeIndex::IsSupportedType(OGRFieldType eType)
+{
+    return eType == OFTInteger || eType == OFTReal || eType == OFTString;
+}
+
+int wxGISAttributeIndex::GetField(void) const
+{
+    return m_nField;
+}
+
+void wxGISAttributeIndex::Clear(void)
+{
+    m_mHash.clear();
+    m_mFIDValues.clear();
+    m_oSorted.clear();
+    m_bSorted = false;
+}
+
+size_t wxGISAttributeIndex::GetCount(void) const
+{
+    return m_mFIDValues.size();
+}
+
+CPLString wxGISAttributeIndex::GetKey(const ATTRIBUTEINDEXVALUE &Value) const
+{
+    if(m_bNumeric)
+    {
+        //%.17g is exact for any double, so distinct values never share a key; -0 and 0 are equal
+        if(Value.dfValue == 0)
+            return CPLString("0");
+        return CPLString(CPLSPrintf("%.17g", Value.dfValue));
+    }
+    return Value.sValue;
+}
+
+void wxGISAttributeIndex::Add(long nFID, OGRFeature* const poFeature)
+{
+    if(NULL == poFeature || m_nField >= poFeature->GetFieldCount() || !poFeature->IsFieldSet(m_nField))
+        return;
+
+    ATTRIBUTEINDEXVALUE Value;
+    Value.dfValue = 0;
+    if(m_bNumeric)
+        Value.dfValue = poFeature->GetFieldAsDouble(m_nField);
+    else
+        Value.sValue = poFeature->GetFieldAsString(m_nField);
+    Add(nFID, Value);
+}
+
+void wxGISAttributeIndex::Add(long nFID, const ATTRIBUTEINDEXVALUE &Value)
+{
+    m_mFIDValues[nFID] = Value;
+    m_mHash[GetKey(Value)].push_back(nFID);
+
+    if(m_bSorted)
+    {
+        ATTRIBUTEINDEXITEM stItem;
+        stItem.Value = Value;
+        stItem.nFID = nFID;
+        m_oSorted.insert(stItem);
+    }
+}
+
+void wxGISAttributeIndex::Remove(long nFID)
+{
+    wxGISAttributeFIDValueMap::iterator itValue = m_mFIDValues.find(nFID);
+    if(itValue == m_mFIDValues.end())
+        return;
+
+    wxGISAttributeHashIndex::iterator itHash = m_mHash.find(GetKey(itValue->second));
+    if(itHash != m_mHash.end())
+    {
+        wxVector<long> &anFIDs = itHash->second;
+        for(size_t i = 0; i < anFIDs.size(); ++i)
+        {
+            if(anFIDs[i] == nFID)
+            {
+                anFIDs[i] = anFIDs[anFIDs.size() - 1];
+                anFIDs.pop_back();
+                break;
+            }
+        }
+        if(anFIDs.empty())
+            m_mHash.erase(itHash);
+    }
+
+    if(m_bSorted)
+    {
+        ATTRIBUTEINDEXITEM stItem;
+        stItem.Value = itValue->second;
+        stItem.nFID = nFID;
+        m_oSorted.erase(stItem);
+    }
+
+    m_mFIDValues.erase(itValue);
+}
+
+bool wxGISAttributeIndex::Fill(const wxGISFeatureColumnStore* pStore, ITrackCancel* const pTrackCancel)
+{
+    wxCHECK_MSG(pStore, false, wxT("The input store pointer is null"));
+    if(m_nField >= pStore->GetColumnCount())
+        return true;
+
+    const long* panFIDs = pStore->GetFIDs();
+    const wxUint32* panSet = pStore->GetSetMask(m_nField);
+    OGRFieldType eType = pStore->GetColumnType(m_nField);
+
+    ATTRIBUTEINDEXVALUE Value;
+    Value.dfValue = 0;
+    for(size_t i = 0; i < pStore->GetRowCount(); ++i)
+    {
+        if((i & 4095) == 0 && pTrackCancel && !pTrackCancel->Continue())
+            return false;
+
+        //skip deleted rows and null values
+        if(panFIDs[i] == wxNOT_FOUND || (panSet[i >> 5] & (1U << (i & 31))) == 0)
+            continue;
+
+        switch(eType)
+        {
+        case OFTInteger:
+            Value.dfValue = pStore->GetIntegerValues(m_nField)[i];
+            break;
+        case OFTReal:
+            Value.dfValue = pStore->GetRealValues(m_nField)[i];
+            break;
+        default:
+            Value.sValue = pStore->GetString(m_nField, i);
+            break;
+        }
+        Add(panFIDs[i], Value);
+    }
+    return true;
+}
+
+bool wxGISAttributeIndex::Fill(OGRLayer* const poLayer, ITrackCancel* const pTrackCancel)
+{
+    wxCHECK_MSG(poLayer, false, wxT("The input layer pointer is null"));
+
+    poLayer->ResetReading();
+    OGRFeature* poFeature;
+    while((poFeature = poLayer->GetNextFeature()) != NULL)
+    {
+        Add(poFeature->GetFID(), poFeature);
+        OGRFeature::DestroyFeature(poFeature);
+
+        if(pTrackCancel && !pTrackCancel->Continue())
+        {
+            poLayer->ResetReading();
+            return false;
+        }
+    }
+    poLayer->ResetReading();
+    return true;
+}
+
+void wxGISAttributeIndex::Sort(void)
+{
+    if(m_bSorted)
+        return;
+
+    m_oSorted.clear();
+    for(wxGISAttributeFIDValueMap::const_iterator it = m_mFIDValues.begin(); it != m_mFIDValues.end(); ++it)
+    {
+        ATTRIBUTEINDEXITEM stItem;
+        stItem.Value = it->second;
+        stItem.nFID = it->first;
+        m_oSorted.insert(stItem);
+    }
+    m_bSorted = true;
+}
+
+void wxGISAttributeIndex::Find(wxGISEnumFilterOperator eOp, double dfValue, const char* pszValue, wxVector<long> &anFIDs)
+{
+    ATTRIBUTEINDEXITEM stItem;
+    stItem.Value.dfValue = dfValue;
+    if(!m_bNumeric && pszValue)
+        stItem.Value.sValue = pszValue;
+    stItem.nFID = wxNOT_FOUND;
+
+    if(eOp == enumGISFilterOpEQ)
+    {
+        wxGISAttributeHashIndex::const_iterator it = m_mHash.find(GetKey(stItem.Value));
+        if(it != m_mHash.end())
+        {
+            for(size_t i = 0; i < it->second.size(); ++i)
+                anFIDs.push_back(it->second[i]);
+        }
+        return;
+    }
+
+    //the bounds of the equal values range, the items with the same value are ordered by FID
+    Sort();
+    stItem.nFID = LONG_MIN;
+    wxGISAttributeSortedIndex::const_iterator itLower = m_oSorted.lower_bound(stItem);
+    stItem.nFID = LONG_MAX;
+    wxGISAttributeSortedIndex::const_iterator itUpper = m_oSorted.upper_bound(stItem);
+
+    wxGISAttributeSortedIndex::const_iterator itBegin = m_oSorted.begin(), itEnd = m_oSorted.end();
+    switch(eOp)
+    {
+    case enumGISFilterOpNE:
+        for(; itBegin != itLower; ++itBegin)
+            anFIDs.push_back(itBegin->nFID);
+        itBegin = itUpper;
+        break;
+    case enumGISFilterOpLT:
+        itEnd = itLower;
+        break;
+    case enumGISFilterOpLE:
+        itEnd = itUpper;
+        break;
+    case enumGISFilterOpGT:
+        itBegin = itUpper;
+        break;
+    case enumGISFilterOpGE:
+        itBegin = itLower;
+        break;
+    default:
+        return;
+    }
+
+    for(; itBegin != itEnd; ++itBegin)
+        anFIDs.push_back(itBegin->nFID);
+}
+
+void wxGISAttributeIndex::GetOrderedFIDs(bool bAscending, wxVector<long> &anFIDs)
+{
+    Sort();
+    anFIDs.clear();
+    anFIDs.reserve(m_oSorted.size());
+    if(bAscending)
+    {
+        for(wxGISAttributeSortedIndex::const_iterator it = m_oSorted.begin(); it != m_oSorted.end(); ++it)
+            anFIDs.push_back(it->nFID);
+    }
+    else
+    {
+        for(wxGISAttributeSortedIndex::const_reverse_iterator it = m_oSorted.rbegin(); it != m_oSorted.rend(); ++it)
+            anFIDs.push_back(it->nFID);
+    }
+}
@@ -0,0 +1,785 @@
+/******************************************************************************
+ * Project:  wxGIS
+ * Purpose:  wxGISColumnStoreFilter class. Attribute filter over column store.
+ * Author:   Dmitry Baryshnikov (aka Bishop), polimax@mail.ru
+ ******************************************************************************
+*   Copyright (C) 2014 Dmitry Baryshnikov
+*
+*    This program is free software: you can redistribute it and/or modify
+*    it under the terms of the GNU General Public License as published by
+*    the Free Software Foundation, either version 2 of the License, or
+*    (at your option) any later version.
+*
+*    This program is distributed in the hope that it will be useful,
+*    but WITHOUT ANY WARRANTY; without even the implied warranty of
+*    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+*    GNU General Public License for more details.
+*
+*    You should have received a copy of the GNU General Public License
+*    along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ ****************************************************************************/
+#include "wxgis/datasource/columnfilter.h"
+#include "wxgis/datasource/attrindex.h"
+
+#include <algorithm>
+#include <ctype.h>
+
+static const char* s_apszKeywords[] = { "AND", "OR", "NOT", "IN", "LIKE", "ILIKE", "ESCAPE", "IS", "NULL", "BETWEEN", NULL };
+
+template <typename T> static wxUint32 CompareValues(const T* paValues, wxGISEnumFilterOperator eOp, double dfValue, size_t nRows)
+{
+    wxUint32 nBits = 0;
+    size_t i;
+    switch(eOp)
+    {
+    case enumGISFilterOpEQ:
+        for(i = 0; i < nRows; ++i)
+            nBits |= wxUint32(paValues[i] == dfValue) << i;
+        break;
+    case enumGISFilterOpNE:
+        for(i = 0; i < nRows; ++i)
+            nBits |= wxUint32(paValues[i] != dfValue) << i;
+        break;
+    case enumGISFilterOpLT:
+        for(i = 0; i < nRows; ++i)
+            nBits |= wxUint32(paValues[i] < dfValue) << i;
+        break;
+    case enumGISFilterOpLE:
+        for(i = 0; i < nRows; ++i)
+            nBits |= wxUint32(paValues[i] <= dfValue) << i;
+        break;
+    case enumGISFilterOpGT:
+        for(i = 0; i < nRows; ++i)
+            nBits |= wxUint32(paValues[i] > dfValue) << i;
+        break;
+    case enumGISFilterOpGE:
+        for(i = 0; i < nRows; ++i)
+            nBits |= wxUint32(paValues[i] >= dfValue) << i;
+        break;
+    }
+    return nBits;
+}
+
+template <typename T> static wxUint32 TestValues(const T* paValues, wxGISEnumFilterNodeType eType, wxGISEnumFilterOperator eOp, const wxVector<double> &adfValues, size_t nRows)
+{
+    if(eType != enumGISFilterNodeIn)
+        return CompareValues(paValues, eOp, adfValues[0], nRows);
+
+    wxUint32 nBits = 0;
+    for(size_t i = 0; i < adfValues.size(); ++i)
+        nBits |= CompareValues(paValues, enumGISFilterOpEQ, adfValues[i], nRows);
+    return nBits;
+}
+
+static wxGISEnumFilterOperator MirrorOperator(wxGISEnumFilterOperator eOp)
+{
+    switch(eOp)
+    {
+    case enumGISFilterOpLT:
+        return enumGISFilterOpGT;
+    case enumGISFilterOpLE:
+        return enumGISFilterOpGE;
+    case enumGISFilterOpGT:
+        return enumGISFilterOpLT;
+    case enumGISFilterOpGE:
+        return enumGISFilterOpLE;
+    default:
+        return eOp;
+    }
+}
+
+//-----------------------------------------------------------------------------
+// wxGISColumnStoreFilter
+//-----------------------------------------------------------------------------
+
+wxGISColumnStoreFilter::wxGISColumnStoreFilter(void)
+{
+    m_pRoot = NULL;
+    m_poDefn = NULL;
+    m_nToken = 0;
+}
+
+wxGISColumnStoreFilter::~wxGISColumnStoreFilter(void)
+{
+    DeleteNode(m_pRoot);
+}
+
+bool wxGISColumnStoreFilter::IsOk(void) const
+{
+    return m_pRoot != NULL;
+}
+
+void wxGISColumnStoreFilter::DeleteNode(NODE* pNode)
+{
+    if(NULL == pNode)
+        return;
+    DeleteNode(pNode->pLeft);
+    DeleteNode(pNode->pRight);
+    delete pNode;
+}
+
+wxGISColumnStoreFilter::NODE* wxGISColumnStoreFilter::CreateNode(wxGISEnumFilterNodeType eType, NODE* pLeft, NODE* pRight)
+{
+    NODE* pNode = new NODE;
+    pNode->eType = eType;
+    pNode->eOp = enumGISFilterOpEQ;
+    pNode->nField = COLUMN_FILTER_FID;
+    pNode->pLeft = pLeft;
+    pNode->pRight = pRight;
+    return pNode;
+}
+
+bool wxGISColumnStoreFilter::Parse(const wxString &sWhereClause, OGRFeatureDefn* const poDefn)
+{
+    DeleteNode(m_pRoot);
+    m_pRoot = NULL;
+    m_poDefn = poDefn;
+    if(NULL == m_poDefn)
+        return false;
+
+    CPLString sClause(sWhereClause.ToUTF8());
+    if(!Tokenize(sClause))
+        return false;
+
+    m_nToken = 0;
+    m_pRoot = ParseOr();
+    if(m_pRoot && m_astTokens[m_nToken].eType != enumGISFilterTokenEnd)
+    {
+        DeleteNode(m_pRoot);
+        m_pRoot = NULL;
+    }
+    m_astTokens.clear();
+    return m_pRoot != NULL;
+}
+
+bool wxGISColumnStoreFilter::Tokenize(const char* pszClause)
+{
+    m_astTokens.clear();
+    const char* psz = pszClause;
+    while(*psz != 0)
+    {
+        unsigned char c = (unsigned char)*psz;
+        if(isspace(c))
+        {
+            psz++;
+            continue;
+        }
+
+        TOKEN stToken;
+        stToken.dfValue = 0;
+        stToken.bQuoted = false;
+
+        if(c == '\'' || c == '"')
+        {
+            //string literal or quoted identifier, the doubled quote is escaped quote
+            stToken.eType = c == '\'' ? enumGISFilterTokenString : enumGISFilterTokenIdentifier;
+            stToken.bQuoted = true;
+            psz++;
+            while(*psz != 0)
+            {
+                if(*psz == (char)c)
+                {
+                    if(psz[1] != (char)c)
+                        break;
+                    psz++;
+                }
+                stToken.sValue += *psz;
+                psz++;
+            }
+            if(*psz != (char)c)
+                return false;
+            psz++;
+        }
+        else if(isdigit(c) || ((c == '.' || c == '-') && (isdigit((unsigned char)psz[1]) || psz[1] == '.')))
+        {
+            char* pszEnd = NULL;
+            stToken.eType = enumGISFilterTokenNumber;
+            stToken.dfValue = CPLStrtod(psz, &pszEnd);
+            if(pszEnd == psz)
+                return false;
+            stToken.sValue.assign(psz, pszEnd - psz);
+            psz = pszEnd;
+        }
+        else if(isalpha(c) || c == '_')
+        {
+            stToken.eType = enumGISFilterTokenIdentifier;
+            while(isalnum((unsigned char)*psz) || *psz == '_')
+            {
+                stToken.sValue += *psz;
+                psz++;
+            }
+        }
+        else if(c == '(')
+        {
+            stToken.eType = enumGISFilterTokenOpen;
+            psz++;
+        }
+        else if(c == ')')
+        {
+            stToken.eType = enumGISFilterTokenClose;
+            psz++;
+        }
+        else if(c == ',')
+        {
+            stToken.eType = enumGISFilterTokenComma;
+            psz++;
+        }
+        else if(c == '=' || c == '<' || c == '>' || c == '!')
+        {
+            stToken.eType = enumGISFilterTokenOperator;
+            stToken.sValue += *psz++;
+            if(*psz == '=' || (c == '<' && *psz == '>'))
+                stToken.sValue += *psz++;
+        }
+        else
+        {
+            //arithmetic and other expressions are not supported
+            return false;
+        }
+        m_astTokens.push_back(stToken);
+    }
+
+    TOKEN stEnd;
+    stEnd.eType = enumGISFilterTokenEnd;
+    stEnd.dfValue = 0;
+    stEnd.bQuoted = false;
+    m_astTokens.push_back(stEnd);
+    return true;
+}
+
+bool wxGISColumnStoreFilter::IsKeyword(const char* pszKeyword) const
+{
+    const TOKEN &stToken = m_astTokens[m_nToken];
+    return stToken.eType == enumGISFilterTokenIdentifier && !stToken.bQuoted && EQUAL(stToken.sValue, pszKeyword);
+}
+
+wxGISColumnStoreFilter::NODE* wxGISColumnStoreFilter::ParseOr(void)
+{
+    NODE* pNode = ParseAnd();
+    while(pNode && IsKeyword("OR"))
+    {
+        m_nToken++;
+        NODE* pRight = ParseAnd();
+        if(NULL == pRight)
+        {
+            DeleteNode(pNode);
+            return NULL;
+        }
+        pNode = CreateNode(enumGISFilterNodeOr, pNode, pRight);
+    }
+    return pNode;
+}
+
+wxGISColumnStoreFilter::NODE* wxGISColumnStoreFilter::ParseAnd(void)
+{
+    NODE* pNode = ParseNot();
+    while(pNode && IsKeyword("AND"))
+    {
+        m_nToken++;
+        NODE* pRight = ParseNot();
+        if(NULL == pRight)
+        {
+            DeleteNode(pNode);
+            return NULL;
+        }
+        pNode = CreateNode(enumGISFilterNodeAnd, pNode, pRight);
+    }
+    return pNode;
+}
+
+wxGISColumnStoreFilter::NODE* wxGISColumnStoreFilter::ParseNot(void)
+{
+    if(IsKeyword("NOT"))
+    {
+        m_nToken++;
+        NODE* pNode = ParseNot();
+        if(NULL == pNode)
+            return NULL;
+        return CreateNode(enumGISFilterNodeNot, pNode);
+    }
+    return ParsePredicate();
+}
+
+wxGISColumnStoreFilter::NODE* wxGISColumnStoreFilter::ParsePredicate(void)
+{
+    wxGISEnumFilterTokenType eType = m_astTokens[m_nToken].eType;
+    if(eType == enumGISFilterTokenOpen)
+    {
+        m_nToken++;
+        NODE* pNode = ParseOr();
+        if(NULL == pNode)
+            return NULL;
+        if(m_astTokens[m_nToken].eType != enumGISFilterTokenClose)
+        {
+            DeleteNode(pNode);
+            return NULL;
+        }
+        m_nToken++;
+        return pNode;
+    }
+
+    int nField;
+    wxGISEnumFilterOperator eOp;
+
+    //literal operator field
+    if(eType == enumGISFilterTokenString || eType == enumGISFilterTokenNumber)
+    {
+        size_t nLiteral = m_nToken++;
+        if(!ParseOperator(eOp) || !ParseField(nField))
+            return NULL;
+
+        NODE* pNode = CreateNode(enumGISFilterNodeCompare);
+        pNode->nField = nField;
+        pNode->eOp = MirrorOperator(eOp);
+        size_t nToken = m_nToken;
+        m_nToken = nLiteral;
+        bool bResult = ParseLiteral(nField, pNode);
+        m_nToken = nToken;
+        if(!bResult)
+        {
+            DeleteNode(pNode);
+            return NULL;
+        }
+        return pNode;
+    }
+
+    if(!ParseField(nField))
+        return NULL;
+
+    //field operator literal
+    if(ParseOperator(eOp))
+    {
+        NODE* pNode = CreateNode(enumGISFilterNodeCompare);
+        pNode->nField = nField;
+        pNode->eOp = eOp;
+        if(!ParseLiteral(nField, pNode))
+        {
+            DeleteNode(pNode);
+            return NULL;
+        }
+        return pNode;
+    }
+
+    bool bNot = false;
+    NODE* pNode = NULL;
+    if(IsKeyword("IS"))
+    {
+        m_nToken++;
+        if(IsKeyword("NOT"))
+        {
+            bNot = true;
+            m_nToken++;
+        }
+        if(!IsKeyword("NULL"))
+            return NULL;
+        m_nToken++;
+        pNode = CreateNode(enumGISFilterNodeIsNull);
+        pNode->nField = nField;
+        return bNot ? CreateNode(enumGISFilterNodeNot, pNode) : pNode;
+    }
+
+    if(IsKeyword("NOT"))
+    {
+        bNot = true;
+        m_nToken++;
+    }
+
+    if(IsKeyword("IN"))
+    {
+        m_nToken++;
+        if(m_astTokens[m_nToken].eType != enumGISFilterTokenOpen)
+            return NULL;
+        m_nToken++;
+
+        pNode = CreateNode(enumGISFilterNodeIn);
+        pNode->nField = nField;
+        while(true)
+        {
+            if(!ParseLiteral(nField, pNode))
+            {
+                DeleteNode(pNode);
+                return NULL;
+            }
+            eType = m_astTokens[m_nToken++].eType;
+            if(eType == enumGISFilterTokenClose)
+                break;
+            if(eType != enumGISFilterTokenComma)
+            {
+                DeleteNode(pNode);
+                return NULL;
+            }
+        }
+    }
+    else if(IsKeyword("LIKE"))
+    {
+        m_nToken++;
+        if(nField == COLUMN_FILTER_FID || m_poDefn->GetFieldDefn(nField)->GetType() != OFTString)
+            return NULL;
+        pNode = CreateNode(enumGISFilterNodeLike);
+        pNode->nField = nField;
+        if(!ParseLiteral(nField, pNode) || IsKeyword("ESCAPE"))
+        {
+            DeleteNode(pNode);
+            return NULL;
+        }
+    }
+    else if(IsKeyword("BETWEEN"))
+    {
+        m_nToken++;
+        NODE* pLeft = CreateNode(enumGISFilterNodeCompare);
+        pLeft->nField = nField;
+        pLeft->eOp = enumGISFilterOpGE;
+        NODE* pRight = CreateNode(enumGISFilterNodeCompare);
+        pRight->nField = nField;
+        pRight->eOp = enumGISFilterOpLE;
+        pNode = CreateNode(enumGISFilterNodeAnd, pLeft, pRight);
+        if(!ParseLiteral(nField, pLeft) || !IsKeyword("AND"))
+        {
+            DeleteNode(pNode);
+            return NULL;
+        }
+        m_nToken++;
+        if(!ParseLiteral(nField, pRight))
+        {
+            DeleteNode(pNode);
+            return NULL;
+        }
+    }
+    else
+    {
+        return NULL;
+    }
+
+    return bNot ? CreateNode(enumGISFilterNodeNot, pNode) : pNode;
+}
+
+bool wxGISColumnStoreFilter::ParseField(int &nField)
+{
+    const TOKEN &stToken = m_astTokens[m_nToken];
+    if(stToken.eType != enumGISFilterTokenIdentifier)
+        return false;
+
+    if(!stToken.bQuoted)
+    {
+        for(int i = 0; s_apszKeywords[i] != NULL; ++i)
+        {
+            if(EQUAL(stToken.sValue, s_apszKeywords[i]))
+                return false;
+        }
+    }
+
+    nField = m_poDefn->GetFieldIndex(stToken.sValue);
+    if(nField < 0)
+    {
+        if(!EQUAL(stToken.sValue, "FID"))
+            return false;
+        nField = COLUMN_FILTER_FID;
+    }
+    m_nToken++;
+    return true;
+}
+
+bool wxGISColumnStoreFilter::ParseOperator(wxGISEnumFilterOperator &eOp)
+{
+    const TOKEN &stToken = m_astTokens[m_nToken];
+    if(stToken.eType != enumGISFilterTokenOperator)
+        return false;
+
+    if(stToken.sValue == "=" || stToken.sValue == "==")
+        eOp = enumGISFilterOpEQ;
+    else if(stToken.sValue == "<>" || stToken.sValue == "!=")
+        eOp = enumGISFilterOpNE;
+    else if(stToken.sValue == "<")
+        eOp = enumGISFilterOpLT;
+    else if(stToken.sValue == "<=")
+        eOp = enumGISFilterOpLE;
+    else if(stToken.sValue == ">")
+        eOp = enumGISFilterOpGT;
+    else if(stToken.sValue == ">=")
+        eOp = enumGISFilterOpGE;
+    else
+        return false;
+
+    m_nToken++;
+    return true;
+}
+
+bool wxGISColumnStoreFilter::ParseLiteral(int nField, NODE* pNode)
+{
+    const TOKEN &stToken = m_astTokens[m_nToken];
+    OGRFieldType eType = nField == COLUMN_FILTER_FID ? OFTInteger : m_poDefn->GetFieldDefn(nField)->GetType();
+
+    //the other field types and the types conversion are left to OGR
+    if(eType == OFTInteger || eType == OFTReal)
+    {
+        if(stToken.eType != enumGISFilterTokenNumber)
+            return false;
+        pNode->adfValues.push_back(stToken.dfValue);
+    }
+    else if(eType == OFTString)
+    {
+        if(stToken.eType != enumGISFilterTokenString)
+            return false;
+        pNode->asValues.push_back(stToken.sValue);
+    }
+    else
+    {
+        return false;
+    }
+
+    m_nToken++;
+    return true;
+}
+
+bool wxGISColumnStoreFilter::Evaluate(const wxGISFeatureColumnStore* pStore, wxVector<wxUint32> &anRowMask, ITrackCancel* const pTrackCancel) const
+{
+    anRowMask.clear();
+    if(NULL == m_pRoot || NULL == pStore)
+        return true;
+
+    size_t nRowCount = pStore->GetRowCount();
+    size_t nWordCount = (nRowCount + 31) >> 5;
+    anRowMask.resize(nWordCount, 0);
+    const long* panFIDs = pStore->GetFIDs();
+
+    wxUint32 anTrue[COLUMN_FILTER_BATCH_WORDS], anUnknown[COLUMN_FILTER_BATCH_WORDS];
+    for(size_t nWord = 0; nWord < nWordCount; nWord += COLUMN_FILTER_BATCH_WORDS)
+    {
+        if(pTrackCancel && !pTrackCancel->Continue())
+            return false;
+
+        size_t nWords = wxMin(size_t(COLUMN_FILTER_BATCH_WORDS), nWordCount - nWord);
+        EvaluateNode(m_pRoot, pStore, nWord, nWords, anTrue, anUnknown);
+
+        for(size_t i = 0; i < nWords; ++i)
+        {
+            wxUint32 nBits = anTrue[i];
+            //drop the deleted rows and the rows after the end
+            size_t nRow = (nWord + i) << 5;
+            for(size_t j = 0; nBits != 0 && j < 32; ++j)
+            {
+                if(nRow + j >= nRowCount || panFIDs[nRow + j] == wxNOT_FOUND)
+                    nBits &= ~(1U << j);
+            }
+            anRowMask[nWord + i] = nBits;
+        }
+    }
+    return true;
+}
+
+void wxGISColumnStoreFilter::EvaluateNode(const NODE* pNode, const wxGISFeatureColumnStore* pStore, size_t nFirstWord, size_t nWords, wxUint32* panTrue, wxUint32* panUnknown) const
+{
+    size_t i;
+    switch(pNode->eType)
+    {
+    case enumGISFilterNodeAnd:
+    case enumGISFilterNodeOr:
+        {
+            wxUint32 anTrue[COLUMN_FILTER_BATCH_WORDS], anUnknown[COLUMN_FILTER_BATCH_WORDS];
+            EvaluateNode(pNode->pLeft, pStore, nFirstWord, nWords, panTrue, panUnknown);
+            EvaluateNode(pNode->pRight, pStore, nFirstWord, nWords, anTrue, anUnknown);
+            for(i = 0; i < nWords; ++i)
+            {
+                if(pNode->eType == enumGISFilterNodeAnd)
+                {
+                    //unknown if any is unknown and none is false
+                    wxUint32 nFalse = ~(panTrue[i] | panUnknown[i]) | ~(anTrue[i] | anUnknown[i]);
+                    panTrue[i] &= anTrue[i];
+                    panUnknown[i] = (panUnknown[i] | anUnknown[i]) & ~nFalse;
+                }
+                else
+                {
+                    panTrue[i] |= anTrue[i];
+                    panUnknown[i] = (panUnknown[i] | anUnknown[i]) & ~panTrue[i];
+                }
+            }
+        }
+        break;
+    case enumGISFilterNodeNot:
+        EvaluateNode(pNode->pLeft, pStore, nFirstWord, nWords, panTrue, panUnknown);
+        for(i = 0; i < nWords; ++i)
+            panTrue[i] = ~(panTrue[i] | panUnknown[i]);
+        break;
+    default:
+        {
+            size_t nRowCount = pStore->GetRowCount();
+            const wxUint32* panSet = pNode->nField == COLUMN_FILTER_FID ? NULL : pStore->GetSetMask(pNode->nField);
+            for(i = 0; i < nWords; ++i)
+            {
+                size_t nRow = (nFirstWord + i) << 5;
+                wxUint32 nSet = panSet ? panSet[nFirstWord + i] : 0xFFFFFFFF;
+                if(pNode->eType == enumGISFilterNodeIsNull)
+                {
+                    panTrue[i] = ~nSet;
+                    panUnknown[i] = 0;
+                    continue;
+                }
+                //the compare with null is unknown
+                panTrue[i] = nSet == 0 ? 0 : EvaluateRows(pNode, pStore, nRow, wxMin(size_t(32), nRowCount - nRow), nSet) & nSet;
+                panUnknown[i] = ~nSet;
+            }
+        }
+        break;
+    }
+}
+
+wxUint32 wxGISColumnStoreFilter::EvaluateRows(const NODE* pNode, const wxGISFeatureColumnStore* pStore, size_t nFirstRow, size_t nRows, wxUint32 nSet) const
+{
+    if(pNode->nField == COLUMN_FILTER_FID)
+        return TestValues(pStore->GetFIDs() + nFirstRow, pNode->eType, pNode->eOp, pNode->adfValues, nRows);
+
+    switch(pStore->GetColumnType(pNode->nField))
+    {
+    case OFTInteger:
+        return TestValues(pStore->GetIntegerValues(pNode->nField) + nFirstRow, pNode->eType, pNode->eOp, pNode->adfValues, nRows);
+    case OFTReal:
+        return TestValues(pStore->GetRealValues(pNode->nField) + nFirstRow, pNode->eType, pNode->eOp, pNode->adfValues, nRows);
+    default:
+        break;
+    }
+
+    wxUint32 nBits = 0;
+    for(size_t i = 0; i < nRows; ++i)
+    {
+        if((nSet & (1U << i)) == 0)
+            continue;
+
+        const char* pszValue = pStore->GetString(pNode->nField, nFirstRow + i);
+        bool bResult = false;
+        switch(pNode->eType)
+        {
+        case enumGISFilterNodeIn:
+            for(size_t j = 0; j < pNode->asValues.size() && !bResult; ++j)
+                bResult = strcmp(pszValue, pNode->asValues[j]) == 0;
+            break;
+        case enumGISFilterNodeLike:
+            bResult = Like(pszValue, pNode->asValues[0]);
+            break;
+        default:
+            switch(pNode->eOp)
+            {
+            case enumGISFilterOpEQ:
+                bResult = strcmp(pszValue, pNode->asValues[0]) == 0;
+                break;
+            case enumGISFilterOpNE:
+                bResult = strcmp(pszValue, pNode->asValues[0]) != 0;
+                break;
+            case enumGISFilterOpLT:
+                bResult = strcmp(pszValue, pNode->asValues[0]) < 0;
+                break;
+            case enumGISFilterOpLE:
+                bResult = strcmp(pszValue, pNode->asValues[0]) <= 0;
+                break;
+            case enumGISFilterOpGT:
+                bResult = strcmp(pszValue, pNode->asValues[0]) > 0;
+                break;
+            case enumGISFilterOpGE:
+                bResult = strcmp(pszValue, pNode->asValues[0]) >= 0;
+                break;
+            }
+            break;
+        }
+        if(bResult)
+            nBits |= 1U << i;
+    }
+    return nBits;
+}
+
+bool wxGISColumnStoreFilter::Like(const char* pszInput, const char* pszPattern)
+{
+    for( ; *pszPattern != 0; ++pszPattern)
+    {
+        if(*pszPattern == '_')
+        {
+            if(*pszInput == 0)
+                return false;
+            pszInput++;
+        }
+        else if(*pszPattern == '%')
+        {
+            for( ; *pszInput != 0; ++pszInput)
+            {
+                if(Like(pszInput, pszPattern + 1))
+                    return true;
+            }
+            return Like(pszInput, pszPattern + 1);
+        }
+        else
+        {
+            if(tolower((unsigned char)*pszPattern) != tolower((unsigned char)*pszInput))
+                return false;
+            pszInput++;
+        }
+    }
+    return *pszInput == 0;
+}
+
+bool wxGISColumnStoreFilter::GetIndexField(int &nField) const
+{
+    if(NULL == m_pRoot)
+        return false;
+    nField = COLUMN_FILTER_FID;
+    return GetNodeField(m_pRoot, nField);
+}
+
+bool wxGISColumnStoreFilter::GetNodeField(const NODE* pNode, int &nField) const
+{
+    switch(pNode->eType)
+    {
+    case enumGISFilterNodeAnd:
+    case enumGISFilterNodeOr:
+        return GetNodeField(pNode->pLeft, nField) && GetNodeField(pNode->pRight, nField);
+    case enumGISFilterNodeCompare:
+    case enumGISFilterNodeIn:
+        //FID is looked up by the datasource
+        if(pNode->nField == COLUMN_FILTER_FID || (nField != COLUMN_FILTER_FID && nField != pNode->nField))
+            return false;
+        nField = pNode->nField;
+        return true;
+    default:
+        return false;
+    }
+}
+
+void wxGISColumnStoreFilter::Select(wxGISAttributeIndex* const pIndex, wxVector<long> &anFIDs) const
+{
+    anFIDs.clear();
+    if(NULL == m_pRoot || NULL == pIndex)
+        return;
+    SelectNode(m_pRoot, pIndex, anFIDs);
+}
+
+void wxGISColumnStoreFilter::SelectNode(const NODE* pNode, wxGISAttributeIndex* const pIndex, wxVector<long> &anFIDs) const
+{
+    size_t i;
+    switch(pNode->eType)
+    {
+    case enumGISFilterNodeAnd:
+    case enumGISFilterNodeOr:
+        {
+            wxVector<long> anLeft, anRight;
+            SelectNode(pNode->pLeft, pIndex, anLeft);
+            SelectNode(pNode->pRight, pIndex, anRight);
+            anFIDs.resize(anLeft.size() + anRight.size());
+            wxVector<long>::iterator itEnd;
+            if(pNode->eType == enumGISFilterNodeAnd)
+                itEnd = std::set_intersection(anLeft.begin(), anLeft.end(), anRight.begin(), anRight.end(), anFIDs.begin());
+            else
+                itEnd = std::set_union(anLeft.begin(), anLeft.end(), anRight.begin(), anRight.end(), anFIDs.begin());
+            anFIDs.resize(itEnd - anFIDs.begin());
+        }
+        break;
+    case enumGISFilterNodeCompare:
+        pIndex->Find(pNode->eOp, pNode->adfValues.empty() ? 0 : pNode->adfValues[0], pNode->asValues.empty() ? NULL : pNode->asValues[0].c_str(), anFIDs);
+        std::sort(anFIDs.begin(), anFIDs.end());
+        break;
+    case enumGISFilterNodeIn:
+        for(i = 0; i < wxMax(pNode->adfValues.size(), pNode->asValues.size()); ++i)
+            pIndex->Find(enumGISFilterOpEQ, pNode->adfValues.empty() ? 0 : pNode->adfValues[i], pNode->asValues.empty() ? NULL : pNode->asValues[i].c_str(), anFIDs);
+        std::sort(anFIDs.begin(), anFIDs.end());
+        anFIDs.resize(std::unique(anFIDs.begin(), anFIDs.end()) - anFIDs.begin());
+        break;
+    default:
+        break;
+    }
+}
@@ -0,0 +1,539 @@
+/******************************************************************************
+ * Project:  wxGIS
+ * Purpose:  wxGISFeatureColumnStore class. Column oriented in memory features storage.
+ * Author:   Dmitry Baryshnikov (aka Bishop), polimax@mail.ru
+ ******************************************************************************
+*   Copyright (C) 2014 Dmitry Baryshnikov
+*
+*    This program is free software: you can redistribute it and/or modify
+*    it under the terms of the GNU General Public License as published by
+*    the Free Software Foundation, either version 2 of the License, or
+*    (at your option) any later version.
+*
+*    This program is distributed in the hope that it will be useful,
+*    but WITHOUT ANY WARRANTY; without even the implied warranty of
+*    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+*    GNU General Public License for more details.
+*
+*    You should have received a copy of the GNU General Public License
+*    along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ ****************************************************************************/
+#include "wxgis/datasource/columnstore.h"
+
+//-----------------------------------------------------------------------------
+// wxGISFeatureColumnStore
+//-----------------------------------------------------------------------------
+
+wxGISFeatureColumnStore::wxGISFeatureColumnStore(OGRFeatureDefn* const poDefn, const wxFontEncoding &oEncoding, bool bRecodeToSystem)
+{
+    m_poDefn = poDefn;
+    if(m_poDefn)
+        m_poDefn->Reference();
+    m_Encoding = oEncoding;
+    m_bRecodeToSystem = bRecodeToSystem;
+
+    int nFieldCount = m_poDefn ? m_poDefn->GetFieldCount() : 0;
+    m_astColumns.resize(nFieldCount);
+    for(int i = 0; i < nFieldCount; ++i)
+    {
+        m_astColumns[i].eType = m_poDefn->GetFieldDefn(i)->GetType();
+    }
+
+    m_nMinFID = 0;
+    m_bDenseFID = true;
+    m_nUnusedStrings = 0;
+    m_nUnusedWKB = 0;
+    m_poSpatialRef = NULL;
+}
+
+wxGISFeatureColumnStore::~wxGISFeatureColumnStore(void)
+{
+    Clear();
+    if(m_poDefn)
+        m_poDefn->Release();
+    if(m_poSpatialRef)
+        m_poSpatialRef->Release();
+}
+
+void wxGISFeatureColumnStore::SetSpatialReference(OGRSpatialReference* const poSpatialRef)
+{
+    if(m_poSpatialRef == poSpatialRef)
+        return;
+    if(m_poSpatialRef)
+        m_poSpatialRef->Release();
+    m_poSpatialRef = poSpatialRef;
+    if(m_poSpatialRef)
+        m_poSpatialRef->Reference();
+}
+
+bool wxGISFeatureColumnStore::IsSupported(OGRFeatureDefn* const poDefn)
+{
+    if(NULL == poDefn)
+        return false;
+
+    for(int i = 0; i < poDefn->GetFieldCount(); ++i)
+    {
+        switch(poDefn->GetFieldDefn(i)->GetType())
+        {
+        case OFTInteger:
+#if GDAL_VERSION_NUM >= 2000000
+        case OFTInteger64:
+#endif //GDAL_VERSION_NUM
+        case OFTReal:
+        case OFTString:
+        case OFTBinary:
+        case OFTDate:
+        case OFTTime:
+        case OFTDateTime:
+            break;
+        default:
+            return false;
+        }
+    }
+    return true;
+}
+
+void wxGISFeatureColumnStore::Clear(void)
+{
+    for(size_t i = 0; i < m_astColumns.size(); ++i)
+    {
+        m_astColumns[i].anValues.clear();
+        m_astColumns[i].anValues64.clear();
+        m_astColumns[i].adfValues.clear();
+        m_astColumns[i].astRawValues.clear();
+        m_astColumns[i].anOffsets.clear();
+        m_astColumns[i].anSizes.clear();
+        m_astColumns[i].anSetMask.clear();
+    }
+    m_anFIDs.clear();
+    m_anStyleOffsets.clear();
+    m_achStrings.clear();
+    m_anWKBOffsets.clear();
+    m_anWKBSizes.clear();
+    m_abyWKB.clear();
+    m_nUnusedStrings = 0;
+    m_nUnusedWKB = 0;
+
+    m_nMinFID = 0;
+    m_anFIDRows.clear();
+    m_mFIDRows.clear();
+    m_bDenseFID = true;
+}
+
+size_t wxGISFeatureColumnStore::GetRowCount(void) const
+{
+    return m_anFIDs.size();
+}
+
+void wxGISFeatureColumnStore::Add(OGRFeature* const poFeature)
+{
+    wxCHECK_RET(poFeature, wxT("The input feature pointer is null"));
+
+    size_t nRow = m_anFIDs.size();
+    m_anFIDs.push_back(poFeature->GetFID());
+    m_anStyleOffsets.push_back(0);
+    m_anWKBOffsets.push_back(0);
+    m_anWKBSizes.push_back(0);
+    for(size_t i = 0; i < m_astColumns.size(); ++i)
+    {
+        COLUMN &stColumn = m_astColumns[i];
+        switch(stColumn.eType)
+        {
+        case OFTInteger:
+            stColumn.anValues.push_back(0);
+            break;
+#if GDAL_VERSION_NUM >= 2000000
+        case OFTInteger64:
+            stColumn.anValues64.push_back(0);
+            break;
+#endif //GDAL_VERSION_NUM
+        case OFTReal:
+            stColumn.adfValues.push_back(0);
+            break;
+        case OFTDate:
+        case OFTTime:
+        case OFTDateTime:
+            stColumn.astRawValues.push_back(OGRField());
+            break;
+        case OFTBinary:
+            stColumn.anOffsets.push_back(0);
+            stColumn.anSizes.push_back(0);
+            break;
+        default:
+            stColumn.anOffsets.push_back(0);
+            break;
+        }
+        if((nRow >> 5) >= stColumn.anSetMask.size())
+            stColumn.anSetMask.push_back(0);
+    }
+
+    SetRow(nRow, poFeature);
+    SetFIDRow(poFeature->GetFID(), nRow);
+}
+
+void wxGISFeatureColumnStore::Set(OGRFeature* const poFeature)
+{
+    wxCHECK_RET(poFeature, wxT("The input feature pointer is null"));
+
+    long nRow = GetRow(poFeature->GetFID());
+    if(nRow == wxNOT_FOUND)
+    {
+        Add(poFeature);
+    }
+    else
+    {
+        SetRow(nRow, poFeature);
+        CompactIfNeeded();
+    }
+}
+
+void wxGISFeatureColumnStore::SetRow(size_t nRow, OGRFeature* const poFeature)
+{
+    //the previous values of the changed row are left in the buffers
+    ReleaseRow(nRow);
+
+    //the definition of feature may differ from the storage one (e.g. stored to the layer), so the fields are matched by index
+    int nFieldCount = wxMin((int)m_astColumns.size(), poFeature->GetFieldCount());
+    for(int i = 0; i < (int)m_astColumns.size(); ++i)
+    {
+        COLUMN &stColumn = m_astColumns[i];
+        wxUint32 nBit = 1U << (nRow & 31);
+        if(i >= nFieldCount || !poFeature->IsFieldSet(i))
+        {
+            stColumn.anSetMask[nRow >> 5] &= ~nBit;
+            continue;
+        }
+        stColumn.anSetMask[nRow >> 5] |= nBit;
+
+        switch(stColumn.eType)
+        {
+        case OFTInteger:
+            stColumn.anValues[nRow] = poFeature->GetFieldAsInteger(i);
+            break;
+#if GDAL_VERSION_NUM >= 2000000
+        case OFTInteger64:
+            stColumn.anValues64[nRow] = poFeature->GetFieldAsInteger64(i);
+            break;
+#endif //GDAL_VERSION_NUM
+        case OFTReal:
+            stColumn.adfValues[nRow] = poFeature->GetFieldAsDouble(i);
+            break;
+        case OFTDate:
+        case OFTTime:
+        case OFTDateTime:
+            //the date and time values have no pointers, the copy is safe
+            stColumn.astRawValues[nRow] = *poFeature->GetRawFieldRef(i);
+            break;
+        case OFTBinary:
+            {
+                int nBytes(0);
+                GByte* pabyData = poFeature->GetFieldAsBinary(i, &nBytes);
+                stColumn.anOffsets[nRow] = AddBytes(pabyData, nBytes);
+                stColumn.anSizes[nRow] = nBytes;
+            }
+            break;
+        default:
+            stColumn.anOffsets[nRow] = AddString(poFeature->GetFieldAsString(i));
+            break;
+        }
+    }
+
+    const char* pszStyle = poFeature->GetStyleString();
+    m_anStyleOffsets[nRow] = pszStyle == NULL || pszStyle[0] == 0 ? 0 : AddString(pszStyle) + 1;
+
+    OGRGeometry* poGeom = poFeature->GetGeometryRef();
+    m_anWKBSizes[nRow] = 0;
+    if(poGeom)
+    {
+        if(NULL == m_poSpatialRef && poGeom->getSpatialReference())
+            SetSpatialReference(poGeom->getSpatialReference());
+
+        size_t nSize = poGeom->WkbSize();
+        size_t nOffset = m_abyWKB.size();
+        m_abyWKB.resize(nOffset + nSize);
+        if(poGeom->exportToWkb(wkbNDR, &m_abyWKB[nOffset]) == OGRERR_NONE)
+        {
+            m_anWKBOffsets[nRow] = nOffset;
+            m_anWKBSizes[nRow] = nSize;
+        }
+        else
+        {
+            m_abyWKB.resize(nOffset);
+        }
+    }
+}
+
+size_t wxGISFeatureColumnStore::AddString(const char* pszValue)
+{
+    return AddBytes(pszValue, strlen(pszValue) + 1);
+}
+
+size_t wxGISFeatureColumnStore::AddBytes(const void* pData, size_t nSize)
+{
+    size_t nOffset = m_achStrings.size();
+    if(nSize == 0)
+        return nOffset;
+    m_achStrings.resize(nOffset + nSize);
+    memcpy(&m_achStrings[nOffset], pData, nSize);
+    return nOffset;
+}
+
+void wxGISFeatureColumnStore::Delete(long nFID)
+{
+    long nRow = GetRow(nFID);
+    if(nRow == wxNOT_FOUND)
+        return;
+
+    //the row values are unset, so the compacting and the filters never read them
+    ReleaseRow(nRow);
+    for(size_t i = 0; i < m_astColumns.size(); ++i)
+        m_astColumns[i].anSetMask[nRow >> 5] &= ~(1U << (nRow & 31));
+    m_anStyleOffsets[nRow] = 0;
+    m_anFIDs[nRow] = wxNOT_FOUND;
+    m_anWKBSizes[nRow] = 0;
+    RemoveFIDRow(nFID);
+    CompactIfNeeded();
+}
+
+void wxGISFeatureColumnStore::ReleaseRow(size_t nRow)
+{
+    for(size_t i = 0; i < m_astColumns.size(); ++i)
+    {
+        const COLUMN &stColumn = m_astColumns[i];
+        if(!IsSet(stColumn, nRow))
+            continue;
+
+        switch(stColumn.eType)
+        {
+        case OFTInteger:
+#if GDAL_VERSION_NUM >= 2000000
+        case OFTInteger64:
+#endif //GDAL_VERSION_NUM
+        case OFTReal:
+        case OFTDate:
+        case OFTTime:
+        case OFTDateTime:
+            break;
+        case OFTBinary:
+            m_nUnusedStrings += stColumn.anSizes[nRow];
+            break;
+        default:
+            m_nUnusedStrings += strlen(&m_achStrings[stColumn.anOffsets[nRow]]) + 1;
+            break;
+        }
+    }
+
+    if(m_anStyleOffsets[nRow] > 0)
+        m_nUnusedStrings += strlen(&m_achStrings[m_anStyleOffsets[nRow] - 1]) + 1;
+    m_nUnusedWKB += m_anWKBSizes[nRow];
+}
+
+void wxGISFeatureColumnStore::CompactIfNeeded(void)
+{
+    if(m_nUnusedStrings > COLUMN_STORE_COMPACT_SIZE && m_nUnusedStrings > m_achStrings.size() / 2)
+        CompactStrings();
+    if(m_nUnusedWKB > COLUMN_STORE_COMPACT_SIZE && m_nUnusedWKB > m_abyWKB.size() / 2)
+        CompactWKB();
+}
+
+void wxGISFeatureColumnStore::CompactStrings(void)
+{
+    wxVector<char> achStrings;
+    achStrings.reserve(m_achStrings.size() - m_nUnusedStrings);
+    for(size_t nRow = 0; nRow < m_anFIDs.size(); ++nRow)
+    {
+        for(size_t i = 0; i < m_astColumns.size(); ++i)
+        {
+            COLUMN &stColumn = m_astColumns[i];
+            if(!IsSet(stColumn, nRow))
+                continue;
+
+            size_t nSize;
+            switch(stColumn.eType)
+            {
+            case OFTInteger:
+#if GDAL_VERSION_NUM >= 2000000
+            case OFTInteger64:
+#endif //GDAL_VERSION_NUM
+            case OFTReal:
+            case OFTDate:
+            case OFTTime:
+            case OFTDateTime:
+                continue;
+            case OFTBinary:
+                nSize = stColumn.anSizes[nRow];
+                break;
+            default:
+                nSize = strlen(&m_achStrings[stColumn.anOffsets[nRow]]) + 1;
+                break;
+            }
+
+            size_t nOffset = achStrings.size();
+            if(nSize > 0)
+            {
+                achStrings.resize(nOffset + nSize);
+                memcpy(&achStrings[nOffset], &m_achStrings[stColumn.anOffsets[nRow]], nSize);
+            }
+            stColumn.anOffsets[nRow] = nOffset;
+        }
+
+        if(m_anStyleOffsets[nRow] > 0)
+        {
+            const char* pszStyle = &m_achStrings[m_anStyleOffsets[nRow] - 1];
+            size_t nSize = strlen(pszStyle) + 1;
+            size_t nOffset = achStrings.size();
+            achStrings.resize(nOffset + nSize);
+            memcpy(&achStrings[nOffset], pszStyle, nSize);
+            m_anStyleOffsets[nRow] = nOffset + 1;
+        }
+    }
+    m_achStrings = achStrings;
+    m_nUnusedStrings = 0;
+}
+
+void wxGISFeatureColumnStore::CompactWKB(void)
+{
+    wxVector<unsigned char> abyWKB;
+    abyWKB.reserve(m_abyWKB.size() - m_nUnusedWKB);
+    for(size_t nRow = 0; nRow < m_anFIDs.size(); ++nRow)
+    {
+        if(m_anWKBSizes[nRow] == 0)
+            continue;
+        size_t nOffset = abyWKB.size();
+        abyWKB.resize(nOffset + m_anWKBSizes[nRow]);
+        memcpy(&abyWKB[nOffset], &m_abyWKB[m_anWKBOffsets[nRow]], m_anWKBSizes[nRow]);
+        m_anWKBOffsets[nRow] = nOffset;
+    }
+    m_abyWKB = abyWKB;
+    m_nUnusedWKB = 0;
+}
+
+void wxGISFeatureColumnStore::SetFIDRow(long nFID, size_t nRow)
+{
+    if(m_bDenseFID)
+    {
+        if(m_anFIDRows.empty())
+            m_nMinFID = nFID;
+
+        //the array is used while FIDs go up and have no big gaps
+        if(nFID >= m_nMinFID && size_t(nFID - m_nMinFID) < (m_anFIDs.size() + 1) * COLUMN_STORE_DENSE_FID_GAP + 1024)
+        {
+            size_t nIndex = nFID - m_nMinFID;
+            if(nIndex >= m_anFIDRows.size())
+                m_anFIDRows.resize(nIndex + 1, wxNOT_FOUND);
+            m_anFIDRows[nIndex] = nRow;
+            return;
+        }
+
+        //switch to the hash map
+        for(size_t i = 0; i < m_anFIDRows.size(); ++i)
+        {
+            if(m_anFIDRows[i] != wxNOT_FOUND)
+                m_mFIDRows[m_nMinFID + long(i)] = m_anFIDRows[i];
+        }
+        m_anFIDRows.clear();
+        m_bDenseFID = false;
+    }
+    m_mFIDRows[nFID] = nRow;
+}
+
+void wxGISFeatureColumnStore::RemoveFIDRow(long nFID)
+{
+    if(m_bDenseFID)
+    {
+        if(nFID >= m_nMinFID && size_t(nFID - m_nMinFID) < m_anFIDRows.size())
+            m_anFIDRows[nFID - m_nMinFID] = wxNOT_FOUND;
+    }
+    else
+    {
+        m_mFIDRows.erase(nFID);
+    }
+}
+
+long wxGISFeatureColumnStore::GetRow(long nFID) const
+{
+    if(m_bDenseFID)
+    {
+        if(nFID < m_nMinFID || size_t(nFID - m_nMinFID) >= m_anFIDRows.size())
+            return wxNOT_FOUND;
+        return m_anFIDRows[nFID - m_nMinFID];
+    }
+
+    wxGISFIDRowMap::const_iterator it = m_mFIDRows.find(nFID);
+    if(it == m_mFIDRows.end())
+        return wxNOT_FOUND;
+    return it->second;
+}
+
+bool wxGISFeatureColumnStore::HasFID(long nFID) const
+{
+    return GetRow(nFID) != wxNOT_FOUND;
+}
+
+long wxGISFeatureColumnStore::GetFID(size_t nRow) const
+{
+    wxCHECK_MSG(nRow < m_anFIDs.size(), wxNOT_FOUND, wxT("The row index is out of range"));
+    return m_anFIDs[nRow];
+}
+
+wxGISFeature wxGISFeatureColumnStore::GetFeature(size_t nRow) const
+{
+    if(nRow >= m_anFIDs.size() || m_anFIDs[nRow] == wxNOT_FOUND || m_poDefn == NULL)
+        return wxGISFeature();
+
+    OGRFeature* poFeature = OGRFeature::CreateFeature(m_poDefn);
+    poFeature->SetFID(m_anFIDs[nRow]);
+
+    for(size_t i = 0; i < m_astColumns.size(); ++i)
+    {
+        const COLUMN &stColumn = m_astColumns[i];
+        if(!IsSet(stColumn, nRow))
+            continue;
+
+        switch(stColumn.eType)
+        {
+        case OFTInteger:
+            poFeature->SetField((int)i, stColumn.anValues[nRow]);
+            break;
+#if GDAL_VERSION_NUM >= 2000000
+        case OFTInteger64:
+            poFeature->SetField((int)i, stColumn.anValues64[nRow]);
+            break;
+#endif //GDAL_VERSION_NUM
+        case OFTReal:
+            poFeature->SetField((int)i, stColumn.adfValues[nRow]);
+            break;
+        case OFTDate:
+        case OFTTime:
+        case OFTDateTime:
+            poFeature->SetField((int)i, (OGRField*)&stColumn.astRawValues[nRow]);
+            break;
+        case OFTBinary:
+            poFeature->SetField((int)i, (int)stColumn.anSizes[nRow], stColumn.anSizes[nRow] == 0 ? NULL : (GByte*)&m_achStrings[stColumn.anOffsets[nRow]]);
+            break;
+        default:
+            poFeature->SetField((int)i, &m_achStrings[stColumn.anOffsets[nRow]]);
+            break;
+        }
+    }
+
+    if(m_anStyleOffsets[nRow] > 0)
+        poFeature->SetStyleString(&m_achStrings[m_anStyleOffsets[nRow] - 1]);
+
+    if(m_anWKBSizes[nRow] > 0)
+    {
+        OGRGeometry* poGeom = NULL;
+        if(OGRGeometryFactory::createFromWkb((unsigned char*)&m_abyWKB[m_anWKBOffsets[nRow]], m_poSpatialRef, &poGeom, m_anWKBSizes[nRow]) == OGRERR_NONE)
+            poFeature->SetGeometryDirectly(poGeom);
+    }
+
+    return wxGISFeature(poFeature, m_Encoding, m_bRecodeToSystem);
+}
+
+wxGISFeature wxGISFeatureColumnStore::GetFeatureByID(long nFID) const
+{
+    long nRow = GetRow(nFID);
+    if(nRow == wxNOT_FOUND)
+        return wxGISFeature();
+    return GetFeature(nRow);
+}
@@ -136,3 +136,239 @@ wxGISTable* wxFeatureCursorRefData::GetDataset() const
     wsGET(m_pFeatureDataSet);
 }
 
+
+//----------------------------------------------------------------------------
+// wxFeatureStream
+//----------------------------------------------------------------------------
+
+wxFeatureStream::wxFeatureStream(wxGISTable* pFeatureDataSet, size_t nBatchSize)
+{
+    wsSET(m_pFeatureDataSet, pFeatureDataSet);
+    m_nBatchSize = wxMax(nBatchSize, size_t(1));
+    m_nBatchPos = 0;
+    m_nPosition = 0;
+    m_bStopped = false;
+}
+
+wxFeatureStream::~wxFeatureStream(void)
+{
+    m_aBatch.clear();
+    wsDELETE(m_pFeatureDataSet);
+}
+
+wxGISFeature wxFeatureStream::Next(void)
+{
+    if(m_nBatchPos >= m_aBatch.size())
+    {
+        m_aBatch.clear();
+        m_nBatchPos = 0;
+        if(m_bStopped || Fetch(m_aBatch, m_nBatchSize) == 0)
+        {
+            Stop();
+            return wxGISFeature();
+        }
+    }
+
+    m_nPosition++;
+    return m_aBatch[m_nBatchPos++];
+}
+
+size_t wxFeatureStream::NextBatch(wxVector<wxGISFeature> &aFeatures)
+{
+    aFeatures.clear();
+    //return the rest of current batch first
+    for(; m_nBatchPos < m_aBatch.size(); ++m_nBatchPos)
+        aFeatures.push_back(m_aBatch[m_nBatchPos]);
+    m_aBatch.clear();
+    m_nBatchPos = 0;
+
+    if(aFeatures.empty() && (m_bStopped || Fetch(aFeatures, m_nBatchSize) == 0))
+    {
+        Stop();
+        return 0;
+    }
+
+    m_nPosition += aFeatures.size();
+    return aFeatures.size();
+}
+
+void wxFeatureStream::Stop(void)
+{
+    if(m_bStopped)
+        return;
+    m_bStopped = true;
+    m_aBatch.clear();
+    m_nBatchPos = 0;
+    Release();
+}
+
+bool wxFeatureStream::IsStopped(void) const
+{
+    return m_bStopped;
+}
+
+size_t wxFeatureStream::GetPosition(void) const
+{
+    return m_nPosition;
+}
+
+wxGISTable* wxFeatureStream::GetDataset() const
+{
+    wsGET(m_pFeatureDataSet);
+}
+
+void wxFeatureStream::Release(void)
+{
+}
+
+//----------------------------------------------------------------------------
+// wxFeatureLayerStream
+//----------------------------------------------------------------------------
+
+wxFeatureLayerStream::wxFeatureLayerStream(wxGISTable* pFeatureDataSet, OGRLayer* poLayer, const wxString &sWhereClause, size_t nBatchSize) : wxFeatureStream(pFeatureDataSet, nBatchSize)
+{
+    m_poLayer = poLayer;
+    m_bHasFilter = false;
+    m_nNextFID = 0;
+    if(NULL == m_poLayer || NULL == m_pFeatureDataSet)
+    {
+        m_bStopped = true;
+        return;
+    }
+
+    wxCriticalSectionLocker locker(m_pFeatureDataSet->m_CritSect);
+    if(!sWhereClause.IsEmpty())
+    {
+        if(m_poLayer->SetAttributeFilter(sWhereClause.ToUTF8()) != OGRERR_NONE)
+        {
+            //restore the dataset filter
+            m_bHasFilter = true;
+            Release();
+            m_bStopped = true;
+            return;
+        }
+        m_bHasFilter = true;
+    }
+    m_poLayer->ResetReading();
+}
+
+wxFeatureLayerStream::~wxFeatureLayerStream(void)
+{
+    Stop();
+}
+
+size_t wxFeatureLayerStream::Fetch(wxVector<wxGISFeature> &aFeatures, size_t nCount)
+{
+    wxCriticalSectionLocker locker(m_pFeatureDataSet->m_CritSect);
+    wxFontEncoding eEncoding = m_pFeatureDataSet->m_Encoding;
+    bool bRecodeToSystem = m_pFeatureDataSet->m_bRecodeToSystem;
+
+    OGRFeature* poFeature;
+    while(aFeatures.size() < nCount && (poFeature = m_poLayer->GetNextFeature()) != NULL)
+    {
+        //the same FIDs as wxGISTable::Next sets
+        if(!m_pFeatureDataSet->m_bHasFID)
+            poFeature->SetFID(m_nNextFID++);
+        aFeatures.push_back(wxGISFeature(poFeature, eEncoding, bRecodeToSystem));
+    }
+    return aFeatures.size();
+}
+
+void wxFeatureLayerStream::Release(void)
+{
+    //set the dataset filter back
+    if(m_bHasFilter)
+    {
+        wxCriticalSectionLocker locker(m_pFeatureDataSet->m_CritSect);
+        if(m_pFeatureDataSet->m_bHasFilter)
+            m_poLayer->SetAttributeFilter(m_pFeatureDataSet->m_sFilter.ToUTF8());
+        else
+            m_poLayer->SetAttributeFilter(NULL);
+        m_bHasFilter = false;
+    }
+}
+
+//----------------------------------------------------------------------------
+// wxFeatureFIDStream
+//----------------------------------------------------------------------------
+
+wxFeatureFIDStream::wxFeatureFIDStream(wxGISTable* pFeatureDataSet, const wxVector<long> &anFIDs, size_t nBatchSize) : wxFeatureStream(pFeatureDataSet, nBatchSize)
+{
+    m_anFIDs = anFIDs;
+    m_nFIDPos = 0;
+    if(NULL == m_pFeatureDataSet)
+        m_bStopped = true;
+}
+
+wxFeatureFIDStream::~wxFeatureFIDStream(void)
+{
+    Stop();
+}
+
+size_t wxFeatureFIDStream::Fetch(wxVector<wxGISFeature> &aFeatures, size_t nCount)
+{
+    for(; aFeatures.size() < nCount && m_nFIDPos < m_anFIDs.size(); ++m_nFIDPos)
+    {
+        wxGISFeature Feature = m_pFeatureDataSet->GetFeatureByID(m_anFIDs[m_nFIDPos]);
+        if(Feature.IsOk())
+            aFeatures.push_back(Feature);
+    }
+    return aFeatures.size();
+}
+
+//----------------------------------------------------------------------------
+// wxFeatureStoreStream
+//----------------------------------------------------------------------------
+
+wxFeatureStoreStream::wxFeatureStoreStream(wxGISTableCached* pFeatureDataSet, const wxVector<wxUint32>* panRowMask, size_t nBatchSize) : wxFeatureStream(pFeatureDataSet, nBatchSize)
+{
+    m_pTableCached = pFeatureDataSet;
+    m_nStoreRevision = wxNOT_FOUND;
+    m_bHasMask = panRowMask != NULL;
+    if(m_bHasMask)
+        m_anRowMask = *panRowMask;
+    m_nRow = 0;
+    if(NULL == m_pTableCached || NULL == m_pTableCached->m_pColumnStore)
+        m_bStopped = true;
+    else
+        m_nStoreRevision = m_pTableCached->m_nColumnStoreRevision;
+}
+
+wxFeatureStoreStream::~wxFeatureStoreStream(void)
+{
+    Stop();
+}
+
+size_t wxFeatureStoreStream::Fetch(wxVector<wxGISFeature> &aFeatures, size_t nCount)
+{
+    //the cached dataset changes and deletes the store under this lock
+    wxCriticalSectionLocker locker(m_pFeatureDataSet->m_CritSect);
+    const wxGISFeatureColumnStore* pStore = m_pTableCached->m_pColumnStore;
+    if(NULL == pStore || m_pTableCached->m_nColumnStoreRevision != m_nStoreRevision)
+        return 0;
+    size_t nRowCount = pStore->GetRowCount();
+    if(m_bHasMask)
+        nRowCount = wxMin(nRowCount, m_anRowMask.size() << 5);
+
+    for(; aFeatures.size() < nCount && m_nRow < nRowCount; ++m_nRow)
+    {
+        if(m_bHasMask)
+        {
+            wxUint32 nBits = m_anRowMask[m_nRow >> 5] >> (m_nRow & 31);
+            //skip the empty rest of the word
+            if(nBits == 0)
+            {
+                m_nRow |= 31;
+                continue;
+            }
+            if((nBits & 1) == 0)
+                continue;
+        }
+
+        //the deleted rows are empty
+        wxGISFeature Feature = pStore->GetFeature(m_nRow);
+        if(Feature.IsOk())
+            aFeatures.push_back(Feature);
+    }
+    return aFeatures.size();
+}
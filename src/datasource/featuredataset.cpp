@@ -26,11 +26,14 @@
 #ifdef wxGIS_USE_CURL
 
 #include "wxgis/net/curl.h"
+#include "wxgis/core/config.h"
 
 #endif // wxGIS_USE_CURL
 
 #include <wx/base64.h> 
 
+#include <set>
+
 //---------------------------------------
 // wxGISFeatureDataset
 //---------------------------------------
@@ -435,6 +438,18 @@ wxGISSpatialTreeCursor wxGISFeatureDataset::SearchGeometry(const OGREnvelope &En
 		return wxNullSpatialTreeCursor;
 }
 
+wxGISGeometry wxGISFeatureDataset::CopyGeometry(long nFID)
+{
+    //the feature is read from the layer, so it is not shared with other threads
+    wxGISFeature Feature = GetFeatureByID(nFID);
+    if(!Feature.IsOk())
+        return wxGISGeometry();
+    wxGISGeometry Geom = Feature.GetGeometry();
+    if(!Geom.IsOk())
+        return wxGISGeometry();
+    return wxGISGeometry(Geom.Copy());
+}
+
 OGRErr wxGISFeatureDataset::DeleteFeature(long nFID)
 {
     OGRErr ret = wxGISTable::DeleteFeature(nFID);
@@ -525,16 +540,26 @@ IMPLEMENT_CLASS(wxGISFeatureDatasetCached, wxGISFeatureDataset)
 
 wxGISFeatureDatasetCached::wxGISFeatureDatasetCached(const CPLString &sPath, int nSubType, OGRLayer* poLayer, OGRCompatibleDataSource* poDS) : wxGISFeatureDataset(sPath, nSubType, poLayer, poDS)
 {
+    m_pColumnStore = NULL;
+
+    m_bUseColumnStore = true;
+    wxGISAppConfig oConfig = GetConfig();
+    if(oConfig.IsOk())
+    {
+        m_bUseColumnStore = oConfig.ReadBool(enumGISHKCU, wxString(wxT("wxGISCommon/datasource/columnar_cache")), m_bUseColumnStore);
+    }
 }
 
 wxGISFeatureDatasetCached::~wxGISFeatureDatasetCached(void)
 {
+    wxDELETE(m_pColumnStore);
 }
 
 void wxGISFeatureDatasetCached::Close(void)
 {
     wxDELETE(m_pSpatialTree);
     m_omFeatures.clear();
+    wxDELETE(m_pColumnStore);
 	wxGISTable::Close();
 }
 
@@ -581,9 +606,15 @@ void wxGISFeatureDatasetCached::Cache(ITrackCancel* const pTrackCancel)
         return;
 
     m_omFeatures.clear();
+    wxDELETE(m_pColumnStore);
 
     if(!m_poLayer)
         return;
+    if(m_bUseColumnStore && wxGISFeatureColumnStore::IsSupported(m_poLayer->GetLayerDefn()))
+    {
+        m_pColumnStore = new wxGISFeatureColumnStore(m_poLayer->GetLayerDefn(), m_Encoding, m_bRecodeToSystem);
+        m_pColumnStore->SetSpatialReference(m_poLayer->GetSpatialRef());
+    }
     m_poLayer->ResetReading();
 
 	IProgressor* pProgress(NULL);
@@ -637,15 +668,23 @@ void wxGISFeatureDatasetCached::Cache(ITrackCancel* const pTrackCancel)
             nFID = poFeature->GetFID();
 		}
 
-        //store features in array for speed
-        m_omFeatures[nFID] = wxGISFeature(poFeature, m_Encoding, m_bRecodeToSystem);
-
         //fill extent
         OGRGeometry* pGeom = poFeature->GetGeometryRef();
         OGREnvelope CurrEnv;
         if(pGeom)
             pGeom->getEnvelope(&CurrEnv);
 
+        //store features in array for speed
+        if(m_pColumnStore)
+        {
+            m_pColumnStore->Set(poFeature);
+            OGRFeature::DestroyFeature(poFeature);
+        }
+        else
+        {
+            m_omFeatures[nFID] = wxGISFeature(poFeature, m_Encoding, m_bRecodeToSystem);
+        }
+
         if(CurrEnv.IsInit())
         {
             if(m_stExtent.IsInit())
@@ -666,7 +705,7 @@ void wxGISFeatureDatasetCached::Cache(ITrackCancel* const pTrackCancel)
 		}		
     }
 
-	m_nFeatureCount = m_omFeatures.size();
+	m_nFeatureCount = m_pColumnStore ? m_pColumnStore->GetRowCount() : m_omFeatures.size();
 
     setlocale(LC_NUMERIC, oldlocale);
 
@@ -707,6 +746,11 @@ void wxGISFeatureDatasetCached::Reset(void)
 
 wxGISFeature wxGISFeatureDatasetCached::Next(void)
 {
+    if(m_pColumnStore)
+    {
+        return m_pColumnStore->GetFeatureByID(m_nCurrentFID++);
+    }
+
     if(m_omFeatures.empty())
     {
         return wxGISFeature();
@@ -735,7 +779,7 @@ size_t wxGISFeatureDatasetCached::GetFeatureCount(bool bForce, ITrackCancel* con
 		return m_nFeatureCount;
     if(	m_poLayer )
     {
-        if (m_omFeatures.empty())
+        if (m_omFeatures.empty() && (m_pColumnStore == NULL || m_pColumnStore->GetRowCount() == 0))
         {
             Cache(pTrackCancel);
 			return m_nFeatureCount;
@@ -769,8 +813,11 @@ OGRErr wxGISFeatureDatasetCached::DeleteFeature(long nFID)
         return eErr;
 
 	m_nFeatureCount--;
+    UpdateAttributeIndexes(nFID, NULL);
 
-    if(m_omFeatures[nFID].IsOk())
+    if(m_pColumnStore)
+        m_pColumnStore->Delete(nFID);
+    else if(m_omFeatures[nFID].IsOk())
 		m_omFeatures[nFID] = wxGISFeature();
 
     return eErr;
@@ -784,7 +831,10 @@ OGRErr wxGISFeatureDatasetCached::StoreFeature(wxGISFeature &Feature)
         return eErr;
     }
 
-    m_omFeatures[Feature.GetFID()] = Feature;
+    if(m_pColumnStore)
+        m_pColumnStore->Set(Feature);
+    else
+        m_omFeatures[Feature.GetFID()] = Feature;
     return eErr;
 }
 
@@ -796,14 +846,24 @@ OGRErr wxGISFeatureDatasetCached::SetFeature(const wxGISFeature &Feature)
         return eErr;
     }
     //TODO: if FID in feature is changed
-    m_omFeatures[Feature.GetFID()] = Feature;
+    if(m_pColumnStore)
+        m_pColumnStore->Set(Feature);
+    else
+        m_omFeatures[Feature.GetFID()] = Feature;
     return eErr;
 }
 
+wxGISGeometry wxGISFeatureDatasetCached::CopyGeometry(long nFID)
+{
+    //the cached feature may be referenced by other threads, so it is referenced and copied under the cache lock only
+    wxCriticalSectionLocker locker(m_CritSectCache);
+    return wxGISFeatureDataset::CopyGeometry(nFID);
+}
+
 wxGISFeature wxGISFeatureDatasetCached::GetFeatureByID(long nFID)
 {
 	wxCriticalSectionLocker locker(m_CritSectCache);
-    wxGISFeature ret = m_omFeatures[nFID];
+    wxGISFeature ret = m_pColumnStore ? m_pColumnStore->GetFeatureByID(nFID) : m_omFeatures[nFID];
     if(ret.IsOk())
 		return ret;
 	else
@@ -814,13 +874,32 @@ wxGISFeature wxGISFeatureDatasetCached::GetFeatureByID(long nFID)
 		    if(pFeature)
 		    {
                 ret = wxGISFeature(pFeature, m_Encoding, m_bRecodeToSystem);
-			    m_omFeatures[nFID] = ret;
+                if(m_pColumnStore)
+                    m_pColumnStore->Set(pFeature);
+                else
+			        m_omFeatures[nFID] = ret;
 		    }
 	    }
     }
 	return ret;
 }
 
+bool wxGISFeatureDatasetCached::FillAttributeIndex(wxGISAttributeIndex* const pIndex, ITrackCancel* const pTrackCancel)
+{
+    if(m_pColumnStore)
+        return pIndex->Fill(m_pColumnStore, pTrackCancel);
+
+    if(!m_bIsCached)
+        return wxGISFeatureDataset::FillAttributeIndex(pIndex, pTrackCancel);
+
+    for(std::map<long, wxGISFeature>::iterator it = m_omFeatures.begin(); it != m_omFeatures.end(); ++it)
+    {
+        if(it->second.IsOk())
+            pIndex->Add(it->first, it->second);
+    }
+    return true;
+}
+
 OGREnvelope wxGISFeatureDatasetCached::GetEnvelope(void)
 {
     wxCriticalSectionLocker locker(m_CritSect);
@@ -840,6 +919,7 @@ void wxGISFeatureDatasetCached::SetEncoding(const wxFontEncoding &oEncoding)
     if (IsCached())
     {
         m_omFeatures.clear();
+        wxDELETE(m_pColumnStore);
         m_bIsCached = false;
     }
 
@@ -939,6 +1019,21 @@ wxGISNGWFeatureDataset::wxGISNGWFeatureDataset(long nResourceId, const wxJSONVal
     m_bOLCFastFeatureCount = false;
 
     m_Encoding = wxFONTENCODING_UTF8;
+
+    m_bBatchEdit = false;
+    m_nFailedEdits = 0;
+    m_nEditBatchSize = NGW_EDIT_BATCH_SIZE;
+    m_nMaxConnections = CURL_MULTI_MAX_CONNECTIONS;
+    wxGISAppConfig oConfig = GetConfig();
+    if (oConfig.IsOk())
+    {
+        m_nEditBatchSize = oConfig.ReadInt(enumGISHKCU, wxString(wxT("wxGISCommon/ngw/edit_batch_size")), m_nEditBatchSize);
+        m_nMaxConnections = oConfig.ReadInt(enumGISHKCU, wxString(wxT("wxGISCommon/curl/max_connections")), m_nMaxConnections);
+    }
+    if (m_nEditBatchSize < 1)
+        m_nEditBatchSize = 1;
+    if (m_nMaxConnections < 1)
+        m_nMaxConnections = 1;
 }
 
 wxGISNGWFeatureDataset::~wxGISNGWFeatureDataset(void)
@@ -962,94 +1057,113 @@ void wxGISNGWFeatureDataset::Cache(ITrackCancel* const pTrackCancel)
     wxString sPayload = wxT("Basic ") + wxBase64Encode(m_sAuth.c_str(), m_sAuth.Len());
 
     curl.AppendHeader(wxT("Authorization:") + sPayload);
-    PERFORMRESULT res = curl.Get(m_sURL + wxString::Format(wxT("/api/resource/%ld/feature/"), m_nResourceId));
-    
-    bool bResult = res.IsValid && res.nHTTPCode < 400;
 
-    if (!bResult)
+    int nPageSize = NGW_FEATURE_PAGE_SIZE;
+    wxGISAppConfig oConfig = GetConfig();
+    if (oConfig.IsOk())
     {
-        return;
+        nPageSize = oConfig.ReadInt(enumGISHKCU, wxString(wxT("wxGISCommon/ngw/feature_page_size")), nPageSize);
     }
-        
-    wxJSONReader reader;
-    wxJSONValue features;
-    int numErrors = reader.Parse(res.sBody, &features);
-    if (numErrors != 0)
+
+    // get features count for progress, the old servers have no feature_count
+    long nTotalCount = wxNOT_FOUND;
+    PERFORMRESULT res = curl.Get(m_sURL + wxString::Format(wxT("/api/resource/%ld/feature_count"), m_nResourceId));
+    if (res.IsValid && res.nHTTPCode < 400)
     {
-        return;
+        wxJSONReader reader;
+        wxJSONValue count;
+        if (reader.Parse(res.sBody, &count) == 0 && count.HasMember(wxT("total_count")))
+        {
+            nTotalCount = count[wxT("total_count")].AsLong();
+        }
+    }
+
+    IProgressor* pProgressor(NULL);
+    if (pTrackCancel)
+    {
+        pProgressor = pTrackCancel->GetProgressor();
+    }
+    if (pProgressor && nTotalCount > 0)
+    {
+        pProgressor->SetRange(nTotalCount);
     }
 
-    for (int i = 0; i < features.Size(); ++i)
+    // load features by pages, so only one page text and JSON is in memory
+    long nOffset = 0;
+    // the server ignoring limit and offset returns the same page again
+    std::set<long> snLoadedFIDs;
+    long nPrevFirstFID = wxNOT_FOUND;
+    while (true)
     {
-        wxJSONValue feature = features[i];
-        long nId = feature["id"].AsLong();
-        wxString sGeom = feature["geom"].AsString();
+        wxString sFeaturesURL = m_sURL + wxString::Format(wxT("/api/resource/%ld/feature/"), m_nResourceId);
+        if (nPageSize > 0)
+        {
+            sFeaturesURL += wxString::Format(wxT("?limit=%d&offset=%ld"), nPageSize, nOffset);
+        }
+        res = curl.Get(sFeaturesURL);
 
-        OGRGeometry *pGeom = NULL;
-        CPLString sWKT = CPLString(sGeom.ToUTF8());
-        char *pszWKT = (char *)sWKT.c_str();
-        OGRGeometryFactory::createFromWkt(&pszWKT, GetSpatialReference(), (OGRGeometry**)(&pGeom));
+        bool bResult = res.IsValid && res.nHTTPCode < 400;
 
-        OGRFeature *poFeature = OGRFeature::CreateFeature(m_poLayer->GetLayerDefn());
-        poFeature->SetGeometryDirectly(pGeom);
-        poFeature->SetFID(nId);
+        if (!bResult)
+        {
+            return;
+        }
 
-        wxJSONValue fields = feature["fields"];
-        OGRFeatureDefn* pDefn = GetDefinition();
-               
-        for (int j = 0; j < pDefn->GetFieldCount(); ++j)
+        int nPageCount = 0, nNewCount = 0;
+        long nFirstFID = wxNOT_FOUND;
         {
-            OGRFieldDefn *pFieldDefn = pDefn->GetFieldDefn(j);
-            wxString sKey = wxString::FromUTF8(pFieldDefn->GetNameRef());
-            if (fields.HasMember(sKey))
+            wxJSONReader reader;
+            wxJSONValue features;
+            int numErrors = reader.Parse(res.sBody, &features);
+            if (numErrors != 0)
+            {
+                return;
+            }
+            res.sBody.Clear();
+
+            nPageCount = features.Size();
+            for (int i = 0; i < nPageCount; ++i)
             {
-                switch (pFieldDefn->GetType())
+                long nId = features[i]["id"].AsLong();
+                if (i == 0)
                 {
-                case OFTInteger:
-                    poFeature->SetField(pFieldDefn->GetNameRef(), fields[sKey].AsInt());
-                    break;
-                case OFTReal:
-                    poFeature->SetField(pFieldDefn->GetNameRef(), fields[sKey].AsDouble());
-                    break;
-                case OFTString:
-                    poFeature->SetField(pFieldDefn->GetNameRef(), fields[sKey].AsString().ToUTF8());
-                    break;
-                case OFTDate:
-                    {
-                        wxJSONValue date = fields[sKey];
-                        int nYear = date["year"].AsInt();
-                        int nMonth = date["month"].AsInt();
-                        int nDay = date["day"].AsInt();
-                        poFeature->SetField(pFieldDefn->GetNameRef(), nYear, nMonth, nDay);
-                    }
-                    break;
-                case OFTTime:
-                    {
-                        wxJSONValue date = fields[sKey];
-                        int nHour = date["hour"].AsInt();
-                        int nMinute = date["minute"].AsInt();
-                        int nSecond = date["second"].AsInt();
-                        poFeature->SetField(pFieldDefn->GetNameRef(), 1970, 1, 1, nHour, nMinute, nSecond);
-                    }
-                    break;
-                case OFTDateTime:
-                    {
-                        wxJSONValue date = fields[sKey];
-                        int nYear = date["year"].AsInt();
-                        int nMonth = date["month"].AsInt();
-                        int nDay = date["day"].AsInt();
-                        int nHour = date["hour"].AsInt();
-                        int nMinute = date["minute"].AsInt();
-                        int nSecond = date["second"].AsInt();
-                        poFeature->SetField(pFieldDefn->GetNameRef(), nYear, nMonth, nDay, nHour, nMinute, nSecond);
-                    }
-                    break;
-                default:
-                    break;
+                    nFirstFID = nId;
                 }
+                if (!snLoadedFIDs.insert(nId).second)
+                {
+                    continue;
+                }
+                nNewCount++;
+
+                OGRFeature *poFeature = JSONToFeature(features[i]);
+                m_poLayer->CreateFeature(poFeature);
+                OGRFeature::DestroyFeature(poFeature);
             }
         }
-        m_poLayer->CreateFeature(poFeature);
+
+        nOffset += nPageCount;
+        if (pProgressor && nTotalCount > 0)
+        {
+            pProgressor->SetValue(nOffset);
+        }
+
+        if (pTrackCancel && !pTrackCancel->Continue())
+        {
+            return;
+        }
+
+        // the last page, or the server without paging returned all features
+        if (nPageSize <= 0 || nPageCount != nPageSize || (nTotalCount >= 0 && nOffset >= nTotalCount))
+        {
+            break;
+        }
+
+        // the page repeats or has nothing new, so the offset is ignored and the next request is the same
+        if (nNewCount == 0 || (nPageCount > 0 && nFirstFID == nPrevFirstFID))
+        {
+            break;
+        }
+        nPrevFirstFID = nFirstFID;
     }
 
     m_bOLCFastFeatureCount = true;
@@ -1086,6 +1200,78 @@ void wxGISNGWFeatureDataset::Cache(ITrackCancel* const pTrackCancel)
     m_pSpatialTree->Load(m_SpatialReference, pTrackCancel);
 }
 
+OGRFeature* wxGISNGWFeatureDataset::JSONToFeature(const wxJSONValue &JSONFeature)
+{
+    long nId = JSONFeature["id"].AsLong();
+    wxString sGeom = JSONFeature["geom"].AsString();
+
+    OGRGeometry *pGeom = NULL;
+    CPLString sWKT = CPLString(sGeom.ToUTF8());
+    char *pszWKT = (char *)sWKT.c_str();
+    OGRGeometryFactory::createFromWkt(&pszWKT, GetSpatialReference(), (OGRGeometry**)(&pGeom));
+
+    OGRFeature *poFeature = OGRFeature::CreateFeature(m_poLayer->GetLayerDefn());
+    poFeature->SetGeometryDirectly(pGeom);
+    poFeature->SetFID(nId);
+
+    wxJSONValue fields = JSONFeature["fields"];
+    OGRFeatureDefn* pDefn = GetDefinition();
+           
+    for (int j = 0; j < pDefn->GetFieldCount(); ++j)
+    {
+        OGRFieldDefn *pFieldDefn = pDefn->GetFieldDefn(j);
+        wxString sKey = wxString::FromUTF8(pFieldDefn->GetNameRef());
+        if (fields.HasMember(sKey))
+        {
+            switch (pFieldDefn->GetType())
+            {
+            case OFTInteger:
+                poFeature->SetField(pFieldDefn->GetNameRef(), fields[sKey].AsInt());
+                break;
+            case OFTReal:
+                poFeature->SetField(pFieldDefn->GetNameRef(), fields[sKey].AsDouble());
+                break;
+            case OFTString:
+                poFeature->SetField(pFieldDefn->GetNameRef(), fields[sKey].AsString().ToUTF8());
+                break;
+            case OFTDate:
+                {
+                    wxJSONValue date = fields[sKey];
+                    int nYear = date["year"].AsInt();
+                    int nMonth = date["month"].AsInt();
+                    int nDay = date["day"].AsInt();
+                    poFeature->SetField(pFieldDefn->GetNameRef(), nYear, nMonth, nDay);
+                }
+                break;
+            case OFTTime:
+                {
+                    wxJSONValue date = fields[sKey];
+                    int nHour = date["hour"].AsInt();
+                    int nMinute = date["minute"].AsInt();
+                    int nSecond = date["second"].AsInt();
+                    poFeature->SetField(pFieldDefn->GetNameRef(), 1970, 1, 1, nHour, nMinute, nSecond);
+                }
+                break;
+            case OFTDateTime:
+                {
+                    wxJSONValue date = fields[sKey];
+                    int nYear = date["year"].AsInt();
+                    int nMonth = date["month"].AsInt();
+                    int nDay = date["day"].AsInt();
+                    int nHour = date["hour"].AsInt();
+                    int nMinute = date["minute"].AsInt();
+                    int nSecond = date["second"].AsInt();
+                    poFeature->SetField(pFieldDefn->GetNameRef(), nYear, nMonth, nDay, nHour, nMinute, nSecond);
+                }
+                break;
+            default:
+                break;
+            }
+        }
+    }
+    return poFeature;
+}
+
 OGRErr wxGISNGWFeatureDataset::DeleteAll()
 {
     wxGISCurl curl;
@@ -1117,6 +1303,11 @@ OGRErr wxGISNGWFeatureDataset::DeleteAll()
 
 OGRErr wxGISNGWFeatureDataset::DeleteFeature(long nFID)
 {
+    if (m_bBatchEdit)
+    {
+        return QueueEdit(enumGISNGWEditDelete, wxGISFeature(), nFID);
+    }
+
     wxGISCurl curl;
     if (!curl.IsOk())
     {
@@ -1140,6 +1331,11 @@ OGRErr wxGISNGWFeatureDataset::DeleteFeature(long nFID)
 
 OGRErr wxGISNGWFeatureDataset::StoreFeature(wxGISFeature &Feature)
 {
+    if (m_bBatchEdit)
+    {
+        return QueueEdit(enumGISNGWEditCreate, Feature, wxNOT_FOUND);
+    }
+
     wxGISCurl curl;
     if (!curl.IsOk())
     {
@@ -1173,6 +1369,11 @@ OGRErr wxGISNGWFeatureDataset::StoreFeature(wxGISFeature &Feature)
 
 OGRErr wxGISNGWFeatureDataset::SetFeature(const wxGISFeature &Feature)
 {
+    if (m_bBatchEdit)
+    {
+        return QueueEdit(enumGISNGWEditUpdate, Feature, Feature.GetFID());
+    }
+
     wxGISCurl curl;
     if (!curl.IsOk())
     {
@@ -1195,6 +1396,15 @@ OGRErr wxGISNGWFeatureDataset::SetFeature(const wxGISFeature &Feature)
 }
 
 wxString wxGISNGWFeatureDataset::FeatureToPayload(const wxGISFeature &Feature)
+{
+    wxString sPayload;
+    wxJSONWriter writer(wxJSONWRITER_NO_INDENTATION | wxJSONWRITER_NO_LINEFEEDS);
+    writer.Write(FeatureToJSON(Feature), sPayload);
+
+    return sPayload;
+}
+
+wxJSONValue wxGISNGWFeatureDataset::FeatureToJSON(const wxGISFeature &Feature)
 {
     wxString sGeom = Feature.GetGeometry().ToWKT();
     wxJSONValue val;
@@ -1258,11 +1468,225 @@ wxString wxGISNGWFeatureDataset::FeatureToPayload(const wxGISFeature &Feature)
 
     val["fields"] = fields;
 
-    wxString sPayload;
+    return val;
+}
+
+OGRErr wxGISNGWFeatureDataset::StartTransaction(void)
+{
+    //the local copy is in memory layer, so the transaction is the edits queue
+    m_astEdits.clear();
+    m_nFailedEdits = 0;
+    m_bBatchEdit = true;
+    return OGRERR_NONE;
+}
+
+OGRErr wxGISNGWFeatureDataset::CommitTransaction(void)
+{
+    if (!m_bBatchEdit)
+    {
+        return OGRERR_FAILURE;
+    }
+
+    //the failed edits stay queued, the transaction is open to commit them again or roll back
+    OGRErr eErr = FlushEdits();
+    if (eErr == OGRERR_NONE)
+    {
+        m_bBatchEdit = false;
+    }
+    return eErr;
+}
+
+OGRErr wxGISNGWFeatureDataset::RollbackTransaction(void)
+{
+    if (!m_bBatchEdit)
+    {
+        return OGRERR_FAILURE;
+    }
+
+    //the flushed edits are already on server
+    m_astEdits.clear();
+    m_nFailedEdits = 0;
+    m_bBatchEdit = false;
+    return OGRERR_NONE;
+}
+
+OGRErr wxGISNGWFeatureDataset::QueueEdit(wxGISEnumNGWEditType eType, const wxGISFeature &Feature, long nFID)
+{
+    //the deletes and the creates/updates are sent by different requests, so keep the order between them
+    if (!m_astEdits.empty() && (m_astEdits[0].eType == enumGISNGWEditDelete) != (eType == enumGISNGWEditDelete))
+    {
+        if (FlushEdits() != OGRERR_NONE)
+        {
+            //the edits of other type are not sent, this one can not be queued after them
+            return OGRERR_FAILURE;
+        }
+    }
+
+    //the concurrent requests have no order, so the repeated update replaces the queued one
+    if (eType == enumGISNGWEditUpdate)
+    {
+        for (size_t i = 0; i < m_astEdits.size(); ++i)
+        {
+            if (m_astEdits[i].eType == enumGISNGWEditUpdate && m_astEdits[i].nFID == nFID)
+            {
+                m_astEdits[i].Feature = Feature;
+                return OGRERR_NONE;
+            }
+        }
+    }
+
+    NGWEDIT stEdit;
+    stEdit.eType = eType;
+    stEdit.Feature = Feature;
+    stEdit.nFID = nFID;
+    m_astEdits.push_back(stEdit);
+
+    size_t nMaxEdits = (size_t)m_nEditBatchSize * m_nMaxConnections;
+    if (eType == enumGISNGWEditDelete)
+    {
+        nMaxEdits = m_nMaxConnections;
+    }
+
+    //the failed edits are sent again with the next full queue, not on each new edit.
+    //the flush error is the batch one and reported by FlushEdits and CommitTransaction, this edit is queued
+    if (m_astEdits.size() >= m_nFailedEdits + nMaxEdits)
+    {
+        FlushEdits();
+    }
+    return OGRERR_NONE;
+}
+
+void wxGISNGWFeatureDataset::ReportFailedEdits(size_t nFirst, size_t nLast, long nHTTPCode, const wxString &sResponse)
+{
+    wxString sErr;
+    if (m_astEdits[nFirst].eType == enumGISNGWEditDelete)
+    {
+        sErr = wxString::Format(_("The NextGIS Web resource %ld: failed to delete the feature %ld (HTTP code %ld). The edit is kept queued."), m_nResourceId, m_astEdits[nFirst].nFID, nHTTPCode);
+    }
+    else
+    {
+        sErr = wxString::Format(_("The NextGIS Web resource %ld: failed to store the batch of %lu features (HTTP code %ld). The edits are kept queued."), m_nResourceId, (unsigned long)(nLast - nFirst), nHTTPCode);
+    }
+    if (!sResponse.IsEmpty())
+    {
+        sErr += wxT("\n") + sResponse.Left(256);
+    }
+
+    wxLogError(sErr);
+    CPLError(CE_Failure, CPLE_AppDefined, "%s", (const char*)sErr.ToUTF8());
+}
+
+OGRErr wxGISNGWFeatureDataset::FlushEdits(void)
+{
+    if (m_astEdits.empty())
+    {
+        return OGRERR_NONE;
+    }
+
+    wxGISCurlMulti curl;
+    if (!curl.IsOk())
+    {
+        //keep the edits queued to send them later
+        m_nFailedEdits = m_astEdits.size();
+        CPLError(CE_Failure, CPLE_AppDefined, "%s", (const char*)wxString(_("cURL initialization failed")).ToUTF8());
+        return OGRERR_FAILURE;
+    }
+
+    wxString sPayload = wxT("Basic ") + wxBase64Encode(m_sAuth.c_str(), m_sAuth.Len());
+    curl.AppendHeader(wxT("Authorization:") + sPayload);
+
+    wxString sFeaturesURL = m_sURL + wxString::Format(wxT("/api/resource/%ld/feature/"), m_nResourceId);
     wxJSONWriter writer(wxJSONWRITER_NO_INDENTATION | wxJSONWRITER_NO_LINEFEEDS);
-    writer.Write(val, sPayload);
 
-    return sPayload;
+    //the first queued edit of each request, the NGW has no bulk delete of selected features
+    wxVector<size_t> anFirstEdits;
+    size_t nEdit = 0;
+    while (nEdit < m_astEdits.size())
+    {
+        anFirstEdits.push_back(nEdit);
+        if (m_astEdits[nEdit].eType == enumGISNGWEditDelete)
+        {
+            curl.Add(enumGISHTTPDelete, sFeaturesURL + wxString::Format(wxT("%ld"), m_astEdits[nEdit].nFID));
+            nEdit++;
+            continue;
+        }
+
+        //the features with id are updated, without id are created
+        wxJSONValue val;
+        for (int i = 0; i < m_nEditBatchSize && nEdit < m_astEdits.size(); ++i, ++nEdit)
+        {
+            wxJSONValue feature = FeatureToJSON(m_astEdits[nEdit].Feature);
+            if (m_astEdits[nEdit].eType == enumGISNGWEditUpdate)
+            {
+                feature["id"] = m_astEdits[nEdit].nFID;
+            }
+            val.Append(feature);
+        }
+
+        wxString sBatchPayload;
+        writer.Write(val, sBatchPayload);
+        curl.Add(enumGISHTTPPatch, sFeaturesURL, sBatchPayload);
+    }
+
+    curl.Perform();
+
+    //the edits of failed requests are kept for the retry, the server may be unavailable for a while
+    OGRErr eErr = OGRERR_NONE;
+    wxVector<NGWEDIT> astFailedEdits;
+    wxJSONReader reader;
+    for (size_t nRequest = 0; nRequest < curl.GetCount(); ++nRequest)
+    {
+        PERFORMRESULT res = curl.GetResult(nRequest);
+        size_t nFirst = anFirstEdits[nRequest];
+        size_t nLast = nRequest + 1 < anFirstEdits.size() ? anFirstEdits[nRequest + 1] : m_astEdits.size();
+
+        bool bAccepted = res.IsValid && res.nHTTPCode < 400;
+        wxJSONValue response;
+        if (bAccepted && m_astEdits[nFirst].eType != enumGISNGWEditDelete)
+        {
+            //the created features FIDs are taken from the response, so it should have an item per feature
+            int numErrors = reader.Parse(res.sBody, &response);
+            bAccepted = numErrors == 0 && response.IsArray() && response.Size() == int(nLast - nFirst);
+        }
+
+        if (!bAccepted)
+        {
+            ReportFailedEdits(nFirst, nLast, res.nHTTPCode, res.sBody);
+            for (size_t i = nFirst; i < nLast; ++i)
+            {
+                astFailedEdits.push_back(m_astEdits[i]);
+            }
+            eErr = OGRERR_FAILURE;
+            continue;
+        }
+
+        if (m_astEdits[nFirst].eType == enumGISNGWEditDelete)
+        {
+            wxGISFeatureDataset::DeleteFeature(m_astEdits[nFirst].nFID);
+            continue;
+        }
+
+        for (size_t i = nFirst; i < nLast; ++i)
+        {
+            NGWEDIT &stEdit = m_astEdits[i];
+            if (stEdit.eType == enumGISNGWEditCreate)
+            {
+                stEdit.Feature.SetFID(response[(unsigned)(i - nFirst)]["id"].AsLong());
+                if (wxGISFeatureDataset::StoreFeature(stEdit.Feature) != OGRERR_NONE)
+                {
+                    eErr = OGRERR_FAILURE;
+                }
+            }
+            else if (wxGISFeatureDataset::SetFeature(stEdit.Feature) != OGRERR_NONE)
+            {
+                eErr = OGRERR_FAILURE;
+            }
+        }
+    }
+
+    m_astEdits = astFailedEdits;
+    m_nFailedEdits = m_astEdits.size();
+    return eErr;
 }
 
 #endif // wxGIS_USE_CURL
@@ -305,6 +305,13 @@ long wxGISFeature::GetFID(void) const
     return ((wxGISFeatureRefData *)m_refData)->m_poFeature->GetFID();
 }
 
+wxGISFeature wxGISFeature::Clone(void) const
+{
+    wxCHECK_MSG(m_refData && ((wxGISFeatureRefData *)m_refData)->m_poFeature, wxGISFeature(), wxT("The OGRFeature pointer is null"));
+    wxGISFeatureRefData* pData = (wxGISFeatureRefData *)m_refData;
+    return wxGISFeature(pData->m_poFeature->Clone(), pData->m_oEncoding, pData->m_bRecodeToSystem);
+}
+
 wxDateTime wxGISFeature::GetFieldAsDateTime(const wxString &sFieldName) const
 {
     int nIndex = GetFieldIndex(sFieldName);
@@ -742,6 +749,12 @@ OGRField* wxGISFeature::GetRawField(int nField) const
     return ((wxGISFeatureRefData *)m_refData)->m_poFeature->GetRawFieldRef(nField);
 }
 
+bool wxGISFeature::IsFieldSet(int nField) const
+{
+    wxCHECK_MSG(m_refData && ((wxGISFeatureRefData *)m_refData)->m_poFeature, false, wxT("The OGRFeature pointer is null"));
+    return ((wxGISFeatureRefData *)m_refData)->m_poFeature->IsFieldSet(nField) == TRUE;
+}
+
 void wxGISFeature::SetField(int nIndex, OGRField* psField)
 {
     wxCHECK_RET(m_refData && ((wxGISFeatureRefData *)m_refData)->m_poFeature, wxT("The OGRFeature pointer is null"));
@@ -911,7 +924,7 @@ wxGISGeometry wxGISGeometry::Clone() const
 bool wxGISGeometry::Project(const wxGISSpatialReference &SpaRef)
 {
     wxCHECK_MSG(m_refData && ((wxGISGeometryRefData *)m_refData)->m_poGeom, false, wxT("OGRGeometry pointer is null"));
-    return ((wxGISGeometryRefData *)m_refData)->m_poGeom->transformTo(SpaRef) == OGRERR_NONE;
+    return wxGISCoordinateTransformationCache::Transform(((wxGISGeometryRefData *)m_refData)->m_poGeom, SpaRef);
 }
 
 bool wxGISGeometry::Project(OGRCoordinateTransformation* const poCT)
@@ -919,3 +932,316 @@ bool wxGISGeometry::Project(OGRCoordinateTransformation* const poCT)
     wxCHECK_MSG(m_refData && ((wxGISGeometryRefData *)m_refData)->m_poGeom, false, wxT("OGRGeometry pointer is null"));
     return ((wxGISGeometryRefData *)m_refData)->m_poGeom->transform(poCT) == OGRERR_NONE;
 }
+
+//----------------------------------------------------------------------------
+// wxGISCoordinateTransformationCache
+//----------------------------------------------------------------------------
+
+wxCriticalSection wxGISCoordinateTransformationCache::m_CritSect;
+wxVector<wxGISCoordinateTransformationCache::TRANSFORMATION> wxGISCoordinateTransformationCache::m_astTransformations;
+
+OGRCoordinateTransformation* wxGISCoordinateTransformationCache::Acquire(OGRSpatialReference* poSrcSRS, OGRSpatialReference* poDstSRS)
+{
+    if (NULL == poSrcSRS || NULL == poDstSRS)
+        return NULL;
+
+    bool bKnownPair = false;
+    {
+        wxCriticalSectionLocker locker(m_CritSect);
+        for (size_t i = 0; i < m_astTransformations.size(); ++i)
+        {
+            TRANSFORMATION &stTransformation = m_astTransformations[i];
+            if (stTransformation.poSrcSRS != poSrcSRS || stTransformation.poDstSRS != poDstSRS)
+                continue;
+            //the transformation between this pair is impossible
+            if (NULL == stTransformation.poCT)
+                return NULL;
+            bKnownPair = true;
+            if (!stTransformation.bInUse)
+            {
+                stTransformation.bInUse = true;
+                return stTransformation.poCT;
+            }
+        }
+    }
+
+    //the PROJ setup is long, so create outside the lock
+    OGRCoordinateTransformation* poCT = OGRCreateCoordinateTransformation(poSrcSRS, poDstSRS);
+    if (NULL == poCT && bKnownPair)
+        return NULL;
+
+    wxCriticalSectionLocker locker(m_CritSect);
+    Purge(COORD_TRANSFORM_CACHE_SIZE);
+
+    TRANSFORMATION stTransformation;
+    wsSET(stTransformation.poSrcSRS, poSrcSRS);
+    wsSET(stTransformation.poDstSRS, poDstSRS);
+    stTransformation.poCT = poCT;
+    stTransformation.bInUse = poCT != NULL;
+    m_astTransformations.push_back(stTransformation);
+
+    return poCT;
+}
+
+void wxGISCoordinateTransformationCache::Release(OGRCoordinateTransformation* poCT)
+{
+    if (NULL == poCT)
+        return;
+
+    wxCriticalSectionLocker locker(m_CritSect);
+    for (size_t i = 0; i < m_astTransformations.size(); ++i)
+    {
+        if (m_astTransformations[i].poCT == poCT)
+        {
+            m_astTransformations[i].bInUse = false;
+            return;
+        }
+    }
+}
+
+void wxGISCoordinateTransformationCache::Purge(size_t nMaxCount)
+{
+    if (m_astTransformations.size() < nMaxCount)
+        return;
+
+    //the used transformations are kept
+    for (size_t i = m_astTransformations.size(); i > 0; --i)
+    {
+        TRANSFORMATION &stTransformation = m_astTransformations[i - 1];
+        if (stTransformation.bInUse)
+            continue;
+
+        if (stTransformation.poCT)
+            OCTDestroyCoordinateTransformation(stTransformation.poCT);
+        wsDELETE(stTransformation.poSrcSRS);
+        wsDELETE(stTransformation.poDstSRS);
+        m_astTransformations.erase(m_astTransformations.begin() + (i - 1));
+    }
+}
+
+void wxGISCoordinateTransformationCache::Clear(void)
+{
+    wxCriticalSectionLocker locker(m_CritSect);
+    Purge(0);
+}
+
+bool wxGISCoordinateTransformationCache::Transform(OGRGeometry* poGeom, OGRSpatialReference* poDstSRS)
+{
+    if (NULL == poGeom || NULL == poDstSRS)
+        return false;
+
+    OGRCoordinateTransformation* poCT = Acquire(poGeom->getSpatialReference(), poDstSRS);
+    if (NULL == poCT)
+        return false;
+
+    bool bResult = poGeom->transform(poCT) == OGRERR_NONE;
+    Release(poCT);
+    return bResult;
+}
+
+size_t wxGISCoordinateTransformationCache::Transform(wxVector<wxGISGeometry> &aGeometries, OGRSpatialReference* poDstSRS)
+{
+    size_t nTransformed = 0;
+    wxVector<bool> abDone(aGeometries.size(), false);
+    wxVector<size_t> anGeometries, anFirstPoints;
+    wxVector<double> adfX, adfY, adfZ;
+
+    for (size_t i = 0; i < aGeometries.size(); ++i)
+    {
+        if (abDone[i])
+            continue;
+
+        OGRGeometry* poGeom = aGeometries[i].IsOk() ? (OGRGeometry*)aGeometries[i] : NULL;
+        OGRSpatialReference* poSrcSRS = poGeom == NULL ? NULL : poGeom->getSpatialReference();
+        OGRCoordinateTransformation* poCT = Acquire(poSrcSRS, poDstSRS);
+
+        //collect the points of all geometries with the same spatial reference
+        anGeometries.clear();
+        anFirstPoints.clear();
+        adfX.clear();
+        adfY.clear();
+        adfZ.clear();
+        for (size_t j = i; j < aGeometries.size(); ++j)
+        {
+            if (abDone[j])
+                continue;
+            OGRGeometry* poCurrentGeom = aGeometries[j].IsOk() ? (OGRGeometry*)aGeometries[j] : NULL;
+            OGRSpatialReference* poCurrentSRS = poCurrentGeom == NULL ? NULL : poCurrentGeom->getSpatialReference();
+            if (poCurrentSRS != poSrcSRS)
+                continue;
+
+            abDone[j] = true;
+            if (NULL == poCT)
+            {
+                aGeometries[j] = wxGISGeometry();
+                continue;
+            }
+
+            size_t nFirstPoint = adfX.size();
+            if (GetPoints(poCurrentGeom, adfX, adfY, adfZ))
+            {
+                anGeometries.push_back(j);
+                anFirstPoints.push_back(nFirstPoint);
+                continue;
+            }
+
+            //the curves and other types are transformed by OGR
+            adfX.erase(adfX.begin() + nFirstPoint, adfX.end());
+            adfY.erase(adfY.begin() + nFirstPoint, adfY.end());
+            adfZ.erase(adfZ.begin() + nFirstPoint, adfZ.end());
+            if (poCurrentGeom->transform(poCT) == OGRERR_NONE)
+                nTransformed++;
+            else
+                aGeometries[j] = wxGISGeometry();
+        }
+
+        if (NULL == poCT)
+            continue;
+
+        if (!adfX.empty())
+        {
+            wxVector<int> abSuccess(adfX.size(), TRUE);
+            poCT->TransformEx((int)adfX.size(), &adfX[0], &adfY[0], &adfZ[0], &abSuccess[0]);
+
+            for (size_t j = 0; j < anGeometries.size(); ++j)
+            {
+                size_t nPoint = anFirstPoints[j];
+                size_t nLastPoint = j + 1 < anFirstPoints.size() ? anFirstPoints[j + 1] : adfX.size();
+                bool bSuccess = true;
+                for (size_t k = nPoint; k < nLastPoint; ++k)
+                {
+                    if (!abSuccess[k])
+                    {
+                        bSuccess = false;
+                        break;
+                    }
+                }
+
+                if (!bSuccess)
+                {
+                    aGeometries[anGeometries[j]] = wxGISGeometry();
+                    continue;
+                }
+
+                OGRGeometry* poCurrentGeom = aGeometries[anGeometries[j]];
+                SetPoints(poCurrentGeom, adfX, adfY, adfZ, nPoint);
+                poCurrentGeom->assignSpatialReference(poCT->GetTargetCS());
+                nTransformed++;
+            }
+        }
+
+        Release(poCT);
+    }
+
+    return nTransformed;
+}
+
+bool wxGISCoordinateTransformationCache::GetPoints(OGRGeometry* poGeom, wxVector<double> &adfX, wxVector<double> &adfY, wxVector<double> &adfZ)
+{
+    switch (wkbFlatten(poGeom->getGeometryType()))
+    {
+    case wkbPoint:
+        {
+            OGRPoint* poPoint = (OGRPoint*)poGeom;
+            if (poPoint->IsEmpty())
+                return true;
+            adfX.push_back(poPoint->getX());
+            adfY.push_back(poPoint->getY());
+            adfZ.push_back(poPoint->getZ());
+        }
+        return true;
+    case wkbLineString:
+    case wkbLinearRing:
+        {
+            OGRLineString* poLine = (OGRLineString*)poGeom;
+            for (int i = 0; i < poLine->getNumPoints(); ++i)
+            {
+                adfX.push_back(poLine->getX(i));
+                adfY.push_back(poLine->getY(i));
+                adfZ.push_back(poLine->getZ(i));
+            }
+        }
+        return true;
+    case wkbPolygon:
+        {
+            OGRPolygon* poPolygon = (OGRPolygon*)poGeom;
+            if (poPolygon->getExteriorRing() && !GetPoints(poPolygon->getExteriorRing(), adfX, adfY, adfZ))
+                return false;
+            for (int i = 0; i < poPolygon->getNumInteriorRings(); ++i)
+            {
+                if (!GetPoints(poPolygon->getInteriorRing(i), adfX, adfY, adfZ))
+                    return false;
+            }
+        }
+        return true;
+    case wkbMultiPoint:
+    case wkbMultiLineString:
+    case wkbMultiPolygon:
+    case wkbGeometryCollection:
+        {
+            OGRGeometryCollection* poCollection = (OGRGeometryCollection*)poGeom;
+            for (int i = 0; i < poCollection->getNumGeometries(); ++i)
+            {
+                if (!GetPoints(poCollection->getGeometryRef(i), adfX, adfY, adfZ))
+                    return false;
+            }
+        }
+        return true;
+    default:
+        return false;
+    }
+}
+
+void wxGISCoordinateTransformationCache::SetPoints(OGRGeometry* poGeom, const wxVector<double> &adfX, const wxVector<double> &adfY, const wxVector<double> &adfZ, size_t &nPoint)
+{
+    bool b3D = poGeom->getCoordinateDimension() == 3;
+    switch (wkbFlatten(poGeom->getGeometryType()))
+    {
+    case wkbPoint:
+        {
+            OGRPoint* poPoint = (OGRPoint*)poGeom;
+            if (poPoint->IsEmpty())
+                return;
+            poPoint->setX(adfX[nPoint]);
+            poPoint->setY(adfY[nPoint]);
+            if (b3D)
+                poPoint->setZ(adfZ[nPoint]);
+            nPoint++;
+        }
+        return;
+    case wkbLineString:
+    case wkbLinearRing:
+        {
+            OGRLineString* poLine = (OGRLineString*)poGeom;
+            for (int i = 0; i < poLine->getNumPoints(); ++i, ++nPoint)
+            {
+                if (b3D)
+                    poLine->setPoint(i, adfX[nPoint], adfY[nPoint], adfZ[nPoint]);
+                else
+                    poLine->setPoint(i, adfX[nPoint], adfY[nPoint]);
+            }
+        }
+        return;
+    case wkbPolygon:
+        {
+            OGRPolygon* poPolygon = (OGRPolygon*)poGeom;
+            if (poPolygon->getExteriorRing())
+                SetPoints(poPolygon->getExteriorRing(), adfX, adfY, adfZ, nPoint);
+            for (int i = 0; i < poPolygon->getNumInteriorRings(); ++i)
+                SetPoints(poPolygon->getInteriorRing(i), adfX, adfY, adfZ, nPoint);
+        }
+        return;
+    case wkbMultiPoint:
+    case wkbMultiLineString:
+    case wkbMultiPolygon:
+    case wkbGeometryCollection:
+        {
+            OGRGeometryCollection* poCollection = (OGRGeometryCollection*)poGeom;
+            for (int i = 0; i < poCollection->getNumGeometries(); ++i)
+                SetPoints(poCollection->getGeometryRef(i), adfX, adfY, adfZ, nPoint);
+        }
+        return;
+    default:
+        return;
+    }
+}
@@ -0,0 +1,390 @@
+/******************************************************************************
+ * Project:  wxGIS
+ * Purpose:  wxGISSpatialIndexFile class. The spatial tree items stored on disk.
+ * Author:   Dmitry Baryshnikov (aka Bishop), polimax@mail.ru
+ ******************************************************************************
+*   Copyright (C) 2014 Dmitry Baryshnikov
+*
+*    This program is free software: you can redistribute it and/or modify
+*    it under the terms of the GNU General Public License as published by
+*    the Free Software Foundation, either version 2 of the License, or
+*    (at your option) any later version.
+*
+*    This program is distributed in the hope that it will be useful,
+*    but WITHOUT ANY WARRANTY; without even the implied warranty of
+*    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+*    GNU General Public License for more details.
+*
+*    You should have received a copy of the GNU General Public License
+*    along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ ****************************************************************************/
+#include "wxgis/datasource/spatialindexfile.h"
+
+#include <wx/file.h>
+#include <wx/filename.h>
+#include <wx/dir.h>
+
+#include <algorithm>
+
+#define SPATIAL_INDEX_FILE_MAGIC "WXGSIDX1"
+
+// The file layout is: magic (8 bytes), key length (8 bytes), key (UTF-8, padded to 8 bytes), item count (8 bytes),
+// item records and WKB of items. All values are in the native byte order, the file from other platform is rejected by the magic and sizes check.
+typedef struct _spatialindexrecord
+{
+    double dfMinX, dfMinY, dfMaxX, dfMaxY;
+    wxInt64 nFID;
+    wxUint64 nWKBOffset;
+    wxUint64 nWKBSize;
+} SPATIALINDEXRECORD;
+
+#define SPATIAL_INDEX_ALIGN(x) (((x) + 7) & ~((wxUint64)7))
+
+typedef struct _spatialindexfileinfo
+{
+    wxString sPath;
+    wxULongLong nSize;
+    time_t nTime;
+    bool operator<(const _spatialindexfileinfo &other) const { return nTime < other.nTime; }
+} SPATIALINDEXFILEINFO;
+
+//-----------------------------------------------------------------------------
+// wxGISSpatialIndexFileData
+//-----------------------------------------------------------------------------
+
+wxGISSpatialIndexFileData::wxGISSpatialIndexFileData(wxGISSpatialIndexFile* const pIndexFile, long nFID, const OGREnvelope &Env, const GByte* pabyWKB, size_t nWKBSize) : wxGISSpatialTreeData(wxNullGeometry, nFID)
+{
+    m_pIndexFile = pIndexFile;
+    m_Env = Env;
+    m_pabyWKB = pabyWKB;
+    m_nWKBSize = nWKBSize;
+}
+
+wxGISSpatialIndexFileData::~wxGISSpatialIndexFileData()
+{
+}
+
+wxGISGeometry wxGISSpatialIndexFileData::GetGeometry(void) const
+{
+    //the geometry is created from WKB on first request, so any read of m_Geom goes under the file lock
+    wxCriticalSectionLocker locker(m_pIndexFile->GetLock());
+    if(m_pabyWKB != NULL)
+    {
+        wxGISSpatialIndexFileData* pThis = const_cast<wxGISSpatialIndexFileData*>(this);
+        pThis->m_Geom = m_pIndexFile->CreateGeometry(m_pabyWKB, m_nWKBSize);
+        pThis->m_pabyWKB = NULL;
+    }
+    return m_Geom;
+}
+
+void wxGISSpatialIndexFileData::SetGeometry(const wxGISGeometry &oGeom)
+{
+    wxCriticalSectionLocker locker(m_pIndexFile->GetLock());
+    m_pabyWKB = NULL;
+    m_Geom = oGeom;
+    if(m_Geom.IsOk())
+        m_Env = m_Geom.GetEnvelope();
+    else
+        m_Env = OGREnvelope();
+}
+
+OGREnvelope wxGISSpatialIndexFileData::GetEnvelope(void) const
+{
+    return m_Env;
+}
+
+wxGISSpatialTreeData* wxGISSpatialIndexFileData::Clone() const
+{
+    return new wxGISSpatialTreeData(GetGeometry().Clone(), m_nFID);
+}
+
+//-----------------------------------------------------------------------------
+// wxGISSpatialIndexFile
+//-----------------------------------------------------------------------------
+
+wxGISSpatialIndexFile::wxGISSpatialIndexFile(const wxGISSpatialReference &SpatialReference) : m_SpatialReference(SpatialReference)
+{
+    m_fp = NULL;
+#if GDAL_VERSION_NUM >= 1110000
+    m_pVirtualMem = NULL;
+#endif
+    m_pabyData = NULL;
+    m_bOwnData = false;
+    m_nDataSize = 0;
+    m_nItemCount = 0;
+    m_pabyRecords = NULL;
+}
+
+wxGISSpatialIndexFile::~wxGISSpatialIndexFile(void)
+{
+    Close();
+}
+
+void wxGISSpatialIndexFile::Close(void)
+{
+#if GDAL_VERSION_NUM >= 1110000
+    if(m_pVirtualMem)
+    {
+        CPLVirtualMemFree(m_pVirtualMem);
+        m_pVirtualMem = NULL;
+    }
+#endif
+    if(m_bOwnData)
+        CPLFree(m_pabyData);
+    m_pabyData = NULL;
+    m_bOwnData = false;
+
+    if(m_fp)
+    {
+        VSIFCloseL(m_fp);
+        m_fp = NULL;
+    }
+    m_nDataSize = 0;
+    m_nItemCount = 0;
+    m_pabyRecords = NULL;
+}
+
+bool wxGISSpatialIndexFile::IsOpened(void) const
+{
+    return m_pabyData != NULL;
+}
+
+size_t wxGISSpatialIndexFile::GetItemCount(void) const
+{
+    return m_nItemCount;
+}
+
+bool wxGISSpatialIndexFile::Open(const wxString &sPath, const wxString &sSourceKey)
+{
+    Close();
+
+    m_fp = VSIFOpenL(sPath.ToUTF8(), "rb");
+    if(m_fp == NULL)
+        return false;
+
+    VSIFSeekL(m_fp, 0, SEEK_END);
+    vsi_l_offset nFileSize = VSIFTellL(m_fp);
+    VSIFSeekL(m_fp, 0, SEEK_SET);
+    if(nFileSize < 24 || nFileSize > (vsi_l_offset)((size_t)-1))
+    {
+        Close();
+        return false;
+    }
+    m_nDataSize = (size_t)nFileSize;
+
+#if GDAL_VERSION_NUM >= 1110000
+    if(CPLIsVirtualMemFileMapAvailable())
+    {
+        m_pVirtualMem = CPLVirtualMemFileMapNew(m_fp, 0, nFileSize, VIRTUALMEM_READONLY, NULL, NULL);
+        if(m_pVirtualMem)
+            m_pabyData = (GByte*)CPLVirtualMemGetAddr(m_pVirtualMem);
+    }
+#endif
+
+    if(m_pabyData == NULL)
+    {
+        m_pabyData = (GByte*)VSIMalloc(m_nDataSize);
+        if(m_pabyData == NULL || VSIFReadL(m_pabyData, 1, m_nDataSize, m_fp) != m_nDataSize)
+        {
+            Close();
+            return false;
+        }
+        m_bOwnData = true;
+    }
+
+    //check header
+    if(memcmp(m_pabyData, SPATIAL_INDEX_FILE_MAGIC, 8) != 0)
+    {
+        Close();
+        return false;
+    }
+
+    wxUint64 nKeyLen;
+    memcpy(&nKeyLen, m_pabyData + 8, sizeof(nKeyLen));
+    wxUint64 nCountOffset = 16 + SPATIAL_INDEX_ALIGN(nKeyLen);
+    if(nCountOffset + 8 > m_nDataSize)
+    {
+        Close();
+        return false;
+    }
+
+    wxCharBuffer buf = sSourceKey.ToUTF8();
+    if(nKeyLen != strlen(buf.data()) || memcmp(m_pabyData + 16, buf.data(), nKeyLen) != 0)
+    {
+        Close();
+        return false;
+    }
+
+    wxUint64 nItemCount;
+    memcpy(&nItemCount, m_pabyData + nCountOffset, sizeof(nItemCount));
+    wxUint64 nRecordsOffset = nCountOffset + 8;
+    if(nItemCount > (m_nDataSize - nRecordsOffset) / sizeof(SPATIALINDEXRECORD))
+    {
+        Close();
+        return false;
+    }
+
+    m_nItemCount = (size_t)nItemCount;
+    m_pabyRecords = m_pabyData + nRecordsOffset;
+
+    return true;
+}
+
+wxGISSpatialTreeData* wxGISSpatialIndexFile::CreateItem(size_t nIndex)
+{
+    wxCHECK_MSG(nIndex < m_nItemCount, NULL, wxT("The item index is out of range"));
+
+    SPATIALINDEXRECORD stRecord;
+    memcpy(&stRecord, m_pabyRecords + nIndex * sizeof(SPATIALINDEXRECORD), sizeof(SPATIALINDEXRECORD));
+    if(stRecord.nWKBOffset > m_nDataSize || stRecord.nWKBSize > m_nDataSize - stRecord.nWKBOffset)
+        return NULL;
+
+    OGREnvelope Env;
+    Env.MinX = stRecord.dfMinX;
+    Env.MinY = stRecord.dfMinY;
+    Env.MaxX = stRecord.dfMaxX;
+    Env.MaxY = stRecord.dfMaxY;
+
+    return new wxGISSpatialIndexFileData(this, (long)stRecord.nFID, Env, m_pabyData + stRecord.nWKBOffset, (size_t)stRecord.nWKBSize);
+}
+
+wxGISGeometry wxGISSpatialIndexFile::CreateGeometry(const GByte* pabyWKB, size_t nWKBSize) const
+{
+    OGRGeometry *poGeom = NULL;
+    if(OGRGeometryFactory::createFromWkb((unsigned char*)pabyWKB, NULL, &poGeom, (int)nWKBSize) != OGRERR_NONE || poGeom == NULL)
+        return wxNullGeometry;
+
+    if(m_SpatialReference.IsOk())
+        poGeom->assignSpatialReference(m_SpatialReference);
+    return wxGISGeometry(poGeom);
+}
+
+bool wxGISSpatialIndexFile::Create(const wxString &sPath, const wxString &sSourceKey, const wxGISSpatialTreeCursor &Cursor, wxThread* const pThread)
+{
+    //write to temp file and rename to not leave the partial index
+    wxString sTmpPath = sPath + wxT(".tmp");
+    wxFile oFile;
+    if(!oFile.Create(sTmpPath, true))
+        return false;
+
+    wxCharBuffer buf = sSourceKey.ToUTF8();
+    wxUint64 nKeyLen = strlen(buf.data());
+    wxUint64 nPadLen = SPATIAL_INDEX_ALIGN(nKeyLen) - nKeyLen;
+    const char szPad[8] = {0};
+    wxUint64 nItemCount = Cursor.size();
+
+    bool bRes = oFile.Write(SPATIAL_INDEX_FILE_MAGIC, 8) == 8;
+    bRes = bRes && oFile.Write(&nKeyLen, sizeof(nKeyLen)) == sizeof(nKeyLen);
+    bRes = bRes && oFile.Write(buf.data(), nKeyLen) == nKeyLen;
+    bRes = bRes && oFile.Write(szPad, nPadLen) == nPadLen;
+    bRes = bRes && oFile.Write(&nItemCount, sizeof(nItemCount)) == sizeof(nItemCount);
+
+    //the records go first, so the WKB offsets are computed from the sizes
+    wxUint64 nWKBOffset = 24 + nKeyLen + nPadLen + nItemCount * sizeof(SPATIALINDEXRECORD);
+    for(size_t i = 0; bRes && i < Cursor.size(); ++i)
+    {
+        if(pThread && pThread->TestDestroy())
+        {
+            bRes = false;
+            break;
+        }
+
+        SPATIALINDEXRECORD stRecord = {0};
+        wxGISGeometry Geom = Cursor[i]->GetGeometry();
+        OGRGeometry* poGeom = Geom;
+        if(poGeom)
+        {
+            OGREnvelope Env = Cursor[i]->GetEnvelope();
+            stRecord.dfMinX = Env.MinX;
+            stRecord.dfMinY = Env.MinY;
+            stRecord.dfMaxX = Env.MaxX;
+            stRecord.dfMaxY = Env.MaxY;
+            stRecord.nWKBSize = poGeom->WkbSize();
+        }
+        stRecord.nFID = Cursor[i]->GetFID();
+        stRecord.nWKBOffset = nWKBOffset;
+        nWKBOffset += stRecord.nWKBSize;
+
+        bRes = oFile.Write(&stRecord, sizeof(stRecord)) == sizeof(stRecord);
+    }
+
+    wxVector<unsigned char> abyWKB;
+    for(size_t i = 0; bRes && i < Cursor.size(); ++i)
+    {
+        if(pThread && pThread->TestDestroy())
+        {
+            bRes = false;
+            break;
+        }
+
+        wxGISGeometry Geom = Cursor[i]->GetGeometry();
+        OGRGeometry* poGeom = Geom;
+        if(poGeom == NULL)
+            continue;
+        size_t nSize = poGeom->WkbSize();
+        if(abyWKB.size() < nSize)
+            abyWKB.resize(nSize);
+        poGeom->exportToWkb(wkbNDR, &abyWKB[0]);
+        bRes = oFile.Write(&abyWKB[0], nSize) == nSize;
+    }
+    oFile.Close();
+
+    if(!bRes)
+    {
+        wxRemoveFile(sTmpPath);
+        return false;
+    }
+
+    if(wxFileName::FileExists(sPath))
+        wxRemoveFile(sPath);
+    return wxRenameFile(sTmpPath, sPath, true);
+}
+
+void wxGISSpatialIndexFile::CleanUp(const wxString &sDir, wxULongLong nMaxSize, const wxString &sKeepPath)
+{
+    if(!wxDir::Exists(sDir))
+        return;
+
+    wxArrayString saFiles;
+    wxDir::GetAllFiles(sDir, &saFiles, wxString(wxT("*.")) + SPATIAL_INDEX_FILE_EXT + wxT("*"), wxDIR_FILES);
+
+    wxVector<SPATIALINDEXFILEINFO> astFiles;
+    wxULongLong nTotalSize = 0;
+    time_t nNow = wxDateTime::Now().GetTicks();
+    for(size_t i = 0; i < saFiles.GetCount(); ++i)
+    {
+        wxFileName oFileName(saFiles[i]);
+        //the temporary files left by a crashed or killed process, the one older than a day is not written any more
+        if(oFileName.GetExt().IsSameAs(wxT("tmp"), false))
+        {
+            if(nNow - oFileName.GetModificationTime().GetTicks() > 86400)
+                wxRemoveFile(saFiles[i]);
+            continue;
+        }
+        if(!oFileName.GetExt().IsSameAs(SPATIAL_INDEX_FILE_EXT, false))
+            continue;
+
+        SPATIALINDEXFILEINFO stInfo;
+        stInfo.sPath = saFiles[i];
+        stInfo.nSize = oFileName.GetSize();
+        if(stInfo.nSize == wxInvalidSize)
+            continue;
+        stInfo.nTime = oFileName.GetModificationTime().GetTicks();
+        nTotalSize += stInfo.nSize;
+        astFiles.push_back(stInfo);
+    }
+
+    if(nTotalSize <= nMaxSize)
+        return;
+
+    //the opened files are touched, so the modification time is the last use time
+    std::sort(astFiles.begin(), astFiles.end());
+    wxFileName oKeepFileName(sKeepPath);
+    for(size_t i = 0; i < astFiles.size() && nTotalSize > nMaxSize; ++i)
+    {
+        if(!sKeepPath.IsEmpty() && oKeepFileName.SameAs(wxFileName(astFiles[i].sPath)))
+            continue;
+        if(wxRemoveFile(astFiles[i].sPath))
+            nTotalSize -= astFiles[i].nSize;
+    }
+}
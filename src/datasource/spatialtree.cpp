@@ -22,6 +22,16 @@
 #include "wxgis/datasource/spatialtree.h"
 #include "wxgis/datasource/featuredataset.h"
 #include "wxgis/datasource/vectorop.h"
+#include "wxgis/datasource/spatialindexfile.h"
+#include "wxgis/core/config.h"
+
+#include <wx/filename.h>
+
+#include <algorithm>
+
+#ifdef wxGIS_USE_SSE2
+#   include <emmintrin.h>
+#endif
 
 #define PRELOAD_GEOM_COUNT 2000
 
@@ -76,12 +86,57 @@ void wxGISSpatialTreeData::SetGeometry(const wxGISGeometry &oGeom)
     m_Geom = oGeom;
 }
 
+OGREnvelope wxGISSpatialTreeData::GetEnvelope(void) const
+{
+    if(m_Geom.IsOk())
+        return m_Geom.GetEnvelope();
+    return OGREnvelope();
+}
+
 wxGISSpatialTreeData* wxGISSpatialTreeData::Clone() const
 {
     return new wxGISSpatialTreeData(m_Geom.Clone(), m_nFID);
 }
 
 
+//-----------------------------------------------------------------------------
+// wxGISGeometryProjectThread
+//-----------------------------------------------------------------------------
+
+wxGISGeometryProjectThread::wxGISGeometryProjectThread(wxMessageQueue<PRELOADBATCH*> &InQueue, wxMessageQueue<PRELOADBATCH*> &OutQueue, OGRCoordinateTransformation* poCT) : wxThread(wxTHREAD_JOINABLE), m_InQueue(InQueue), m_OutQueue(OutQueue)
+{
+    m_poCT = poCT;
+}
+
+wxGISGeometryProjectThread::~wxGISGeometryProjectThread()
+{
+    if(m_poCT)
+        OCTDestroyCoordinateTransformation(m_poCT);
+}
+
+void *wxGISGeometryProjectThread::Entry()
+{
+    while(true)
+    {
+        PRELOADBATCH* pBatch(NULL);
+        if(m_InQueue.Receive(pBatch) != wxMSGQUEUE_NO_ERROR || pBatch == NULL)
+            break;
+
+        for(size_t i = 0; i < pBatch->paData.size(); ++i)
+        {
+            wxGISSpatialTreeData* pData = pBatch->paData[i];
+            wxGISGeometry Geom = pData->GetGeometry();
+            if(pBatch->abShared[i])
+                Geom = Geom.Copy();
+            Geom.Project(m_poCT);
+            pData->SetGeometry(Geom);
+        }
+
+        m_OutQueue.Post(pBatch);
+    }
+    return NULL;
+}
+
 //-----------------------------------------------------------------------------
 // wxGISSpatialTree
 //----------------------------------------------------------------------------
@@ -94,10 +149,20 @@ wxGISSpatialTree::wxGISSpatialTree(wxGISFeatureDataset* pDSet) : wxGISThreadHelp
     m_nReadPos = 0;
 
     m_bIsLoaded = false;
+    m_pIndexFile = NULL;
+
+    m_bUseIndexFile = true;
+    wxGISAppConfig oConfig = GetConfig();
+    if(oConfig.IsOk())
+    {
+        m_bUseIndexFile = oConfig.ReadBool(enumGISHKCU, wxString(wxT("wxGISCommon/spatial_index/use_cache")), m_bUseIndexFile);
+    }
 }
 
 wxGISSpatialTree::~wxGISSpatialTree(void)
 {
+    //the items of index file should be deleted in derived classes destructor
+    wxDELETE(m_pIndexFile);
     wsDELETE(m_pDSet);
 }
 
@@ -112,11 +177,119 @@ bool wxGISSpatialTree::Load(const wxGISSpatialReference &SpatRef, ITrackCancel*
     //create quad tree
     if(m_pDSet != NULL)
     {
+        //the tree from the spatial index file is ready without the preload thread
+        if(LoadIndexFile())
+        {
+            m_pTrackCancel = NULL;
+            m_pDSet->SetCached(true);
+            m_bIsLoaded = true;
+            return true;
+        }
 	    return CreateAndRunThread();
     }
     return false;
 }
 
+wxString wxGISSpatialTree::GetIndexFileKey(void) const
+{
+    if(!m_bUseIndexFile || m_pDSet == NULL || m_pDSet->HasFilter())
+        return wxEmptyString;
+    if(m_SpatialReference.IsOk() && !m_SpatialReference.IsSame(m_pDSet->GetSpatialReference()))
+        return wxEmptyString;
+
+    wxString sPath(m_pDSet->GetPath(), wxConvUTF8);
+    wxFileName oFileName(sPath);
+    if(!oFileName.FileExists())
+        return wxEmptyString;
+
+    return wxString::Format(wxT("%s|%s|%ld|%s"), sPath.c_str(), m_pDSet->GetName().c_str(), (long)oFileName.GetModificationTime().GetTicks(), oFileName.GetSize().ToString().c_str());
+}
+
+wxString wxGISSpatialTree::GetIndexFilePath(void) const
+{
+    wxGISAppConfig oConfig = GetConfig();
+    if(!oConfig.IsOk())
+        return wxEmptyString;
+
+    wxString sDir = oConfig.GetLocalConfigDirNonPortable() + wxFileName::GetPathSeparator() + wxString(wxT("sidx"));
+    sDir = oConfig.Read(enumGISHKCU, wxString(wxT("wxGISCommon/spatial_index/path")), sDir);
+
+    //FNV-1a hash of the dataset path and name, the full key is stored in the file
+    wxString sName = wxString(m_pDSet->GetPath(), wxConvUTF8) + wxT("|") + m_pDSet->GetName();
+    wxCharBuffer buf = sName.ToUTF8();
+    wxUint32 nHash1 = 2166136261U, nHash2 = 84696351U;
+    for(const char *p = buf.data(); *p; ++p)
+    {
+        nHash1 = (nHash1 ^ (unsigned char)*p) * 16777619U;
+        nHash2 = (nHash2 ^ (unsigned char)*p) * 16777619U;
+    }
+    wxFileName oFileName(sDir, wxString::Format(wxT("%08x%08x"), nHash1, nHash2), SPATIAL_INDEX_FILE_EXT);
+    return oFileName.GetFullPath();
+}
+
+bool wxGISSpatialTree::LoadIndexFile(void)
+{
+    wxString sKey = GetIndexFileKey();
+    if(sKey.IsEmpty())
+        return false;
+    wxString sPath = GetIndexFilePath();
+    if(sPath.IsEmpty() || !wxFileName::FileExists(sPath))
+        return false;
+
+    wxGISSpatialIndexFile* pIndexFile = new wxGISSpatialIndexFile(m_pDSet->GetSpatialReference());
+    if(!pIndexFile->Open(sPath, sKey))
+    {
+        wxDELETE(pIndexFile);
+        //the file is created for the other version of the source or is corrupted, it will be never valid again
+        wxRemoveFile(sPath);
+        return false;
+    }
+
+    //the modification time is the last use time for the cache clean up
+    wxFileName(sPath).Touch();
+
+    wxDELETE(m_pIndexFile);
+    m_pIndexFile = pIndexFile;
+
+    BeginBulkLoad();
+    for(size_t i = 0; i < m_pIndexFile->GetItemCount(); ++i)
+    {
+        wxGISSpatialTreeData* pData = m_pIndexFile->CreateItem(i);
+        if(pData)
+            Insert(pData);
+    }
+    EndBulkLoad();
+
+    m_nReadPos = m_pIndexFile->GetItemCount();
+
+    wxLogDebug(wxT("The spatial index of %s loaded from %s"), m_pDSet->GetName().c_str(), sPath.c_str());
+    return true;
+}
+
+bool wxGISSpatialTree::SaveIndexFile(void)
+{
+    wxString sKey = GetIndexFileKey();
+    if(sKey.IsEmpty())
+        return false;
+    wxString sPath = GetIndexFilePath();
+    if(sPath.IsEmpty())
+        return false;
+
+    wxFileName oFileName(sPath);
+    if(!oFileName.DirExists() && !oFileName.Mkdir(0755, wxPATH_MKDIR_FULL))
+        return false;
+
+    if(!wxGISSpatialIndexFile::Create(sPath, sKey, Search(OGREnvelope()), GetThread()))
+        return false;
+
+    wxULongLong nMaxSize = wxULongLong(SPATIAL_INDEX_CACHE_SIZE) * 1024 * 1024;
+    wxGISAppConfig oConfig = GetConfig();
+    if(oConfig.IsOk())
+        nMaxSize = wxULongLong(oConfig.ReadInt(enumGISHKCU, wxString(wxT("wxGISCommon/spatial_index/max_size_mb")), SPATIAL_INDEX_CACHE_SIZE)) * 1024 * 1024;
+    wxGISSpatialIndexFile::CleanUp(oFileName.GetPath(), nMaxSize, sPath);
+    return true;
+}
+
 bool wxGISSpatialTree::IsLoading(void) const
 {
     return GetThread() && GetThread()->IsRunning();
@@ -171,9 +344,21 @@ wxThread::ExitCode wxGISSpatialTree::Entry()
         poCT = OGRCreateCoordinateTransformation( m_pDSet->GetSpatialReference(), m_SpatialReference);
     }
 
+    //the geometries of big layers are projected by worker threads, this thread only reads the features
+    wxMessageQueue<PRELOADBATCH*> InQueue, OutQueue;
+    wxVector<wxGISGeometryProjectThread*> paThreads;
+    if(poCT != NULL && nFeaturesCount > m_nPreloadItemCount)
+    {
+        StartProjectThreads(paThreads, InQueue, OutQueue);
+    }
+    PRELOADBATCH* pBatch(NULL);
+    size_t nBatchesInWork(0);
+
     wxVector<wxGISSpatialTreeData*> m_paCachedData;
     m_paCachedData.reserve(m_nPreloadItemCount);
 
+    BeginBulkLoad();
+
     wxGISFeature Feature = m_pDSet->GetFeature(m_nReadPos);
     while(Feature.IsOk())
     {
@@ -181,31 +366,51 @@ wxThread::ExitCode wxGISSpatialTree::Entry()
         wxGISGeometry Geom = Feature.GetGeometry();
         if(Geom.IsOk())
         {
-            if(poCT != NULL)
+            //the feature buffered in m_pDSet shares the geometry, otherwise the geometry is taken from the feature without copy
+            bool bShared = Feature.GetRefData()->GetRefCount() > 1;
+            if(!bShared)
+                Geom = wxGISGeometry(((OGRFeature*)Feature)->StealGeometry());
+            long nFid = Feature.GetFID();
+
+            if(!paThreads.empty())
             {
-                Geom = Geom.Copy();
-                Geom.Project(poCT);
+                if(pBatch == NULL)
+                    pBatch = new PRELOADBATCH;
+                pBatch->paData.push_back(new wxGISSpatialTreeData(Geom, nFid));
+                pBatch->abShared.push_back(bShared);
+                if(pBatch->paData.size() >= (size_t)m_nPreloadItemCount)
+                {
+                    InQueue.Post(pBatch);
+                    pBatch = NULL;
+                    nBatchesInWork++;
+                    //wait the workers if too many batches are queued
+                    nBatchesInWork -= AddProjectedBatches(OutQueue, nBatchesInWork, nBatchesInWork > paThreads.size() * 2);
+                }
             }
-
-            wxGISSpatialTreeData *pData(NULL);
-            long nFid = Feature.GetFID();
-            if(Feature.GetRefData()->GetRefCount() > 1)
-                pData = new wxGISSpatialTreeData(Geom, nFid);//appologise the feature is buffered in m_pDSet
             else
-                pData = new wxGISSpatialTreeData(Geom.Copy(), nFid);
+            {
+                if(poCT != NULL)
+                {
+                    if(bShared)
+                        Geom = Geom.Copy();
+                    Geom.Project(poCT);
+                }
 
-            Insert(pData);
-            m_paCachedData.push_back(pData);
+                wxGISSpatialTreeData *pData = new wxGISSpatialTreeData(Geom, nFid);
 
-            if(nItemCounter == m_nPreloadItemCount)
-            {
-                wxGISSpatialTreeCursor cursor;
-                WX_APPEND_ARRAY(cursor, m_paCachedData);
-                /*for(wxVector<wxGISSpatialTreeData*>::const_iterator it = m_paCachedData.begin(); it != m_paCachedData.end(); ++it)
-                    cursor.push_back(*it);*/
-                m_pDSet->PostEvent(new wxFeatureDSEvent(wxDS_FEATURES_ADDED, cursor));
-                nItemCounter = 0;
-                m_paCachedData.clear();
+                Insert(pData);
+                m_paCachedData.push_back(pData);
+
+                if(nItemCounter == m_nPreloadItemCount)
+                {
+                    wxGISSpatialTreeCursor cursor;
+                    WX_APPEND_ARRAY(cursor, m_paCachedData);
+                    /*for(wxVector<wxGISSpatialTreeData*>::const_iterator it = m_paCachedData.begin(); it != m_paCachedData.end(); ++it)
+                        cursor.push_back(*it);*/
+                    m_pDSet->PostEvent(new wxFeatureDSEvent(wxDS_FEATURES_ADDED, cursor));
+                    nItemCounter = 0;
+                    m_paCachedData.clear();
+                }
             }
         }
 
@@ -214,6 +419,9 @@ wxThread::ExitCode wxGISSpatialTree::Entry()
 
         if (TestDestroy())
         {
+            StopProjectThreads(paThreads, InQueue, OutQueue, pBatch, nBatchesInWork);
+            EndBulkLoad();
+
             saIgnoredFields.Clear();
             m_pDSet->SetIgnoredFields(saIgnoredFields);
 
@@ -243,7 +451,10 @@ wxThread::ExitCode wxGISSpatialTree::Entry()
         Feature = m_pDSet->Next();
     }
 
-    if(nItemCounter > 0)
+    StopProjectThreads(paThreads, InQueue, OutQueue, pBatch, nBatchesInWork);
+    EndBulkLoad();
+
+    if(!m_paCachedData.empty())
     {
         wxGISSpatialTreeCursor cursor;
         WX_APPEND_ARRAY(cursor, m_paCachedData);
@@ -273,6 +484,10 @@ wxThread::ExitCode wxGISSpatialTree::Entry()
 
     m_bIsLoaded = true;
 
+    //the full scan result is stored for the next open
+    if(m_nReadPos == nFeaturesCount)
+        SaveIndexFile();
+
 	return (wxThread::ExitCode)wxTHREAD_NO_ERROR;     // success
 
 }
@@ -288,6 +503,89 @@ void wxGISSpatialTree::Change(const wxGISGeometry &Geom, long nFID)
     Insert(Geom, nFID);
 }
 
+void wxGISSpatialTree::StartProjectThreads(wxVector<wxGISGeometryProjectThread*> &paThreads, wxMessageQueue<PRELOADBATCH*> &InQueue, wxMessageQueue<PRELOADBATCH*> &OutQueue)
+{
+    int nThreadCount = wxThread::GetCPUCount() - 1;
+    for(int i = 0; i < nThreadCount; ++i)
+    {
+        //the coordinate transformation is not thread safe, so each thread has own
+        OGRCoordinateTransformation *poCT = OGRCreateCoordinateTransformation( m_pDSet->GetSpatialReference(), m_SpatialReference);
+        if(poCT == NULL)
+            break;
+
+        wxGISGeometryProjectThread *thread = new wxGISGeometryProjectThread(InQueue, OutQueue, poCT);
+        if(::CreateAndRunThread(thread, wxT("wxGISGeometryProjectThread"), wxT("GeometryProjectThread")))
+        {
+            paThreads.push_back(thread);
+        }
+        else
+        {
+            wxDELETE(thread);
+            break;
+        }
+    }
+}
+
+void wxGISSpatialTree::StopProjectThreads(wxVector<wxGISGeometryProjectThread*> &paThreads, wxMessageQueue<PRELOADBATCH*> &InQueue, wxMessageQueue<PRELOADBATCH*> &OutQueue, PRELOADBATCH* &pBatch, size_t &nBatchesInWork)
+{
+    if(paThreads.empty())
+        return;
+
+    if(pBatch)
+    {
+        InQueue.Post(pBatch);
+        pBatch = NULL;
+        nBatchesInWork++;
+    }
+
+    //the threads exit on NULL batch after all queued batches are done
+    for(size_t i = 0; i < paThreads.size(); ++i)
+        InQueue.Post(NULL);
+
+    while(nBatchesInWork > 0)
+        nBatchesInWork -= AddProjectedBatches(OutQueue, nBatchesInWork, true);
+
+    for(size_t i = 0; i < paThreads.size(); ++i)
+    {
+        wgDELETE(paThreads[i], Wait());
+    }
+    paThreads.clear();
+}
+
+size_t wxGISSpatialTree::AddProjectedBatches(wxMessageQueue<PRELOADBATCH*> &OutQueue, size_t nMaxCount, bool bWait)
+{
+    size_t nCount(0);
+    while(nCount < nMaxCount)
+    {
+        PRELOADBATCH* pBatch(NULL);
+        wxMessageQueueError eErr = bWait ? OutQueue.Receive(pBatch) : OutQueue.ReceiveTimeout(0, pBatch);
+        if(eErr != wxMSGQUEUE_NO_ERROR || pBatch == NULL)
+            break;
+        //wait only for the first batch
+        bWait = false;
+
+        wxGISSpatialTreeCursor cursor;
+        for(size_t i = 0; i < pBatch->paData.size(); ++i)
+        {
+            Insert(pBatch->paData[i]);
+            cursor.push_back(pBatch->paData[i]);
+        }
+        m_pDSet->PostEvent(new wxFeatureDSEvent(wxDS_FEATURES_ADDED, cursor));
+
+        wxDELETE(pBatch);
+        nCount++;
+    }
+    return nCount;
+}
+
+void wxGISSpatialTree::BeginBulkLoad(void)
+{
+}
+
+void wxGISSpatialTree::EndBulkLoad(void)
+{
+}
+
 //-----------------------------------------------------------------------------
 // wxGISRTreeNode
 //-----------------------------------------------------------------------------
@@ -297,15 +595,15 @@ wxGISRTreeNode::wxGISRTreeNode(unsigned short nMinChildItems, unsigned short nMa
     m_nMinChildItems = nMinChildItems;
     m_nMaxChildItems = nMaxChildItems;
     m_pData = pData;
+    m_bHasLeaves = false;
+    //the data node has no children to pack
+    m_bPackDirty = m_bSubtreeDirty = pData == NULL;
+    m_pParent = NULL;
 
-    if(m_pData && m_pData->GetGeometry().IsOk())
+    if(m_pData)
     {
-        wxGISGeometry Geom = m_pData->GetGeometry();
-        if(Geom.IsOk())
-        {
-            m_Env = Geom.GetEnvelope();
-            m_dfArea = fabs((m_Env.MaxX - m_Env.MinX) * (m_Env.MaxY - m_Env.MinY));
-        }
+        m_Env = m_pData->GetEnvelope();
+        m_dfArea = fabs((m_Env.MaxX - m_Env.MinX) * (m_Env.MaxY - m_Env.MinY));
     }
 }
 
@@ -341,7 +639,9 @@ void wxGISRTreeNode::PutNode(wxGISRTreeNode* pNode)
     if(m_paNodes.empty())
         m_paNodes.reserve(m_nMinChildItems);
 
+    pNode->m_pParent = this;
     m_paNodes.push_back(pNode);
+    SetPackDirty();
 }
 
 double wxGISRTreeNode::GetArea() const
@@ -373,6 +673,7 @@ void wxGISRTreeNode::Delete()
     }
 
     m_paNodes.clear();
+    SetPackDirty();
 
     wxDELETE(m_pData);
 }
@@ -381,6 +682,8 @@ void wxGISRTreeNode::StretchBounds(const OGREnvelope &Env)
 {
     m_Env.Merge(Env);
     m_dfArea = fabs((m_Env.MaxX - m_Env.MinX) * (m_Env.MaxY - m_Env.MinY));
+    if(m_pParent)
+        m_pParent->SetPackDirty();
 }
 
 void wxGISRTreeNode::UpdateBounds(void)
@@ -393,9 +696,12 @@ void wxGISRTreeNode::UpdateBounds(void)
     }
 
     m_dfArea = fabs((m_Env.MaxX - m_Env.MinX) * (m_Env.MaxY - m_Env.MinY));
+    SetPackDirty();
+    if(m_pParent)
+        m_pParent->SetPackDirty();
 }
 
-OGREnvelope wxGISRTreeNode::GetBounds() const
+const OGREnvelope &wxGISRTreeNode::GetBounds() const
 {
     return m_Env;
 }
@@ -414,6 +720,7 @@ void wxGISRTreeNode::RemoveFarestItems(size_t p, wxVector<wxGISRTreeNode*> &remo
     // RI3.A: Remove the last p items from N
     removed_items.assign(m_paNodes.end() - p, m_paNodes.end());
     m_paNodes.erase(m_paNodes.end() - p, m_paNodes.end());
+    SetPackDirty();
 }
 
 wxGISRTreeNode* wxGISRTreeNode::Split()
@@ -481,6 +788,8 @@ wxGISRTreeNode* wxGISRTreeNode::Split()
     // distribute the end of the array to the new node, then erase them from the original node
     pNewNode->m_paNodes.assign(m_paNodes.begin() + split_index, m_paNodes.end());
     m_paNodes.erase(m_paNodes.begin() + split_index, m_paNodes.end());
+    for(size_t i = 0; i < pNewNode->m_paNodes.size(); ++i)
+        pNewNode->m_paNodes[i]->m_pParent = pNewNode;
 
     // adjust the bounding box for each 'new' node
     UpdateBounds();
@@ -564,91 +873,122 @@ wxGISRTreeNode::SPLIT_DIR wxGISRTreeNode::GetSplitDirection(const bool bIsX, siz
     return ret;
 }
 
-void wxGISRTreeNode::Search(wxGISSpatialTreeCursor &Cursor, const OGREnvelope& env)
+void wxGISRTreeNode::PackBounds(void)
 {
-    for(size_t i = 0; i < GetCount(); ++i)
+    size_t nCount = m_paNodes.size();
+    m_adfBounds.resize(nCount * 4);
+    m_paPackedData.resize(nCount);
+    m_bPackDirty = false;
+    if(nCount == 0)
+        return;
+
+    double *pdfMinX = &m_adfBounds[0];
+    double *pdfMaxX = pdfMinX + nCount;
+    double *pdfMinY = pdfMaxX + nCount;
+    double *pdfMaxY = pdfMinY + nCount;
+    for(size_t i = 0; i < nCount; ++i)
     {
-        if(m_paNodes[i]->GetBounds().Intersects(env))
-        {
-            if(m_paNodes[i]->GetCount() > 0)
-            {
-                m_paNodes[i]->Search(Cursor, env);
-            }
-            else
-            {
-                Cursor.push_back(m_paNodes[i]->GetData());
-            }
-        }
+        const OGREnvelope &Env = m_paNodes[i]->GetBounds();
+        pdfMinX[i] = Env.MinX;
+        pdfMaxX[i] = Env.MaxX;
+        pdfMinY[i] = Env.MinY;
+        pdfMaxY[i] = Env.MaxY;
+        m_paPackedData[i] = m_paNodes[i]->GetCount() > 0 ? NULL : m_paNodes[i]->GetData();
     }
 }
 
-void wxGISRTreeNode::GetAll(wxGISSpatialTreeCursor &Cursor)
+void wxGISRTreeNode::SetPackDirty(void)
 {
-    for(size_t i = 0; i < GetCount(); ++i)
+    m_bPackDirty = true;
+    //the parents marked before have all their parents marked too
+    wxGISRTreeNode* pNode = this;
+    while(pNode && !pNode->m_bSubtreeDirty)
     {
-        if(m_paNodes[i]->GetCount() > 0)
-        {
-            m_paNodes[i]->GetAll(Cursor);
-        }
-        else
-        {
-            Cursor.push_back(m_paNodes[i]->GetData());
-        }
+        pNode->m_bSubtreeDirty = true;
+        pNode = pNode->m_pParent;
     }
 }
 
-bool wxGISRTreeNode::Remove(long nFID)
+void wxGISRTreeNode::PackDirty(void)
 {
+    if(!m_bSubtreeDirty)
+        return;
+
+    if(m_bPackDirty)
+        PackBounds();
     for(size_t i = 0; i < m_paNodes.size(); ++i)
     {
-        if(m_paNodes[i]->GetCount() > 0)
+        if(m_paNodes[i]->m_bSubtreeDirty)
+            m_paNodes[i]->PackDirty();
+    }
+    m_bSubtreeDirty = false;
+}
+
+void wxGISRTreeNode::Search(wxGISSpatialTreeCursor &Cursor, const OGREnvelope& env)
+{
+    //the packed bounds are rebuilt by the tree after insert or delete, the search only reads them
+    wxASSERT(!m_bPackDirty);
+
+    size_t nCount = m_paNodes.size();
+    if(nCount == 0)
+        return;
+
+    const double *pdfMinX = &m_adfBounds[0];
+    const double *pdfMaxX = pdfMinX + nCount;
+    const double *pdfMinY = pdfMaxX + nCount;
+    const double *pdfMaxY = pdfMinY + nCount;
+
+    size_t i = 0;
+#ifdef wxGIS_USE_SSE2
+    const __m128d mEnvMinX = _mm_set1_pd(env.MinX);
+    const __m128d mEnvMaxX = _mm_set1_pd(env.MaxX);
+    const __m128d mEnvMinY = _mm_set1_pd(env.MinY);
+    const __m128d mEnvMaxY = _mm_set1_pd(env.MaxY);
+    for(; i + 2 <= nCount; i += 2)
+    {
+        __m128d mHitX = _mm_and_pd(_mm_cmple_pd(_mm_loadu_pd(pdfMinX + i), mEnvMaxX), _mm_cmpge_pd(_mm_loadu_pd(pdfMaxX + i), mEnvMinX));
+        __m128d mHitY = _mm_and_pd(_mm_cmple_pd(_mm_loadu_pd(pdfMinY + i), mEnvMaxY), _mm_cmpge_pd(_mm_loadu_pd(pdfMaxY + i), mEnvMinY));
+        int nMask = _mm_movemask_pd(_mm_and_pd(mHitX, mHitY));
+        if(nMask == 0)
+            continue;
+
+        for(size_t j = 0; j < 2; ++j)
         {
-            if(m_paNodes[i]->Remove(nFID))
-            {
-                m_paNodes.erase(m_paNodes.begin() + i);
-                if(m_paNodes.empty())
-                {
-                    delete this;
-                    return true;
-                }
-				return false;
-            }
+            if((nMask & (1 << j)) == 0)
+                continue;
+            if(m_paPackedData[i + j])
+                Cursor.push_back(m_paPackedData[i + j]);
+            else
+                m_paNodes[i + j]->Search(Cursor, env);
         }
-        else
+    }
+#endif
+
+    for(; i < nCount; ++i)
+    {
+        if(pdfMinX[i] <= env.MaxX && pdfMaxX[i] >= env.MinX && pdfMinY[i] <= env.MaxY && pdfMaxY[i] >= env.MinY)
         {
-            if(m_paNodes[i]->GetData()->GetFID() == nFID)
-            {
-                m_paNodes.erase(m_paNodes.begin() + i);
-                if(m_paNodes.empty())
-                {
-                    delete this;
-                    return true;
-                }
-				return false;
-            }
+            if(m_paPackedData[i])
+                Cursor.push_back(m_paPackedData[i]);
+            else
+                m_paNodes[i]->Search(Cursor, env);
         }
     }
-    return false;
 }
 
-bool wxGISRTreeNode::HasFID(long nFID) const
+void wxGISRTreeNode::GetAll(wxGISSpatialTreeCursor &Cursor)
 {
-    for(size_t i = 0; i < m_paNodes.size(); ++i)
+    for(size_t i = 0; i < GetCount(); ++i)
     {
         if(m_paNodes[i]->GetCount() > 0)
         {
-            if(m_paNodes[i]->HasFID(nFID))
-                return true;
+            m_paNodes[i]->GetAll(Cursor);
         }
         else
         {
-            if(m_paNodes[i]->GetData()->GetFID() == nFID)
-            {
-                return true;
-            }
+            Cursor.push_back(m_paNodes[i]->GetData());
         }
     }
-    return false;
 }
 
 //-----------------------------------------------------------------------------
@@ -663,12 +1003,132 @@ wxGISRTree::wxGISRTree(wxGISFeatureDataset* pDSet, unsigned short nMaxChildItems
     wxASSERT(1 <= nMinChildItems && nMinChildItems <= nMaxChildItems / 2);
 
     m_pRoot = NULL;
+    m_bBulkLoad = false;
+    m_nItemCount = 0;
 }
 
 wxGISRTree::~wxGISRTree(void)
 {
 	wxCriticalSectionLocker locker(m_CritSect);
 	wxDELETE(m_pRoot);
+    for(size_t i = 0; i < m_paBulkNodes.size(); ++i)
+        wxDELETE(m_paBulkNodes[i]);
+    for(size_t i = 0; i < m_paBulkChunks.size(); ++i)
+        wxDELETE(m_paBulkChunks[i]);
+    for(size_t i = 0; i < m_paRemovedNodes.size(); ++i)
+        wxDELETE(m_paRemovedNodes[i]);
+}
+
+void wxGISRTree::BeginBulkLoad(void)
+{
+	wxCriticalSectionLocker locker(m_CritSect);
+    m_bBulkLoad = true;
+}
+
+void wxGISRTree::EndBulkLoad(void)
+{
+	wxCriticalSectionLocker locker(m_CritSect);
+    m_bBulkLoad = false;
+
+    wxVector<wxGISRTreeNode*> paNodes;
+    paNodes.reserve(m_paBulkChunks.size() * RTREE_BULK_CHUNK_SIZE + m_paBulkNodes.size());
+    for(size_t i = 0; i < m_paBulkChunks.size(); ++i)
+    {
+        DetachLeaves(m_paBulkChunks[i], paNodes);
+        delete m_paBulkChunks[i];
+    }
+    m_paBulkChunks.clear();
+    paNodes.insert(paNodes.end(), m_paBulkNodes.begin(), m_paBulkNodes.end());
+    m_paBulkNodes.clear();
+    if(paNodes.empty())
+        return;
+
+    size_t nTreeCount = m_nItemCount - paNodes.size();
+    if(m_pRoot && m_pRoot->GetCount() > 0 && paNodes.size() * RTREE_BULK_INSERT_RATIO < nTreeCount)
+    {
+        //the few items are inserted to the large tree one by one
+        for(size_t i = 0; i < paNodes.size(); ++i)
+            InsertInternal(paNodes[i], m_pRoot);
+        m_pRoot->PackDirty();
+        return;
+    }
+
+    //the tree items are packed again together with the new ones
+    if(m_pRoot)
+    {
+        DetachLeaves(m_pRoot, paNodes);
+        wxDELETE(m_pRoot);
+    }
+    m_pRoot = BulkLoad(paNodes);
+    m_pRoot->PackDirty();
+}
+
+void wxGISRTree::DetachLeaves(wxGISRTreeNode* pNode, wxVector<wxGISRTreeNode*> &paNodes)
+{
+    for(size_t i = 0; i < pNode->m_paNodes.size(); ++i)
+    {
+        wxGISRTreeNode* pChild = pNode->m_paNodes[i];
+        if(pChild->GetData())
+        {
+            pChild->m_pParent = NULL;
+            paNodes.push_back(pChild);
+        }
+        else
+        {
+            DetachLeaves(pChild, paNodes);
+            delete pChild;
+        }
+    }
+    pNode->m_paNodes.clear();
+}
+
+// Sort-Tile-Recursive packing: the items of level are sorted by X center and cut to
+// vertical slices of sqrt(node count) nodes, each slice is sorted by Y center and cut
+// to fully packed nodes. The nodes are the items of upper level.
+wxGISRTreeNode* wxGISRTree::BulkLoad(wxVector<wxGISRTreeNode*> &paNodes)
+{
+    if(paNodes.empty())
+        return NULL;
+
+    wxVector<wxGISRTreeNode*> paLevel(paNodes);
+    bool bHasLeaves = true;
+    while(true)
+    {
+        size_t nCount = paLevel.size();
+        size_t nNodeCount = (nCount + m_nMaxChildItems - 1) / m_nMaxChildItems;
+        size_t nSliceSize = (size_t)ceil(sqrt((double)nNodeCount)) * m_nMaxChildItems;
+
+        std::sort(paLevel.begin(), paLevel.end(), wxGISRTreeNode::SortBoundedItemsByCenter(true));
+
+        wxVector<wxGISRTreeNode*> paUpperLevel;
+        paUpperLevel.reserve(nNodeCount);
+        for(size_t nSlice = 0; nSlice < nCount; nSlice += nSliceSize)
+        {
+            size_t nSliceEnd = wxMin(nSlice + nSliceSize, nCount);
+            std::sort(paLevel.begin() + nSlice, paLevel.begin() + nSliceEnd, wxGISRTreeNode::SortBoundedItemsByCenter(false));
+
+            for(size_t i = nSlice; i < nSliceEnd; i += m_nMaxChildItems)
+            {
+                size_t nEnd = wxMin(i + m_nMaxChildItems, nSliceEnd);
+                wxGISRTreeNode* pNode = new wxGISRTreeNode(m_nMinChildItems, m_nMaxChildItems);
+                pNode->SetHasLeaves(bHasLeaves);
+                pNode->m_paNodes.reserve(nEnd - i);
+                for(size_t j = i; j < nEnd; ++j)
+                {
+                    paLevel[j]->m_pParent = pNode;
+                    pNode->m_paNodes.push_back(paLevel[j]);
+                }
+                pNode->UpdateBounds();
+                paUpperLevel.push_back(pNode);
+            }
+        }
+
+        if(paUpperLevel.size() == 1)
+            return paUpperLevel[0];
+
+        paLevel = paUpperLevel;
+        bHasLeaves = false;
+    }
 }
 
 wxGISRTreeNode* wxGISRTree::ChooseSubtree(wxGISRTreeNode* pNode, const OGREnvelope &Env)
@@ -689,15 +1149,35 @@ wxGISRTreeNode* wxGISRTree::ChooseSubtree(wxGISRTreeNode* pNode, const OGREnvelo
 
 void wxGISRTree::Insert(wxGISSpatialTreeData* pData)
 {
+    wxCHECK_RET(pData, wxT("The input pointer is null"));
+
 	wxCriticalSectionLocker locker(m_CritSect);
 
     wxGISRTreeNode* pNode = new wxGISRTreeNode(m_nMinChildItems, m_nMaxChildItems, pData );
+    if(pData->GetFID() != wxNOT_FOUND)
+        m_mFIDIndex[pData->GetFID()] = pNode;
+    m_nItemCount++;
+    if (m_bBulkLoad)
+    {
+        m_paBulkNodes.push_back(pNode);
+        //the collected items are packed to the subtree to search them without the full scan
+        if(m_paBulkNodes.size() >= RTREE_BULK_CHUNK_SIZE)
+        {
+            wxGISRTreeNode* pChunk = BulkLoad(m_paBulkNodes);
+            pChunk->PackDirty();
+            m_paBulkChunks.push_back(pChunk);
+            m_paBulkNodes.clear();
+        }
+        return;
+    }
+
 	if (!m_pRoot)
 	{
 		m_pRoot = new wxGISRTreeNode(m_nMinChildItems, m_nMaxChildItems);
 		m_pRoot->SetHasLeaves(true);
 	}
     InsertInternal(pNode, m_pRoot);
+    m_pRoot->PackDirty();
 }
 
 wxGISRTreeNode* wxGISRTree::InsertInternal(wxGISRTreeNode* pInsertNode, wxGISRTreeNode * pStartNode, bool bIsFirstInsert)
@@ -828,41 +1308,118 @@ void wxGISRTree::Remove(long nFID)
 {
 	wxCriticalSectionLocker locker(m_CritSect);
 
-	if (m_pRoot && m_pRoot->Remove(nFID))
-		m_pRoot = NULL;
+    wxGISRTreeFIDMap::iterator it = m_mFIDIndex.find(nFID);
+    if(it == m_mFIDIndex.end())
+        return;
+
+    RemoveNode(it->second);
+    m_mFIDIndex.erase(it);
+    m_nItemCount--;
+
+    if(m_pRoot)
+        m_pRoot->PackDirty();
+    for(size_t i = 0; i < m_paBulkChunks.size(); ++i)
+        m_paBulkChunks[i]->PackDirty();
+}
+
+void wxGISRTree::RemoveNode(wxGISRTreeNode* pNode)
+{
+    //the data node is deleted in RemoveAll as the search cursors may point to its data
+    m_paRemovedNodes.push_back(pNode);
+
+    wxGISRTreeNode* pParent = pNode->m_pParent;
+    pNode->m_pParent = NULL;
+    if(pParent == NULL)
+    {
+        //the item loaded in bulk and not indexed yet
+        wxVector<wxGISRTreeNode*>::iterator it = std::find(m_paBulkNodes.begin(), m_paBulkNodes.end(), pNode);
+        if(it != m_paBulkNodes.end())
+            m_paBulkNodes.erase(it);
+        return;
+    }
+
+    wxGISRTreeNode* pChild = pNode;
+    while(pParent)
+    {
+        wxVector<wxGISRTreeNode*>::iterator it = std::find(pParent->m_paNodes.begin(), pParent->m_paNodes.end(), pChild);
+        if(it != pParent->m_paNodes.end())
+            pParent->m_paNodes.erase(it);
+        pParent->SetPackDirty();
+        //the upper node became empty
+        if(pChild != pNode)
+            delete pChild;
+
+        if(!pParent->m_paNodes.empty())
+            break;
+        //the root is kept even empty and the next items are put to it directly
+        if(pParent->m_pParent == NULL)
+        {
+            pParent->SetHasLeaves(true);
+            break;
+        }
+        pChild = pParent;
+        pParent = pParent->m_pParent;
+    }
 }
 
 bool wxGISRTree::HasFID(long nFID) const
 {
-	if (!m_pRoot)
-		return false;
-    return m_pRoot->HasFID(nFID);
+	wxCriticalSectionLocker locker(m_CritSect);
+    return m_mFIDIndex.find(nFID) != m_mFIDIndex.end();
 }
 
 void wxGISRTree::RemoveAll()
 {
 	wxCriticalSectionLocker locker(m_CritSect);
-	if (!m_pRoot)
-		return;
-    // Delete all existing nodes
-    m_pRoot->Delete();
+    for(size_t i = 0; i < m_paBulkNodes.size(); ++i)
+        wxDELETE(m_paBulkNodes[i]);
+    m_paBulkNodes.clear();
+    for(size_t i = 0; i < m_paBulkChunks.size(); ++i)
+        wxDELETE(m_paBulkChunks[i]);
+    m_paBulkChunks.clear();
+    for(size_t i = 0; i < m_paRemovedNodes.size(); ++i)
+        wxDELETE(m_paRemovedNodes[i]);
+    m_paRemovedNodes.clear();
+    m_mFIDIndex.clear();
+    m_nItemCount = 0;
+
+    //the root may be the upper node without leaves, so it is recreated on next insert
+    wxDELETE(m_pRoot);
 }
 
 wxGISSpatialTreeCursor wxGISRTree::Search(const OGREnvelope& env)
 {
 	wxCriticalSectionLocker locker(m_CritSect);
-	if (!m_pRoot)
+	if (!m_pRoot && m_paBulkNodes.empty() && m_paBulkChunks.empty())
 		return wxNullSpatialTreeCursor;
 
     wxGISSpatialTreeCursor ret;
 
     if(env.IsInit())
     {
-        m_pRoot->Search(ret, env);
+        if(m_pRoot)
+            m_pRoot->Search(ret, env);
+        //the items loaded in bulk and packed to the subtrees
+        for(size_t i = 0; i < m_paBulkChunks.size(); ++i)
+        {
+            if(m_paBulkChunks[i]->GetBounds().Intersects(env))
+                m_paBulkChunks[i]->Search(ret, env);
+        }
+        //the rest items loaded in bulk and not indexed yet
+        for(size_t i = 0; i < m_paBulkNodes.size(); ++i)
+        {
+            if(m_paBulkNodes[i]->GetBounds().Intersects(env))
+                ret.push_back(m_paBulkNodes[i]->GetData());
+        }
     }
     else
     {
-        m_pRoot->GetAll(ret);
+        if(m_pRoot)
+            m_pRoot->GetAll(ret);
+        for(size_t i = 0; i < m_paBulkChunks.size(); ++i)
+            m_paBulkChunks[i]->GetAll(ret);
+        for(size_t i = 0; i < m_paBulkNodes.size(); ++i)
+            ret.push_back(m_paBulkNodes[i]->GetData());
     }
     return ret;
 }
@@ -877,10 +1434,9 @@ void GetGeometryBoundsFunc(const void* hFeature, CPLRectObj* pBounds)
     if(!pTreeItem)
 		return;
 
-    wxGISGeometry Geom = pTreeItem->GetGeometry();
-    if(Geom.IsOk())
+    OGREnvelope Env = pTreeItem->GetEnvelope();
+    if(Env.IsInit() || pTreeItem->GetGeometry().IsOk())
     {
-        OGREnvelope Env = Geom.GetEnvelope();
 	    if(IsDoubleEquil(Env.MinX, Env.MaxX))
 		    Env.MaxX += DELTA;
 	    if(IsDoubleEquil(Env.MinY, Env.MaxY))
@@ -900,6 +1456,7 @@ void GetGeometryBoundsFunc(const void* hFeature, CPLRectObj* pBounds)
 
 wxGISQuadTree::wxGISQuadTree(wxGISFeatureDataset* pDSet) : wxGISSpatialTree(pDSet)
 {
+    m_nRemovedCount = 0;
     CreateQuadTree();
 }
 
@@ -974,48 +1531,87 @@ void wxGISQuadTree::DestroyQuadTree()
     {
         wxDELETE(*iter);
     }*/
+    for(size_t i = 0; i < m_paRemovedData.size(); ++i)
+        wxDELETE(m_paRemovedData[i]);
+    m_paRemovedData.clear();
+    m_mFIDIndex.clear();
+    m_nRemovedCount = 0;
 }
 
 void wxGISQuadTree::Insert(wxGISSpatialTreeData* pData)
 {
     if(!pData)
         return;
-    if(!pData->GetGeometry().IsOk())
+    OGREnvelope Env = pData->GetEnvelope();
+    if(!Env.IsInit() && !pData->GetGeometry().IsOk())
         return;
 
-    m_Envelope.Merge(pData->GetGeometry().GetEnvelope());
+    wxCriticalSectionLocker locker(m_CritSect);
+
+    m_Envelope.Merge(Env);
 	CPLQuadTreeInsert(m_pQuadTree, (void*)pData);
+    if(pData->GetFID() != wxNOT_FOUND)
+        m_mFIDIndex[pData->GetFID()] = m_Cursor.size();
 	m_Cursor.push_back(pData);
 }
 
 void wxGISQuadTree::Remove(long nFID)
 {
-    wxGISSpatialTreeCursor::iterator iter;
-    for(iter = m_Cursor.begin(); iter != m_Cursor.end(); ++iter)
-    {
-		wxGISSpatialTreeData* item = *iter;
-        if(item && item->GetFID() == nFID)
-        {
-            item->SetGeometry(wxNullGeometry);
-            item->SetFID(wxNOT_FOUND);
-        }
-    }
+    wxCriticalSectionLocker locker(m_CritSect);
+
+    wxGISFIDIndexMap::iterator it = m_mFIDIndex.find(nFID);
+    if(it == m_mFIDIndex.end())
+        return;
+
+    //the CPLQuadTree cannot remove items, so the item is marked as removed until the next compaction
+    wxGISSpatialTreeData* item = m_Cursor[it->second];
+    item->SetGeometry(wxNullGeometry);
+    item->SetFID(wxNOT_FOUND);
+    m_mFIDIndex.erase(it);
+    m_nRemovedCount++;
+
+    if(m_nRemovedCount >= QUADTREE_COMPACT_MIN && m_nRemovedCount * 4 >= m_Cursor.size() && !IsLoading())
+        Compact();
 }
 
 bool wxGISQuadTree::HasFID(long nFID) const
 {
-    wxGISSpatialTreeCursor::const_iterator iter;
-    for(iter = m_Cursor.begin(); iter != m_Cursor.end(); ++iter)
+    wxCriticalSectionLocker locker(m_CritSect);
+    return m_mFIDIndex.find(nFID) != m_mFIDIndex.end();
+}
+
+void wxGISQuadTree::Compact()
+{
+    //rebuild the tree and the cursor without removed items
+    if(m_pQuadTree)
+        CPLQuadTreeDestroy(m_pQuadTree);
+    CreateQuadTree();
+
+    size_t nPos = 0;
+    for(size_t i = 0; i < m_Cursor.size(); ++i)
     {
-		wxGISSpatialTreeData* item = *iter;
-        if(item && item->GetFID() == nFID)
-            return true;
+		wxGISSpatialTreeData* item = m_Cursor[i];
+        if(NULL == item)
+            continue;
+        if(item->GetFID() == wxNOT_FOUND && !item->GetGeometry().IsOk())
+        {
+            //the search cursors and wxDS_FEATURES_ADDED events may point to the item, so it is deleted with the tree
+            m_paRemovedData.push_back(item);
+            continue;
+        }
+
+	    CPLQuadTreeInsert(m_pQuadTree, (void*)item);
+        if(item->GetFID() != wxNOT_FOUND)
+            m_mFIDIndex[item->GetFID()] = nPos;
+        m_Cursor[nPos++] = item;
     }
-    return false;
+    m_Cursor.RemoveAt(nPos, m_Cursor.size() - nPos);
+    m_nRemovedCount = 0;
 }
 
 void wxGISQuadTree::RemoveAll()
 {
+    wxCriticalSectionLocker locker(m_CritSect);
     DestroyQuadTree();
     CreateQuadTree();
 }
@@ -1040,8 +1636,12 @@ wxGISSpatialTreeCursor wxGISQuadTree::Search(const OGREnvelope& Env)
         wxGISSpatialTreeCursor retCursor;
         for(int i = 0; i < nItemCount; ++i)
         {
+            //skip removed items
+            if(ppData[i]->GetFID() == wxNOT_FOUND && !ppData[i]->GetGeometry().IsOk())
+                continue;
             retCursor.push_back(ppData[i]);
         }
+        CPLFree(ppData);
 		return retCursor;
 	}
 	else
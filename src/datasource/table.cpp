@@ -20,6 +20,7 @@
  ****************************************************************************/
 
 #include "wxgis/datasource/table.h"
+#include "wxgis/datasource/columnfilter.h"
 #include "wxgis/datasource/sysop.h"
 #include "wxgis/core/config.h"
 #include "wxgis/core/app.h"
@@ -62,6 +63,7 @@ wxGISTable::wxGISTable(const CPLString &sPath, int nSubType, OGRLayer* poLayer,
 wxGISTable::~wxGISTable(void)
 {
 	Close();
+    DeleteAttributeIndexes();
 }
 
 wxString wxGISTable::GetName(void) const
@@ -330,8 +332,11 @@ void wxGISTable::Close(void)
 	    m_poLayer = NULL;
 	    m_Encoding = wxLocale::GetSystemEncoding();
 
+        DeleteAttributeIndexes();
+
 	    m_bHasFID = false;
         m_bHasFilter = false;
+        m_sFilter.Clear();
 
         m_nFeatureCount = wxNOT_FOUND;
 
@@ -390,6 +395,8 @@ OGRErr wxGISTable::DeleteField(int nIndex)
 		return OGRERR_UNSUPPORTED_OPERATION;
     wxCriticalSectionLocker locker(m_CritSect);
     OGRErr eErr = m_poLayer->DeleteField(nIndex);
+    //the fields after deleted one are shifted
+    DeleteAttributeIndexes();
 
     //PostEvent(new wxFeatureDSEvent(wxDS_FEATURE_DELETED, nIndex)); TODO:
 
@@ -414,6 +421,7 @@ OGRErr wxGISTable::DeleteFeature(long nFID)
         return eErr;
 
 	m_nFeatureCount--;
+    UpdateAttributeIndexes(nFID, NULL);
 
     PostEvent(new wxFeatureDSEvent(wxDS_FEATURE_DELETED, nFID));
 
@@ -433,6 +441,8 @@ OGRErr wxGISTable::StoreFeature(wxGISFeature &Feature)
 
         if(!m_bHasFID && Feature.GetFID() == -1)
             Feature.SetFID(m_nFeatureCount);
+
+        UpdateAttributeIndexes(Feature.GetFID(), Feature);
     }
 
     PostEvent(new wxFeatureDSEvent(wxDS_FEATURE_ADDED, Feature.GetFID()));
@@ -464,6 +474,8 @@ OGRErr wxGISTable::SetFeature(const wxGISFeature &Feature)
 		return OGRERR_FAILURE;
 
 	OGRErr eErr = m_poLayer->SetFeature(Feature);
+    if(eErr == OGRERR_NONE)
+        UpdateAttributeIndexes(Feature.GetFID(), Feature);
 
     PostEvent(new wxFeatureDSEvent(wxDS_FEATURE_CHANGED, Feature.GetFID()));
 
@@ -567,8 +579,6 @@ wxFeatureCursor wxGISTable::Search(const wxGISQueryFilter &QFilter, bool bOnlyFi
 {
     wxCriticalSectionLocker locker(m_CritSect);
     wxFeatureCursor oOutCursor(this);
-    if(	!m_poLayer )
-		return oOutCursor;
 
     IProgressor* pProgressor(NULL);
     if (pTrackCancel)
@@ -576,7 +586,6 @@ wxFeatureCursor wxGISTable::Search(const wxGISQueryFilter &QFilter, bool bOnlyFi
         pProgressor = pTrackCancel->GetProgressor();
     }
 
-    int nCounter(0);
     int nRange = 100;
     if (NULL != pProgressor)
     {
@@ -591,92 +600,58 @@ wxFeatureCursor wxGISTable::Search(const wxGISQueryFilter &QFilter, bool bOnlyFi
         pProgressor->SetRange(nRange);
     }
 
-	OGRErr eErr;
-    if(QFilter.GetWhereClause().IsEmpty())
-	{
-        m_poLayer->ResetReading();
-		//create and fill cursor
-		OGRFeature* pFeature = NULL;
-        while((pFeature = m_poLayer->GetNextFeature()) != NULL)
-		{
-            if (pTrackCancel && !pTrackCancel->Continue())
-            {
-                wxString sErr(_("Interrupted by user"));
-                CPLString sFullErr(sErr.ToUTF8());
-                CPLError(CE_Warning, CPLE_AppDefined, sFullErr);
-
-                if (pTrackCancel)
-                {
-                    pTrackCancel->PutMessage(wxString(sFullErr), wxNOT_FOUND, enumGISMessageError);
-                }
-                oOutCursor.Reset();
-                return oOutCursor;
-            }
-
+    wxFeatureStream* pStream = SearchStream(QFilter, bOnlyFirst ? 1 : FEATURE_STREAM_BATCH_SIZE, pTrackCancel);
+    wxVector<wxGISFeature> aFeatures;
+    bool bCanceled(false);
+    while (NULL != pStream && pStream->NextBatch(aFeatures) > 0)
+    {
+        for (size_t i = 0; i < aFeatures.size(); ++i)
+        {
+            oOutCursor.Add(aFeatures[i]);
+            if (bOnlyFirst)
+                break;
+        }
 
-            if (NULL != pProgressor)
-            {
-               pProgressor->SetValue(nCounter++);
-            }
-            oOutCursor.Add(wxGISFeature(pFeature, m_Encoding, m_bRecodeToSystem));
-			if(bOnlyFirst)
-				break;
-		}
+        if (NULL != pProgressor)
+        {
+            pProgressor->SetValue(pStream->GetPosition());
+        }
 
-		oOutCursor.Reset();
-		return oOutCursor;
-	}
-    else
-	{
-		wxString sFilter = QFilter.GetWhereClause();
-		//if(!m_sCurrentFilter.IsEmpty() && !sFilter.IsEmpty())
-		//{
-		//	//combain two clauses
-		//	sFilter.Prepend(wxT("(") + m_sCurrentFilter + wxT(") AND ("));
-		//	sFilter.Append(wxT(")"));
-		//}
-        eErr = m_poLayer->SetAttributeFilter(sFilter.ToUTF8());
-		if(eErr != OGRERR_NONE)
-			return oOutCursor;
-		//create and fill cursor
-		m_poLayer->ResetReading();
-		OGRFeature* poFeature = NULL;
-		while((poFeature = m_poLayer->GetNextFeature()) != NULL )
-		{
-            if (pTrackCancel && !pTrackCancel->Continue())
-            {
-                wxString sErr(_("Interrupted by user"));
-                CPLString sFullErr(sErr.ToUTF8());
-                CPLError(CE_Warning, CPLE_AppDefined, sFullErr);
+        if (bOnlyFirst)
+            break;
 
-                if (pTrackCancel)
-                {
-                    pTrackCancel->PutMessage(wxString(sFullErr), wxNOT_FOUND, enumGISMessageError);
-                }
-                oOutCursor.Reset();
-                m_poLayer->SetAttributeFilter(NULL);
-                return oOutCursor;
-            }
+        if (pTrackCancel && !pTrackCancel->Continue())
+        {
+            bCanceled = true;
+            break;
+        }
+    }
 
-            if (NULL != pProgressor)
-            {
-                pProgressor->SetValue(nCounter++);
-            }
+    if (bCanceled)
+    {
+        wxString sErr(_("Interrupted by user"));
+        CPLString sFullErr(sErr.ToUTF8());
+        CPLError(CE_Warning, CPLE_AppDefined, sFullErr);
 
-            oOutCursor.Add(wxGISFeature(poFeature, m_Encoding, m_bRecodeToSystem));
-			if(bOnlyFirst)
-				break;
-		}
+        pTrackCancel->PutMessage(wxString(sFullErr), wxNOT_FOUND, enumGISMessageError);
+    }
 
-		oOutCursor.Reset();
+    wxDELETE(pStream);
+    oOutCursor.Reset();
+    return oOutCursor;
+}
 
-        //set full selection back
-        m_poLayer->SetAttributeFilter(NULL);
+wxFeatureStream* wxGISTable::SearchStream(const wxGISQueryFilter &QFilter, size_t nBatchSize, ITrackCancel* const pTrackCancel)
+{
+    wxCriticalSectionLocker locker(m_CritSect);
+    if (!m_poLayer)
+        return NULL;
 
-		return oOutCursor;
-	}
+    wxVector<long> anFIDs;
+    if (SelectByIndex(QFilter, anFIDs, pTrackCancel))
+        return new wxFeatureFIDStream(this, anFIDs, nBatchSize);
 
-    return oOutCursor;
+    return new wxFeatureLayerStream(this, m_poLayer, QFilter.GetWhereClause(), nBatchSize);
 }
 
 OGRFeatureDefn* const wxGISTable::GetDefinition(void) const
@@ -698,6 +673,87 @@ OGRFeatureDefn* const wxGISTable::GetDefinition(void)
     return NULL;
 }
 
+wxGISAttributeIndex* const wxGISTable::GetAttributeIndex(int nField, bool bCreate, ITrackCancel* const pTrackCancel)
+{
+    wxCriticalSectionLocker locker(m_CritSect);
+    std::map<int, wxGISAttributeIndex*>::const_iterator it = m_omAttributeIndexes.find(nField);
+    if (it != m_omAttributeIndexes.end())
+        return it->second;
+
+    if (!bCreate)
+        return NULL;
+
+    OGRFeatureDefn* const poDefn = GetDefinition();
+    if (NULL == poDefn || nField < 0 || nField >= poDefn->GetFieldCount())
+        return NULL;
+    OGRFieldDefn* const poFieldDefn = poDefn->GetFieldDefn(nField);
+    if (!wxGISAttributeIndex::IsSupportedType(poFieldDefn->GetType()) || poFieldDefn->IsIgnored())
+        return NULL;
+
+    wxGISAttributeIndex* pIndex = new wxGISAttributeIndex(nField, poFieldDefn->GetType());
+    if (!FillAttributeIndex(pIndex, pTrackCancel))
+    {
+        wxDELETE(pIndex);
+        return NULL;
+    }
+    m_omAttributeIndexes[nField] = pIndex;
+    return pIndex;
+}
+
+void wxGISTable::DeleteAttributeIndexes(void)
+{
+    wxCriticalSectionLocker locker(m_CritSect);
+    for (std::map<int, wxGISAttributeIndex*>::iterator it = m_omAttributeIndexes.begin(); it != m_omAttributeIndexes.end(); ++it)
+        wxDELETE(it->second);
+    m_omAttributeIndexes.clear();
+    m_omAttributeLookups.clear();
+}
+
+bool wxGISTable::FillAttributeIndex(wxGISAttributeIndex* const pIndex, ITrackCancel* const pTrackCancel)
+{
+    //the layer filter hides some features
+    if (NULL == m_poLayer || m_bHasFilter)
+        return false;
+    return pIndex->Fill(m_poLayer, pTrackCancel);
+}
+
+void wxGISTable::UpdateAttributeIndexes(long nFID, OGRFeature* const poFeature)
+{
+    wxCriticalSectionLocker locker(m_CritSect);
+    for (std::map<int, wxGISAttributeIndex*>::iterator it = m_omAttributeIndexes.begin(); it != m_omAttributeIndexes.end(); ++it)
+    {
+        it->second->Remove(nFID);
+        it->second->Add(nFID, poFeature);
+    }
+}
+
+bool wxGISTable::SelectByIndex(const wxGISQueryFilter &QFilter, wxVector<long> &anFIDs, ITrackCancel* const pTrackCancel)
+{
+    if (QFilter.GetWhereClause().IsEmpty())
+        return false;
+
+    //the index know nothing about spatial filter
+    if (m_poLayer && m_poLayer->GetSpatialFilter() != NULL)
+        return false;
+
+    wxGISColumnStoreFilter oFilter;
+    int nField;
+    if (!oFilter.Parse(QFilter.GetWhereClause(), GetDefinition()) || !oFilter.GetIndexField(nField))
+        return false;
+
+    //the index and the lookups counter are shared with the edit methods, the Find may sort the index
+    wxCriticalSectionLocker locker(m_CritSect);
+
+    //create the index on repeated lookups of the same field
+    bool bCreate = ++m_omAttributeLookups[nField] >= ATTRIBUTE_INDEX_AUTO_LOOKUPS;
+    wxGISAttributeIndex* const pIndex = GetAttributeIndex(nField, bCreate, pTrackCancel);
+    if (NULL == pIndex)
+        return false;
+
+    oFilter.Select(pIndex, anFIDs);
+    return true;
+}
+
 wxArrayString wxGISTable::GetFieldNames() const
 {
     wxArrayString saFields;
@@ -744,6 +800,7 @@ OGRErr wxGISTable::SetFilter(const wxGISQueryFilter &QFilter)
         m_nFeatureCount = wxNOT_FOUND;
         GetFeatureCount(true);
         m_bHasFilter = false;
+        m_sFilter.Clear();
         return eErr;
     }
     else
@@ -752,6 +809,8 @@ OGRErr wxGISTable::SetFilter(const wxGISQueryFilter &QFilter)
         m_nFeatureCount = wxNOT_FOUND;
         GetFeatureCount(true);
         m_bHasFilter = true;
+        //the layer streams set own filter while reading and restore this one
+        m_sFilter = QFilter.GetWhereClause();
         return eErr;
 	}
 }
@@ -862,10 +921,28 @@ IMPLEMENT_CLASS(wxGISTableCached, wxGISTable)
 
 wxGISTableCached::wxGISTableCached(const CPLString &sPath, int nSubType, OGRLayer* poLayer, OGRCompatibleDataSource* poDS) : wxGISTable(sPath, nSubType, poLayer, poDS)
 {
+    m_pColumnStore = NULL;
+    m_nColumnStoreRevision = 0;
+    m_bIsCaching = false;
+
+    m_bUseColumnStore = true;
+    wxGISAppConfig oConfig = GetConfig();
+    if(oConfig.IsOk())
+    {
+        m_bUseColumnStore = oConfig.ReadBool(enumGISHKCU, wxString(wxT("wxGISCommon/datasource/columnar_cache")), m_bUseColumnStore);
+    }
 }
 
 wxGISTableCached::~wxGISTableCached()
 {
+    wxDELETE(m_pColumnStore);
+}
+
+void wxGISTableCached::DeleteColumnStore(void)
+{
+    wxCriticalSectionLocker locker(m_CritSect);
+    wxDELETE(m_pColumnStore);
+    m_nColumnStoreRevision++;
 }
 
 void wxGISTableCached::Cache(ITrackCancel* const pTrackCancel)
@@ -874,9 +951,12 @@ void wxGISTableCached::Cache(ITrackCancel* const pTrackCancel)
         return;
 
     m_omFeatures.clear();
+    DeleteColumnStore();
 
     if(!m_poLayer)
         return;
+    if(m_bUseColumnStore && wxGISFeatureColumnStore::IsSupported(m_poLayer->GetLayerDefn()))
+        m_pColumnStore = new wxGISFeatureColumnStore(m_poLayer->GetLayerDefn(), m_Encoding, m_bRecodeToSystem);
     m_bIsCaching = true;
     m_poLayer->ResetReading();
 
@@ -928,7 +1008,15 @@ void wxGISTableCached::Cache(ITrackCancel* const pTrackCancel)
             nFID = poFeature->GetFID();
 
         //store features in array for speed
-        m_omFeatures[nFID] = wxGISFeature(poFeature, m_Encoding, m_bRecodeToSystem);
+        if(m_pColumnStore)
+        {
+            m_pColumnStore->Set(poFeature);
+            OGRFeature::DestroyFeature(poFeature);
+        }
+        else
+        {
+            m_omFeatures[nFID] = wxGISFeature(poFeature, m_Encoding, m_bRecodeToSystem);
+        }
 		m_nCurrentFID++;
 
 		if(pTrackCancel && !pTrackCancel->Continue())
@@ -938,7 +1026,7 @@ void wxGISTableCached::Cache(ITrackCancel* const pTrackCancel)
             m_bIsCaching = false;
 			return;
 		}
-		m_nFeatureCount = m_omFeatures.size();
+		m_nFeatureCount = m_pColumnStore ? m_pColumnStore->GetRowCount() : m_omFeatures.size();
     }
 
 
@@ -959,6 +1047,7 @@ bool wxGISTableCached::IsCaching(void) const
 void wxGISTableCached::Close(void)
 {
     m_omFeatures.clear();
+    DeleteColumnStore();
     wxGISTable::Close();
 }
 
@@ -969,6 +1058,11 @@ void wxGISTableCached::Reset(void)
 
 wxGISFeature wxGISTableCached::Next(void)
 {
+    if(m_pColumnStore)
+    {
+        return m_pColumnStore->GetFeatureByID(m_nCurrentFID++);
+    }
+
     if(m_omFeatures.empty())
     {
         return wxGISFeature();
@@ -1032,8 +1126,11 @@ OGRErr wxGISTableCached::DeleteFeature(long nFID)
         return eErr;
 
 	m_nFeatureCount--;
+    UpdateAttributeIndexes(nFID, NULL);
 
-    if(m_omFeatures[nFID].IsOk())
+    if(m_pColumnStore)
+        m_pColumnStore->Delete(nFID);
+    else if(m_omFeatures[nFID].IsOk())
 		m_omFeatures[nFID] = wxGISFeature();
 
     return eErr;
@@ -1047,7 +1144,12 @@ OGRErr wxGISTableCached::StoreFeature(wxGISFeature &Feature)
         return eErr;
     }
 
-    m_omFeatures[Feature.GetFID()] = Feature;
+    //the streams read the store under lock
+    wxCriticalSectionLocker locker(m_CritSect);
+    if(m_pColumnStore)
+        m_pColumnStore->Set(Feature);
+    else
+        m_omFeatures[Feature.GetFID()] = Feature;
     return eErr;
 }
 
@@ -1059,14 +1161,19 @@ OGRErr wxGISTableCached::SetFeature(const wxGISFeature &Feature)
         return eErr;
     }
     //TODO: if FID in feature is changed
-    m_omFeatures[Feature.GetFID()] = Feature;
+    //the streams read the store under lock
+    wxCriticalSectionLocker locker(m_CritSect);
+    if(m_pColumnStore)
+        m_pColumnStore->Set(Feature);
+    else
+        m_omFeatures[Feature.GetFID()] = Feature;
     return eErr;
 }
 
 wxGISFeature wxGISTableCached::GetFeatureByID(long nFID)
 {
     wxCriticalSectionLocker locker(m_CritSect);
-    wxGISFeature ret = m_omFeatures[nFID];
+    wxGISFeature ret = m_pColumnStore ? m_pColumnStore->GetFeatureByID(nFID) : m_omFeatures[nFID];
     if(ret.IsOk())
 		return ret;
 	else
@@ -1077,7 +1184,10 @@ wxGISFeature wxGISTableCached::GetFeatureByID(long nFID)
 		    if(pFeature)
 		    {
                 ret = wxGISFeature(pFeature, m_Encoding, m_bRecodeToSystem);
-			    m_omFeatures[nFID] = ret;
+                if(m_pColumnStore)
+                    m_pColumnStore->Set(pFeature);
+                else
+			        m_omFeatures[nFID] = ret;
 		    }
 	    }
     }
@@ -1085,118 +1195,57 @@ wxGISFeature wxGISTableCached::GetFeatureByID(long nFID)
 }
 
 
-wxFeatureCursor wxGISTableCached::Search(const wxGISQueryFilter &QFilter, bool bOnlyFirst, ITrackCancel* const pTrackCancel)
+wxFeatureStream* wxGISTableCached::SearchStream(const wxGISQueryFilter &QFilter, size_t nBatchSize, ITrackCancel* const pTrackCancel)
 {
     wxCriticalSectionLocker locker(m_CritSect);
-    wxFeatureCursor oOutCursor(this);
-
-    IProgressor* pProgressor(NULL);
-    if (pTrackCancel)
+    if (QFilter.GetWhereClause().IsEmpty())
     {
-        pProgressor = pTrackCancel->GetProgressor();
-    }
+        if (m_pColumnStore)
+            return new wxFeatureStoreStream(this, NULL, nBatchSize);
 
-    int nCounter(0);
-    int nRange = 100;
-    if (NULL != pProgressor)
-    {
-        if (bOnlyFirst)
-        {
-            nRange = 1;
-        }
-        else
+        wxVector<long> anFIDs;
+        for (std::map<long, wxGISFeature>::const_iterator it = m_omFeatures.begin(); it != m_omFeatures.end(); ++it)
         {
-            nRange = GetFeatureCount(false, pTrackCancel);
+            if (it->second.IsOk())
+                anFIDs.push_back(it->first);
         }
-        pProgressor->SetRange(nRange);
+        return new wxFeatureFIDStream(this, anFIDs, nBatchSize);
     }
 
-    OGRErr eErr;
-    if (QFilter.GetWhereClause().IsEmpty())
-    {
-        for (std::map<long, wxGISFeature>::iterator it = m_omFeatures.begin(); it != m_omFeatures.end(); ++it)
-        {
-            if (pTrackCancel && !pTrackCancel->Continue())
-            {
-                wxString sErr(_("Interrupted by user"));
-                CPLString sFullErr(sErr.ToUTF8());
-                CPLError(CE_Warning, CPLE_AppDefined, sFullErr);
+    wxVector<long> anFIDs;
+    if (SelectByIndex(QFilter, anFIDs, pTrackCancel))
+        return new wxFeatureFIDStream(this, anFIDs, nBatchSize);
 
-                if (pTrackCancel)
-                {
-                    pTrackCancel->PutMessage(wxString(sFullErr), wxNOT_FOUND, enumGISMessageError);
-                }
-                oOutCursor.Reset();
-                return oOutCursor;
-            }
-
-
-            if (NULL != pProgressor)
-            {
-                pProgressor->SetValue(nCounter++);
-            }
-            oOutCursor.Add(it->second);
-            if (bOnlyFirst)
-                break;
-        }
-
-        oOutCursor.Reset();
-        return oOutCursor;
-    }
-    else
+    //evaluate the where clause over the cached columns if possible
+    wxGISColumnStoreFilter oColumnFilter;
+    if (m_pColumnStore && oColumnFilter.Parse(QFilter.GetWhereClause(), m_pColumnStore->GetDefinition()))
     {
-        if (!m_poLayer)
-            return oOutCursor;
-        wxString sFilter = QFilter.GetWhereClause();
-        //if(!m_sCurrentFilter.IsEmpty() && !sFilter.IsEmpty())
-        //{
-        //	//combain two clauses
-        //	sFilter.Prepend(wxT("(") + m_sCurrentFilter + wxT(") AND ("));
-        //	sFilter.Append(wxT(")"));
-        //}
-        eErr = m_poLayer->SetAttributeFilter(sFilter.ToUTF8());
-        if (eErr != OGRERR_NONE)
-            return oOutCursor;
-        //create and fill cursor
-        m_poLayer->ResetReading();
-        OGRFeature* poFeature = NULL;
-        while ((poFeature = m_poLayer->GetNextFeature()) != NULL)
-        {
-            if (pTrackCancel && !pTrackCancel->Continue())
-            {
-                wxString sErr(_("Interrupted by user"));
-                CPLString sFullErr(sErr.ToUTF8());
-                CPLError(CE_Warning, CPLE_AppDefined, sFullErr);
-
-                if (pTrackCancel)
-                {
-                    pTrackCancel->PutMessage(wxString(sFullErr), wxNOT_FOUND, enumGISMessageError);
-                }
-                oOutCursor.Reset();
-                m_poLayer->SetAttributeFilter(NULL);
-                return oOutCursor;
-            }
-
-            if (NULL != pProgressor)
-            {
-                pProgressor->SetValue(nCounter++);
-            }
-
-            oOutCursor.Add(wxGISFeature(poFeature, m_Encoding, m_bRecodeToSystem));
-            if (bOnlyFirst)
-                break;
-        }
+        wxVector<wxUint32> anRowMask;
+        if (!oColumnFilter.Evaluate(m_pColumnStore, anRowMask, pTrackCancel))
+            return NULL;
+        return new wxFeatureStoreStream(this, &anRowMask, nBatchSize);
+    }
 
-        oOutCursor.Reset();
+    if (!m_poLayer)
+        return NULL;
+    return new wxFeatureLayerStream(this, m_poLayer, QFilter.GetWhereClause(), nBatchSize);
+}
+bool wxGISTableCached::FillAttributeIndex(wxGISAttributeIndex* const pIndex, ITrackCancel* const pTrackCancel)
+{
+    if (m_pColumnStore)
+        return pIndex->Fill(m_pColumnStore, pTrackCancel);
 
-        //set full selection back
-        m_poLayer->SetAttributeFilter(NULL);
+    if (!m_bIsCached)
+        return wxGISTable::FillAttributeIndex(pIndex, pTrackCancel);
 
-        return oOutCursor;
+    for (std::map<long, wxGISFeature>::iterator it = m_omFeatures.begin(); it != m_omFeatures.end(); ++it)
+    {
+        if (it->second.IsOk())
+            pIndex->Add(it->first, it->second);
     }
-
-    return oOutCursor;
+    return true;
 }
+
 //--------------------------------------------------------------------------------
 // wxGISTableQuery
 //--------------------------------------------------------------------------------
@@ -1216,6 +1265,10 @@ void wxGISTableQuery::Cache(ITrackCancel* const pTrackCancel)
 {
     if (!m_poLayer)
         return;
+    DeleteColumnStore();
+    //the store keeps the reference to the definition after the result set is released
+    if (m_bUseColumnStore && wxGISFeatureColumnStore::IsSupported(m_poLayer->GetLayerDefn()))
+        m_pColumnStore = new wxGISFeatureColumnStore(m_poLayer->GetLayerDefn(), m_Encoding, m_bRecodeToSystem);
     m_bIsCaching = true;
     m_poLayer->ResetReading();
 
@@ -1236,13 +1289,21 @@ void wxGISTableQuery::Cache(ITrackCancel* const pTrackCancel)
             nFID = poFeature->GetFID();
 
         //store features in array for speed
-        m_omFeatures[nFID] = wxGISFeature(poFeature, m_Encoding, m_bRecodeToSystem);
+        if (m_pColumnStore)
+        {
+            m_pColumnStore->Set(poFeature);
+            OGRFeature::DestroyFeature(poFeature);
+        }
+        else
+        {
+            m_omFeatures[nFID] = wxGISFeature(poFeature, m_Encoding, m_bRecodeToSystem);
+        }
         m_nCurrentFID++;
 
     }
 
 
-    m_nFeatureCount = m_omFeatures.size();
+    m_nFeatureCount = m_pColumnStore ? m_pColumnStore->GetRowCount() : m_omFeatures.size();
     m_bIsCaching = false;
     m_bIsCached = true;
 
@@ -117,3 +117,158 @@ void MoveEnvelope(OGREnvelope &MoveEnv, const OGREnvelope &Env)
 	MoveEnv.MaxY = dCenterY + dMoveHeight;
 }
 
+//Douglas-Peucker simplification
+
+static void SimplifyPoints(const OGRRawPoint* pPoints, int nPointCount, double dfSqTolerance, wxVector<bool> &abKeep)
+{
+    abKeep.clear();
+    abKeep.resize(nPointCount, false);
+    abKeep[0] = abKeep[nPointCount - 1] = true;
+
+    //the stack of not processed parts instead of recursion
+    wxVector<int> anStack;
+    anStack.push_back(0);
+    anStack.push_back(nPointCount - 1);
+    while(!anStack.empty())
+    {
+        int nLast = anStack.back();
+        anStack.pop_back();
+        int nFirst = anStack.back();
+        anStack.pop_back();
+
+        double dfDX = pPoints[nLast].x - pPoints[nFirst].x;
+        double dfDY = pPoints[nLast].y - pPoints[nFirst].y;
+        double dfSqLen = dfDX * dfDX + dfDY * dfDY;
+        double dfMaxSqDist = 0;
+        int nMax = wxNOT_FOUND;
+        for(int i = nFirst + 1; i < nLast; ++i)
+        {
+            double dfPX = pPoints[i].x - pPoints[nFirst].x;
+            double dfPY = pPoints[i].y - pPoints[nFirst].y;
+            double dfSqDist;
+            if(dfSqLen > 0)
+            {
+                //distance to the segment
+                double dfT = (dfPX * dfDX + dfPY * dfDY) / dfSqLen;
+                if(dfT > 1.0)
+                {
+                    dfPX = pPoints[i].x - pPoints[nLast].x;
+                    dfPY = pPoints[i].y - pPoints[nLast].y;
+                }
+                else if(dfT > 0.0)
+                {
+                    dfPX -= dfT * dfDX;
+                    dfPY -= dfT * dfDY;
+                }
+            }
+            dfSqDist = dfPX * dfPX + dfPY * dfPY;
+            if(dfSqDist > dfMaxSqDist)
+            {
+                dfMaxSqDist = dfSqDist;
+                nMax = i;
+            }
+        }
+
+        if(nMax != wxNOT_FOUND && dfMaxSqDist > dfSqTolerance)
+        {
+            abKeep[nMax] = true;
+            anStack.push_back(nFirst);
+            anStack.push_back(nMax);
+            anStack.push_back(nMax);
+            anStack.push_back(nLast);
+        }
+    }
+}
+
+static bool SimplifyLineString(const OGRLineString* pLine, OGRLineString* pOutLine, double dfSqTolerance, int nMinPoints)
+{
+    int nPointCount = pLine->getNumPoints();
+    if(nPointCount <= nMinPoints)
+        return false;
+
+    OGRRawPoint* pPoints = new OGRRawPoint[nPointCount];
+    pLine->getPoints(pPoints);
+
+    wxVector<bool> abKeep;
+    SimplifyPoints(pPoints, nPointCount, dfSqTolerance, abKeep);
+
+    int nKeepCount = 0;
+    for(int i = 0; i < nPointCount; ++i)
+    {
+        if(abKeep[i])
+            pPoints[nKeepCount++] = pPoints[i];
+    }
+
+    bool bResult = nKeepCount >= nMinPoints;
+    if(bResult)
+        pOutLine->setPoints(nKeepCount, pPoints);
+
+    wxDELETEA(pPoints);
+    return bResult;
+}
+
+static OGRGeometry* SimplifyOGRGeometry(const OGRGeometry* pGeom, double dfSqTolerance)
+{
+    switch(wkbFlatten(pGeom->getGeometryType()))
+    {
+    case wkbLineString:
+        {
+            OGRLineString* pOutLine = new OGRLineString();
+            if(!SimplifyLineString((const OGRLineString*)pGeom, pOutLine, dfSqTolerance, 2))
+            {
+                delete pOutLine;
+                return NULL;
+            }
+            return pOutLine;
+        }
+    case wkbPolygon:
+        {
+            const OGRPolygon* pPolygon = (const OGRPolygon*)pGeom;
+            if(pPolygon->getExteriorRing() == NULL)
+                return NULL;
+            OGRPolygon* pOutPolygon = new OGRPolygon();
+            for(int i = -1; i < pPolygon->getNumInteriorRings(); ++i)
+            {
+                const OGRLinearRing* pRing = i < 0 ? pPolygon->getExteriorRing() : pPolygon->getInteriorRing(i);
+                OGRLinearRing OutRing;
+                //the collapsed rings are kept as is
+                if(SimplifyLineString(pRing, &OutRing, dfSqTolerance, 4))
+                    pOutPolygon->addRing(&OutRing);
+                else
+                    pOutPolygon->addRing((OGRLinearRing*)pRing);
+            }
+            return pOutPolygon;
+        }
+    case wkbMultiLineString:
+    case wkbMultiPolygon:
+    case wkbGeometryCollection:
+        {
+            const OGRGeometryCollection* pCollection = (const OGRGeometryCollection*)pGeom;
+            OGRGeometryCollection* pOutCollection = (OGRGeometryCollection*)OGRGeometryFactory::createGeometry(wkbFlatten(pGeom->getGeometryType()));
+            for(int i = 0; i < pCollection->getNumGeometries(); ++i)
+            {
+                const OGRGeometry* pPart = pCollection->getGeometryRef(i);
+                OGRGeometry* pOutPart = SimplifyOGRGeometry(pPart, dfSqTolerance);
+                if(pOutPart)
+                    pOutCollection->addGeometryDirectly(pOutPart);
+                else
+                    pOutCollection->addGeometry(pPart);
+            }
+            return pOutCollection;
+        }
+    default:
+        return NULL;
+    }
+}
+
+wxGISGeometry SimplifyGeometry(const wxGISGeometry &Geom, double dfTolerance)
+{
+    OGRGeometry* pGeom = Geom;
+    if(NULL == pGeom || dfTolerance <= 0)
+        return Geom;
+
+    OGRGeometry* pOutGeom = SimplifyOGRGeometry(pGeom, dfTolerance * dfTolerance);
+    if(NULL == pOutGeom)
+        return Geom;
+    return wxGISGeometry(pOutGeom);
+}
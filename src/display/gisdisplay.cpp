@@ -72,6 +72,57 @@ wxGISDisplay::wxGISDisplay(void)
 	Clear();
 }
 
+wxGISDisplay::wxGISDisplay(wxGISDisplay* const pParentDisplay)
+{
+    wxCriticalSectionLocker locker(pParentDisplay->GetLock());
+
+	m_BackGroudnColour = pParentDisplay->m_BackGroudnColour;
+	m_oDeviceFrameRect = pParentDisplay->m_oDeviceFrameRect;
+	m_dFrameCenterX = pParentDisplay->m_dFrameCenterX;
+	m_dFrameCenterY = pParentDisplay->m_dFrameCenterY;
+	m_dFrameRatio = pParentDisplay->m_dFrameRatio;
+	m_dFrameXShift = pParentDisplay->m_dFrameXShift;
+	m_dFrameYShift = pParentDisplay->m_dFrameYShift;
+	m_dOrigin_X = pParentDisplay->m_dOrigin_X;
+	m_dOrigin_Y = pParentDisplay->m_dOrigin_Y;
+	m_dCacheCenterX = pParentDisplay->m_dCacheCenterX;
+	m_dCacheCenterY = pParentDisplay->m_dCacheCenterY;
+	m_RealBounds = pParentDisplay->m_RealBounds;
+	m_CurrentBounds = pParentDisplay->m_CurrentBounds;
+	m_CurrentBoundsRotated = pParentDisplay->m_CurrentBoundsRotated;
+	m_CurrentBoundsX8 = pParentDisplay->m_CurrentBoundsX8;
+	m_dRotatedBoundsCenterX = pParentDisplay->m_dRotatedBoundsCenterX;
+	m_dRotatedBoundsCenterY = pParentDisplay->m_dRotatedBoundsCenterY;
+	m_dAngleRad = pParentDisplay->m_dAngleRad;
+    m_dScale = pParentDisplay->m_dScale;
+    m_dfLineWidth = pParentDisplay->m_dfLineWidth;
+
+	m_pMatrix = new cairo_matrix_t;
+	m_pDisplayMatrix = new cairo_matrix_t;
+	m_pDisplayMatrixNoRotate = new cairo_matrix_t;
+    *m_pMatrix = *pParentDisplay->m_pMatrix;
+    *m_pDisplayMatrix = *pParentDisplay->m_pDisplayMatrix;
+    *m_pDisplayMatrixNoRotate = *pParentDisplay->m_pDisplayMatrixNoRotate;
+
+	//the only cache, the new image surface is transparent
+	m_nMax_X = pParentDisplay->m_nMax_X;
+	m_nMax_Y = pParentDisplay->m_nMax_Y;
+	LAYERCACHEDATA layercachedata;
+	layercachedata.bIsDerty = true;
+	layercachedata.pCairoSurface = cairo_image_surface_create (CAIRO_FORMAT_ARGB32, m_nMax_X, m_nMax_Y);
+	layercachedata.pCairoContext = cairo_create (layercachedata.pCairoSurface);
+    cairo_set_matrix (layercachedata.pCairoContext, m_pMatrix);
+	m_saLayerCaches.push_back(layercachedata);
+    m_nSysCacheCount = 1;
+    m_nLastCacheID = 0;
+	m_nCurrentLayer = 0;
+	m_bZeroCacheSet = true;
+
+	//no output from offscreen display
+	m_surface_tmp = NULL;
+	m_cr_tmp = NULL;
+}
+
 wxGISDisplay::~wxGISDisplay(void)
 {
     for(size_t i = 0; i < m_saLayerCaches.size(); ++i)
@@ -613,14 +664,23 @@ bool wxGISDisplay::DrawLine(OGRRawPoint* pOGRRawPoints, int nPointCount, bool bO
     }
 
 	ClipGeometryByEnvelope(pOGRRawPoints, &nPointCount, m_CurrentBoundsX8, !bIsRing);
+    if (nPointCount < 1)
+    {
+        if(bOwn)
+            wxDELETEA(pOGRRawPoints);
+        return false;
+    }
 
-	cairo_move_to(m_saLayerCaches[m_nCurrentLayer].pCairoContext, pOGRRawPoints[0].x + dOffsetX, pOGRRawPoints[0].y + dOffsetY);
-
-	for(int i = 1; i < nPointCount; ++i)
-	{
+    //the whole clipped vertex array goes to cairo under one lock
+    {
         wxCriticalSectionLocker locker(m_CritSect);
-        cairo_line_to(m_saLayerCaches[m_nCurrentLayer].pCairoContext, pOGRRawPoints[i].x + dOffsetX, pOGRRawPoints[i].y + dOffsetY);
-	}
+        cairo_t *pCairoContext = m_saLayerCaches[m_nCurrentLayer].pCairoContext;
+        cairo_move_to(pCairoContext, pOGRRawPoints[0].x + dOffsetX, pOGRRawPoints[0].y + dOffsetY);
+        for(int i = 1; i < nPointCount; ++i)
+        {
+            cairo_line_to(pCairoContext, pOGRRawPoints[i].x + dOffsetX, pOGRRawPoints[i].y + dOffsetY);
+        }
+    }
 
     if(bOwn)
         wxDELETEA(pOGRRawPoints);
@@ -729,6 +789,26 @@ OGREnvelope wxGISDisplay::TransformRect(wxRect &rect)
 	return out;
 }
 
+void wxGISDisplay::MergeDisplay(wxGISDisplay* const pDisplay)
+{
+    wxCHECK_RET(pDisplay, wxT("Input display pointer is NULL"));
+
+	wxCriticalSectionLocker locker(m_CritSect);
+    cairo_surface_t *pSurface = pDisplay->m_saLayerCaches[pDisplay->m_nCurrentLayer].pCairoSurface;
+    cairo_surface_flush(pSurface);
+
+    cairo_t *pCairoContext = m_saLayerCaches[m_nCurrentLayer].pCairoContext;
+	cairo_save(pCairoContext);
+
+	cairo_matrix_t mat = {1, 0, 0, 1, 0, 0};
+    cairo_set_matrix(pCairoContext, &mat);
+    cairo_set_source_surface(pCairoContext, pSurface, 0, 0);
+    cairo_set_operator(pCairoContext, CAIRO_OPERATOR_OVER);
+    cairo_paint(pCairoContext);
+
+	cairo_restore(pCairoContext);
+}
+
 void wxGISDisplay::SetRotate(double dAngleRad)
 {
 	m_dAngleRad = dAngleRad;
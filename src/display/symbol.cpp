@@ -38,6 +38,13 @@ wxGISSymbol::wxGISSymbol(const wxGISColor& Color)
     m_Color = Color;
 }
 
+wxGISSymbol::wxGISSymbol(const wxGISSymbol& Symbol) : wxObject(Symbol), wxGISPointer()
+{
+    //the copy is the new object without references
+    m_pDisplay = Symbol.m_pDisplay;
+    m_Color = Symbol.m_Color;
+}
+
 wxGISSymbol::~wxGISSymbol()
 {
 }
@@ -612,13 +619,16 @@ wxGISSimpleCollectionSymbol::wxGISSimpleCollectionSymbol() : wxGISSymbol()
 
 wxGISSimpleCollectionSymbol::wxGISSimpleCollectionSymbol(const wxGISColor& Color, wxGISSimpleMarkerSymbol* pMarkerSymbol, wxGISSimpleLineSymbol* pLineSymbol, wxGISSimpleFillSymbol* pFillSymbol) : wxGISSymbol(Color)
 {
-    m_pMarkerSymbol = pMarkerSymbol;
-    m_pLineSymbol = pLineSymbol;
-    m_pFillSymbol = pFillSymbol;
+    wsSET(m_pMarkerSymbol, pMarkerSymbol);
+    wsSET(m_pLineSymbol, pLineSymbol);
+    wsSET(m_pFillSymbol, pFillSymbol);
 }
 
 wxGISSimpleCollectionSymbol::~wxGISSimpleCollectionSymbol()
 {
+    wsDELETE(m_pMarkerSymbol);
+    wsDELETE(m_pLineSymbol);
+    wsDELETE(m_pFillSymbol);
 }
 
 void wxGISSimpleCollectionSymbol::Draw(const wxGISGeometry &Geometry, int nLevel)
@@ -683,7 +693,8 @@ void wxGISSimpleCollectionSymbol::SetupDisplay(wxGISDisplay* const pDisplay)
 
 wxGISSimpleCollectionSymbol* wxGISSimpleCollectionSymbol::Clone() const
 {
-    return new wxGISSimpleCollectionSymbol(*this);
+    //the copy should not share the sub symbols as they hold the display pointer
+    return new wxGISSimpleCollectionSymbol(GetColor(), m_pMarkerSymbol == NULL ? NULL : m_pMarkerSymbol->Clone(), m_pLineSymbol == NULL ? NULL : m_pLineSymbol->Clone(), m_pFillSymbol == NULL ? NULL : m_pFillSymbol->Clone());
 }
 
 wxGISSimpleMarkerSymbol* wxGISSimpleCollectionSymbol::GetMarkerSymbol() const
@@ -23,6 +23,7 @@
 #include "wxgis/core/format.h"
 #include "wxgis/catalog/catop.h"
 #include "wxgis/core/app.h"
+#include "wxgis/core/config.h"
 
 #include "wxgisdefs.h"
 
@@ -32,160 +33,546 @@
 
 #include <wx/fontmap.h>
 #include <wx/encconv.h>
+#include <wx/msgqueue.h>
+
+#include <map>
 
 #define MAX_FEATURES_FORINSERT 1000
+#define COPY_ROWS_BATCH_SIZE 10000
 
-bool CopyRows(wxGISTable* const pSrcDataSet, wxGISTable* const pDstDataSet, const wxVector<ST_FIELD_MAP> &staFieldMap, ITrackCancel* const pTrackCancel)
+/** \enum wxGISEnumCopyFieldMethod gpvector.cpp
+    \brief The way CopyRows copy the field value
+*/
+enum wxGISEnumCopyFieldMethod
 {
-    //progress & messages
-    IProgressor* pProgressor(NULL);
-    if (pTrackCancel)
+    enumGISCopyFieldRaw = 0,        //the same type and encoding, the OGRField is copied as is
+    enumGISCopyFieldRecode,         //the string in other encoding
+    enumGISCopyFieldStringList,     //the string list in other encoding
+    enumGISCopyFieldAsString        //the types differ, the value is converted by OGR from string
+};
+
+typedef struct _copy_field_plan
+{
+    int nDstFieldNo;
+    int nSrsFieldNo;
+    wxGISEnumCopyFieldMethod eMethod;
+} COPY_FIELD_PLAN;
+
+/** \fn void PrepareCopyFieldPlan(wxGISTable* const pSrcDataSet, wxGISTable* const pDstDataSet, const wxVector<ST_FIELD_MAP> &staFieldMap, wxVector<COPY_FIELD_PLAN> &astPlan)
+ *  \brief Resolve the copy method of each mapped field once before the rows loop
+ */
+static void PrepareCopyFieldPlan(wxGISTable* const pSrcDataSet, wxGISTable* const pDstDataSet, const wxVector<ST_FIELD_MAP> &staFieldMap, wxVector<COPY_FIELD_PLAN> &astPlan)
+{
+#ifdef CPL_RECODE_ICONV
+    //OGR returns the strings in UTF-8
+    bool bSameEncoding = true;
+#else
+    bool bSameEncoding = pSrcDataSet->GetEncoding() == pDstDataSet->GetEncoding();
+#endif //CPL_RECODE_ICONV
+
+    OGRFeatureDefn *poSrcDefn = pSrcDataSet->GetDefinition();
+    OGRFeatureDefn *poDstDefn = pDstDataSet->GetDefinition();
+
+    astPlan.clear();
+    astPlan.reserve(staFieldMap.size());
+    for (size_t i = 0; i < staFieldMap.size(); ++i)
+    {
+        COPY_FIELD_PLAN stPlan = { (int)staFieldMap[i].nDstFieldNo, (int)staFieldMap[i].nSrsFieldNo, enumGISCopyFieldRaw };
+
+        OGRFieldDefn *poSrcField = NULL == poSrcDefn ? NULL : poSrcDefn->GetFieldDefn(stPlan.nSrsFieldNo);
+        OGRFieldDefn *poDstField = NULL == poDstDefn ? NULL : poDstDefn->GetFieldDefn(stPlan.nDstFieldNo);
+        OGRFieldType eSrcType = NULL == poSrcField ? staFieldMap[i].eFieldType : poSrcField->GetType();
+        OGRFieldType eDstType = NULL == poDstField ? eSrcType : poDstField->GetType();
+
+        if (eSrcType == OFTString && !bSameEncoding)
+        {
+            stPlan.eMethod = enumGISCopyFieldRecode;
+        }
+        else if (eSrcType == OFTStringList && !bSameEncoding)
+        {
+            stPlan.eMethod = enumGISCopyFieldStringList;
+        }
+        else if (eSrcType != eDstType)
+        {
+            //the driver changed the field type on create (e.g. date time to date or string)
+            stPlan.eMethod = enumGISCopyFieldAsString;
+        }
+        astPlan.push_back(stPlan);
+    }
+}
+
+/** \fn void CopyFields(const wxGISFeature &SrcFeature, wxGISFeature &DstFeature, const wxVector<COPY_FIELD_PLAN> &astPlan, wxEncodingConverter* const pEncConverter)
+ *  \brief Copy the feature fields by plan. The null values are left unset.
+ */
+static void CopyFields(const wxGISFeature &SrcFeature, wxGISFeature &DstFeature, const wxVector<COPY_FIELD_PLAN> &astPlan, wxEncodingConverter* const pEncConverter)
+{
+#ifndef CPL_RECODE_ICONV
+    char szMaxStr[4096];
+#endif //CPL_RECODE_ICONV
+
+    for (size_t i = 0; i < astPlan.size(); ++i)
     {
-        pProgressor = pTrackCancel->GetProgressor();
+        const COPY_FIELD_PLAN &stPlan = astPlan[i];
+        if (stPlan.eMethod == enumGISCopyFieldRaw)
+        {
+            DstFeature.SetField(stPlan.nDstFieldNo, SrcFeature.GetRawField(stPlan.nSrsFieldNo));
+            continue;
+        }
+
+        if (!SrcFeature.IsFieldSet(stPlan.nSrsFieldNo))
+            continue;
+
+        switch (stPlan.eMethod)
+        {
+        case enumGISCopyFieldStringList:
+            DstFeature.SetField(stPlan.nDstFieldNo, SrcFeature.GetFieldAsStringList(stPlan.nSrsFieldNo));
+            break;
+        case enumGISCopyFieldAsString:
+            DstFeature.SetField(stPlan.nDstFieldNo, SrcFeature.GetFieldAsChar(stPlan.nSrsFieldNo));
+            break;
+        case enumGISCopyFieldRecode:
+        default:
+#ifndef CPL_RECODE_ICONV
+            if (NULL != pEncConverter && pEncConverter->Convert(SrcFeature.GetFieldAsChar(stPlan.nSrsFieldNo), szMaxStr))
+            {
+                DstFeature.SetField(stPlan.nDstFieldNo, szMaxStr);
+                break;
+            }
+#endif //CPL_RECODE_ICONV
+            DstFeature.SetField(stPlan.nDstFieldNo, SrcFeature.GetFieldAsString(stPlan.nSrsFieldNo));
+            break;
+        };
     }
+}
 
-    int nCounter(0);
-    if (pProgressor)
+/** \fn int GetCopyRowsBatchSize(void)
+ *  \brief The count of features stored in one transaction. Zero or less means the one transaction for all features.
+ */
+static int GetCopyRowsBatchSize(void)
+{
+    int nBatchSize = COPY_ROWS_BATCH_SIZE;
+    wxGISAppConfig oConfig = GetConfig();
+    if (oConfig.IsOk())
     {
-        pProgressor->SetRange(pSrcDataSet->GetFeatureCount(false, pTrackCancel));
+        nBatchSize = oConfig.ReadInt(enumGISHKCU, wxString(wxT("wxGISCommon/gp/copy_batch_size")), nBatchSize);
     }
+    return nBatchSize;
+}
 
-    wxFontEncoding OutputEncoding = pDstDataSet->GetEncoding();
+/** \fn bool CommitCopyRows(wxGISTable* const pDstDataSet, ITrackCancel* const pTrackCancel)
+ *  \brief Commit the current transaction of CopyRows and report the error. The failed transaction is rolled back as some drivers keep it open.
+ */
+static bool CommitCopyRows(wxGISTable* const pDstDataSet, ITrackCancel* const pTrackCancel)
+{
     CPLErrorReset();
+    if (pDstDataSet->CommitTransaction() != OGRERR_NONE)
+    {
+        wxString sErr(_("Error commit transaction!"));
+        wxGISLogError(sErr, wxString::FromUTF8(CPLGetLastErrorMsg()), wxEmptyString, pTrackCancel);
+        pDstDataSet->RollbackTransaction();
+        return false;
+    }
+    return true;
+}
 
-    //create src -> dst field mapping
+/** \def COPY_ROWS_CHUNK_SIZE gpvector.cpp
+    \brief The count of features passed to the copy thread at once
+*/
+#define COPY_ROWS_CHUNK_SIZE 256
 
-    OGRFeatureDefn *pFeatureDefn = pDstDataSet->GetDefinition();
+//-----------------------------------------------------------------------------
+// wxGISCopyRowsWriter
+//-----------------------------------------------------------------------------
 
-    if (NULL == pFeatureDefn)
+/** \fn bool DeletePartialOutput(wxGISTable* const pDstDataSet, const CPLString &sPath, const wxString &sName, wxGxObjectFilter* const pFilter)
+ *  \brief Remove the output of failed or cancelled export. The dataset path is the output directory (and the PostGIS output has no file), so the layer is deleted through its datasource and the new file is deleted by the driver.
+ */
+static bool DeletePartialOutput(wxGISTable* const pDstDataSet, const CPLString &sPath, const wxString &sName, wxGxObjectFilter* const pFilter)
+{
+    bool bIsDB = (pFilter->GetType() == enumGISFeatureDataset && pFilter->GetSubType() == enumVecPostGIS) || (pFilter->GetType() == enumGISTable && pFilter->GetSubType() == enumTablePostgres);
+    if (!bIsDB)
     {
-        if (pTrackCancel)
+        pDstDataSet->Close();
+
+        CPLString szFullPath = sPath;
+        if (!sName.IsEmpty())
         {
-            pTrackCancel->PutMessage(_("Input dataset is corrupt"), wxNOT_FOUND, enumGISMessageError);
+            szFullPath = CPLFormFilename(sPath, sName.ToUTF8(), pFilter->GetExt().ToUTF8());
         }
+
+        CPLErrorReset();
+        OGRCompatibleDriver *poDriver = GetOGRCompatibleDriverByName(pFilter->GetDriver().mb_str());
+        if (NULL != poDriver && poDriver->DeleteOGRCompatibleDataSource(szFullPath))
+            return true;
+        //the driver without delete support, the output is the single file
+        VSIStatBufL sStatBuf;
+        return VSIStatL(szFullPath, &sStatBuf) != 0 || VSIUnlink(szFullPath) == 0;
+    }
+
+    OGRCompatibleDataSource* poDS = pDstDataSet->GetDataSourceRef();
+    OGRLayer* poLayer = pDstDataSet->GetLayerRef();
+    if (NULL == poDS || NULL == poLayer)
+    {
+        pDstDataSet->Close();
         return false;
     }
 
-#ifndef CPL_RECODE_ICONV
-    wxEncodingConverter oEncConverter;
-    bool bFastConv = oEncConverter.Init(pSrcDataSet->GetEncoding(), pDstDataSet->GetEncoding(), wxCONVERT_SUBSTITUTE);
-    char szMaxStr[4096];
-#endif
+    int nLayer = wxNOT_FOUND;
+    for (int i = 0; i < poDS->GetLayerCount(); ++i)
+    {
+        if (poDS->GetLayer(i) == poLayer)
+        {
+            nLayer = i;
+            break;
+        }
+    }
 
-    pSrcDataSet->Reset();
-    wxGISFeature Feature;
-    size_t i;
-    OGRwkbGeometryType eGeoFieldtype = pFeatureDefn->GetGeomType();
-    while ((Feature = pSrcDataSet->Next()).IsOk())
+    //keep the datasource opened after the table closed
+    poDS->Reference();
+    pDstDataSet->Close();
+
+    CPLErrorReset();
+    bool bRes = nLayer != wxNOT_FOUND && poDS->DeleteLayer(nLayer) == OGRERR_NONE;
+
+    if (poDS->Dereference() <= 0)
     {
-        if (pTrackCancel && !pTrackCancel->Continue())
+        OGRCompatibleClose(poDS);
+    }
+    return bRes;
+}
+
+/** @class wxGISCopyRowsWriter
+
+    Store the destination features of CopyRows in transaction batches and show the progress.
+
+    @library{gp}
+*/
+
+class wxGISCopyRowsWriter
+{
+public:
+    wxGISCopyRowsWriter(wxGISTable* const pDstDataSet, long nFeatureCount, ITrackCancel* const pTrackCancel) : m_pDstDataSet(pDstDataSet), m_pTrackCancel(pTrackCancel)
+    {
+        m_pProgressor = NULL;
+        if (m_pTrackCancel)
         {
-            wxString sErr(_("Interrupted by user"));
-            CPLString sFullErr(sErr.ToUTF8());
-            CPLError(CE_Warning, CPLE_AppDefined, sFullErr);
+            m_pProgressor = m_pTrackCancel->GetProgressor();
+        }
+        if (m_pProgressor)
+        {
+            m_pProgressor->SetRange(nFeatureCount);
+        }
+        m_nCounter = 0;
+        m_nBatchSize = GetCopyRowsBatchSize();
+        m_nBatchCount = 0;
+        m_bTransaction = m_pDstDataSet->StartTransaction() == OGRERR_NONE;
+    }
+    /** \fn bool Write(long nSrcFID, wxGISFeature &Feature)
+     *  \brief Store the feature. The invalid feature (skipped one) only moves the progress.
+     *  \return false if the transaction commit failed
+     */
+    bool Write(long nSrcFID, wxGISFeature &Feature)
+    {
+        if (Feature.IsOk())
+        {
+            OGRErr eErr = m_pDstDataSet->StoreFeature(Feature);
+            if (eErr != OGRERR_NONE)
+            {
+                wxString sErr = wxString::Format(_("Error create feature!\nSource feature FID:%ld"), nSrcFID);
+                wxGISLogError(sErr, wxString::FromUTF8(CPLGetLastErrorMsg()), wxEmptyString, m_pTrackCancel);
+            }
 
-            if (pTrackCancel)
+            if (m_bTransaction && m_nBatchSize > 0 && ++m_nBatchCount >= m_nBatchSize)
             {
-                pTrackCancel->PutMessage(wxString(sFullErr, wxConvUTF8), wxNOT_FOUND, enumGISMessageError);
+                m_nBatchCount = 0;
+                if (!CommitCopyRows(m_pDstDataSet, m_pTrackCancel))
+                {
+                    m_bTransaction = false;
+                    return false;
+                }
+                m_bTransaction = m_pDstDataSet->StartTransaction() == OGRERR_NONE;
             }
+        }
+
+        if (m_pProgressor)
+        {
+            m_pProgressor->SetValue(m_nCounter++);
+        }
+        return true;
+    }
+    /** \fn bool End(bool bCommit)
+     *  \brief Commit or rollback the last transaction
+     */
+    bool End(bool bCommit)
+    {
+        if (!m_bTransaction)
+            return bCommit;
+        m_bTransaction = false;
+        if (bCommit)
+            return CommitCopyRows(m_pDstDataSet, m_pTrackCancel);
+        m_pDstDataSet->RollbackTransaction();
+        return false;
+    }
+protected:
+    wxGISTable* m_pDstDataSet;
+    ITrackCancel* m_pTrackCancel;
+    IProgressor* m_pProgressor;
+    int m_nCounter;
+    int m_nBatchSize, m_nBatchCount;
+    bool m_bTransaction;
+};
+
+//-----------------------------------------------------------------------------
+// wxGISFeatureCopier
+//-----------------------------------------------------------------------------
+
+/** @class wxGISFeatureCopier
+
+    Fill the destination feature from the source one: filter, coerce and project the geometry and copy the fields by plan.
+    The coordinate transformation and encoding converter are not thread safe, so each copy thread has own copier. The copier does not touch the datasets and the track cancel, the warnings are collected to the array.
+
+    @library{gp}
+*/
+
+class wxGISFeatureCopier
+{
+public:
+    wxGISFeatureCopier(wxGISFeatureDataset* const pSrcDataSet, wxGISFeatureDataset* const pDstDataSet, const wxVector<ST_FIELD_MAP> &staFieldMap, const wxVector<COPY_FIELD_PLAN> &astPlan, OGRwkbGeometryType eFilterGeomType, bool bToMulti, wxDword eSkipGeometry) : m_staFieldMap(staFieldMap), m_astPlan(astPlan)
+    {
+        m_eFilterGeomType = eFilterGeomType;
+        m_bToMulti = bToMulti;
+        m_eSkipGeometry = eSkipGeometry;
+        m_eGeoFieldType = wkbUnknown;
+        OGRFeatureDefn *pFeatureDefn = pDstDataSet->GetDefinition();
+        if (NULL != pFeatureDefn)
+        {
+            m_eGeoFieldType = pFeatureDefn->GetGeomType();
+        }
+        m_bDXF = pDstDataSet->GetSubType() == enumVecDXF;
+
+        m_poCT = NULL;
+        const wxGISSpatialReference oSrcSRS = pSrcDataSet->GetSpatialReference();
+        const wxGISSpatialReference oDstSRS = pDstDataSet->GetSpatialReference();
+        if (oSrcSRS.IsOk() && oDstSRS.IsOk() && !oSrcSRS.IsSame(oDstSRS))
+        {
+            m_poCT = OGRCreateCoordinateTransformation(oSrcSRS, oDstSRS);
+        }
+
+        m_pEncConverter = NULL;
+#ifndef CPL_RECODE_ICONV
+        if (m_oEncConverter.Init(pSrcDataSet->GetEncoding(), pDstDataSet->GetEncoding(), wxCONVERT_SUBSTITUTE))
+        {
+            m_pEncConverter = &m_oEncConverter;
+        }
+#endif //CPL_RECODE_ICONV
+    }
+    ~wxGISFeatureCopier()
+    {
+        if (NULL != m_poCT)
+        {
+            OCTDestroyCoordinateTransformation(m_poCT);
+        }
+    }
+    /** \fn bool Copy(const wxGISFeature &Feature, wxGISFeature &newFeature, wxArrayString &saWarnings)
+     *  \brief Fill the destination feature
+     *  \return false if the source feature is skipped
+     */
+    bool Copy(const wxGISFeature &Feature, wxGISFeature &newFeature, wxArrayString &saWarnings)
+    {
+        //set geometry
+        wxGISGeometry Geom = Feature.GetGeometry();
+        bool bSkip = false;
+        if ((m_eSkipGeometry & enumGISSkipEmptyGeometry) && !Geom.IsOk())
+            bSkip = true;
+        else if ((m_eSkipGeometry & enumGISSkipInvalidGeometry) && !Geom.IsValid())
+            bSkip = true;
 
+        if (bSkip)
+        {
+            saWarnings.Add(wxString::Format(_("Skip feature id %ld with empty or invalid geometry"), Feature.GetFID()));
             return false;
         }
 
+        OGRGeometry *pNewGeom = NULL;
+        OGRwkbGeometryType eGeomType = Geom.GetType();
+        if (m_eFilterGeomType != wkbUnknown)
+        {
+            OGRwkbGeometryType eTestGeomType = eGeomType;
+            if (m_bToMulti && wkbFlatten(eGeomType) > 1 && wkbFlatten(eGeomType) < 4)
+            {
+                eTestGeomType = (OGRwkbGeometryType)(eGeomType + 3);
+            }
 
-        wxGISFeature newFeature = pDstDataSet->CreateFeature();
+            if (m_eFilterGeomType != eTestGeomType)
+            {
+                return false;
+            }
+        }
 
-        for (i = 0; i < staFieldMap.size(); ++i)
+        if (m_eGeoFieldType != eGeomType)
         {
-            switch (staFieldMap[i].eFieldType)
+            switch (wkbFlatten(m_eGeoFieldType))
             {
-            case OFTRealList:
-                newFeature.SetField(staFieldMap[i].nDstFieldNo, Feature.GetFieldAsDoubleList(staFieldMap[i].nSrsFieldNo));
+            case wkbLineString:
+                pNewGeom = OGRGeometryFactory::forceToLineString(Geom.Copy());
                 break;
-            case OFTIntegerList:
-                newFeature.SetField(staFieldMap[i].nDstFieldNo, Feature.GetFieldAsIntegerList(staFieldMap[i].nSrsFieldNo));
+            case wkbPolygon:
+                pNewGeom = OGRGeometryFactory::forceToPolygon(Geom.Copy());
                 break;
-            case OFTStringList:
-                newFeature.SetField(staFieldMap[i].nDstFieldNo, Feature.GetFieldAsStringList(staFieldMap[i].nSrsFieldNo));
+            case wkbMultiPoint:
+                pNewGeom = OGRGeometryFactory::forceToMultiPoint(Geom.Copy());
                 break;
-            case OFTDate:
-            case OFTTime:
-            case OFTDateTime:
-                //                    newFeature.SetField(staFieldMap[i].nDstFieldNo, Feature.GetFieldAsDateTime(staFieldMap[i].nSrsFieldNo));
-                //                    break;
-            case OFTReal:
-                //                    newFeature.SetField(staFieldMap[i].nDstFieldNo, Feature.GetFieldAsDouble(staFieldMap[i].nSrsFieldNo));
-                //                    break;
-            case OFTInteger:
-                //                    newFeature.SetField(staFieldMap[i].nDstFieldNo, Feature.GetFieldAsInteger(staFieldMap[i].nSrsFieldNo));
-                newFeature.SetField(staFieldMap[i].nDstFieldNo, Feature.GetRawField(staFieldMap[i].nSrsFieldNo));
+            case wkbMultiLineString:
+                pNewGeom = OGRGeometryFactory::forceToMultiLineString(Geom.Copy());
                 break;
-            case OFTString:
-#ifdef CPL_RECODE_ICONV
-                //                    newFeature.SetField(staFieldMap[i].nDstFieldNo, Feature.GetFieldAsString(staFieldMap[i].nSrsFieldNo));
-                //                    newFeature.SetField(staFieldMap[i].nDstFieldNo, Feature.GetFieldAsChar(staFieldMap[i].nSrsFieldNo));
-                //                    break;
-#else
-                if (bFastConv)
-                {
-                    const char* pszStr = Feature.GetFieldAsChar(staFieldMap[i].nSrsFieldNo);
-                    if (oEncConverter.Convert(pszStr, szMaxStr))
-                    {
-                        newFeature.SetField(staFieldMap[i].nDstFieldNo, szMaxStr);
-                        break;
-                    }
-                }
-#endif //CPL_RECODE_ICONV
+            case wkbMultiPolygon:
+                pNewGeom = OGRGeometryFactory::forceToMultiPolygon(Geom.Copy());
+                break;
+            case wkbPoint:
             default:
-                //TODO: recode to output encoding if pDstDataSet encoding diffes from src
-                newFeature.SetField(staFieldMap[i].nDstFieldNo, Feature.GetFieldAsString(staFieldMap[i].nSrsFieldNo));
-                //                    newFeature.SetField(staFieldMap[i].nDstFieldNo, Feature.GetFieldAsString(staFieldMap[i].nSrsFieldNo));
+                pNewGeom = Geom.Copy();
                 break;
             };
         }
+        else
+        {
+            pNewGeom = Geom.Copy();
+        }
 
-        OGRErr eErr = pDstDataSet->StoreFeature(newFeature);
-        if (eErr != OGRERR_NONE)
+        if (NULL != m_poCT && NULL != pNewGeom)
         {
-            wxString sErr = wxString::Format(_("Error create feature!\nSource feature FID:%ld"), Feature.GetFID());
-			wxGISLogError(sErr, wxString::FromUTF8(CPLGetLastErrorMsg()), wxEmptyString, pTrackCancel);
+            if (eGeomType != wkbUnknown && eGeomType != wkbNone)
+            {
+                OGRErr eErr = pNewGeom->transform(m_poCT);
+                if (eErr != OGRERR_NONE)
+                {
+                    saWarnings.Add(wxString::Format(_("Geometry transform failed\nFeature id %ld"), Feature.GetFID()));
+                }
+            }
         }
 
-        if (pProgressor)
+        newFeature.SetGeometryDirectly(wxGISGeometry(pNewGeom, false));
+
+        if (m_bDXF)
         {
-            pProgressor->SetValue(nCounter++);
+            wxString sFieldText;
+            //    //LABEL(f:"Arial, Helvetica", s:12pt, t:"Hello World!")
+            for (size_t i = 0; i < m_staFieldMap.size(); ++i)
+            {
+                sFieldText += Feature.GetFieldAsString(m_staFieldMap[i].nSrsFieldNo);
+                sFieldText.Append(wxT("\n"));
+            }
+            wxString sStyleLabel = wxString::Format(wxT("LABEL(f:\"Arial, Helvetica\", s:12pt, t:\"%s\")"), sFieldText.c_str());
+            newFeature.SetStyleString(sStyleLabel);
         }
+        else
+        {
+            CopyFields(Feature, newFeature, m_astPlan, m_pEncConverter);
+        }
+        return true;
     }
+protected:
+    wxVector<ST_FIELD_MAP> m_staFieldMap;
+    wxVector<COPY_FIELD_PLAN> m_astPlan;
+    OGRwkbGeometryType m_eFilterGeomType, m_eGeoFieldType;
+    bool m_bToMulti, m_bDXF;
+    wxDword m_eSkipGeometry;
+    OGRCoordinateTransformation *m_poCT;
+    wxEncodingConverter* m_pEncConverter;
+#ifndef CPL_RECODE_ICONV
+    wxEncodingConverter m_oEncConverter;
+#endif //CPL_RECODE_ICONV
+};
 
-    return true;
-}
+//-----------------------------------------------------------------------------
+// wxGISCopyRowsThread
+//-----------------------------------------------------------------------------
 
-bool CopyRows(wxGISFeatureDataset* const pSrcDataSet, wxGISFeatureDataset* const pDstDataSet, const wxVector<ST_FIELD_MAP> &staFieldMap, OGRwkbGeometryType eFilterGeomType, bool bToMulti, wxDword eSkipGeometry, ITrackCancel* const pTrackCancel)
+/** \struct COPY_ROWS_CHUNK gpvector.cpp
+    \brief The features passed to the copy thread. The chunk owns the only references of the features, so the features are never shared between threads.
+*/
+typedef struct _copy_rows_chunk
 {
-    const wxGISSpatialReference oSrcSRS = pSrcDataSet->GetSpatialReference();
-    const wxGISSpatialReference oDstSRS = pDstDataSet->GetSpatialReference();
-    OGRCoordinateTransformation *poCT = NULL;
+    size_t nSequence;
+    wxVector<wxGISFeature> aSrcFeatures;  //detached clones of source features
+    wxVector<wxGISFeature> aDstFeatures;  //created by the reading thread, filled by copy thread
+    wxVector<bool> abCopied;              //false for the skipped feature
+    wxArrayString saWarnings;
+} COPY_ROWS_CHUNK;
+
+/** @class wxGISCopyRowsThread
+
+    The thread filling the destination features of the chunks. The chunks are received from input queue and posted to output queue. The thread exits on NULL chunk.
+    The thread never touches the datasets, the track cancel and the features reference counters, all of them are used by the reading thread only.
 
-    if (oSrcSRS.IsOk() && oDstSRS.IsOk() && !oSrcSRS.IsSame(oDstSRS))
+    @library{gp}
+*/
+
+class wxGISCopyRowsThread : public wxThread
+{
+public:
+    wxGISCopyRowsThread(wxMessageQueue<COPY_ROWS_CHUNK*> &InQueue, wxMessageQueue<COPY_ROWS_CHUNK*> &OutQueue, wxGISFeatureCopier* pCopier) : wxThread(wxTHREAD_JOINABLE), m_InQueue(InQueue), m_OutQueue(OutQueue)
     {
-        poCT = OGRCreateCoordinateTransformation(oSrcSRS, oDstSRS);
+        m_pCopier = pCopier;
     }
+    virtual ~wxGISCopyRowsThread()
+    {
+        wxDELETE(m_pCopier);
+    }
+    virtual void *Entry()
+    {
+        while (true)
+        {
+            COPY_ROWS_CHUNK* pChunk(NULL);
+            if (m_InQueue.Receive(pChunk) != wxMSGQUEUE_NO_ERROR || pChunk == NULL)
+                break;
 
-    //progress & messages
-    IProgressor* pProgressor(NULL);
-    if(pTrackCancel)
+            for (size_t i = 0; i < pChunk->aSrcFeatures.size(); ++i)
+            {
+                pChunk->abCopied[i] = m_pCopier->Copy(pChunk->aSrcFeatures[i], pChunk->aDstFeatures[i], pChunk->saWarnings);
+            }
+
+            m_OutQueue.Post(pChunk);
+        }
+        return NULL;
+    }
+protected:
+    wxMessageQueue<COPY_ROWS_CHUNK*> &m_InQueue;
+    wxMessageQueue<COPY_ROWS_CHUNK*> &m_OutQueue;
+    wxGISFeatureCopier* m_pCopier;
+};
+
+/** \fn static bool WriteCopyRowsChunk(wxGISCopyRowsWriter &Writer, COPY_ROWS_CHUNK* const pChunk, ITrackCancel* const pTrackCancel)
+ *  \brief Report the chunk warnings and store the copied features. Called by the reading thread.
+ *  \return false if the transaction commit failed
+ */
+static bool WriteCopyRowsChunk(wxGISCopyRowsWriter &Writer, COPY_ROWS_CHUNK* const pChunk, ITrackCancel* const pTrackCancel)
+{
+    if (pTrackCancel)
     {
-       pProgressor = pTrackCancel->GetProgressor();
+        for (size_t i = 0; i < pChunk->saWarnings.GetCount(); ++i)
+        {
+            pTrackCancel->PutMessage(pChunk->saWarnings[i], wxNOT_FOUND, enumGISMessageWarning);
+        }
     }
 
-    int nCounter(0);
-    if (pProgressor)
+    wxGISFeature InvalidFeature;
+    for (size_t i = 0; i < pChunk->aDstFeatures.size(); ++i)
     {
-        pProgressor->SetRange(pSrcDataSet->GetFeatureCount(false, pTrackCancel));
+        if (!Writer.Write(pChunk->aSrcFeatures[i].GetFID(), pChunk->abCopied[i] ? pChunk->aDstFeatures[i] : InvalidFeature))
+            return false;
     }
+    return true;
+}
 
-    wxFontEncoding OutputEncoding = pDstDataSet->GetEncoding();
+//-----------------------------------------------------------------------------
+// CopyRows
+//-----------------------------------------------------------------------------
+
+bool CopyRows(wxGISTable* const pSrcDataSet, wxGISTable* const pDstDataSet, const wxVector<ST_FIELD_MAP> &staFieldMap, ITrackCancel* const pTrackCancel)
+{
     CPLErrorReset();
+
     //create src -> dst field mapping
 
     OGRFeatureDefn *pFeatureDefn = pDstDataSet->GetDefinition();
@@ -199,222 +586,236 @@ bool CopyRows(wxGISFeatureDataset* const pSrcDataSet, wxGISFeatureDataset* const
         return false;
     }
 
+    //precompute the field copy methods
+    wxVector<COPY_FIELD_PLAN> astPlan;
+    PrepareCopyFieldPlan(pSrcDataSet, pDstDataSet, staFieldMap, astPlan);
+
+    wxEncodingConverter* pEncConverter = NULL;
 #ifndef CPL_RECODE_ICONV
     wxEncodingConverter oEncConverter;
-    bool bFastConv = oEncConverter.Init(pSrcDataSet->GetEncoding(), pDstDataSet->GetEncoding(), wxCONVERT_SUBSTITUTE);
-    char szMaxStr[4096];
-#endif
+    if (oEncConverter.Init(pSrcDataSet->GetEncoding(), pDstDataSet->GetEncoding(), wxCONVERT_SUBSTITUTE))
+    {
+        pEncConverter = &oEncConverter;
+    }
+#endif //CPL_RECODE_ICONV
 
-    pSrcDataSet->Reset();
-    wxGISFeature Feature;
-    size_t i;
-    OGRwkbGeometryType eGeoFieldtype = pFeatureDefn->GetGeomType();
-    while ((Feature = pSrcDataSet->Next()).IsOk())
+    //store the features in transaction batches & show progress
+    wxGISCopyRowsWriter Writer(pDstDataSet, pSrcDataSet->GetFeatureCount(false, pTrackCancel), pTrackCancel);
+
+    wxFeatureStream* pStream = pSrcDataSet->SearchStream();
+    wxVector<wxGISFeature> aFeatures;
+    while (NULL != pStream && pStream->NextBatch(aFeatures) > 0)
     {
-        if(pTrackCancel && !pTrackCancel->Continue())
+        if (pTrackCancel && !pTrackCancel->Continue())
         {
             wxString sErr(_("Interrupted by user"));
             CPLString sFullErr(sErr.ToUTF8());
-            CPLError( CE_Warning, CPLE_AppDefined, sFullErr );
+            CPLError(CE_Warning, CPLE_AppDefined, sFullErr);
 
             if (pTrackCancel)
             {
                 pTrackCancel->PutMessage(wxString(sFullErr, wxConvUTF8), wxNOT_FOUND, enumGISMessageError);
             }
 
+            wxDELETE(pStream);
+            Writer.End(false);
             return false;
         }
 
+        for (size_t i = 0; i < aFeatures.size(); ++i)
+        {
+            wxGISFeature newFeature = pDstDataSet->CreateFeature();
 
-        wxGISFeature newFeature = pDstDataSet->CreateFeature();
+            CopyFields(aFeatures[i], newFeature, astPlan, pEncConverter);
 
-        //set geometry
-        wxGISGeometry Geom = Feature.GetGeometry();
-		bool bSkip = true;
-		if(eSkipGeometry & enumGISSkipGeometryNone)
-		{
-			bSkip = false;			
-		}
-		else
-		{
-			if((eSkipGeometry & enumGISSkipEmptyGeometry) && !Geom.IsOk())
-				bSkip = true;
-			else
-				bSkip = false;
-			
-			if(!bSkip && (eSkipGeometry & enumGISSkipInvalidGeometry) && !Geom.IsValid())
-				bSkip = true;
-			else
-				bSkip = false;
-		}
- 
-        if (!bSkip)
-        {
-            OGRGeometry *pNewGeom = NULL;
-            OGRwkbGeometryType eGeomType = Geom.GetType();
-            if (eFilterGeomType != wkbUnknown)
+            if (!Writer.Write(aFeatures[i].GetFID(), newFeature))
             {
-                OGRwkbGeometryType eTestGeomType = eGeomType;
-                if (bToMulti && wkbFlatten(eGeomType) > 1 && wkbFlatten(eGeomType) < 4)
-                {
-                    eTestGeomType = (OGRwkbGeometryType)(eGeomType + 3);
-                }
-
-                if (eFilterGeomType != eTestGeomType)
-                {
-                    if (pProgressor)
-                    {
-                        pProgressor->SetValue(nCounter++);
-                    }
-                    continue;
-                }
+                wxDELETE(pStream);
+                return false;
             }
+        }
+    }
+    wxDELETE(pStream);
 
-            if (eGeoFieldtype != eGeomType)
-            {
-                switch (wkbFlatten(eGeoFieldtype))
-                {
-                case wkbLineString:
-                    pNewGeom = OGRGeometryFactory::forceToLineString(Geom.Copy());
-                    break;
-                case wkbPolygon:
-                    pNewGeom = OGRGeometryFactory::forceToPolygon(Geom.Copy());
-                    break;
-                case wkbMultiPoint:
-                    pNewGeom = OGRGeometryFactory::forceToMultiPoint(Geom.Copy());
-                    break;
-                case wkbMultiLineString:
-                    pNewGeom = OGRGeometryFactory::forceToMultiLineString(Geom.Copy());
-                    break;
-                case wkbMultiPolygon:
-                    pNewGeom = OGRGeometryFactory::forceToMultiPolygon(Geom.Copy());
-                    break;
-                case wkbPoint:
-                default:
-                    pNewGeom = Geom.Copy();
-                    break;
-                };
+    return Writer.End(true);
+}
+
+bool CopyRows(wxGISFeatureDataset* const pSrcDataSet, wxGISFeatureDataset* const pDstDataSet, const wxVector<ST_FIELD_MAP> &staFieldMap, OGRwkbGeometryType eFilterGeomType, bool bToMulti, wxDword eSkipGeometry, ITrackCancel* const pTrackCancel)
+{
+    CPLErrorReset();
+
+    //create src -> dst field mapping
 
+    OGRFeatureDefn *pFeatureDefn = pDstDataSet->GetDefinition();
+
+    if (NULL == pFeatureDefn)
+    {
+        if (pTrackCancel)
+        {
+            pTrackCancel->PutMessage(_("Input dataset is corrupt"), wxNOT_FOUND, enumGISMessageError);
+        }
+        return false;
+    }
+
+    //precompute the field copy methods
+    wxVector<COPY_FIELD_PLAN> astPlan;
+    PrepareCopyFieldPlan(pSrcDataSet, pDstDataSet, staFieldMap, astPlan);
+
+    //store the features in transaction batches & show progress
+    long nFeatureCount = pSrcDataSet->GetFeatureCount(false, pTrackCancel);
+    wxGISCopyRowsWriter Writer(pDstDataSet, nFeatureCount, pTrackCancel);
+
+    //the big datasets are read and stored by this thread, the features are filled by copy threads.
+    //the datasets, progressor and messages are used by this thread only
+    wxMessageQueue<COPY_ROWS_CHUNK*> InQueue, OutQueue;
+    wxVector<wxGISCopyRowsThread*> paThreads;
+    if (nFeatureCount > COPY_ROWS_CHUNK_SIZE)
+    {
+        int nThreadCount = wxThread::GetCPUCount() - 1;
+        for (int i = 0; i < nThreadCount; ++i)
+        {
+            wxGISFeatureCopier* pCopier = new wxGISFeatureCopier(pSrcDataSet, pDstDataSet, staFieldMap, astPlan, eFilterGeomType, bToMulti, eSkipGeometry);
+            wxGISCopyRowsThread *thread = new wxGISCopyRowsThread(InQueue, OutQueue, pCopier);
+            if (::CreateAndRunThread(thread, wxT("CopyRows"), wxT("CopyRowsThread")))
+            {
+                paThreads.push_back(thread);
             }
             else
             {
-                pNewGeom = Geom.Copy();
+                wxDELETE(thread);
+                break;
             }
+        }
+    }
 
-            if (NULL != poCT)
-            {
-                if (Geom.GetType() != wkbUnknown && Geom.GetType() != wkbNone)
-                {
-                    OGRErr eErr = pNewGeom->transform(poCT);
-                    if (eErr != OGRERR_NONE)
-                    {
-                        pTrackCancel->PutMessage(wxString::Format(_("Geometry transform failed\nFeature id %ld"), Feature.GetFID()), wxNOT_FOUND, enumGISMessageWarning);
-                    }
-                }
-            }
-            newFeature.SetGeometryDirectly(wxGISGeometry(pNewGeom, false));
+    wxGISFeatureCopier Copier(pSrcDataSet, pDstDataSet, staFieldMap, astPlan, eFilterGeomType, bToMulti, eSkipGeometry);
+    COPY_ROWS_CHUNK* pChunk(NULL);
+    size_t nSequence(0), nNextSequence(0), nInWork(0);
+    size_t nMaxInWork = paThreads.size() * 2 + 1;
+    std::map<size_t, COPY_ROWS_CHUNK*> mpDone;
+    std::map<size_t, COPY_ROWS_CHUNK*>::iterator it;
+    bool bCancel(false), bFailed(false);
+
+    //the source is read by batches, the cancel is checked once per batch
+    wxFeatureStream* pStream = pSrcDataSet->SearchStream();
+    wxVector<wxGISFeature> aFeatures;
+    size_t nFeaturePos(0);
+    wxGISFeature Feature;
+    while (true)
+    {
+        bool bNewBatch = false;
+        if (!bCancel && !bFailed && nFeaturePos >= aFeatures.size())
+        {
+            nFeaturePos = 0;
+            if (NULL == pStream || pStream->NextBatch(aFeatures) == 0)
+                aFeatures.clear();
+            bNewBatch = true;
         }
-		else
-		{
-			//skip feature
-			
-			if (pTrackCancel)
+        bool bNext = !bCancel && !bFailed && nFeaturePos < aFeatures.size();
+        if (bNext)
+            Feature = aFeatures[nFeaturePos++];
+        if (bNext && bNewBatch && pTrackCancel && !pTrackCancel->Continue())
+        {
+            wxString sErr(_("Interrupted by user"));
+            CPLString sFullErr(sErr.ToUTF8());
+            CPLError( CE_Warning, CPLE_AppDefined, sFullErr );
+
+            if (pTrackCancel)
             {
-                pTrackCancel->PutMessage(wxString::Format(_("Skip feature id %ld with empty or invalid geometry"), Feature.GetFID()), wxNOT_FOUND, enumGISMessageWarning);
+                pTrackCancel->PutMessage(wxString(sFullErr, wxConvUTF8), wxNOT_FOUND, enumGISMessageError);
             }
-			
-			if (pProgressor)
-			{
-				pProgressor->SetValue(nCounter++);
-			}
-			continue;
-			
-		}
 
-        if (pDstDataSet->GetSubType() == enumVecDXF)
+            bCancel = true;
+            bNext = false;
+        }
+
+        if (paThreads.empty())
         {
-            wxString sFieldText;
-            //    //LABEL(f:"Arial, Helvetica", s:12pt, t:"Hello World!")
-            for (size_t i = 0; i < staFieldMap.size(); ++i)
+            if (!bNext)
+                break;
+
+            wxGISFeature newFeature = pDstDataSet->CreateFeature(), InvalidFeature;
+            wxArrayString saWarnings;
+            bool bCopied = Copier.Copy(Feature, newFeature, saWarnings);
+            for (size_t i = 0; pTrackCancel && i < saWarnings.GetCount(); ++i)
             {
-                sFieldText += Feature.GetFieldAsString(staFieldMap[i].nSrsFieldNo);
-                sFieldText.Append(wxT("\n"));
+                pTrackCancel->PutMessage(saWarnings[i], wxNOT_FOUND, enumGISMessageWarning);
             }
-            wxString sStyleLabel = wxString::Format(wxT("LABEL(f:\"Arial, Helvetica\", s:12pt, t:\"%s\")"), sFieldText.c_str());
-            newFeature.SetStyleString(sStyleLabel);
+            if (!Writer.Write(Feature.GetFID(), bCopied ? newFeature : InvalidFeature))
+            {
+                bFailed = true;
+            }
+            continue;
         }
-        else
+
+        if (bNext)
         {
-            for ( i = 0; i < staFieldMap.size(); ++i)
+            if (NULL == pChunk)
             {
-                switch (staFieldMap[i].eFieldType)
-                {
-                 case OFTRealList:
-                    newFeature.SetField(staFieldMap[i].nDstFieldNo, Feature.GetFieldAsDoubleList(staFieldMap[i].nSrsFieldNo));
-                    break;
-                case OFTIntegerList:
-                    newFeature.SetField(staFieldMap[i].nDstFieldNo, Feature.GetFieldAsIntegerList(staFieldMap[i].nSrsFieldNo));
-                    break;
-                case OFTStringList:
-                    newFeature.SetField(staFieldMap[i].nDstFieldNo, Feature.GetFieldAsStringList(staFieldMap[i].nSrsFieldNo));
-                    break;
-
-                case OFTDate:
-                case OFTTime:
-                case OFTDateTime:
-//                    newFeature.SetField(staFieldMap[i].nDstFieldNo, Feature.GetFieldAsDateTime(staFieldMap[i].nSrsFieldNo));
-//                    break;
-                case OFTReal:
-//                    newFeature.SetField(staFieldMap[i].nDstFieldNo, Feature.GetFieldAsDouble(staFieldMap[i].nSrsFieldNo));
-//                    break;
-                case OFTInteger:
-//                    newFeature.SetField(staFieldMap[i].nDstFieldNo, Feature.GetFieldAsInteger(staFieldMap[i].nSrsFieldNo));
-                    newFeature.SetField(staFieldMap[i].nDstFieldNo, Feature.GetRawField(staFieldMap[i].nSrsFieldNo));
-                    break;
-                case OFTString:
-#ifdef CPL_RECODE_ICONV
-//                    newFeature.SetField(staFieldMap[i].nDstFieldNo, Feature.GetFieldAsString(staFieldMap[i].nSrsFieldNo));
-//                    newFeature.SetField(staFieldMap[i].nDstFieldNo, Feature.GetFieldAsChar(staFieldMap[i].nSrsFieldNo));
-//                    break;
-#else
-                    if (bFastConv)
-                    {
-                        const char* pszStr = Feature.GetFieldAsChar(staFieldMap[i].nSrsFieldNo);
-                        if (oEncConverter.Convert(pszStr, szMaxStr))
-                        {
-                            newFeature.SetField(staFieldMap[i].nDstFieldNo, szMaxStr);
-                            break;
-                        }
-                    }
-#endif //CPL_RECODE_ICONV
-                default:
-                    //TODO: recode to output encoding if pDstDataSet encoding diffes from src
-//                    newFeature.SetField(staFieldMap[i].nDstFieldNo, Feature.GetRawField(staFieldMap[i].nSrsFieldNo));
-                    newFeature.SetField(staFieldMap[i].nDstFieldNo, Feature.GetFieldAsString(staFieldMap[i].nSrsFieldNo));
-                    break;
-                };
+                pChunk = new COPY_ROWS_CHUNK;
+                pChunk->nSequence = nSequence++;
+                pChunk->aSrcFeatures.reserve(COPY_ROWS_CHUNK_SIZE);
+                pChunk->aDstFeatures.reserve(COPY_ROWS_CHUNK_SIZE);
             }
+
+            pChunk->aSrcFeatures.push_back(Feature.Clone());
+            pChunk->aDstFeatures.push_back(pDstDataSet->CreateFeature());
+            pChunk->abCopied.push_back(false);
         }
 
-        OGRErr eErr = pDstDataSet->StoreFeature(newFeature);
-        if(eErr != OGRERR_NONE)
+        if (NULL != pChunk && (!bNext || pChunk->aSrcFeatures.size() >= COPY_ROWS_CHUNK_SIZE))
         {
-			wxString sErr = wxString::Format(_("Error create feature!\nSource feature FID:%ld"), Feature.GetFID());
-            wxGISLogError(sErr, wxString::FromUTF8(CPLGetLastErrorMsg()), wxEmptyString, pTrackCancel);
+            InQueue.Post(pChunk);
+            pChunk = NULL;
+            nInWork++;
         }
 
-        if (pProgressor)
+        //wait the copied chunks if too many are in work or the reading is finished
+        while (nInWork > 0 && (nInWork >= nMaxInWork || !bNext))
         {
-            pProgressor->SetValue(nCounter++);
+            COPY_ROWS_CHUNK* pDoneChunk(NULL);
+            if (OutQueue.Receive(pDoneChunk) != wxMSGQUEUE_NO_ERROR)
+                break;
+            nInWork--;
+
+            //the chunks come from several threads, store them in the source order
+            mpDone[pDoneChunk->nSequence] = pDoneChunk;
+            while ((it = mpDone.find(nNextSequence)) != mpDone.end())
+            {
+                pDoneChunk = it->second;
+                mpDone.erase(it);
+                nNextSequence++;
+
+                if (!bCancel && !bFailed && !WriteCopyRowsChunk(Writer, pDoneChunk, pTrackCancel))
+                {
+                    bFailed = true;
+                }
+                delete pDoneChunk;
+            }
         }
+
+        if (!bNext)
+            break;
     }
 
-    if (NULL != poCT)
+    //the copy threads exit on NULL chunk
+    for (size_t i = 0; i < paThreads.size(); ++i)
     {
-        OCTDestroyCoordinateTransformation(poCT);
+        InQueue.Post(NULL);
+    }
+    for (size_t i = 0; i < paThreads.size(); ++i)
+    {
+        wgDELETE(paThreads[i], Wait());
+    }
+    for (it = mpDone.begin(); it != mpDone.end(); ++it)
+    {
+        delete it->second;
     }
+    wxDELETE(pStream);
 
-    return true;
+    if (bFailed)
+        return false;
+    return Writer.End(!bCancel);
 }
 
 bool ExportFormatEx(wxGISTable* const pSrsDataSet, const CPLString &sPath, const wxString &sName, wxGxObjectFilter* const pFilter, const wxGISSpatialFilter &SpaFilter, OGRFeatureDefn* const poFields, const wxVector<ST_FIELD_MAP> &staFieldMap, char ** papszDataSourceOptions, char ** papszLayerOptions, bool bCreateEmpty, ITrackCancel* const pTrackCancel)
@@ -452,9 +853,7 @@ bool ExportFormatEx(wxGISTable* const pSrsDataSet, const CPLString &sPath, const
     }
 
 
-    OGRErr eErr = pDstDataSet->StartTransaction();
-
-    //copy data
+    //copy data, the transactions are committed by CopyRows
     if (!CopyRows(pSrsDataSet, pDstDataSet, staFieldMap, pTrackCancel))
     {
         wxString sErr(_("Error copying data to a new dataset!"));
@@ -462,31 +861,21 @@ bool ExportFormatEx(wxGISTable* const pSrsDataSet, const CPLString &sPath, const
 
         //remove filter
         pSrsDataSet->SetFilter();
-        eErr = pDstDataSet->RollbackTransaction();
+        //the committed batches are left on failure or cancel, so remove the partial output
+        if (!DeletePartialOutput(pDstDataSet, sPath, sName, pFilter))
+        {
+            wxString sDelErr(_("Error deleting the partially copied dataset!"));
+            wxGISLogError(sDelErr, wxString::FromUTF8(CPLGetLastErrorMsg()), wxEmptyString, pTrackCancel);
+        }
         return false;
     }
 
-
-
-    CPLErrorReset();
-    eErr = pDstDataSet->CommitTransaction();
-
     //remove filter
-    pSrsDataSet->SetFilter();    
-    
-    if (CPLGetLastErrorType() != OGRERR_NONE)
-    {
-        pDstDataSet->Close();
-
-		wxString sErr(_("Error copying data to a new dataset!"));
-        wxGISLogError(sErr, wxString::FromUTF8(CPLGetLastErrorMsg()), wxEmptyString, pTrackCancel);
-        return false;
-    }
-
+    pSrsDataSet->SetFilter();
 
     pDstDataSet->Close();
 
-    return eErr == OGRERR_NONE;
+    return true;
 }
 
 bool ExportFormatEx(wxGISFeatureDataset* const pSrsDataSet, const CPLString &sPath, const wxString &sName, wxGxObjectFilter* const pFilter, const wxGISSpatialFilter &SpaFilter, OGRFeatureDefn* const poFields, const wxVector<ST_FIELD_MAP> &staFieldMap, const wxGISSpatialReference &oSpatialRef, char ** papszDataSourceOptions, char ** papszLayerOptions, bool bCreateEmpty, OGRwkbGeometryType eFilterGeomType, bool bToMulti, wxDword eSkipGeometry, ITrackCancel* const pTrackCancel)
@@ -528,9 +917,7 @@ bool ExportFormatEx(wxGISFeatureDataset* const pSrsDataSet, const CPLString &sPa
     }
 
 
-    OGRErr eErr = pDstDataSet->StartTransaction();
-
-    //copy data
+    //copy data, the transactions are committed by CopyRows
     if (!CopyRows(pSrsDataSet, pDstDataSet, staFieldMap, eFilterGeomType, bToMulti, eSkipGeometry, pTrackCancel))
     {
         wxString sErr(_("Error copying data to a new dataset!"));
@@ -539,28 +926,21 @@ bool ExportFormatEx(wxGISFeatureDataset* const pSrsDataSet, const CPLString &sPa
 
         //remove filter
         pSrsDataSet->SetFilter();
-        eErr = pDstDataSet->RollbackTransaction();
+        //the committed batches are left on failure or cancel, so remove the partial output
+        if (!DeletePartialOutput(pDstDataSet, sPath, sName, pFilter))
+        {
+            wxString sDelErr(_("Error deleting the partially copied dataset!"));
+            wxGISLogError(sDelErr, wxString::FromUTF8(CPLGetLastErrorMsg()), wxEmptyString, pTrackCancel);
+        }
         return false;
     }
 
-    CPLErrorReset();
-    eErr = pDstDataSet->CommitTransaction();
-
     //remove filter
     pSrsDataSet->SetFilter();
 
-    if (CPLGetLastErrorType() != OGRERR_NONE)
-    {
-        pDstDataSet->Close();
-
-        wxString sErr(_("Error copying data to a new dataset!"));
-		wxGISLogError(sErr, wxString::FromUTF8(CPLGetLastErrorMsg()), wxEmptyString, pTrackCancel);
-        return false;
-    }
-
     pDstDataSet->Close();
 
-    return eErr == OGRERR_NONE;
+    return true;
 }
 
 bool ExportFormat(wxGISTable* const pSrsDataSet, const CPLString &sPath, const wxString &sName, wxGxObjectFilter* const pFilter, const wxGISSpatialFilter &SpaFilter, char ** papszDataSourceOptions, char ** papszLayerOptions, ITrackCancel* const pTrackCancel)
@@ -1617,7 +1997,13 @@ wxGISDataset* CreateDataset(const CPLString &sPath, const wxString &sName, wxGxO
         szFullPath = CPLFormFilename(sPath, sName.ToUTF8(), pFilter->GetExt().ToUTF8());
     }
 	
-	wxGxObject* pObj = wxDynamicCast(GetGxCatalog()->FindGxObjectByPath(szFullPath), wxGxObject);
+    //the catalog is not created by the command line tools
+    wxGxCatalogBase* pCatalog = GetGxCatalog();
+	wxGxObject* pObj = NULL;
+    if (NULL != pCatalog)
+    {
+        pObj = wxDynamicCast(pCatalog->FindGxObjectByPath(szFullPath), wxGxObject);
+    }
     if (!OverWriteGxObject(pObj, pTrackCancel))
     {
         wxString sErr(_("Overwrite failed"));
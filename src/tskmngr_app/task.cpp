@@ -26,8 +26,13 @@
 #include <wx/wfstream.h>
 #include <wx/txtstrm.h>
 
+#include <algorithm>
+
 #define TASK_SEND_COUNT 7
 
+//the subtasks revisions are unique in process, so the category index never takes the new task for the removed one
+static long g_nSubTasksRevision = 0;
+
 //------------------------------------------------------------------
 // wxGISTaskBase
 //------------------------------------------------------------------
@@ -89,19 +94,15 @@ bool wxGISTaskBase::Save(void)
             return false;
     }
 
-    wxJSONWriter writer( wxJSONWRITER_STYLED | wxJSONWRITER_WRITE_COMMENTS );
+    wxJSONWriter writer( wxJSONWRITER_NONE );
     wxString  sJSONText;
 
     writer.Write( GetStoreConfig(), sJSONText );
-    wxFile oStorageFile(m_sStoragePath, wxFile::write);
-    if(!oStorageFile.Write(sJSONText))
-    {
-        oStorageFile.Close();
-        return false;
-    }
-
-    return oStorageFile.Close();
 
+    wxGISTaskStoreWriter* const pWriter = wxGISTaskStoreWriter::GetWriter();
+    if(NULL == pWriter)
+        return wxGISTaskStoreWriter::Write(m_sStoragePath, sJSONText);
+    return pWriter->Store(m_sStoragePath, sJSONText);
 }
 
 wxString wxGISTaskBase::GetNewStorePath(const wxString &sAddToName, const wxString &sSubDir)
@@ -117,6 +118,18 @@ void wxGISTaskBase::StartNextQueredTask(void)
         m_pParentTask->StartNextQueredTask();
 }
 
+void wxGISTaskBase::UpdateTaskIndex(wxGISTask* const pTask)
+{
+    if(NULL != m_pParentTask)
+        m_pParentTask->UpdateTaskIndex(pTask);
+}
+
+void wxGISTaskBase::RemoveFromTaskIndex(wxGISTask* const pTask)
+{
+    if(NULL != m_pParentTask)
+        m_pParentTask->RemoveFromTaskIndex(pTask);
+}
+
 void wxGISTaskBase::OnDestroy(void)
 {
     m_pParentTask = NULL;
@@ -144,6 +157,167 @@ bool wxGISTaskBase::HasName(const wxString &sName) const
     return false;
 }
 
+//------------------------------------------------------------------------------
+// wxGISTaskStoreWriter
+//------------------------------------------------------------------------------
+
+wxGISTaskStoreWriter* wxGISTaskStoreWriter::m_pWriter = NULL;
+wxCriticalSection wxGISTaskStoreWriter::m_WriterCritSect;
+bool wxGISTaskStoreWriter::m_bShutdown = false;
+
+wxGISTaskStoreWriter::wxGISTaskStoreWriter(int nDelay) : wxThread(wxTHREAD_JOINABLE)
+{
+    m_nDelay = nDelay;
+    m_bExit = false;
+}
+
+wxGISTaskStoreWriter::~wxGISTaskStoreWriter(void)
+{
+}
+
+wxGISTaskStoreWriter* const wxGISTaskStoreWriter::GetWriter(bool bCreate)
+{
+    wxCriticalSectionLocker locker(m_WriterCritSect);
+    if(NULL == m_pWriter && bCreate && !m_bShutdown)
+    {
+        int nDelay(TASK_SAVE_DELAY);
+        wxGISAppConfig oConfig = GetConfig();
+        if (oConfig.IsOk())
+        {
+            nDelay = oConfig.ReadInt(enumGISHKCU, wxString(wxT("wxGISTaskNamager/app/save_delay")), nDelay);
+        }
+        if (nDelay < 1)
+            nDelay = TASK_SAVE_DELAY;
+
+        wxGISTaskStoreWriter* pWriter = new wxGISTaskStoreWriter(nDelay);
+        if(!CreateAndRunThread(pWriter, wxT("wxGISTaskStoreWriter"), wxT("TaskStoreWriter")))
+        {
+            wxDELETE(pWriter);
+            m_bShutdown = true;
+            return NULL;
+        }
+        m_pWriter = pWriter;
+    }
+    return m_pWriter;
+}
+
+void wxGISTaskStoreWriter::Cleanup(void)
+{
+    wxCriticalSectionLocker locker(m_WriterCritSect);
+    m_bShutdown = true;
+    if(NULL != m_pWriter)
+    {
+        m_pWriter->Shutdown();
+        m_pWriter->Wait();
+        //write the configs stored while the thread exits
+        m_pWriter->Flush();
+        wxDELETE(m_pWriter);
+    }
+}
+
+bool wxGISTaskStoreWriter::Write(const wxString &sPath, const wxString &sJSONText)
+{
+    wxString sTempPath = sPath + wxT(".tmp");
+    wxFile oStorageFile(sTempPath, wxFile::write);
+    if(!oStorageFile.IsOpened())
+        return false;
+
+    if(!oStorageFile.Write(sJSONText))
+    {
+        oStorageFile.Close();
+        wxRemoveFile(sTempPath);
+        return false;
+    }
+
+    if(!oStorageFile.Close())
+    {
+        wxRemoveFile(sTempPath);
+        return false;
+    }
+
+    //the reader never see the partly written config
+    return wxRenameFile(sTempPath, sPath, true);
+}
+
+bool wxGISTaskStoreWriter::Store(const wxString &sPath, const wxString &sJSONText)
+{
+    //the new task config is written at once to report the errors
+    if(!wxFileName::FileExists(sPath))
+    {
+        wxCriticalSectionLocker write_locker(m_WriteCritSect);
+        if(!Write(sPath, sJSONText))
+            return false;
+
+        wxCriticalSectionLocker locker(m_CritSect);
+        m_mPending.erase(sPath);
+        m_mWritten[sPath] = sJSONText;
+        return true;
+    }
+
+    wxCriticalSectionLocker locker(m_CritSect);
+    std::map<wxString, wxString>::const_iterator it = m_mWritten.find(sPath);
+    if(it != m_mWritten.end() && it->second == sJSONText)
+    {
+        //the last stored config is back, nothing to write
+        m_mPending.erase(sPath);
+        return true;
+    }
+    m_mPending[sPath] = sJSONText;
+    return true;
+}
+
+void wxGISTaskStoreWriter::Forget(const wxString &sPath)
+{
+    //wait for the writing in progress, so the deleted file will not be written again
+    wxCriticalSectionLocker write_locker(m_WriteCritSect);
+    wxCriticalSectionLocker locker(m_CritSect);
+    m_mPending.erase(sPath);
+    m_mWritten.erase(sPath);
+}
+
+void wxGISTaskStoreWriter::Flush(void)
+{
+    wxCriticalSectionLocker write_locker(m_WriteCritSect);
+
+    std::map<wxString, wxString> mPending;
+    {
+        wxCriticalSectionLocker locker(m_CritSect);
+        if(m_mPending.empty())
+            return;
+        mPending.swap(m_mPending);
+    }
+
+    for(std::map<wxString, wxString>::const_iterator it = mPending.begin(); it != mPending.end(); ++it)
+    {
+        if(Write(it->first, it->second))
+        {
+            wxCriticalSectionLocker locker(m_CritSect);
+            m_mWritten[it->first] = it->second;
+        }
+        else
+        {
+            wxLogError(_("Save task config to file '%s' failed"), it->first.c_str());
+        }
+    }
+}
+
+void wxGISTaskStoreWriter::Shutdown(void)
+{
+    m_bExit = true;
+    m_Wakeup.Post();
+}
+
+wxThread::ExitCode wxGISTaskStoreWriter::Entry()
+{
+    while(!m_bExit && !TestDestroy())
+    {
+        //join the configs stored in the delay
+        m_Wakeup.WaitTimeout(m_nDelay);
+        Flush();
+    }
+    return (wxThread::ExitCode)wxTHREAD_NO_ERROR;
+}
+
 //------------------------------------------------------------------------------
 // wxGISTask
 //------------------------------------------------------------------------------
@@ -156,6 +330,7 @@ wxGISTask::wxGISTask(wxGISTaskBase* pParentTask, const wxString &sPath) : wxGIST
     m_nGroupId = wxNOT_FOUND;
     m_sStoragePath = sPath;
     m_bSubTasksLoaded = false;
+    m_nSubTasksRevision = 0;
 }
 
 wxGISTask::~wxGISTask(void)
@@ -243,6 +418,7 @@ void wxGISTask::LoadSubTasks(const wxJSONValue& subtasks)
         }
     }
     m_bSubTasksLoaded = true;
+    m_nSubTasksRevision = ++g_nSubTasksRevision;
 }
 
 bool wxGISTask::Create(const wxJSONValue& TaskConfig)
@@ -277,6 +453,7 @@ bool wxGISTask::Create(const wxJSONValue& TaskConfig)
             }
         }
         m_bSubTasksLoaded = true;
+        m_nSubTasksRevision = ++g_nSubTasksRevision;
     }
     return Save();
 }
@@ -406,6 +583,7 @@ void wxGISTask::OnStop(void)
     if (m_omSubTasks.empty())
     {
         Stop();
+        OnStateChanged();
         StartNextQueredTask();
     }
     else
@@ -442,6 +620,7 @@ void wxGISTask::OnTerminate(int pid, int status)
 {
     wxGISProcess::OnTerminate(pid, status);
     m_dfPrevDone = 0;
+    OnStateChanged();
     StartNextQueredTask();
     ChangeTask(enumTaskChangeVolume | enumTaskChangeState | enumTaskChangePercent);
     Save();
@@ -509,6 +688,8 @@ bool wxGISTask::Start(void)
 bool wxGISTask::Delete(long nMessageId, int nUserId)
 {
     Stop();
+    if(m_pParentTask)
+        m_pParentTask->RemoveFromTaskIndex(this);
     StartNextQueredTask();
 
     for(wxGISTaskMap::iterator it = m_omSubTasks.begin(); it != m_omSubTasks.end(); ++it)
@@ -522,6 +703,10 @@ bool wxGISTask::Delete(long nMessageId, int nUserId)
     }
 
     //delete config
+    wxGISTaskStoreWriter* const pWriter = wxGISTaskStoreWriter::GetWriter(false);
+    if(NULL != pWriter)
+        pWriter->Forget(m_sStoragePath);
+
     if(wxRemoveFile(m_sStoragePath) && m_pParentTask)
     {
         //don't send subtask delete message
@@ -725,6 +910,9 @@ void wxGISTask::ChangeTask(wxDword eChangeType, wxGISEnumMessageType eMessageTyp
 {
     if(!m_pParentTask)
         return;
+
+    if (eChangeType & enumTaskChangeState)
+        OnStateChanged();
     wxString sMessage(_("Task changed"));
     wxJSONValue val;
     val[wxT("id")] = m_nId;
@@ -863,10 +1051,14 @@ bool wxGISTask::ChangeTask(const wxJSONValue& TaskVal, long nMessageId, int nUse
         val[wxT("subtasks")] = subtasks;
         nHaveChanges = true;
         m_bSubTasksLoaded = true;
+        m_nSubTasksRevision = ++g_nSubTasksRevision;
     }
 
     if (nHaveChanges)
+    {
+        OnStateChanged();
         m_pParentTask->SendNetMessage(enumGISNetCmdCmd, enumGISCmdStChng, enumGISPriorityHigh, val, _("Task changed"), nMessageId, nUserId);
+    }
 
     return true;
 }
@@ -991,6 +1183,25 @@ void wxGISTask::GetQueredTasks(wxGISQueredTasksArray &oaTasks)
 }
 
 
+void wxGISTask::GetLeafTasks(wxGISQueredTasksArray &oaTasks)
+{
+    if(m_omSubTasks.empty())
+    {
+        oaTasks.Add(this);
+    }
+    else
+    {
+        for(wxGISTaskMap::const_iterator it = m_omSubTasks.begin(); it != m_omSubTasks.end(); ++it)
+        {
+            wxGISTask* pSubTask = dynamic_cast<wxGISTask*>(it->second);
+            if(pSubTask)
+            {
+                pSubTask->GetLeafTasks(oaTasks);
+            }
+        }
+    }
+}
+
 int wxGISTask::GetRunningTaskCount(void) const
 {
     if(m_omSubTasks.empty())
@@ -1029,6 +1240,13 @@ void wxGISTask::OnDestroy(void)
     wxGISTaskBase::OnDestroy();
 }
 
+void wxGISTask::OnStateChanged(void)
+{
+    //update the state, group and priority of the task in category scheduling index
+    if(m_pParentTask)
+        m_pParentTask->UpdateTaskIndex(this);
+}
+
 /*
 void wxGISTask::ChangeTask(const wxXmlNode* pTaskNode)
 {
@@ -1168,6 +1386,7 @@ bool wxGISTaskPeriodic::Create(const wxJSONValue& TaskConfig)
             }
         }
         m_bSubTasksLoaded = true;
+        m_nSubTasksRevision = ++g_nSubTasksRevision;
     }
 
     if (m_nPeriod > 0)
@@ -1266,7 +1485,8 @@ wxThread::ExitCode wxGISTaskPeriodic::Entry()
             nCounter -= 100;
         }
 
-        if (m_nState == enumGISTaskWork && IsInputOpened())
+        //the output is read here if the process reader is not available
+        if (m_nState == enumGISTaskWork && IsInputOpened() && !m_bAttachedToReader)
         {
             wxInputStream &InStream = *GetInputStream();
             if (InStream.IsOk())
@@ -1301,10 +1521,13 @@ bool wxGISTaskPeriodic::Start()
     m_nState = enumGISTaskWork;
     m_dtBeg = wxDateTime::Now();
     m_dfDone = 0;
+    OnStateChanged();
 
-    if (IsInputOpened() && m_nPeriod < 1) //not periodic task
+    if (IsInputOpened())
     {
-        return CreateAndRunThread();
+        if (m_nPeriod < 1) //not periodic task
+            return StartReadInput();
+        AttachToReader();
     }
 
     //wait a little and give a chance to quere message to be send first. overwise working state may be owerwrite by quere state
@@ -1320,6 +1543,8 @@ void wxGISTaskPeriodic::Stop(void)
     if (m_nState == enumGISTaskDone || m_nState == enumGISTaskError || m_nState == enumGISTaskPaused)
         return;
 
+    DetachFromReader();
+
     wxCriticalSectionLocker lock(m_ExitLock);
 
     if (m_nState == enumGISTaskWork)
@@ -1358,6 +1583,7 @@ void wxGISTaskPeriodic::Stop(void)
 
 void wxGISTaskPeriodic::OnTerminate(int pid, int status)
 {
+    DetachFromReader(true);
     if (m_nPeriod < 1)
         DestroyThreadAsync();
 
@@ -1489,10 +1715,14 @@ bool wxGISTaskPeriodic::ChangeTask(const wxJSONValue& TaskVal, long nMessageId,
         val[wxT("subtasks")] = subtasks;
         nHaveChanges = true;
         m_bSubTasksLoaded = true;
+        m_nSubTasksRevision = ++g_nSubTasksRevision;
     }
 
     if (nHaveChanges)
+    {
+        OnStateChanged();
         m_pParentTask->SendNetMessage(enumGISNetCmdCmd, enumGISCmdStChng, enumGISPriorityHigh, val, _("Task changed"), nMessageId, nUserId);
+    }
 
     return true;
 }
@@ -1511,6 +1741,11 @@ wxGISTaskCategory::wxGISTaskCategory(const wxString &sPath, wxGISTaskManager* pT
     wxFileName oFName(sPath);
     m_sName = oFName.GetName();
     m_nId = wxNOT_FOUND;
+
+    m_nRunningTaskCount = 0;
+    m_nQueredTaskCount = 0;
+    m_nQueredHeapSize = 0;
+    m_nIndexStamp = 0;
 }
 
 wxGISTaskCategory::~wxGISTaskCategory(void)
@@ -1533,6 +1768,7 @@ bool wxGISTaskCategory::Load(void)
             {
                 wxLogMessage(_("The task '%s' loaded"), pGISTask->GetName().c_str());
                 m_omSubTasks[pGISTask->GetId()] = pGISTask;
+                UpdateTaskIndex(dynamic_cast<wxGISTask*>(pGISTask));
             }
             else
             {
@@ -1548,16 +1784,7 @@ bool wxGISTaskCategory::Load(void)
 
 int wxGISTaskCategory::GetRunningTaskCount(void) const
 {
-    int nRunningTaskCount = 0;
-    for(wxGISTaskMap::const_iterator it = m_omSubTasks.begin(); it != m_omSubTasks.end(); ++it)
-    {
-        wxGISTask* pSubTask = dynamic_cast<wxGISTask*>(it->second);
-        if(pSubTask)
-        {
-            nRunningTaskCount += pSubTask->GetRunningTaskCount();
-        }
-    }
-    return nRunningTaskCount;
+    return m_nRunningTaskCount;
 }
 
 void wxGISTaskCategory::NetMessage(wxGISNetCommand eCmd, wxGISNetCommandState eCmdState, const wxJSONValue &val, long nMessageId, int nUserId)
@@ -1702,6 +1929,7 @@ bool wxGISTaskCategory::AddTask(const wxJSONValue &TaskConfig, long nMessageId,
     if( pTask->Create(TaskConfig) )
     {
         m_omSubTasks[pTask->GetId()] = pTask;
+        UpdateTaskIndex(pTask);
         SendNetMessage(enumGISNetCmdCmd, enumGISCmdStAdd, enumGISPriorityHigh, pTask->GetAsJSON(), _("Add succeeded"), nMessageId, nUserId);
 
         StartNextQueredTask();
@@ -1778,9 +2006,7 @@ void wxGISTaskCategory::GetChildren(long nMessageId, int nUserId)
 
 void wxGISTaskCategory::StartNextQueredTask()
 {
-    wxGISQueredTasksArray oaTasks;
-    GetQueredTasks(oaTasks);
-    if (GetRunningTaskCount() == 0 && oaTasks.IsEmpty()) //no more tasks
+    if (GetRunningTaskCount() == 0 && m_nQueredTaskCount == 0) //no more tasks
     {
         m_pTaskManager->OnCategoryExecutionFinished(this);
 
@@ -1806,23 +2032,174 @@ void wxGISTaskCategory::StartNextQueredTask()
 
 wxGISTask* const wxGISTaskCategory::GetQueredTask()
 {
-    long nMinPriority = LONG_MAX;
-    wxGISTask* pOutTask = NULL;
+    wxCriticalSectionLocker lock(m_CritSect);
+
+    //the heap top of each not executing group is the group ready task, choose the highest priority of them
+    QUEREDTASK stBestTask = {0, 0, NULL};
+    std::map<int, wxVector<QUEREDTASK> >::iterator it = m_mQueredHeaps.begin();
+    while(it != m_mQueredHeaps.end())
+    {
+        if(it->first != wxNOT_FOUND && m_mnRunningGroups.find(it->first) != m_mnRunningGroups.end())
+        {
+            ++it;
+            continue;
+        }
+
+        wxVector<QUEREDTASK> &aHeap = it->second;
+        while(!aHeap.empty())
+        {
+            QUEREDTASK stTask = aHeap.front();
+            //the actual item, the task stay in heap until it's state changed
+            std::map<wxGISTask*, TASKINDEX>::const_iterator itIndex = m_mTaskIndex.find(stTask.pTask);
+            bool bActual = itIndex != m_mTaskIndex.end() && itIndex->second.nStamp == stTask.nStamp;
+            if(bActual && stTask.pTask->GetState() == enumGISTaskQuered)
+                break;
+
+            std::pop_heap(aHeap.begin(), aHeap.end());
+            aHeap.pop_back();
+            m_nQueredHeapSize--;
+
+            //the task state is changed without notify, resync the index
+            if(bActual)
+                IndexTask(stTask.pTask);
+        }
+
+        if(aHeap.empty())
+        {
+            m_mQueredHeaps.erase(it++);
+            continue;
+        }
+
+        if(stBestTask.pTask == NULL || stBestTask < aHeap.front())
+            stBestTask = aHeap.front();
+        ++it;
+    }
+
+    return stBestTask.pTask;
+}
+
+void wxGISTaskCategory::UpdateTaskIndex(wxGISTask* const pTask)
+{
+    wxCHECK_RET(pTask, wxT("Input task pointer is null"));
+
+    wxCriticalSectionLocker lock(m_CritSect);
+
+    if(!pTask->HasSubTasks())
+    {
+        UpdateLeafIndex(pTask);
+        return;
+    }
+
+    //the task with subtasks is scheduled by subtasks, they change the index by themselves
+    UnindexTask(pTask);
+
+    //the leaves are reindexed only if subtasks are added or loaded or the priority they inherit is changed
+    PARENTINDEX stParentIndex = {pTask->GetSubTasksRevision(), pTask->GetCommonPriority()};
+    std::map<wxGISTask*, PARENTINDEX>::iterator it = m_mParentIndex.find(pTask);
+    if(it != m_mParentIndex.end() && it->second.nRevision == stParentIndex.nRevision && it->second.nPriority == stParentIndex.nPriority)
+        return;
+    m_mParentIndex[pTask] = stParentIndex;
+
     wxGISQueredTasksArray oaTasks;
-    GetQueredTasks(oaTasks);
+    pTask->GetLeafTasks(oaTasks);
     for(size_t i = 0; i < oaTasks.GetCount(); ++i)
     {
-        wxGISTask* pTask = oaTasks[i];
-        if(pTask && !IsGroupIdExecuting(pTask->GetGroupId()))//check if task from this group is executing
+        UpdateLeafIndex(oaTasks[i]);
+    }
+}
+
+void wxGISTaskCategory::UpdateLeafIndex(wxGISTask* const pTask)
+{
+    std::map<wxGISTask*, TASKINDEX>::const_iterator it = m_mTaskIndex.find(pTask);
+    if(it != m_mTaskIndex.end() && it->second.eState == pTask->GetState() && it->second.nGroupId == pTask->GetGroupId() && it->second.nPriority == pTask->GetCommonPriority())
+        return;
+    IndexTask(pTask);
+}
+
+void wxGISTaskCategory::RemoveFromTaskIndex(wxGISTask* const pTask)
+{
+    wxCHECK_RET(pTask, wxT("Input task pointer is null"));
+
+    wxCriticalSectionLocker lock(m_CritSect);
+
+    wxGISQueredTasksArray oaTasks;
+    pTask->GetLeafTasks(oaTasks);
+    for(size_t i = 0; i < oaTasks.GetCount(); ++i)
+    {
+        UnindexTask(oaTasks[i]);
+    }
+    UnindexTask(pTask);
+    m_mParentIndex.erase(pTask);
+}
+
+void wxGISTaskCategory::IndexTask(wxGISTask* const pTask)
+{
+    UnindexTask(pTask);
+
+    TASKINDEX stIndex = {pTask->GetState(), pTask->GetGroupId(), pTask->GetCommonPriority(), ++m_nIndexStamp};
+    m_mTaskIndex[pTask] = stIndex;
+
+    if(stIndex.eState == enumGISTaskWork)
+    {
+        m_nRunningTaskCount++;
+        if(stIndex.nGroupId != wxNOT_FOUND)
+            m_mnRunningGroups[stIndex.nGroupId]++;
+    }
+    else if(stIndex.eState == enumGISTaskQuered)
+    {
+        m_nQueredTaskCount++;
+        QUEREDTASK stTask = {stIndex.nPriority, stIndex.nStamp, pTask};
+        wxVector<QUEREDTASK> &aHeap = m_mQueredHeaps[stIndex.nGroupId];
+        aHeap.push_back(stTask);
+        std::push_heap(aHeap.begin(), aHeap.end());
+        m_nQueredHeapSize++;
+
+        //too many outdated items
+        if(m_nQueredHeapSize > size_t(m_nQueredTaskCount) * 2 + 64)
+            RebuildQueredHeap();
+    }
+}
+
+void wxGISTaskCategory::UnindexTask(wxGISTask* const pTask)
+{
+    std::map<wxGISTask*, TASKINDEX>::iterator it = m_mTaskIndex.find(pTask);
+    if(it == m_mTaskIndex.end())
+        return;
+
+    if(it->second.eState == enumGISTaskWork)
+    {
+        m_nRunningTaskCount--;
+        if(it->second.nGroupId != wxNOT_FOUND)
+        {
+            std::map<int, int>::iterator git = m_mnRunningGroups.find(it->second.nGroupId);
+            if(git != m_mnRunningGroups.end() && --git->second <= 0)
+                m_mnRunningGroups.erase(git);
+        }
+    }
+    else if(it->second.eState == enumGISTaskQuered)
+    {
+        m_nQueredTaskCount--;
+    }
+
+    //the heap item become outdated by stamp
+    m_mTaskIndex.erase(it);
+}
+
+void wxGISTaskCategory::RebuildQueredHeap(void)
+{
+    m_mQueredHeaps.clear();
+    m_nQueredHeapSize = 0;
+    for(std::map<wxGISTask*, TASKINDEX>::const_iterator it = m_mTaskIndex.begin(); it != m_mTaskIndex.end(); ++it)
+    {
+        if(it->second.eState == enumGISTaskQuered)
         {
-           if(nMinPriority > pTask->GetCommonPriority())//find the lowerest priority - this mean the high priority (closest to 0)
-           {
-               nMinPriority = pTask->GetCommonPriority();
-               pOutTask = pTask;
-           }
+            QUEREDTASK stTask = {it->second.nPriority, it->second.nStamp, it->first};
+            m_mQueredHeaps[it->second.nGroupId].push_back(stTask);
+            m_nQueredHeapSize++;
         }
     }
-    return pOutTask;
+    for(std::map<int, wxVector<QUEREDTASK> >::iterator it = m_mQueredHeaps.begin(); it != m_mQueredHeaps.end(); ++it)
+        std::make_heap(it->second.begin(), it->second.end());
 }
 
 void wxGISTaskCategory::GetQueredTasks(wxGISQueredTasksArray &oaTasks)
@@ -1842,15 +2219,7 @@ bool wxGISTaskCategory::IsGroupIdExecuting(int nGroupId) const
 {
     if(nGroupId == wxNOT_FOUND)
         return false;
-    for(wxGISTaskMap::const_iterator it = m_omSubTasks.begin(); it != m_omSubTasks.end(); ++it)
-    {
-        wxGISTask* pSubTask = dynamic_cast<wxGISTask*>(it->second);
-        if(pSubTask && pSubTask->IsGroupIdExecuting(nGroupId))
-        {
-            return true;
-        }
-    }
-    return false;
+    return m_mnRunningGroups.find(nGroupId) != m_mnRunningGroups.end();
 }
 
 
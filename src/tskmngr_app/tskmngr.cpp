@@ -91,6 +91,9 @@ void wxGISTaskManager::Exit(void)
         wxGISTaskCategory* pTaskCategory = it->second;
         wxDELETE(pTaskCategory);
     }
+
+    //write the delayed task configs
+    wxGISTaskStoreWriter::Cleanup();
 }
 
 void wxGISTaskManager::DestroyCategories()
@@ -0,0 +1,350 @@
+/******************************************************************************
+ * Project:  wxGIS
+ * Purpose:  Raster row kernels test. The SIMD kernels results are compared
+ *           with the scalar reference for the row lengths with and without
+ *           the vector tail, the resampled rows are compared with the
+ *           reference interpolation of the raster draw thread.
+ * Author:   Dmitry Baryshnikov (aka Bishop), polimax@mail.ru
+ ******************************************************************************
+*   Copyright (C) 2014 Dmitry Baryshnikov
+*
+*    This program is free software: you can redistribute it and/or modify
+*    it under the terms of the GNU General Public License as published by
+*    the Free Software Foundation, either version 2 of the License, or
+*    (at your option) any later version.
+*
+*    This program is distributed in the hope that it will be useful,
+*    but WITHOUT ANY WARRANTY; without even the implied warranty of
+*    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+*    GNU General Public License for more details.
+*
+*    You should have received a copy of the GNU General Public License
+*    along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ ****************************************************************************/
+#include "wxgis/carto/rasterkernels.h"
+#include "wxgis/carto/stretch.h"
+#include "wxgis/core/app.h"
+
+#include <wx/init.h>
+
+#include <stdio.h>
+#include <stdlib.h>
+
+#define TEST_MAX_COUNT 67
+#define TEST_RASTER_X_SIZE 37
+#define TEST_RASTER_Y_SIZE 29
+#define TEST_NODATA 7.0
+
+static const int g_anCounts[] = {0, 1, 7, 15, 16, 17, 31, 32, 33, 47, TEST_MAX_COUNT};
+
+static int g_nFailed = 0;
+
+static void Check(bool bResult, const char* pszMessage)
+{
+    printf("%s: %s\n", bResult ? "PASS" : "FAIL", pszMessage);
+    if(!bResult)
+        g_nFailed++;
+}
+
+static unsigned char StretchValue(float fInput, float fM, float fDX, bool bClamp, bool bInvert)
+{
+    unsigned char cOutput;
+    if(bClamp)
+    {
+        float fVal = fM * (fInput - fDX);
+        if(fVal < 0)
+            cOutput = 0;
+        else if(fVal > 255)
+            cOutput = 255;
+        else
+            cOutput = (unsigned char)fVal;
+    }
+    else
+    {
+        cOutput = (unsigned char)((int)fInput & 0xFF);
+    }
+    return bInvert ? 255 - cOutput : cOutput;
+}
+
+static bool TestStretchRow(bool bClamp, bool bInvert)
+{
+    float afInput[TEST_MAX_COUNT];
+    for(int i = 0; i < TEST_MAX_COUNT; ++i)
+        afInput[i] = -40.25f + i * 7.5f;
+
+    const float fM = 1.75f, fDX = 12.5f;
+    for(size_t j = 0; j < sizeof(g_anCounts) / sizeof(g_anCounts[0]); ++j)
+    {
+        int nCount = g_anCounts[j];
+        unsigned char abyOutput[TEST_MAX_COUNT + 1];
+        abyOutput[nCount] = 0xA5;
+        StretchRow(afInput, abyOutput, nCount, fM, fDX, bClamp, bInvert);
+        if(abyOutput[nCount] != 0xA5)
+            return false;
+        for(int i = 0; i < nCount; ++i)
+        {
+            if(abyOutput[i] != StretchValue(afInput[i], fM, fDX, bClamp, bInvert))
+                return false;
+        }
+    }
+    return true;
+}
+
+static bool TestNoDataMaskRow(double dfNoData)
+{
+    float afInput[TEST_MAX_COUNT];
+    for(int i = 0; i < TEST_MAX_COUNT; ++i)
+        afInput[i] = i % 3 == 0 ? (float)dfNoData : (float)i;
+
+    //the mask is the same as wxGISStretch::IsNoData gives for the pixel
+    wxGISStretch oStretch;
+    oStretch.SetNoData(dfNoData);
+    for(size_t j = 0; j < sizeof(g_anCounts) / sizeof(g_anCounts[0]); ++j)
+    {
+        int nCount = g_anCounts[j];
+        unsigned char abyMask[TEST_MAX_COUNT];
+        NoDataMaskRow(afInput, abyMask, nCount, dfNoData);
+        for(int i = 0; i < nCount; ++i)
+        {
+            if(abyMask[i] != (oStretch.IsNoData((double)afInput[i]) ? 0xFF : 0))
+                return false;
+        }
+    }
+    return true;
+}
+
+static bool TestPackARGB32Row(bool bAlpha, bool bMask)
+{
+    unsigned char abyR[TEST_MAX_COUNT], abyG[TEST_MAX_COUNT], abyB[TEST_MAX_COUNT], abyA[TEST_MAX_COUNT], abyMask[TEST_MAX_COUNT];
+    for(int i = 0; i < TEST_MAX_COUNT; ++i)
+    {
+        abyR[i] = (unsigned char)(i * 3);
+        abyG[i] = (unsigned char)(i * 5 + 1);
+        abyB[i] = (unsigned char)(i * 7 + 2);
+        abyA[i] = (unsigned char)(255 - i);
+        abyMask[i] = i % 4 == 1 ? 0xFF : 0;
+    }
+
+    const wxUint32 nNoDataColor = 0x00123456;
+    for(size_t j = 0; j < sizeof(g_anCounts) / sizeof(g_anCounts[0]); ++j)
+    {
+        int nCount = g_anCounts[j];
+        wxUint32 anOutput[TEST_MAX_COUNT];
+        PackARGB32Row(abyR, abyG, abyB, bAlpha ? abyA : NULL, bMask ? abyMask : NULL, nNoDataColor, (unsigned char*)anOutput, nCount);
+        for(int i = 0; i < nCount; ++i)
+        {
+            wxUint32 nExpected;
+            if(bMask && abyMask[i])
+                nExpected = nNoDataColor;
+            else
+                nExpected = ((wxUint32)(bAlpha ? abyA[i] : 255) << 24) | ((wxUint32)abyR[i] << 16) | ((wxUint32)abyG[i] << 8) | (wxUint32)abyB[i];
+            if(anOutput[i] != nExpected)
+                return false;
+        }
+    }
+    return true;
+}
+
+static bool TestLookupRow(void)
+{
+    unsigned char abyLUT[65536];
+    for(int i = 0; i < 65536; ++i)
+        abyLUT[i] = (unsigned char)(i >> 8);
+
+    wxUint16 anInput[TEST_MAX_COUNT];
+    for(int i = 0; i < TEST_MAX_COUNT; ++i)
+        anInput[i] = (wxUint16)(i * 977);
+
+    for(size_t j = 0; j < sizeof(g_anCounts) / sizeof(g_anCounts[0]); ++j)
+    {
+        int nCount = g_anCounts[j];
+        unsigned char abyOutput[TEST_MAX_COUNT];
+        LookupRow(abyLUT, anInput, abyOutput, nCount);
+        for(int i = 0; i < nCount; ++i)
+        {
+            if(abyOutput[i] != abyLUT[anInput[i]])
+                return false;
+        }
+    }
+    return true;
+}
+
+/** @class wxGISTestApplication
+
+    The application stub, the renderers read the settings by the application name.
+*/
+
+class wxGISTestApplication : public IApplication
+{
+public:
+    virtual void OnAppAbout(void) {};
+    virtual void OnAppOptions(void) {};
+    virtual wxString GetAppName(void) const { return wxString(wxT("test_rasterkernels")); };
+    virtual wxString GetAppDisplayName(void) const { return GetAppName(); };
+    virtual wxString GetAppDisplayNameShort(void) const { return GetAppName(); };
+    virtual wxString GetAppVersionString(void) const { return wxEmptyString; };
+    virtual bool CreateApp(void) { return true; };
+    virtual bool SetupLog(const wxString &sLogPath, const wxString &sNamePrefix = wxEmptyString) { return true; };
+    virtual wxString GetDecimalPoint(void) const { return wxString(wxT(".")); };
+    virtual wxGISEnumReturnType SetupLoc(const wxString &sLoc, const wxString &sLocPath) { return enumGISReturnOk; };
+    virtual bool SetupSys(const wxString &sSysPath) { return true; };
+    virtual void SetDebugMode(bool bDebugMode) {};
+};
+
+/** @class wxGISTestGreyScaleRenderer
+
+    The grey scale renderer without layer with the stretch and the row kernels switch set by the test.
+*/
+
+class wxGISTestGreyScaleRenderer : public wxGISRasterGreyScaleRenderer
+{
+public:
+    wxGISTestGreyScaleRenderer(void) : wxGISRasterGreyScaleRenderer(NULL) {};
+    void SetUseRowKernels(bool bUseRowKernels) { m_bUseRowKernels = bUseRowKernels; };
+    void SetStretch(double dfMin, double dfMax, double dfNoData)
+    {
+        m_oStretch.SetStats(dfMin, dfMax, (dfMin + dfMax) / 2, (dfMax - dfMin) / 5);
+        m_oStretch.SetNoData(dfNoData);
+    };
+};
+
+/** @class wxGISTestRGBARenderer
+
+    The RGB renderer without layer with the stretch and the row kernels switch set by the test.
+*/
+
+class wxGISTestRGBARenderer : public wxGISRasterRGBARenderer
+{
+public:
+    wxGISTestRGBARenderer(void) : wxGISRasterRGBARenderer(NULL) {};
+    void SetUseRowKernels(bool bUseRowKernels) { m_bUseRowKernels = bUseRowKernels; };
+    void SetStretch(double dfMin, double dfMax, double dfNoData)
+    {
+        for(size_t i = 0; i < 4; ++i)
+        {
+            m_paStretch[i]->SetStats(dfMin, dfMax, (dfMin + dfMax) / 2, (dfMax - dfMin) / 5);
+            m_paStretch[i]->SetNoData(dfNoData);
+        }
+    };
+};
+
+/** \fn void* CreateTestRaster(GDALDataType eDT, int nBandCount)
+    \brief Create the pixel interleaved raster with the TEST_NODATA samples, the float samples are not integer
+*/
+
+static void* CreateTestRaster(GDALDataType eDT, int nBandCount)
+{
+    int nCount = TEST_RASTER_X_SIZE * TEST_RASTER_Y_SIZE * nBandCount;
+    void* pData = CPLMalloc(nCount * GDALGetDataTypeSize(eDT) / 8);
+    for(int i = 0; i < nCount; ++i)
+    {
+        int nValue = (i * 37 + (i / TEST_RASTER_X_SIZE) * 13) % 251;
+        if(i % 17 == 0)
+            nValue = (int)TEST_NODATA;
+        switch(eDT)
+        {
+        case GDT_Byte:
+            ((GByte*)pData)[i] = (GByte)nValue;
+            break;
+        case GDT_UInt16:
+            ((GUInt16*)pData)[i] = (GUInt16)(nValue * 200);
+            break;
+        case GDT_Int16:
+            ((GInt16*)pData)[i] = (GInt16)(nValue * 100 - 12000);
+            break;
+        case GDT_Float32:
+            ((float*)pData)[i] = (float)nValue * 1.1f;
+            break;
+        default:
+            break;
+        };
+    }
+    return pData;
+}
+
+/** \fn bool TestResampleRasterRows(R* pRenderer, GDALDataType eDT, int nBandCount, wxGISEnumDrawQuality eQuality, int nOutXSize, int nOutYSize)
+    \brief Draw the test raster by the row kernels and by the reference interpolation, the channels may differ by one as the kernels use float rows
+*/
+
+template<class R> static bool TestResampleRasterRows(R* pRenderer, GDALDataType eDT, int nBandCount, wxGISEnumDrawQuality eQuality, int nOutXSize, int nOutYSize)
+{
+    RAWPIXELDATA stPixelData;
+    stPixelData.pPixelData = CreateTestRaster(eDT, nBandCount);
+    stPixelData.nPixelDataWidth = TEST_RASTER_X_SIZE;
+    stPixelData.nPixelDataHeight = TEST_RASTER_Y_SIZE;
+    stPixelData.dPixelDataWidth = TEST_RASTER_X_SIZE;
+    stPixelData.dPixelDataHeight = TEST_RASTER_Y_SIZE;
+    stPixelData.dPixelDeltaX = stPixelData.dPixelDeltaY = 0;
+    stPixelData.nOutputWidth = nOutXSize;
+    stPixelData.nOutputHeight = nOutYSize;
+
+    wxVector<unsigned char> abyKernels(nOutXSize * nOutYSize * 4), abyReference(nOutXSize * nOutYSize * 4);
+    RASTERDRAWJOB stJob = {&stPixelData, eDT, nBandCount, &abyKernels[0], eQuality, nOutXSize, nOutYSize, 0, nOutYSize, pRenderer, NULL, NULL};
+    pRenderer->SetUseRowKernels(true);
+    wxRasterDrawThread::DrawRows(stJob);
+
+    stJob.pTransformData = &abyReference[0];
+    pRenderer->SetUseRowKernels(false);
+    wxRasterDrawThread::DrawRows(stJob);
+    CPLFree(stPixelData.pPixelData);
+
+    for(size_t i = 0; i < abyKernels.size(); ++i)
+    {
+        if(abs((int)abyKernels[i] - (int)abyReference[i]) > 1)
+        {
+            printf("  the pixel %d, %d channel %d: %d instead of %d\n", (int)(i / 4) % nOutXSize, (int)(i / 4) / nOutXSize, (int)(i % 4), abyKernels[i], abyReference[i]);
+            return false;
+        }
+    }
+    return true;
+}
+
+int main(int argc, char **argv)
+{
+    wxInitializer initializer;
+    if(!initializer)
+    {
+        fprintf(stderr, "Failed to initialize the wxWidgets library\n");
+        return EXIT_FAILURE;
+    }
+    //the renderers without layer assert on the missing dataset statistics
+    wxDisableAsserts();
+    SetApplication(new wxGISTestApplication());
+
+    Check(TestStretchRow(true, false), "StretchRow clamps the stretched values");
+    Check(TestStretchRow(true, true), "StretchRow inverts the clamped values");
+    Check(TestStretchRow(false, false), "StretchRow truncates the values to byte without clamp");
+    Check(TestNoDataMaskRow(-9999.0), "NoDataMaskRow marks the nodata values");
+    Check(TestNoDataMaskRow(1.1), "NoDataMaskRow compares the nodata in double as IsNoData do");
+    Check(TestPackARGB32Row(false, false), "PackARGB32Row packs opaque pixels");
+    Check(TestPackARGB32Row(true, false), "PackARGB32Row packs the alpha band");
+    Check(TestPackARGB32Row(true, true), "PackARGB32Row sets the masked pixels to nodata color");
+    Check(TestLookupRow(), "LookupRow maps the samples through the table");
+
+    //the row kernels and the reference interpolation give the same pixels
+    const wxGISEnumDrawQuality aeQualities[] = {enumGISQualityNearest, enumGISQualityBilinear, enumGISQualityBicubic};
+    const char* apszQualities[] = {"nearest", "bilinear", "bicubic"};
+    wxGISTestGreyScaleRenderer* pGreyRenderer = new wxGISTestGreyScaleRenderer();
+    wxGISTestRGBARenderer* pRGBRenderer = new wxGISTestRGBARenderer();
+    for(size_t i = 0; i < sizeof(aeQualities) / sizeof(aeQualities[0]); ++i)
+    {
+        //the interpolated values may be near the nodata, so it is tested on nearest only
+        double dfNoData = aeQualities[i] == enumGISQualityNearest ? TEST_NODATA : NOTNODATA;
+        pGreyRenderer->SetStretch(0, 250, dfNoData);
+        pRGBRenderer->SetStretch(0, 250, dfNoData);
+        Check(TestResampleRasterRows(pGreyRenderer, GDT_Byte, 1, aeQualities[i], 53, 41), CPLSPrintf("the %s grey scale Byte rows are the same as reference", apszQualities[i]));
+        Check(TestResampleRasterRows(pGreyRenderer, GDT_Byte, 1, aeQualities[i], 19, 13), CPLSPrintf("the %s grey scale downsampled Byte rows are the same as reference", apszQualities[i]));
+        Check(TestResampleRasterRows(pRGBRenderer, GDT_Byte, 3, aeQualities[i], 53, 41), CPLSPrintf("the %s RGB Byte rows are the same as reference", apszQualities[i]));
+        pGreyRenderer->SetStretch(0, 50000, dfNoData);
+        Check(TestResampleRasterRows(pGreyRenderer, GDT_UInt16, 1, aeQualities[i], 53, 41), CPLSPrintf("the %s grey scale UInt16 rows are the same as reference", apszQualities[i]));
+        pGreyRenderer->SetStretch(-12000, 13000, dfNoData);
+        Check(TestResampleRasterRows(pGreyRenderer, GDT_Int16, 1, aeQualities[i], 53, 41), CPLSPrintf("the %s grey scale Int16 rows are the same as reference", apszQualities[i]));
+        pGreyRenderer->SetStretch(0, 275, dfNoData);
+        Check(TestResampleRasterRows(pGreyRenderer, GDT_Float32, 1, aeQualities[i], 53, 41), CPLSPrintf("the %s grey scale Float32 rows are the same as reference", apszQualities[i]));
+    }
+    wxDELETE(pRGBRenderer);
+    wxDELETE(pGreyRenderer);
+    SetApplication(NULL);
+
+    return g_nFailed == 0 ? EXIT_SUCCESS : EXIT_FAILURE;
+}
@@ -0,0 +1,139 @@
+/******************************************************************************
+ * Project:  wxGIS
+ * Purpose:  Raster row kernels benchmark. The time of the raster draw thread
+ *           resampling by the row kernels and by the reference interpolation.
+ * Author:   Dmitry Baryshnikov (aka Bishop), polimax@mail.ru
+ ******************************************************************************
+*   Copyright (C) 2014 Dmitry Baryshnikov
+*
+*    This program is free software: you can redistribute it and/or modify
+*    it under the terms of the GNU General Public License as published by
+*    the Free Software Foundation, either version 2 of the License, or
+*    (at your option) any later version.
+*
+*    This program is distributed in the hope that it will be useful,
+*    but WITHOUT ANY WARRANTY; without even the implied warranty of
+*    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+*    GNU General Public License for more details.
+*
+*    You should have received a copy of the GNU General Public License
+*    along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ ****************************************************************************/
+#include "wxgis/carto/rasterkernels.h"
+#include "wxgis/core/app.h"
+
+#include <wx/init.h>
+#include <wx/stopwatch.h>
+
+#include <stdio.h>
+#include <stdlib.h>
+
+#define BENCH_RASTER_SIZE 2048
+#define BENCH_OUT_SIZE 1536
+
+/** @class wxGISBenchApplication
+
+    The application stub, the renderers read the settings by the application name.
+*/
+
+class wxGISBenchApplication : public IApplication
+{
+public:
+    virtual void OnAppAbout(void) {};
+    virtual void OnAppOptions(void) {};
+    virtual wxString GetAppName(void) const { return wxString(wxT("bench_rasterkernels")); };
+    virtual wxString GetAppDisplayName(void) const { return GetAppName(); };
+    virtual wxString GetAppDisplayNameShort(void) const { return GetAppName(); };
+    virtual wxString GetAppVersionString(void) const { return wxEmptyString; };
+    virtual bool CreateApp(void) { return true; };
+    virtual bool SetupLog(const wxString &sLogPath, const wxString &sNamePrefix = wxEmptyString) { return true; };
+    virtual wxString GetDecimalPoint(void) const { return wxString(wxT(".")); };
+    virtual wxGISEnumReturnType SetupLoc(const wxString &sLoc, const wxString &sLocPath) { return enumGISReturnOk; };
+    virtual bool SetupSys(const wxString &sSysPath) { return true; };
+    virtual void SetDebugMode(bool bDebugMode) {};
+};
+
+/** @class wxGISBenchRGBARenderer
+
+    The RGB renderer without layer with the row kernels switch set by the benchmark.
+*/
+
+class wxGISBenchRGBARenderer : public wxGISRasterRGBARenderer
+{
+public:
+    wxGISBenchRGBARenderer(void) : wxGISRasterRGBARenderer(NULL)
+    {
+        for(size_t i = 0; i < 4; ++i)
+            m_paStretch[i]->SetStats(0, 250, 125, 50);
+    };
+    void SetUseRowKernels(bool bUseRowKernels) { m_bUseRowKernels = bUseRowKernels; };
+};
+
+/** \fn long DrawRaster(wxGISBenchRGBARenderer* pRenderer, RAWPIXELDATA &stPixelData, GDALDataType eDT, int nBandCount, wxGISEnumDrawQuality eQuality, unsigned char* pOutput, bool bUseRowKernels)
+    \brief Resample the whole output in the calling thread and return the time in ms
+*/
+
+static long DrawRaster(wxGISBenchRGBARenderer* pRenderer, RAWPIXELDATA &stPixelData, GDALDataType eDT, int nBandCount, wxGISEnumDrawQuality eQuality, unsigned char* pOutput, bool bUseRowKernels)
+{
+    RASTERDRAWJOB stJob = {&stPixelData, eDT, nBandCount, pOutput, eQuality, BENCH_OUT_SIZE, BENCH_OUT_SIZE, 0, BENCH_OUT_SIZE, pRenderer, NULL, NULL};
+    pRenderer->SetUseRowKernels(bUseRowKernels);
+    wxStopWatch sw;
+    wxRasterDrawThread::DrawRows(stJob);
+    return sw.Time();
+}
+
+int main(int argc, char **argv)
+{
+    wxInitializer initializer;
+    if(!initializer)
+    {
+        fprintf(stderr, "Failed to initialize the wxWidgets library\n");
+        return EXIT_FAILURE;
+    }
+    //the renderer without layer asserts on the missing dataset statistics
+    wxDisableAsserts();
+    SetApplication(new wxGISBenchApplication());
+
+    const GDALDataType aeTypes[] = {GDT_Byte, GDT_UInt16, GDT_Float32};
+    const wxGISEnumDrawQuality aeQualities[] = {enumGISQualityNearest, enumGISQualityBilinear, enumGISQualityBicubic};
+    const char* apszQualities[] = {"nearest", "bilinear", "bicubic"};
+    const int anBandCounts[] = {1, 3};
+
+    wxGISBenchRGBARenderer* pRenderer = new wxGISBenchRGBARenderer();
+    unsigned char* pOutput = (unsigned char*)CPLMalloc(BENCH_OUT_SIZE * BENCH_OUT_SIZE * 4);
+    printf("%dx%d raster to %dx%d ARGB32, one thread\n", BENCH_RASTER_SIZE, BENCH_RASTER_SIZE, BENCH_OUT_SIZE, BENCH_OUT_SIZE);
+    printf("%-8s %-6s %-9s %10s %10s %8s\n", "type", "bands", "quality", "reference", "kernels", "speedup");
+
+    for(size_t t = 0; t < sizeof(aeTypes) / sizeof(aeTypes[0]); ++t)
+    {
+        for(size_t b = 0; b < sizeof(anBandCounts) / sizeof(anBandCounts[0]); ++b)
+        {
+            int nCount = BENCH_RASTER_SIZE * BENCH_RASTER_SIZE * anBandCounts[b];
+            int nDataSize = GDALGetDataTypeSize(aeTypes[t]) / 8;
+            RAWPIXELDATA stPixelData;
+            wxVector<int> anValues(nCount);
+            for(int i = 0; i < nCount; ++i)
+                anValues[i] = (i * 37) % 251;
+            stPixelData.pPixelData = CPLMalloc(nCount * nDataSize);
+            GDALCopyWords(&anValues[0], GDT_Int32, sizeof(int), stPixelData.pPixelData, aeTypes[t], nDataSize, nCount);
+            stPixelData.nPixelDataWidth = stPixelData.nPixelDataHeight = BENCH_RASTER_SIZE;
+            stPixelData.dPixelDataWidth = stPixelData.dPixelDataHeight = BENCH_RASTER_SIZE;
+            stPixelData.dPixelDeltaX = stPixelData.dPixelDeltaY = 0;
+            stPixelData.nOutputWidth = stPixelData.nOutputHeight = BENCH_OUT_SIZE;
+
+            for(size_t q = 0; q < sizeof(aeQualities) / sizeof(aeQualities[0]); ++q)
+            {
+                long nReference = DrawRaster(pRenderer, stPixelData, aeTypes[t], anBandCounts[b], aeQualities[q], pOutput, false);
+                long nKernels = DrawRaster(pRenderer, stPixelData, aeTypes[t], anBandCounts[b], aeQualities[q], pOutput, true);
+                printf("%-8s %-6d %-9s %8ldms %8ldms %7.2fx\n", GDALGetDataTypeName(aeTypes[t]), anBandCounts[b], apszQualities[q], nReference, nKernels, nKernels > 0 ? (double)nReference / nKernels : 0.0);
+            }
+            CPLFree(stPixelData.pPixelData);
+        }
+    }
+
+    CPLFree(pOutput);
+    wxDELETE(pRenderer);
+    SetApplication(NULL);
+
+    return EXIT_SUCCESS;
+}
@@ -0,0 +1,173 @@
+/******************************************************************************
+ * Project:  wxGIS
+ * Purpose:  wxGISProcess output reading test. The child script prints the
+ *           burst of progress lines, each of them should come to the process
+ *           once, whole and in order.
+ * Author:   Dmitry Baryshnikov (aka Bishop), polimax@mail.ru
+ ******************************************************************************
+*   Copyright (C) 2014 Dmitry Baryshnikov
+*
+*    This program is free software: you can redistribute it and/or modify
+*    it under the terms of the GNU General Public License as published by
+*    the Free Software Foundation, either version 2 of the License, or
+*    (at your option) any later version.
+*
+*    This program is distributed in the hope that it will be useful,
+*    but WITHOUT ANY WARRANTY; without even the implied warranty of
+*    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+*    GNU General Public License for more details.
+*
+*    You should have received a copy of the GNU General Public License
+*    along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ ****************************************************************************/
+#include "wxgis/core/process.h"
+
+#include <wx/init.h>
+#include <wx/utils.h>
+
+#include <stdio.h>
+#include <stdlib.h>
+
+#define TEST_LINE_COUNT 5000
+#define TEST_WAIT_TIMEOUT 30000 //30 sec
+
+/** @class wxGISProcessTest
+
+    The process running the progress script. It counts the info lines and checks they come in order.
+*/
+
+class wxGISProcessTest : public wxGISProcess
+{
+public:
+    wxGISProcessTest(const wxString &sScriptPath) : wxGISProcess(NULL), m_sScriptPath(sScriptPath)
+    {
+        m_nLines = 0;
+        m_bInOrder = true;
+        m_bHasLast = false;
+        m_bPercentGrows = true;
+        m_dfLastDone = 0;
+    }
+
+    virtual void ProcessInput(wxString & sInputData)
+    {
+        wxGISProcess::ProcessInput(sInputData);
+        wxCriticalSectionLocker locker(m_CritSect);
+        if(m_dfDone < m_dfLastDone)
+            m_bPercentGrows = false;
+        m_dfLastDone = m_dfDone;
+    }
+
+    void Finish(void)
+    {
+        DetachFromReader(true);
+    }
+
+    int GetLineCount(void)
+    {
+        wxCriticalSectionLocker locker(m_CritSect);
+        return m_nLines;
+    }
+
+    bool IsInOrder(void)
+    {
+        wxCriticalSectionLocker locker(m_CritSect);
+        return m_bInOrder;
+    }
+
+    bool HasLast(void)
+    {
+        wxCriticalSectionLocker locker(m_CritSect);
+        return m_bHasLast;
+    }
+
+    bool IsPercentGrows(void)
+    {
+        wxCriticalSectionLocker locker(m_CritSect);
+        return m_bPercentGrows;
+    }
+
+    double GetDone(void)
+    {
+        wxCriticalSectionLocker locker(m_CritSect);
+        return m_dfLastDone;
+    }
+protected:
+    virtual long Execute(void)
+    {
+        return wxExecute(wxString::Format(wxT("/bin/sh %s %d"), m_sScriptPath.c_str(), TEST_LINE_COUNT), wxEXEC_ASYNC, this);
+    }
+
+    virtual void AddInfo(wxGISEnumMessageType eType, const wxString &sInfoData)
+    {
+        wxCriticalSectionLocker locker(m_CritSect);
+        if(eType != enumGISMessageNormal)
+        {
+            m_bInOrder = false;
+            return;
+        }
+
+        if(sInfoData == wxT("last"))
+        {
+            m_bHasLast = true;
+            return;
+        }
+
+        long nLine = 0;
+        wxString sRest;
+        if(m_bHasLast || !sInfoData.StartsWith(wxT("line "), &sRest) || !sRest.ToLong(&nLine) || nLine != m_nLines + 1)
+            m_bInOrder = false;
+        m_nLines++;
+    }
+protected:
+    wxString m_sScriptPath;
+    wxCriticalSection m_CritSect;
+    int m_nLines;
+    bool m_bInOrder, m_bHasLast, m_bPercentGrows;
+    double m_dfLastDone;
+};
+
+static int g_nFailed = 0;
+
+static void Check(bool bResult, const char* pszMessage)
+{
+    printf("%s: %s\n", bResult ? "PASS" : "FAIL", pszMessage);
+    if(!bResult)
+        g_nFailed++;
+}
+
+int main(int argc, char **argv)
+{
+    if(argc < 2)
+    {
+        fprintf(stderr, "Usage: %s <progress script path>\n", argv[0]);
+        return EXIT_FAILURE;
+    }
+
+    wxInitializer initializer;
+    if(!initializer)
+    {
+        fprintf(stderr, "Failed to initialize the wxWidgets library\n");
+        return EXIT_FAILURE;
+    }
+
+    //the process is owned by wx until the termination is handled, so it is not deleted here
+    wxGISProcessTest* pProcess = new wxGISProcessTest(wxString(argv[1], wxConvLocal));
+    if(!pProcess->Start())
+    {
+        fprintf(stderr, "Failed to start the progress script\n");
+        return EXIT_FAILURE;
+    }
+
+    //the last line without line feed is passed after the end of output
+    for(int i = 0; i < TEST_WAIT_TIMEOUT / 10 && !pProcess->HasLast(); ++i)
+        wxMilliSleep(10);
+    pProcess->Finish();
+
+    Check(pProcess->GetLineCount() == TEST_LINE_COUNT, "each output line is read once");
+    Check(pProcess->IsInOrder(), "the lines are whole and in order");
+    Check(pProcess->HasLast(), "the last line without line feed is read");
+    Check(pProcess->IsPercentGrows(), "the percent never decreases");
+    Check(pProcess->GetDone() == 100.0, "the last percent is 100");
+
+    return g_nFailed == 0 ? EXIT_SUCCESS : EXIT_FAILURE;
+}
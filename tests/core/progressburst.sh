@@ -0,0 +1,35 @@
+#!/bin/sh
+# ****************************************************************************
+# * Project:  wxGIS
+# * Purpose:  The burst of progress lines as the geoprocessing tool prints.
+# *           Usage: progressburst.sh <line count>
+# * Author:   Dmitry Baryshnikov (aka Bishop), polimax@mail.ru
+# ****************************************************************************
+# *   Copyright (C) 2014 Dmitry Baryshnikov
+# *
+# *    This program is free software: you can redistribute it and/or modify
+# *    it under the terms of the GNU General Public License as published by
+# *    the Free Software Foundation, either version 2 of the License, or
+# *    (at your option) any later version.
+# *
+# *    This program is distributed in the hope that it will be useful,
+# *    but WITHOUT ANY WARRANTY; without even the implied warranty of
+# *    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+# *    GNU General Public License for more details.
+# *
+# *    You should have received a copy of the GNU General Public License
+# *    along with this program.  If not, see <http://www.gnu.org/licenses/>.
+# ****************************************************************************
+
+COUNT=$1
+i=1
+while [ $i -le $COUNT ]; do
+    echo "INFO: line $i"
+    if [ $((i % 50)) -eq 0 ]; then
+        echo "DONE: $((i * 100 / COUNT))%"
+    fi
+    i=$((i + 1))
+done
+echo "DONE: 100%"
+# the last line without line feed
+printf "INFO: last"
@@ -0,0 +1,169 @@
+/******************************************************************************
+ * Project:  wxGIS
+ * Purpose:  wxGISAttributeIndex test. The exact string keys, the range
+ *           lookups and the sorted index updates after add and remove.
+ * Author:   Dmitry Baryshnikov (aka Bishop), polimax@mail.ru
+ ******************************************************************************
+*   Copyright (C) 2014 Dmitry Baryshnikov
+*
+*    This program is free software: you can redistribute it and/or modify
+*    it under the terms of the GNU General Public License as published by
+*    the Free Software Foundation, either version 2 of the License, or
+*    (at your option) any later version.
+*
+*    This program is distributed in the hope that it will be useful,
+*    but WITHOUT ANY WARRANTY; without even the implied warranty of
+*    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+*    GNU General Public License for more details.
+*
+*    You should have received a copy of the GNU General Public License
+*    along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ ****************************************************************************/
+#include "wxgis/datasource/attrindex.h"
+
+#include <wx/init.h>
+
+#include <algorithm>
+#include <stdio.h>
+#include <stdlib.h>
+
+#define TEST_ROW_COUNT 20000
+
+static int g_nFailed = 0;
+
+static void Check(bool bResult, const char* pszMessage)
+{
+    printf("%s: %s\n", bResult ? "PASS" : "FAIL", pszMessage);
+    if(!bResult)
+        g_nFailed++;
+}
+
+static void AddString(wxGISAttributeIndex* pIndex, OGRFeatureDefn* poDefn, long nFID, const char* pszValue)
+{
+    OGRFeature* poFeature = new OGRFeature(poDefn);
+    if(pszValue)
+        poFeature->SetField(0, pszValue);
+    pIndex->Add(nFID, poFeature);
+    OGRFeature::DestroyFeature(poFeature);
+}
+
+static void AddNumber(wxGISAttributeIndex* pIndex, OGRFeatureDefn* poDefn, long nFID, int nValue)
+{
+    OGRFeature* poFeature = new OGRFeature(poDefn);
+    poFeature->SetField(1, nValue);
+    pIndex->Add(nFID, poFeature);
+    OGRFeature::DestroyFeature(poFeature);
+}
+
+static bool IsSame(const wxVector<long> &anA, const wxVector<long> &anB)
+{
+    if(anA.size() != anB.size())
+        return false;
+    for(size_t i = 0; i < anA.size(); ++i)
+    {
+        if(anA[i] != anB[i])
+            return false;
+    }
+    return true;
+}
+
+/** \fn bool IsFound(wxGISAttributeIndex* pIndex, wxGISEnumFilterOperator eOp, double dfValue, const char* pszValue, const long* panExpected, size_t nCount)
+    \brief Find the FIDs and compare them sorted with expected ones
+*/
+
+static bool IsFound(wxGISAttributeIndex* pIndex, wxGISEnumFilterOperator eOp, double dfValue, const char* pszValue, const long* panExpected, size_t nCount)
+{
+    wxVector<long> anFIDs;
+    pIndex->Find(eOp, dfValue, pszValue, anFIDs);
+    std::sort(anFIDs.begin(), anFIDs.end());
+    if(anFIDs.size() != nCount)
+        return false;
+    for(size_t i = 0; i < nCount; ++i)
+    {
+        if(anFIDs[i] != panExpected[i])
+            return false;
+    }
+    return true;
+}
+
+int main(int argc, char **argv)
+{
+    wxInitializer initializer;
+    if(!initializer)
+    {
+        fprintf(stderr, "Failed to initialize the wxWidgets library\n");
+        return EXIT_FAILURE;
+    }
+
+    OGRFeatureDefn* poDefn = new OGRFeatureDefn("test");
+    poDefn->Reference();
+    OGRFieldDefn oName("name", OFTString);
+    poDefn->AddFieldDefn(&oName);
+    OGRFieldDefn oValue("value", OFTInteger);
+    poDefn->AddFieldDefn(&oValue);
+
+    //the string keys are exact
+    wxGISAttributeIndex* pIndex = new wxGISAttributeIndex(0, OFTString);
+    AddString(pIndex, poDefn, 0, "Alpha");
+    AddString(pIndex, poDefn, 1, "alpha");
+    AddString(pIndex, poDefn, 2, NULL);
+    AddString(pIndex, poDefn, 3, "Beta");
+    AddString(pIndex, poDefn, 4, "Alpha");
+    Check(pIndex->GetCount() == 4, "the null value is not indexed");
+
+    const long anAlpha[] = {0, 4};
+    const long anLowerAlpha[] = {1};
+    const long anNotAlpha[] = {1, 3};
+    const long anLessB[] = {0, 4};
+    const long anGreaterAlpha[] = {1, 3};
+    Check(IsFound(pIndex, enumGISFilterOpEQ, 0, "Alpha", anAlpha, 2), "= finds the exact string only");
+    Check(IsFound(pIndex, enumGISFilterOpEQ, 0, "alpha", anLowerAlpha, 1), "= is case sensitive");
+    Check(IsFound(pIndex, enumGISFilterOpEQ, 0, "ALPHA", NULL, 0), "= does not fold the case");
+    Check(IsFound(pIndex, enumGISFilterOpNE, 0, "Alpha", anNotAlpha, 2), "<> skips the exact string and null");
+    Check(IsFound(pIndex, enumGISFilterOpLT, 0, "B", anLessB, 2), "< uses the byte order");
+    Check(IsFound(pIndex, enumGISFilterOpGT, 0, "Alpha", anGreaterAlpha, 2), "> skips all equal values");
+
+    //the update after the sorted index is created
+    pIndex->Remove(0);
+    AddString(pIndex, poDefn, 5, "Aardvark");
+    const long anLessAlphaUpdated[] = {5};
+    const long anAlphaUpdated[] = {4};
+    const long anLessEqualAlphaUpdated[] = {4, 5};
+    Check(IsFound(pIndex, enumGISFilterOpLT, 0, "Alpha", anLessAlphaUpdated, 1), "the sorted index has the added value");
+    Check(IsFound(pIndex, enumGISFilterOpLE, 0, "Alpha", anLessEqualAlphaUpdated, 2) && IsFound(pIndex, enumGISFilterOpEQ, 0, "Alpha", anAlphaUpdated, 1), "the removed value is gone from both indexes");
+    wxVector<long> anOrdered;
+    pIndex->GetOrderedFIDs(false, anOrdered);
+    Check(anOrdered.size() == 4 && anOrdered[0] == 1 && anOrdered[1] == 3 && anOrdered[2] == 4 && anOrdered[3] == 5, "the descending order after the update");
+    wxDELETE(pIndex);
+
+    //many updates of the sorted numeric index give the same result as the rebuild
+    pIndex = new wxGISAttributeIndex(1, OFTInteger);
+    AddNumber(pIndex, poDefn, 0, 0);
+    wxVector<long> anFIDs;
+    pIndex->Find(enumGISFilterOpGE, 0, NULL, anFIDs);
+    for(long i = 1; i < TEST_ROW_COUNT; ++i)
+        AddNumber(pIndex, poDefn, i, (int)((i * 7919) % 1000));
+    for(long i = 0; i < TEST_ROW_COUNT; i += 2)
+        pIndex->Remove(i);
+
+    wxGISAttributeIndex* pRebuilt = new wxGISAttributeIndex(1, OFTInteger);
+    for(long i = 1; i < TEST_ROW_COUNT; i += 2)
+        AddNumber(pRebuilt, poDefn, i, (int)((i * 7919) % 1000));
+
+    wxVector<long> anUpdated, anExpected;
+    pIndex->Find(enumGISFilterOpLT, 500, NULL, anUpdated);
+    pRebuilt->Find(enumGISFilterOpLT, 500, NULL, anExpected);
+    std::sort(anUpdated.begin(), anUpdated.end());
+    std::sort(anExpected.begin(), anExpected.end());
+    Check(pIndex->GetCount() == TEST_ROW_COUNT / 2 && IsSame(anUpdated, anExpected), "the updated sorted index matches the rebuilt one");
+
+    pIndex->GetOrderedFIDs(true, anUpdated);
+    pRebuilt->GetOrderedFIDs(true, anExpected);
+    Check(IsSame(anUpdated, anExpected), "the updated order matches the rebuilt one (ties ordered by FID)");
+    wxDELETE(pRebuilt);
+    wxDELETE(pIndex);
+
+    poDefn->Release();
+
+    return g_nFailed == 0 ? EXIT_SUCCESS : EXIT_FAILURE;
+}
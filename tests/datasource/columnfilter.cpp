@@ -0,0 +1,149 @@
+/******************************************************************************
+ * Project:  wxGIS
+ * Purpose:  wxGISColumnStoreFilter test. The where clause parser, the case
+ *           sensitive string comparisons and the three-valued NULL logic.
+ * Author:   Dmitry Baryshnikov (aka Bishop), polimax@mail.ru
+ ******************************************************************************
+*   Copyright (C) 2014 Dmitry Baryshnikov
+*
+*    This program is free software: you can redistribute it and/or modify
+*    it under the terms of the GNU General Public License as published by
+*    the Free Software Foundation, either version 2 of the License, or
+*    (at your option) any later version.
+*
+*    This program is distributed in the hope that it will be useful,
+*    but WITHOUT ANY WARRANTY; without even the implied warranty of
+*    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+*    GNU General Public License for more details.
+*
+*    You should have received a copy of the GNU General Public License
+*    along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ ****************************************************************************/
+#include "wxgis/datasource/columnfilter.h"
+
+#include <wx/init.h>
+
+#include <stdio.h>
+#include <stdlib.h>
+
+static int g_nFailed = 0;
+
+static void Check(bool bResult, const char* pszMessage)
+{
+    printf("%s: %s\n", bResult ? "PASS" : "FAIL", pszMessage);
+    if(!bResult)
+        g_nFailed++;
+}
+
+/** \fn void AddRow(wxGISFeatureColumnStore* pStore, long nFID, const char* pszName, int nValue, double dfReal)
+    \brief Add the row to the store, the NULL name, negative value or real leave the field unset
+*/
+
+static void AddRow(wxGISFeatureColumnStore* pStore, long nFID, const char* pszName, int nValue, double dfReal)
+{
+    OGRFeature* poFeature = new OGRFeature(pStore->GetDefinition());
+    poFeature->SetFID(nFID);
+    if(pszName)
+        poFeature->SetField(0, pszName);
+    if(nValue >= 0)
+        poFeature->SetField(1, nValue);
+    if(dfReal >= 0)
+        poFeature->SetField(2, dfReal);
+    pStore->Add(poFeature);
+    OGRFeature::DestroyFeature(poFeature);
+}
+
+/** \fn bool Test(wxGISFeatureColumnStore* pStore, const char* pszClause, wxUint32 nExpected)
+    \brief Parse and evaluate the clause, compare the row mask with expected one
+*/
+
+static bool Test(wxGISFeatureColumnStore* pStore, const char* pszClause, wxUint32 nExpected)
+{
+    wxGISColumnStoreFilter oFilter;
+    if(!oFilter.Parse(wxString::FromUTF8(pszClause), pStore->GetDefinition()))
+        return false;
+    wxVector<wxUint32> anRowMask;
+    if(!oFilter.Evaluate(pStore, anRowMask) || anRowMask.size() != 1)
+        return false;
+    if(anRowMask[0] != nExpected)
+        printf("  %s: 0x%X instead of 0x%X\n", pszClause, anRowMask[0], nExpected);
+    return anRowMask[0] == nExpected;
+}
+
+static bool Parse(OGRFeatureDefn* const poDefn, const char* pszClause)
+{
+    wxGISColumnStoreFilter oFilter;
+    return oFilter.Parse(wxString::FromUTF8(pszClause), poDefn);
+}
+
+int main(int argc, char **argv)
+{
+    wxInitializer initializer;
+    if(!initializer)
+    {
+        fprintf(stderr, "Failed to initialize the wxWidgets library\n");
+        return EXIT_FAILURE;
+    }
+
+    OGRFeatureDefn* poDefn = new OGRFeatureDefn("test");
+    poDefn->Reference();
+    OGRFieldDefn oName("name", OFTString);
+    poDefn->AddFieldDefn(&oName);
+    OGRFieldDefn oValue("value", OFTInteger);
+    poDefn->AddFieldDefn(&oValue);
+    OGRFieldDefn oReal("real", OFTReal);
+    poDefn->AddFieldDefn(&oReal);
+
+    wxGISFeatureColumnStore* pStore = new wxGISFeatureColumnStore(poDefn, wxFONTENCODING_DEFAULT, false);
+    AddRow(pStore, 0, "Alpha", 1, 1.5);
+    AddRow(pStore, 1, "alpha", 2, -1);
+    AddRow(pStore, 2, NULL, 3, 3.5);
+    AddRow(pStore, 3, "Beta", -1, 4.5);
+    AddRow(pStore, 4, "beta", 5, 5.5);
+    AddRow(pStore, 5, "Gamma", 6, 6.5);
+    pStore->Delete(5);
+
+    //parser
+    Check(Parse(poDefn, "\"name\" = 'it''s' AND (value >= 1 OR NOT real < 2)"), "the quoted identifier, escaped quote, parentheses and NOT are parsed");
+    Check(Parse(poDefn, "value > 2 and name = 'Beta'"), "the keywords are case insensitive");
+    Check(!Parse(poDefn, "value + 1 = 2"), "the arithmetic is left to OGR");
+    Check(!Parse(poDefn, "name = 1"), "the string field compared with number is left to OGR");
+    Check(!Parse(poDefn, "value = '1'"), "the integer field compared with string is left to OGR");
+    Check(!Parse(poDefn, "unknown = 1"), "the unknown field is rejected");
+    Check(!Parse(poDefn, "value ="), "the missing literal is rejected");
+    Check(!Parse(poDefn, "(value = 1"), "the unbalanced parenthesis is rejected");
+    Check(!Parse(poDefn, "value = 1 value"), "the trailing tokens are rejected");
+    Check(!Parse(poDefn, "name = 'open"), "the unterminated string is rejected");
+    Check(!Parse(poDefn, "name LIKE 'a%' ESCAPE '!'"), "LIKE with ESCAPE is left to OGR");
+    Check(!Parse(poDefn, "value LIKE '1%'"), "LIKE on the integer field is left to OGR");
+
+    //string comparisons are case sensitive
+    Check(Test(pStore, "name = 'Alpha'", 0x1), "= is case sensitive");
+    Check(Test(pStore, "name <> 'Alpha'", 0x1A), "<> is case sensitive and skips NULL");
+    Check(Test(pStore, "name IN ('alpha', 'Beta')", 0xA), "IN is case sensitive");
+    Check(Test(pStore, "name < 'B'", 0x1), "< uses the same byte order as =");
+    Check(Test(pStore, "name >= 'a'", 0x12), ">= uses the same byte order as =");
+    Check(Test(pStore, "name LIKE 'a%'", 0x3), "LIKE is case insensitive");
+    Check(Test(pStore, "name LIKE '_eta'", 0x18), "LIKE matches the single character");
+
+    //numbers and FID
+    Check(Test(pStore, "value BETWEEN 2 AND 5", 0x16), "BETWEEN includes the bounds and skips NULL");
+    Check(Test(pStore, "5 <= value", 0x10), "the literal on the left mirrors the operator");
+    Check(Test(pStore, "real >= 4.5", 0x18), "the deleted row is never set");
+    Check(Test(pStore, "FID IN (0, 4, 5)", 0x11), "FID IN skips the deleted row");
+
+    //three-valued NULL logic
+    Check(Test(pStore, "name IS NULL", 0x4), "IS NULL");
+    Check(Test(pStore, "name IS NOT NULL", 0x1B), "IS NOT NULL");
+    Check(Test(pStore, "NOT (value > 2)", 0x3), "NOT unknown is unknown");
+    Check(Test(pStore, "value > 2 OR name = 'Beta'", 0x1C), "unknown OR true is true");
+    Check(Test(pStore, "value > 2 AND name = 'Beta'", 0x0), "unknown AND true is unknown");
+    Check(Test(pStore, "NOT (value > 2 AND name = 'Beta')", 0x13), "NOT (unknown AND x) is unknown, NOT (false AND unknown) is true");
+    Check(Test(pStore, "NOT (real < 2 OR value = 3)", 0x10), "NOT (false OR unknown) is unknown");
+    Check(Test(pStore, "NOT name IN ('Alpha', 'beta')", 0xA), "NOT IN skips NULL");
+
+    wxDELETE(pStore);
+    poDefn->Release();
+
+    return g_nFailed == 0 ? EXIT_SUCCESS : EXIT_FAILURE;
+}
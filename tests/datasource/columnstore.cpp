@@ -0,0 +1,183 @@
+/******************************************************************************
+ * Project:  wxGIS
+ * Purpose:  wxGISFeatureColumnStore test. The created geometries have the
+ *           dataset spatial reference and the buffers are compacted after
+ *           many changes and deletes.
+ * Author:   Dmitry Baryshnikov (aka Bishop), polimax@mail.ru
+ ******************************************************************************
+*   Copyright (C) 2014 Dmitry Baryshnikov
+*
+*    This program is free software: you can redistribute it and/or modify
+*    it under the terms of the GNU General Public License as published by
+*    the Free Software Foundation, either version 2 of the License, or
+*    (at your option) any later version.
+*
+*    This program is distributed in the hope that it will be useful,
+*    but WITHOUT ANY WARRANTY; without even the implied warranty of
+*    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+*    GNU General Public License for more details.
+*
+*    You should have received a copy of the GNU General Public License
+*    along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ ****************************************************************************/
+#include "wxgis/datasource/columnstore.h"
+
+#include <wx/init.h>
+
+#include <stdio.h>
+#include <stdlib.h>
+
+#define TEST_ROW_COUNT 16
+#define TEST_CHANGE_COUNT 2000
+#define TEST_STRING_SIZE 4096
+#define TEST_LINE_POINTS 256
+
+static int g_nFailed = 0;
+
+static void Check(bool bResult, const char* pszMessage)
+{
+    printf("%s: %s\n", bResult ? "PASS" : "FAIL", pszMessage);
+    if(!bResult)
+        g_nFailed++;
+}
+
+/** @class wxGISColumnStoreTest
+
+    The store exposing the buffer sizes.
+*/
+
+class wxGISColumnStoreTest : public wxGISFeatureColumnStore
+{
+public:
+    wxGISColumnStoreTest(OGRFeatureDefn* const poDefn) : wxGISFeatureColumnStore(poDefn, wxFONTENCODING_DEFAULT, false) {};
+    size_t GetStringsSize(void) const { return m_achStrings.size(); };
+    size_t GetWKBSize(void) const { return m_abyWKB.size(); };
+};
+
+/** \fn void SetRow(wxGISFeatureColumnStore* pStore, long nFID, int nVersion, OGRSpatialReference* poSpatialRef)
+    \brief Add or change the row, the string field and the line depend on the version
+*/
+
+static void SetRow(wxGISFeatureColumnStore* pStore, long nFID, int nVersion, OGRSpatialReference* poSpatialRef)
+{
+    OGRFeature* poFeature = new OGRFeature(pStore->GetDefinition());
+    poFeature->SetFID(nFID);
+    CPLString sValue(CPLSPrintf("%ld:%d:", nFID, nVersion));
+    sValue.resize(TEST_STRING_SIZE, 'x');
+    poFeature->SetField(0, sValue.c_str());
+    poFeature->SetField(1, nVersion);
+    poFeature->SetStyleString(CPLSPrintf("PEN(c:#%06X)", nVersion));
+
+    OGRLineString* poLine = new OGRLineString();
+    for(int i = 0; i < TEST_LINE_POINTS; ++i)
+        poLine->addPoint(nFID + i, nVersion);
+    poLine->assignSpatialReference(poSpatialRef);
+    poFeature->SetGeometryDirectly(poLine);
+
+    pStore->Set(poFeature);
+    OGRFeature::DestroyFeature(poFeature);
+}
+
+/** \fn bool IsRowValid(const wxGISFeatureColumnStore* pStore, long nFID, int nVersion)
+    \brief Check the row values are the ones written by SetRow of this version
+*/
+
+static bool IsRowValid(const wxGISFeatureColumnStore* pStore, long nFID, int nVersion)
+{
+    wxGISFeature Feature = pStore->GetFeatureByID(nFID);
+    if(!Feature.IsOk())
+        return false;
+    OGRFeature* poFeature = Feature;
+    CPLString sPrefix(CPLSPrintf("%ld:%d:", nFID, nVersion));
+    const char* pszValue = poFeature->GetFieldAsString(0);
+    if(strlen(pszValue) != TEST_STRING_SIZE || strncmp(pszValue, sPrefix, sPrefix.size()) != 0)
+        return false;
+    if(poFeature->GetFieldAsInteger(1) != nVersion)
+        return false;
+    const char* pszStyle = poFeature->GetStyleString();
+    if(NULL == pszStyle || !EQUAL(pszStyle, CPLSPrintf("PEN(c:#%06X)", nVersion)))
+        return false;
+    OGRLineString* poLine = dynamic_cast<OGRLineString*>(poFeature->GetGeometryRef());
+    return poLine && poLine->getNumPoints() == TEST_LINE_POINTS && poLine->getX(1) == nFID + 1 && poLine->getY(1) == nVersion;
+}
+
+int main(int argc, char **argv)
+{
+    wxInitializer initializer;
+    if(!initializer)
+    {
+        fprintf(stderr, "Failed to initialize the wxWidgets library\n");
+        return EXIT_FAILURE;
+    }
+
+    OGRFeatureDefn* poDefn = new OGRFeatureDefn("test");
+    poDefn->Reference();
+    OGRFieldDefn oName("name", OFTString);
+    poDefn->AddFieldDefn(&oName);
+    OGRFieldDefn oVersion("version", OFTInteger);
+    poDefn->AddFieldDefn(&oVersion);
+
+    OGRSpatialReference* poSpatialRef = new OGRSpatialReference();
+    poSpatialRef->SetWellKnownGeogCS("WGS84");
+
+    //the spatial reference of the dataset
+    wxGISColumnStoreTest* pStore = new wxGISColumnStoreTest(poDefn);
+    pStore->SetSpatialReference(poSpatialRef);
+    SetRow(pStore, 0, 0, NULL);
+    wxGISFeature Feature = pStore->GetFeatureByID(0);
+    Check(Feature.IsOk() && Feature.GetGeometry().IsOk() && Feature.GetGeometry().GetSpatialReference().IsOk(), "the geometry has the set spatial reference");
+    Feature = wxGISFeature();
+    wxDELETE(pStore);
+
+    //the spatial reference of the first added geometry
+    pStore = new wxGISColumnStoreTest(poDefn);
+    SetRow(pStore, 0, 0, poSpatialRef);
+    Feature = pStore->GetFeatureByID(0);
+    OGRGeometry* poGeom = Feature.IsOk() ? ((OGRFeature*)Feature)->GetGeometryRef() : NULL;
+    Check(poGeom && poGeom->getSpatialReference() && poGeom->getSpatialReference()->IsSame(poSpatialRef), "the geometry has the spatial reference of the added one");
+    Feature = wxGISFeature();
+    wxDELETE(pStore);
+
+    //the changed rows are compacted
+    pStore = new wxGISColumnStoreTest(poDefn);
+    for(long i = 0; i < TEST_ROW_COUNT; ++i)
+        SetRow(pStore, i, 0, poSpatialRef);
+    size_t nStringsSize = pStore->GetStringsSize();
+    size_t nWKBSize = pStore->GetWKBSize();
+
+    for(int nVersion = 1; nVersion <= TEST_CHANGE_COUNT; ++nVersion)
+        SetRow(pStore, nVersion % TEST_ROW_COUNT, nVersion, poSpatialRef);
+
+    bool bValid = true;
+    for(long i = 0; i < TEST_ROW_COUNT; ++i)
+    {
+        int nVersion = TEST_CHANGE_COUNT - ((TEST_CHANGE_COUNT - i) % TEST_ROW_COUNT);
+        bValid = bValid && IsRowValid(pStore, i, nVersion);
+    }
+    Check(bValid, "the changed rows have the last values after compacting");
+    Check(pStore->GetStringsSize() < nStringsSize * 3 + COLUMN_STORE_COMPACT_SIZE * 2, "the strings buffer is compacted");
+    Check(pStore->GetWKBSize() < nWKBSize * 3 + COLUMN_STORE_COMPACT_SIZE * 2, "the geometry buffer is compacted");
+
+    //the deleted rows are compacted
+    for(int nVersion = TEST_CHANGE_COUNT + 1; nVersion <= TEST_CHANGE_COUNT * 2; ++nVersion)
+    {
+        long nFID = TEST_ROW_COUNT + nVersion;
+        SetRow(pStore, nFID, nVersion, poSpatialRef);
+        pStore->Delete(nFID);
+    }
+    bValid = true;
+    for(long i = 0; i < TEST_ROW_COUNT; ++i)
+    {
+        int nVersion = TEST_CHANGE_COUNT - ((TEST_CHANGE_COUNT - i) % TEST_ROW_COUNT);
+        bValid = bValid && IsRowValid(pStore, i, nVersion);
+    }
+    Check(bValid, "the rows are kept after compacting the deleted ones");
+    Check(!pStore->GetFeatureByID(TEST_ROW_COUNT + TEST_CHANGE_COUNT + 1).IsOk(), "the deleted row is not returned");
+    Check(pStore->GetStringsSize() < nStringsSize * 3 + COLUMN_STORE_COMPACT_SIZE * 2, "the strings buffer is compacted after deletes");
+    wxDELETE(pStore);
+
+    poSpatialRef->Release();
+    poDefn->Release();
+
+    return g_nFailed == 0 ? EXIT_SUCCESS : EXIT_FAILURE;
+}
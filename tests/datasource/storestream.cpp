@@ -0,0 +1,123 @@
+/******************************************************************************
+ * Project:  wxGIS
+ * Purpose:  wxFeatureStoreStream test. The stream opened on the cached table
+ *           should end, not read the deleted store, after the table recaches
+ *           or closes.
+ * Author:   Dmitry Baryshnikov (aka Bishop), polimax@mail.ru
+ ******************************************************************************
+*   Copyright (C) 2014 Dmitry Baryshnikov
+*
+*    This program is free software: you can redistribute it and/or modify
+*    it under the terms of the GNU General Public License as published by
+*    the Free Software Foundation, either version 2 of the License, or
+*    (at your option) any later version.
+*
+*    This program is distributed in the hope that it will be useful,
+*    but WITHOUT ANY WARRANTY; without even the implied warranty of
+*    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+*    GNU General Public License for more details.
+*
+*    You should have received a copy of the GNU General Public License
+*    along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ ****************************************************************************/
+#include "wxgis/datasource/table.h"
+
+#include <wx/init.h>
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <unistd.h>
+
+#define TEST_ROW_COUNT 10
+#define TEST_BATCH_SIZE 3
+
+static int g_nFailed = 0;
+
+static void Check(bool bResult, const char* pszMessage)
+{
+    printf("%s: %s\n", bResult ? "PASS" : "FAIL", pszMessage);
+    if(!bResult)
+        g_nFailed++;
+}
+
+/** \fn CPLString CreateTestCSV(void)
+    \brief Write the CSV with TEST_ROW_COUNT rows to the temp dir
+*/
+
+static CPLString CreateTestCSV(void)
+{
+    CPLString sPath = CPLFormFilename(CPLGetConfigOption("TMPDIR", "/tmp"), CPLSPrintf("wxgis_storestream_%d", (int)getpid()), "csv");
+    FILE* fp = VSIFOpen(sPath, "wb");
+    if(NULL == fp)
+        return CPLString();
+    fprintf(fp, "name,value\n");
+    for(int i = 0; i < TEST_ROW_COUNT; ++i)
+        fprintf(fp, "row%d,%d\n", i, i);
+    VSIFClose(fp);
+    return sPath;
+}
+
+static size_t ReadAll(wxFeatureStream* pStream)
+{
+    size_t nCount = 0;
+    wxVector<wxGISFeature> aFeatures;
+    while(pStream->NextBatch(aFeatures) > 0)
+        nCount += aFeatures.size();
+    return nCount;
+}
+
+int main(int argc, char **argv)
+{
+    wxInitializer initializer;
+    if(!initializer)
+    {
+        fprintf(stderr, "Failed to initialize the wxWidgets library\n");
+        return EXIT_FAILURE;
+    }
+    OGRRegisterAll();
+
+    CPLString sPath = CreateTestCSV();
+    if(sPath.empty())
+    {
+        fprintf(stderr, "Failed to create the test CSV\n");
+        return EXIT_FAILURE;
+    }
+
+    wxGISTableCached* pTable = new wxGISTableCached(sPath, enumTableCSV);
+    pTable->Reference();
+    if(!pTable->Open(0, false, true, true))
+    {
+        fprintf(stderr, "Failed to open the test CSV\n");
+        wsDELETE(pTable);
+        VSIUnlink(sPath);
+        return EXIT_FAILURE;
+    }
+
+    wxFeatureStream* pStream = pTable->SearchStream(wxGISNullQueryFilter, TEST_BATCH_SIZE);
+    Check(NULL != pStream && ReadAll(pStream) == TEST_ROW_COUNT, "the stream reads all cached rows");
+    wxDELETE(pStream);
+
+    //the recache deletes the column store the stream reads
+    pStream = pTable->SearchStream(wxGISNullQueryFilter, TEST_BATCH_SIZE);
+    wxVector<wxGISFeature> aFeatures;
+    Check(NULL != pStream && pStream->NextBatch(aFeatures) == TEST_BATCH_SIZE, "the first batch is read");
+    pTable->GetFeatureCount(true);
+    Check(NULL != pStream && pStream->NextBatch(aFeatures) == 0 && pStream->IsStopped(), "the stream ends after the table recached");
+    wxDELETE(pStream);
+
+    pStream = pTable->SearchStream(wxGISNullQueryFilter, TEST_BATCH_SIZE);
+    Check(NULL != pStream && ReadAll(pStream) == TEST_ROW_COUNT, "the new stream reads the new store");
+    wxDELETE(pStream);
+
+    //the close deletes the column store too
+    pStream = pTable->SearchStream(wxGISNullQueryFilter, TEST_BATCH_SIZE);
+    Check(NULL != pStream && pStream->NextBatch(aFeatures) == TEST_BATCH_SIZE, "the first batch is read before close");
+    pTable->Close();
+    Check(NULL != pStream && pStream->NextBatch(aFeatures) == 0, "the stream ends after the table closed");
+    wxDELETE(pStream);
+
+    wsDELETE(pTable);
+    VSIUnlink(sPath);
+
+    return g_nFailed == 0 ? EXIT_SUCCESS : EXIT_FAILURE;
+}
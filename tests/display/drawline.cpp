@@ -0,0 +1,149 @@
+/******************************************************************************
+ * Project:  wxGIS
+ * Purpose:  wxGISDisplay::DrawLine test. The clipped vertex array should be
+ *           submitted to cairo as one path, the line clipped away entirely
+ *           should not be submitted at all.
+ * Author:   Dmitry Baryshnikov (aka Bishop), polimax@mail.ru
+ ******************************************************************************
+*   Copyright (C) 2014 Dmitry Baryshnikov
+*
+*    This program is free software: you can redistribute it and/or modify
+*    it under the terms of the GNU General Public License as published by
+*    the Free Software Foundation, either version 2 of the License, or
+*    (at your option) any later version.
+*
+*    This program is distributed in the hope that it will be useful,
+*    but WITHOUT ANY WARRANTY; without even the implied warranty of
+*    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+*    GNU General Public License for more details.
+*
+*    You should have received a copy of the GNU General Public License
+*    along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ ****************************************************************************/
+#include "wxgis/display/gisdisplay.h"
+
+#include <wx/init.h>
+
+#include <math.h>
+#include <stdio.h>
+#include <stdlib.h>
+
+#define TEST_CACHE_SIZE 512
+
+/** @class wxGISDisplayTest
+
+    The display with fixed size caches (the screen size is unknown without the display server) and the access to the current cairo path.
+*/
+
+class wxGISDisplayTest : public wxGISDisplay
+{
+public:
+    wxGISDisplayTest(void) : wxGISDisplay()
+    {
+        m_nMax_X = m_nMax_Y = TEST_CACHE_SIZE;
+        m_dCacheCenterX = m_dCacheCenterY = TEST_CACHE_SIZE / 2;
+        for(size_t i = 0; i < m_saLayerCaches.size(); ++i)
+        {
+            cairo_destroy(m_saLayerCaches[i].pCairoContext);
+            cairo_surface_destroy(m_saLayerCaches[i].pCairoSurface);
+            m_saLayerCaches[i].pCairoSurface = cairo_image_surface_create(CAIRO_FORMAT_ARGB32, m_nMax_X, m_nMax_Y);
+            m_saLayerCaches[i].pCairoContext = cairo_create(m_saLayerCaches[i].pCairoSurface);
+        }
+
+        wxRect rc(0, 0, 400, 400);
+        SetDeviceFrame(rc);
+        OGREnvelope Env;
+        Env.MinX = Env.MinY = 0;
+        Env.MaxX = Env.MaxY = 100;
+        SetBounds(Env);
+    }
+
+    void NewPath(void)
+    {
+        wxCriticalSectionLocker locker(m_CritSect);
+        cairo_new_path(m_saLayerCaches[m_nCurrentLayer].pCairoContext);
+    }
+
+    cairo_path_t* CopyPath(void)
+    {
+        wxCriticalSectionLocker locker(m_CritSect);
+        return cairo_copy_path(m_saLayerCaches[m_nCurrentLayer].pCairoContext);
+    }
+};
+
+static int g_nFailed = 0;
+
+static void Check(bool bResult, const char* pszMessage)
+{
+    printf("%s: %s\n", bResult ? "PASS" : "FAIL", pszMessage);
+    if(!bResult)
+        g_nFailed++;
+}
+
+/** \fn bool CheckPath(cairo_path_t*, const OGRRawPoint*, int)
+    \brief The path should be one move to the first point and the line to each next point
+*/
+
+static bool CheckPath(cairo_path_t* pPath, const OGRRawPoint* pPoints, int nPointCount)
+{
+    if(NULL == pPath || pPath->status != CAIRO_STATUS_SUCCESS)
+        return false;
+
+    int nPoint = 0;
+    for(int i = 0; i < pPath->num_data; i += pPath->data[i].header.length)
+    {
+        const cairo_path_data_t* pData = &pPath->data[i];
+        cairo_path_data_type_t eExpected = nPoint == 0 ? CAIRO_PATH_MOVE_TO : CAIRO_PATH_LINE_TO;
+        if(nPoint >= nPointCount || pData->header.type != eExpected)
+            return false;
+        //cairo stores the path in 24.8 fixed point device coordinates
+        if(fabs(pData[1].point.x - pPoints[nPoint].x) > 0.01 || fabs(pData[1].point.y - pPoints[nPoint].y) > 0.01)
+            return false;
+        nPoint++;
+    }
+    return nPoint == nPointCount;
+}
+
+int main(int argc, char **argv)
+{
+    wxInitializer initializer;
+    if(!initializer)
+    {
+        fprintf(stderr, "Failed to initialize the wxWidgets library\n");
+        return EXIT_FAILURE;
+    }
+
+    wxGISDisplayTest oDisplay;
+
+    OGRRawPoint aInside[5];
+    for(int i = 0; i < 5; ++i)
+    {
+        aInside[i].x = 10 + i * 20;
+        aInside[i].y = i % 2 == 0 ? 20 : 70;
+    }
+    OGRRawPoint aDraw[5];
+    for(int i = 0; i < 5; ++i)
+        aDraw[i] = aInside[i];
+
+    oDisplay.NewPath();
+    Check(oDisplay.DrawLine(aDraw, 5, false), "the line inside bounds is drawn");
+    cairo_path_t* pPath = oDisplay.CopyPath();
+    Check(CheckPath(pPath, aInside, 5), "the line is one move to and line to each next vertex");
+    cairo_path_destroy(pPath);
+
+    //the bounds are 0 - 100 and the clip envelope is eight times bigger
+    OGRRawPoint aOutside[3];
+    for(int i = 0; i < 3; ++i)
+    {
+        aOutside[i].x = 100000 + i * 10;
+        aOutside[i].y = 100000;
+    }
+
+    oDisplay.NewPath();
+    Check(!oDisplay.DrawLine(aOutside, 3, false), "the line out of bounds is not drawn");
+    pPath = oDisplay.CopyPath();
+    Check(NULL != pPath && pPath->status == CAIRO_STATUS_SUCCESS && pPath->num_data == 0, "the line out of bounds is not submitted to cairo");
+    cairo_path_destroy(pPath);
+
+    return g_nFailed == 0 ? EXIT_SUCCESS : EXIT_FAILURE;
+}
@@ -0,0 +1,182 @@
+/******************************************************************************
+ * Project:  wxGIS
+ * Purpose:  wxGISDisplay::DrawLine benchmark. The 1M vertex coastline is
+ *           submitted to cairo under one display lock and, as before, under
+ *           the lock taken for each vertex, by one and by several threads.
+ * Author:   Dmitry Baryshnikov (aka Bishop), polimax@mail.ru
+ ******************************************************************************
+*   Copyright (C) 2014 Dmitry Baryshnikov
+*
+*    This program is free software: you can redistribute it and/or modify
+*    it under the terms of the GNU General Public License as published by
+*    the Free Software Foundation, either version 2 of the License, or
+*    (at your option) any later version.
+*
+*    This program is distributed in the hope that it will be useful,
+*    but WITHOUT ANY WARRANTY; without even the implied warranty of
+*    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+*    GNU General Public License for more details.
+*
+*    You should have received a copy of the GNU General Public License
+*    along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ ****************************************************************************/
+#include "wxgis/display/gisdisplay.h"
+#include "wxgis/display/displayop.h"
+
+#include <wx/init.h>
+#include <wx/stopwatch.h>
+
+#include <math.h>
+#include <stdio.h>
+#include <stdlib.h>
+
+#define BENCH_CACHE_SIZE 512
+#define BENCH_VERTEX_COUNT 1000000
+#define BENCH_ITERATIONS 5
+#define BENCH_THREAD_COUNT 4
+
+/** @class wxGISDisplayBench
+
+    The display with fixed size caches (the screen size is unknown without the display server) and the line submitted with the lock for each vertex as DrawLine did before.
+*/
+
+class wxGISDisplayBench : public wxGISDisplay
+{
+public:
+    wxGISDisplayBench(void) : wxGISDisplay()
+    {
+        m_nMax_X = m_nMax_Y = BENCH_CACHE_SIZE;
+        m_dCacheCenterX = m_dCacheCenterY = BENCH_CACHE_SIZE / 2;
+        for(size_t i = 0; i < m_saLayerCaches.size(); ++i)
+        {
+            cairo_destroy(m_saLayerCaches[i].pCairoContext);
+            cairo_surface_destroy(m_saLayerCaches[i].pCairoSurface);
+            m_saLayerCaches[i].pCairoSurface = cairo_image_surface_create(CAIRO_FORMAT_ARGB32, m_nMax_X, m_nMax_Y);
+            m_saLayerCaches[i].pCairoContext = cairo_create(m_saLayerCaches[i].pCairoSurface);
+        }
+
+        wxRect rc(0, 0, 400, 400);
+        SetDeviceFrame(rc);
+        OGREnvelope Env;
+        Env.MinX = Env.MinY = 0;
+        Env.MaxX = Env.MaxY = 100;
+        SetBounds(Env);
+    }
+
+    bool DrawLinePerVertexLock(OGRRawPoint* pOGRRawPoints, int nPointCount)
+    {
+        ClipGeometryByEnvelope(pOGRRawPoints, &nPointCount, m_CurrentBoundsX8, true);
+        if (nPointCount < 1)
+            return false;
+
+        {
+            wxCriticalSectionLocker locker(m_CritSect);
+            cairo_move_to(m_saLayerCaches[m_nCurrentLayer].pCairoContext, pOGRRawPoints[0].x, pOGRRawPoints[0].y);
+        }
+        for(int i = 1; i < nPointCount; ++i)
+        {
+            wxCriticalSectionLocker locker(m_CritSect);
+            cairo_line_to(m_saLayerCaches[m_nCurrentLayer].pCairoContext, pOGRRawPoints[i].x, pOGRRawPoints[i].y);
+        }
+        return true;
+    }
+
+    void NewPath(void)
+    {
+        wxCriticalSectionLocker locker(m_CritSect);
+        cairo_new_path(m_saLayerCaches[m_nCurrentLayer].pCairoContext);
+    }
+};
+
+/** @class wxGISDrawLineThread
+
+    Submit the coastline copy BENCH_ITERATIONS times by one of the two ways.
+*/
+
+class wxGISDrawLineThread : public wxThread
+{
+public:
+    wxGISDrawLineThread(wxGISDisplayBench* pDisplay, const wxVector<OGRRawPoint> &aPoints, bool bPerVertexLock) : wxThread(wxTHREAD_JOINABLE), m_pDisplay(pDisplay), m_aPoints(aPoints), m_bPerVertexLock(bPerVertexLock)
+    {
+    }
+    virtual void *Entry()
+    {
+        //DrawLine clips the array in place, so each iteration has its own copy
+        wxVector<OGRRawPoint> aDraw;
+        for(int i = 0; i < BENCH_ITERATIONS; ++i)
+        {
+            aDraw = m_aPoints;
+            if(m_bPerVertexLock)
+                m_pDisplay->DrawLinePerVertexLock(&aDraw[0], (int)aDraw.size());
+            else
+                m_pDisplay->DrawLine(&aDraw[0], (int)aDraw.size(), false);
+            m_pDisplay->NewPath();
+        }
+        return (wxThread::ExitCode)wxTHREAD_NO_ERROR;
+    }
+protected:
+    wxGISDisplayBench* m_pDisplay;
+    const wxVector<OGRRawPoint> &m_aPoints;
+    bool m_bPerVertexLock;
+};
+
+/** \fn long DrawCoastline(wxGISDisplayBench* pDisplay, const wxVector<OGRRawPoint> &aPoints, int nThreadCount, bool bPerVertexLock)
+    \brief Run the threads drawing the coastline and return the time in ms
+*/
+
+static long DrawCoastline(wxGISDisplayBench* pDisplay, const wxVector<OGRRawPoint> &aPoints, int nThreadCount, bool bPerVertexLock)
+{
+    wxVector<wxGISDrawLineThread*> paThreads;
+    wxStopWatch sw;
+    for(int i = 0; i < nThreadCount; ++i)
+    {
+        wxGISDrawLineThread* pThread = new wxGISDrawLineThread(pDisplay, aPoints, bPerVertexLock);
+        if(pThread->Create() != wxTHREAD_NO_ERROR || pThread->Run() != wxTHREAD_NO_ERROR)
+        {
+            wxDELETE(pThread);
+            continue;
+        }
+        paThreads.push_back(pThread);
+    }
+    for(size_t i = 0; i < paThreads.size(); ++i)
+    {
+        paThreads[i]->Wait();
+        wxDELETE(paThreads[i]);
+    }
+    return sw.Time();
+}
+
+int main(int argc, char **argv)
+{
+    wxInitializer initializer;
+    if(!initializer)
+    {
+        fprintf(stderr, "Failed to initialize the wxWidgets library\n");
+        return EXIT_FAILURE;
+    }
+
+    //the coastline wanders around the 0 - 100 bounds and goes out of the clip envelope sometimes
+    wxVector<OGRRawPoint> aPoints(BENCH_VERTEX_COUNT);
+    for(int i = 0; i < BENCH_VERTEX_COUNT; ++i)
+    {
+        double dfAngle = 2 * M_PI * i / BENCH_VERTEX_COUNT;
+        double dfRadius = 40 + 8 * sin(dfAngle * 997) + 3 * sin(dfAngle * 7919);
+        if(i % 100000 < 500)
+            dfRadius *= 30;
+        aPoints[i].x = 50 + dfRadius * cos(dfAngle);
+        aPoints[i].y = 50 + dfRadius * sin(dfAngle);
+    }
+
+    wxGISDisplayBench oDisplay;
+    printf("%d vertices x %d iterations per thread, the times include the vertex array copy\n", BENCH_VERTEX_COUNT, BENCH_ITERATIONS);
+    printf("%-8s %16s %16s %8s\n", "threads", "lock per vertex", "lock per line", "speedup");
+    const int anThreadCounts[] = {1, BENCH_THREAD_COUNT};
+    for(size_t i = 0; i < sizeof(anThreadCounts) / sizeof(anThreadCounts[0]); ++i)
+    {
+        long nPerVertex = DrawCoastline(&oDisplay, aPoints, anThreadCounts[i], true);
+        long nPerLine = DrawCoastline(&oDisplay, aPoints, anThreadCounts[i], false);
+        printf("%-8d %14ldms %14ldms %7.2fx\n", anThreadCounts[i], nPerVertex, nPerLine, nPerLine > 0 ? (double)nPerVertex / nPerLine : 0.0);
+    }
+
+    return EXIT_SUCCESS;
+}
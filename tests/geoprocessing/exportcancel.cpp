@@ -0,0 +1,178 @@
+/******************************************************************************
+ * Project:  wxGIS
+ * Purpose:  ExportFormatEx test. The export cancelled halfway should remove
+ *           the partially written output, not leave the committed rows.
+ * Author:   Dmitry Baryshnikov (aka Bishop), polimax@mail.ru
+ ******************************************************************************
+*   Copyright (C) 2014 Dmitry Baryshnikov
+*
+*    This program is free software: you can redistribute it and/or modify
+*    it under the terms of the GNU General Public License as published by
+*    the Free Software Foundation, either version 2 of the License, or
+*    (at your option) any later version.
+*
+*    This program is distributed in the hope that it will be useful,
+*    but WITHOUT ANY WARRANTY; without even the implied warranty of
+*    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+*    GNU General Public License for more details.
+*
+*    You should have received a copy of the GNU General Public License
+*    along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ ****************************************************************************/
+#include "wxgis/geoprocessing/gpvector.h"
+
+#include <wx/init.h>
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <unistd.h>
+
+#define TEST_ROW_COUNT 2000
+
+static int g_nFailed = 0;
+
+static void Check(bool bResult, const char* pszMessage)
+{
+    printf("%s: %s\n", bResult ? "PASS" : "FAIL", pszMessage);
+    if(!bResult)
+        g_nFailed++;
+}
+
+static bool IsFileExist(const CPLString &sPath)
+{
+    VSIStatBufL sStatBuf;
+    return VSIStatL(sPath, &sStatBuf) == 0;
+}
+
+/** @class wxGISTestProgressor
+
+    Cancel the track cancel when the progress reaches the half of range and remember if the output file exists at this moment.
+*/
+
+class wxGISTestProgressor : public IProgressor
+{
+public:
+    wxGISTestProgressor(ITrackCancel* pTrackCancel, const CPLString &sOutPath, bool bCancel) : m_pTrackCancel(pTrackCancel), m_sOutPath(sOutPath), m_bCancel(bCancel)
+    {
+        m_nRange = 0;
+        m_nValue = 0;
+        m_bOutExistOnCancel = false;
+    }
+    virtual bool ShowProgress(bool bShow) { return true; };
+    virtual void SetRange(int range) { m_nRange = range; };
+    virtual int GetRange(void) const { return m_nRange; };
+    virtual void SetValue(int value)
+    {
+        m_nValue = value;
+        if(m_bCancel && m_nRange > 0 && m_nValue >= m_nRange / 2 && m_pTrackCancel->Continue())
+        {
+            m_bOutExistOnCancel = IsFileExist(m_sOutPath);
+            m_pTrackCancel->Cancel();
+        }
+    };
+    virtual int GetValue(void) const { return m_nValue; };
+    virtual void Play(void) {};
+    virtual void Stop(void) {};
+    virtual void SetYield(bool bYield = false) {};
+    bool IsOutExistOnCancel(void) const { return m_bOutExistOnCancel; };
+protected:
+    ITrackCancel* m_pTrackCancel;
+    CPLString m_sOutPath;
+    bool m_bCancel;
+    int m_nRange, m_nValue;
+    bool m_bOutExistOnCancel;
+};
+
+/** \fn CPLString CreateTestCSV(void)
+    \brief Write the CSV with TEST_ROW_COUNT rows to the temp dir
+*/
+
+static CPLString CreateTestCSV(void)
+{
+    CPLString sPath = CPLFormFilename(CPLGetConfigOption("TMPDIR", "/tmp"), CPLSPrintf("wxgis_exportcancel_%d", (int)getpid()), "csv");
+    FILE* fp = VSIFOpen(sPath, "wb");
+    if(NULL == fp)
+        return CPLString();
+    fprintf(fp, "name,value\n");
+    for(int i = 0; i < TEST_ROW_COUNT; ++i)
+        fprintf(fp, "row%d,%d\n", i, i);
+    VSIFClose(fp);
+    return sPath;
+}
+
+static bool Export(wxGISTable* pSrcTable, const wxString &sName, wxGxObjectFilter* pFilter, wxGISTestProgressor* pProgressor, ITrackCancel* pTrackCancel)
+{
+    OGRFeatureDefn* poFields = pSrcTable->GetDefinition()->Clone();
+    wxVector<ST_FIELD_MAP> staFieldMap;
+    for(int i = 0; i < poFields->GetFieldCount(); ++i)
+    {
+        ST_FIELD_MAP stMap = {(unsigned)i, (unsigned)i, poFields->GetFieldDefn(i)->GetType()};
+        staFieldMap.push_back(stMap);
+    }
+
+    pTrackCancel->SetProgressor(pProgressor);
+    CPLString sDir(CPLGetConfigOption("TMPDIR", "/tmp"));
+    bool bRes = ExportFormatEx(pSrcTable, sDir, sName, pFilter, wxGISNullSpatialFilter, poFields, staFieldMap, NULL, NULL, false, pTrackCancel);
+    pTrackCancel->SetProgressor(NULL);
+    poFields->Release();
+    return bRes;
+}
+
+int main(int argc, char **argv)
+{
+    wxInitializer initializer;
+    if(!initializer)
+    {
+        fprintf(stderr, "Failed to initialize the wxWidgets library\n");
+        return EXIT_FAILURE;
+    }
+    OGRRegisterAll();
+
+    CPLString sPath = CreateTestCSV();
+    if(sPath.empty())
+    {
+        fprintf(stderr, "Failed to create the test CSV\n");
+        return EXIT_FAILURE;
+    }
+
+    wxGISTable* pTable = new wxGISTable(sPath, enumTableCSV);
+    pTable->Reference();
+    if(!pTable->Open(0, false, true, false))
+    {
+        fprintf(stderr, "Failed to open the test CSV\n");
+        wsDELETE(pTable);
+        VSIUnlink(sPath);
+        return EXIT_FAILURE;
+    }
+
+    wxGxTableFilter oFilter(enumTableDBF);
+    CPLString sDir(CPLGetConfigOption("TMPDIR", "/tmp"));
+
+    //the complete export keeps the output
+    wxString sName = wxString::Format(wxT("wxgis_export_full_%d"), (int)getpid());
+    CPLString sOutPath = CPLFormFilename(sDir, sName.ToUTF8(), "dbf");
+    ITrackCancel oTrackCancel;
+    wxGISTestProgressor oFullProgressor(&oTrackCancel, sOutPath, false);
+    Check(Export(pTable, sName, &oFilter, &oFullProgressor, &oTrackCancel), "the complete export succeeded");
+    Check(IsFileExist(sOutPath), "the complete export output exists");
+    OGRCompatibleDriver *poDriver = GetOGRCompatibleDriverByName(oFilter.GetDriver().mb_str());
+    if(NULL != poDriver)
+        poDriver->DeleteOGRCompatibleDataSource(sOutPath);
+
+    //the export cancelled halfway removes the output
+    sName = wxString::Format(wxT("wxgis_export_cancel_%d"), (int)getpid());
+    sOutPath = CPLFormFilename(sDir, sName.ToUTF8(), "dbf");
+    oTrackCancel.Reset();
+    wxGISTestProgressor oCancelProgressor(&oTrackCancel, sOutPath, true);
+    Check(!Export(pTable, sName, &oFilter, &oCancelProgressor, &oTrackCancel), "the cancelled export failed");
+    Check(!oTrackCancel.Continue(), "the export was cancelled");
+    Check(oCancelProgressor.IsOutExistOnCancel(), "the output was written when cancelled");
+    Check(!IsFileExist(sOutPath), "the cancelled export output is removed");
+    if(IsFileExist(sOutPath) && NULL != poDriver)
+        poDriver->DeleteOGRCompatibleDataSource(sOutPath);
+
+    wsDELETE(pTable);
+    VSIUnlink(sPath);
+
+    return g_nFailed == 0 ? EXIT_SUCCESS : EXIT_FAILURE;
+}
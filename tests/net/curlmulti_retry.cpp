@@ -0,0 +1,236 @@
+/******************************************************************************
+ * Project:  wxGIS
+ * Purpose:  wxGISCurlMulti retry test. The requests are sent to the local mock
+ *           server answering 503 to each request.
+ * Author:   Dmitry Baryshnikov (aka Bishop), polimax@mail.ru
+ ******************************************************************************
+*   Copyright (C) 2014 Dmitry Baryshnikov
+*
+*    This program is free software: you can redistribute it and/or modify
+*    it under the terms of the GNU General Public License as published by
+*    the Free Software Foundation, either version 2 of the License, or
+*    (at your option) any later version.
+*
+*    This program is distributed in the hope that it will be useful,
+*    but WITHOUT ANY WARRANTY; without even the implied warranty of
+*    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+*    GNU General Public License for more details.
+*
+*    You should have received a copy of the GNU General Public License
+*    along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ ****************************************************************************/
+#include "wxgis/net/curl.h"
+
+#include <wx/init.h>
+#include <wx/thread.h>
+
+#include <sys/socket.h>
+#include <sys/select.h>
+#include <netinet/in.h>
+#include <arpa/inet.h>
+#include <unistd.h>
+#include <stdio.h>
+#include <stdlib.h>
+
+#include <map>
+#include <string>
+
+/** @class wxGISMockHTTPServer
+
+    The HTTP server on the local port. It counts the requests by method and answers 503 to each of them.
+*/
+
+class wxGISMockHTTPServer : public wxThread
+{
+public:
+    wxGISMockHTTPServer(void) : wxThread(wxTHREAD_JOINABLE)
+    {
+        m_nSocket = -1;
+        m_nPort = 0;
+        m_bStop = false;
+    }
+
+    virtual ~wxGISMockHTTPServer(void)
+    {
+        if(m_nSocket != -1)
+            close(m_nSocket);
+    }
+
+    bool Listen(void)
+    {
+        m_nSocket = socket(AF_INET, SOCK_STREAM, 0);
+        if(m_nSocket == -1)
+            return false;
+
+        struct sockaddr_in stAddr = {0};
+        stAddr.sin_family = AF_INET;
+        stAddr.sin_addr.s_addr = htonl(INADDR_LOOPBACK);
+        stAddr.sin_port = 0;
+        socklen_t nLen = sizeof(stAddr);
+        if(bind(m_nSocket, (struct sockaddr*)&stAddr, sizeof(stAddr)) != 0 || listen(m_nSocket, 16) != 0 || getsockname(m_nSocket, (struct sockaddr*)&stAddr, &nLen) != 0)
+            return false;
+        m_nPort = ntohs(stAddr.sin_port);
+        return true;
+    }
+
+    int GetPort(void) const
+    {
+        return m_nPort;
+    }
+
+    int GetHits(const std::string &sMethod)
+    {
+        wxCriticalSectionLocker locker(m_CritSect);
+        return m_mnHits[sMethod];
+    }
+
+    void Stop(void)
+    {
+        wxCriticalSectionLocker locker(m_CritSect);
+        m_bStop = true;
+    }
+
+    virtual void *Entry()
+    {
+        while(!IsStopped())
+        {
+            fd_set fdread;
+            FD_ZERO(&fdread);
+            FD_SET(m_nSocket, &fdread);
+            struct timeval tv = {0, 100000};
+            if(select(m_nSocket + 1, &fdread, NULL, NULL, &tv) <= 0)
+                continue;
+
+            int nClient = accept(m_nSocket, NULL, NULL);
+            if(nClient == -1)
+                continue;
+            Serve(nClient);
+            close(nClient);
+        }
+        return NULL;
+    }
+protected:
+    bool IsStopped(void)
+    {
+        wxCriticalSectionLocker locker(m_CritSect);
+        return m_bStop;
+    }
+
+    void Serve(int nClient)
+    {
+        //read the head and the body of Content-Length size
+        std::string sRequest;
+        size_t nHeadEnd = std::string::npos;
+        size_t nBodySize = 0;
+        char szBuffer[4096];
+        while(true)
+        {
+            if(nHeadEnd != std::string::npos && sRequest.size() >= nHeadEnd + 4 + nBodySize)
+                break;
+            ssize_t nRead = recv(nClient, szBuffer, sizeof(szBuffer), 0);
+            if(nRead <= 0)
+                return;
+            sRequest.append(szBuffer, nRead);
+            if(nHeadEnd == std::string::npos)
+            {
+                nHeadEnd = sRequest.find("\r\n\r\n");
+                if(nHeadEnd == std::string::npos)
+                    continue;
+                size_t nPos = sRequest.find("Content-Length: ");
+                if(nPos != std::string::npos && nPos < nHeadEnd)
+                    nBodySize = atoi(sRequest.c_str() + nPos + 16);
+            }
+        }
+
+        std::string sMethod = sRequest.substr(0, sRequest.find(' '));
+        {
+            wxCriticalSectionLocker locker(m_CritSect);
+            m_mnHits[sMethod]++;
+        }
+
+        const char szAnswer[] = "HTTP/1.1 503 Service Unavailable\r\nContent-Length: 0\r\nConnection: close\r\n\r\n";
+        send(nClient, szAnswer, sizeof(szAnswer) - 1, 0);
+    }
+protected:
+    int m_nSocket, m_nPort;
+    bool m_bStop;
+    std::map<std::string, int> m_mnHits;
+    wxCriticalSection m_CritSect;
+};
+
+/** @class wxGISCurlMultiTest
+
+    The wxGISCurlMulti with access to the retry settings.
+*/
+
+class wxGISCurlMultiTest : public wxGISCurlMulti
+{
+public:
+    int GetRetryCount(void) const
+    {
+        return m_nRetryCount;
+    }
+
+    bool TestCanRetry(wxGISEnumHTTPMethod eMethod, long nHTTPCode, CURLcode eCode) const
+    {
+        REQUEST stRequest;
+        stRequest.eMethod = eMethod;
+        return wxGISCurlMulti::CanRetry(stRequest, nHTTPCode, eCode);
+    }
+};
+
+static int g_nFailed = 0;
+
+static void Check(bool bResult, const char* pszMessage)
+{
+    printf("%s: %s\n", bResult ? "PASS" : "FAIL", pszMessage);
+    if(!bResult)
+        g_nFailed++;
+}
+
+int main(int argc, char **argv)
+{
+    wxInitializer initializer;
+    if(!initializer)
+    {
+        fprintf(stderr, "Failed to initialize the wxWidgets library\n");
+        return EXIT_FAILURE;
+    }
+
+    wxGISCurlMultiTest oMulti;
+    if(!oMulti.IsOk())
+    {
+        fprintf(stderr, "Failed to initialize cURL multi handle\n");
+        return EXIT_FAILURE;
+    }
+
+    Check(oMulti.TestCanRetry(enumGISHTTPPatch, 0, CURLE_COULDNT_CONNECT), "PATCH is repeated if the connection failed");
+    Check(!oMulti.TestCanRetry(enumGISHTTPPatch, 0, CURLE_OPERATION_TIMEDOUT), "PATCH is not repeated on timeout");
+    Check(!oMulti.TestCanRetry(enumGISHTTPPost, 503, CURLE_OK), "POST is not repeated on 5xx code");
+    Check(oMulti.TestCanRetry(enumGISHTTPGet, 0, CURLE_OPERATION_TIMEDOUT), "GET is repeated on timeout");
+    Check(oMulti.TestCanRetry(enumGISHTTPDelete, 503, CURLE_OK), "DELETE is repeated on 5xx code");
+    Check(!oMulti.TestCanRetry(enumGISHTTPGet, 404, CURLE_OK), "GET is not repeated on 4xx code");
+
+    wxGISMockHTTPServer* pServer = new wxGISMockHTTPServer();
+    if(!pServer->Listen() || pServer->Run() != wxTHREAD_NO_ERROR)
+    {
+        fprintf(stderr, "Failed to start the mock server\n");
+        delete pServer;
+        return EXIT_FAILURE;
+    }
+
+    wxString sURL = wxString::Format(wxT("http://127.0.0.1:%d/"), pServer->GetPort());
+    size_t nGet = oMulti.Add(enumGISHTTPGet, sURL + wxT("features"));
+    size_t nPatch = oMulti.Add(enumGISHTTPPatch, sURL + wxT("features"), wxT("[{\"fields\":{}}]"));
+    oMulti.Perform();
+
+    Check(oMulti.GetResult(nGet).nHTTPCode == 503 && oMulti.GetResult(nPatch).nHTTPCode == 503, "the server answers are returned");
+    Check(pServer->GetHits("GET") == oMulti.GetRetryCount() + 1, "GET is sent retry count times more");
+    Check(pServer->GetHits("PATCH") == 1, "PATCH is sent once");
+
+    pServer->Stop();
+    pServer->Wait();
+    delete pServer;
+
+    return g_nFailed == 0 ? EXIT_SUCCESS : EXIT_FAILURE;
+}
@@ -0,0 +1,357 @@
+/******************************************************************************
+ * Project:  wxGIS
+ * Purpose:  wxGISNGWFeatureDataset batched edits test. The edits are sent to
+ *           the local mock server checking the PATCH payload and answering
+ *           with the features ids or the error.
+ * Author:   Dmitry Baryshnikov (aka Bishop), polimax@mail.ru
+ ******************************************************************************
+*   Copyright (C) 2014 Dmitry Baryshnikov
+*
+*    This program is free software: you can redistribute it and/or modify
+*    it under the terms of the GNU General Public License as published by
+*    the Free Software Foundation, either version 2 of the License, or
+*    (at your option) any later version.
+*
+*    This program is distributed in the hope that it will be useful,
+*    but WITHOUT ANY WARRANTY; without even the implied warranty of
+*    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+*    GNU General Public License for more details.
+*
+*    You should have received a copy of the GNU General Public License
+*    along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ ****************************************************************************/
+#include "wxgis/datasource/featuredataset.h"
+#include "wxgis/core/json/jsonreader.h"
+
+#include <wx/init.h>
+#include <wx/thread.h>
+
+#include <sys/socket.h>
+#include <sys/select.h>
+#include <netinet/in.h>
+#include <arpa/inet.h>
+#include <unistd.h>
+#include <stdio.h>
+#include <stdlib.h>
+
+#include <map>
+#include <string>
+
+/** @class wxGISMockNGWServer
+
+    The HTTP server on the local port. It keeps the body of the last PATCH request and answers with the set code and body.
+*/
+
+class wxGISMockNGWServer : public wxThread
+{
+public:
+    wxGISMockNGWServer(void) : wxThread(wxTHREAD_JOINABLE)
+    {
+        m_nSocket = -1;
+        m_nPort = 0;
+        m_bStop = false;
+        SetAnswer(200, "[]");
+    }
+
+    virtual ~wxGISMockNGWServer(void)
+    {
+        if(m_nSocket != -1)
+            close(m_nSocket);
+    }
+
+    bool Listen(void)
+    {
+        m_nSocket = socket(AF_INET, SOCK_STREAM, 0);
+        if(m_nSocket == -1)
+            return false;
+
+        struct sockaddr_in stAddr = {0};
+        stAddr.sin_family = AF_INET;
+        stAddr.sin_addr.s_addr = htonl(INADDR_LOOPBACK);
+        stAddr.sin_port = 0;
+        socklen_t nLen = sizeof(stAddr);
+        if(bind(m_nSocket, (struct sockaddr*)&stAddr, sizeof(stAddr)) != 0 || listen(m_nSocket, 16) != 0 || getsockname(m_nSocket, (struct sockaddr*)&stAddr, &nLen) != 0)
+            return false;
+        m_nPort = ntohs(stAddr.sin_port);
+        return true;
+    }
+
+    int GetPort(void) const
+    {
+        return m_nPort;
+    }
+
+    void SetAnswer(int nCode, const std::string &sBody)
+    {
+        wxCriticalSectionLocker locker(m_CritSect);
+        m_nCode = nCode;
+        m_sAnswerBody = sBody;
+    }
+
+    int GetHits(const std::string &sMethod)
+    {
+        wxCriticalSectionLocker locker(m_CritSect);
+        return m_mnHits[sMethod];
+    }
+
+    std::string GetLastPatchBody(void)
+    {
+        wxCriticalSectionLocker locker(m_CritSect);
+        return m_sPatchBody;
+    }
+
+    std::string GetLastPatchPath(void)
+    {
+        wxCriticalSectionLocker locker(m_CritSect);
+        return m_sPatchPath;
+    }
+
+    void Stop(void)
+    {
+        wxCriticalSectionLocker locker(m_CritSect);
+        m_bStop = true;
+    }
+
+    virtual void *Entry()
+    {
+        while(!IsStopped())
+        {
+            fd_set fdread;
+            FD_ZERO(&fdread);
+            FD_SET(m_nSocket, &fdread);
+            struct timeval tv = {0, 100000};
+            if(select(m_nSocket + 1, &fdread, NULL, NULL, &tv) <= 0)
+                continue;
+
+            int nClient = accept(m_nSocket, NULL, NULL);
+            if(nClient == -1)
+                continue;
+            Serve(nClient);
+            close(nClient);
+        }
+        return NULL;
+    }
+protected:
+    bool IsStopped(void)
+    {
+        wxCriticalSectionLocker locker(m_CritSect);
+        return m_bStop;
+    }
+
+    void Serve(int nClient)
+    {
+        //read the head and the body of Content-Length size
+        std::string sRequest;
+        size_t nHeadEnd = std::string::npos;
+        size_t nBodySize = 0;
+        char szBuffer[4096];
+        while(true)
+        {
+            if(nHeadEnd != std::string::npos && sRequest.size() >= nHeadEnd + 4 + nBodySize)
+                break;
+            ssize_t nRead = recv(nClient, szBuffer, sizeof(szBuffer), 0);
+            if(nRead <= 0)
+                return;
+            sRequest.append(szBuffer, nRead);
+            if(nHeadEnd == std::string::npos)
+            {
+                nHeadEnd = sRequest.find("\r\n\r\n");
+                if(nHeadEnd == std::string::npos)
+                    continue;
+                size_t nPos = sRequest.find("Content-Length: ");
+                if(nPos != std::string::npos && nPos < nHeadEnd)
+                    nBodySize = atoi(sRequest.c_str() + nPos + 16);
+            }
+        }
+
+        std::string sMethod = sRequest.substr(0, sRequest.find(' '));
+        size_t nPathBeg = sMethod.size() + 1;
+        std::string sPath = sRequest.substr(nPathBeg, sRequest.find(' ', nPathBeg) - nPathBeg);
+
+        int nCode;
+        std::string sAnswerBody;
+        {
+            wxCriticalSectionLocker locker(m_CritSect);
+            m_mnHits[sMethod]++;
+            if(sMethod == "PATCH")
+            {
+                m_sPatchBody = sRequest.substr(nHeadEnd + 4, nBodySize);
+                m_sPatchPath = sPath;
+            }
+            nCode = m_nCode;
+            sAnswerBody = m_sAnswerBody;
+        }
+
+        std::string sAnswer = CPLSPrintf("HTTP/1.1 %d %s\r\nContent-Type: application/json\r\nContent-Length: %d\r\nConnection: close\r\n\r\n", nCode, nCode < 400 ? "OK" : "Error", (int)sAnswerBody.size());
+        sAnswer += sAnswerBody;
+        send(nClient, sAnswer.c_str(), sAnswer.size(), 0);
+    }
+protected:
+    int m_nSocket, m_nPort;
+    bool m_bStop;
+    int m_nCode;
+    std::string m_sAnswerBody, m_sPatchBody, m_sPatchPath;
+    std::map<std::string, int> m_mnHits;
+    wxCriticalSection m_CritSect;
+};
+
+/** @class wxGISNGWFeatureDatasetTest
+
+    The wxGISNGWFeatureDataset with access to the edits queue and the local copy.
+*/
+
+class wxGISNGWFeatureDatasetTest : public wxGISNGWFeatureDataset
+{
+public:
+    wxGISNGWFeatureDatasetTest(long nResourceId, const wxJSONValue &Data, const wxString &sURL) : wxGISNGWFeatureDataset(nResourceId, Data, sURL, wxT("user"), wxT("password"))
+    {
+    }
+
+    size_t GetQueuedCount(void) const
+    {
+        return m_astEdits.size();
+    }
+
+    wxString GetLocalName(long nFID)
+    {
+        OGRFeature* poFeature = m_poLayer->GetFeature(nFID);
+        if(NULL == poFeature)
+            return wxEmptyString;
+        wxString sName = wxString::FromUTF8(poFeature->GetFieldAsString(0));
+        OGRFeature::DestroyFeature(poFeature);
+        return sName;
+    }
+};
+
+static int g_nFailed = 0;
+
+static void Check(bool bResult, const char* pszMessage)
+{
+    printf("%s: %s\n", bResult ? "PASS" : "FAIL", pszMessage);
+    if(!bResult)
+        g_nFailed++;
+}
+
+static OGRErr StoreNewFeature(wxGISNGWFeatureDatasetTest* pDSet, const wxString &sName, double dfX)
+{
+    wxGISFeature Feature = pDSet->CreateFeature();
+    Feature.SetField(0, sName);
+    OGRMultiPoint* poMultiPoint = new OGRMultiPoint();
+    OGRPoint oPoint(dfX, 0.0);
+    poMultiPoint->addGeometry(&oPoint);
+    Feature.SetGeometry(wxGISGeometry(poMultiPoint));
+    return pDSet->StoreFeature(Feature);
+}
+
+/** \fn bool CheckPayload(const std::string &sBody, const wxArrayString &saNames, long nUpdateFID)
+    \brief Check the PATCH payload is the array of features with the names in queue order, the id is set for the update only
+*/
+
+static bool CheckPayload(const std::string &sBody, const wxArrayString &saNames, long nUpdateFID = wxNOT_FOUND)
+{
+    wxJSONReader reader;
+    wxJSONValue payload;
+    if(reader.Parse(wxString::FromUTF8(sBody.c_str()), &payload) != 0 || !payload.IsArray() || payload.Size() != (int)saNames.GetCount())
+        return false;
+    for(unsigned i = 0; i < saNames.GetCount(); ++i)
+    {
+        wxJSONValue feature = payload[i];
+        if(feature["fields"]["name"].AsString() != saNames[i] || !feature.HasMember(wxT("geom")))
+            return false;
+        if(nUpdateFID == wxNOT_FOUND && feature.HasMember(wxT("id")))
+            return false;
+        if(nUpdateFID != wxNOT_FOUND && feature["id"].AsLong() != nUpdateFID)
+            return false;
+    }
+    return true;
+}
+
+int main(int argc, char **argv)
+{
+    wxInitializer initializer;
+    if(!initializer)
+    {
+        fprintf(stderr, "Failed to initialize the wxWidgets library\n");
+        return EXIT_FAILURE;
+    }
+    OGRRegisterAll();
+
+    wxGISMockNGWServer* pServer = new wxGISMockNGWServer();
+    if(!pServer->Listen() || pServer->Run() != wxTHREAD_NO_ERROR)
+    {
+        fprintf(stderr, "Failed to start the mock server\n");
+        delete pServer;
+        return EXIT_FAILURE;
+    }
+
+    wxJSONReader reader;
+    wxJSONValue Data;
+    reader.Parse(wxT("{\"vector_layer\":{\"geometry_type\":\"POINT\",\"srs\":{\"id\":4326}},\"feature_layer\":{\"fields\":[{\"keyname\":\"name\",\"datatype\":\"STRING\"}]}}"), &Data);
+
+    wxString sURL = wxString::Format(wxT("http://127.0.0.1:%d"), pServer->GetPort());
+    wxGISNGWFeatureDatasetTest* pDSet = new wxGISNGWFeatureDatasetTest(7, Data, sURL);
+    pDSet->Reference();
+
+    //the created features are sent by one PATCH and get the FIDs from the response in the same order
+    wxArrayString saNames;
+    saNames.Add(wxT("a"));
+    saNames.Add(wxT("b"));
+    saNames.Add(wxT("c"));
+    pServer->SetAnswer(200, "[{\"id\":101},{\"id\":102},{\"id\":103}]");
+    pDSet->StartTransaction();
+    bool bQueued = true;
+    for(size_t i = 0; i < saNames.GetCount(); ++i)
+        bQueued = bQueued && StoreNewFeature(pDSet, saNames[i], double(i)) == OGRERR_NONE;
+    Check(bQueued && pServer->GetHits("PATCH") == 0, "the created features are queued");
+    Check(pDSet->CommitTransaction() == OGRERR_NONE, "the transaction is committed");
+    Check(pServer->GetHits("PATCH") == 1, "the features are sent by one PATCH request");
+    Check(pServer->GetLastPatchPath() == "/api/resource/7/feature/", "the PATCH is sent to the resource features");
+    Check(CheckPayload(pServer->GetLastPatchBody(), saNames), "the PATCH payload has the features in queue order without id");
+    Check(pDSet->GetLocalName(101) == wxT("a") && pDSet->GetLocalName(102) == wxT("b") && pDSet->GetLocalName(103) == wxT("c"), "the local features have the FIDs from the response");
+
+    //the rejected batch is kept in queue and sent again by the next commit
+    saNames.Clear();
+    saNames.Add(wxT("d"));
+    saNames.Add(wxT("e"));
+    pServer->SetAnswer(500, "{\"message\":\"error\"}");
+    pDSet->StartTransaction();
+    bQueued = StoreNewFeature(pDSet, saNames[0], 10.0) == OGRERR_NONE && StoreNewFeature(pDSet, saNames[1], 11.0) == OGRERR_NONE;
+    Check(bQueued, "the features are queued");
+    Check(pDSet->CommitTransaction() != OGRERR_NONE, "the commit fails on the server error");
+    Check(pDSet->GetQueuedCount() == 2, "the rejected edits are kept in queue");
+    Check(pDSet->GetLocalName(201).IsEmpty(), "the rejected features are not in the local copy");
+
+    pServer->SetAnswer(200, "[{\"id\":201}]");
+    Check(pDSet->CommitTransaction() != OGRERR_NONE, "the commit fails on the response of wrong size");
+    Check(pDSet->GetQueuedCount() == 2, "the edits are kept in queue on the wrong response");
+
+    pServer->SetAnswer(200, "[{\"id\":201},{\"id\":202}]");
+    Check(pDSet->CommitTransaction() == OGRERR_NONE, "the commit again sends the kept edits");
+    Check(CheckPayload(pServer->GetLastPatchBody(), saNames), "the kept edits payload is the same");
+    Check(pDSet->GetQueuedCount() == 0, "the queue is empty after commit");
+    Check(pDSet->GetLocalName(201) == wxT("d") && pDSet->GetLocalName(202) == wxT("e"), "the kept features have the FIDs from the response");
+
+    //the update is sent with the feature id
+    saNames.Clear();
+    saNames.Add(wxT("z"));
+    pServer->SetAnswer(200, "[{\"id\":102}]");
+    pDSet->StartTransaction();
+    wxGISFeature Feature = pDSet->CreateFeature();
+    Feature.SetFID(102);
+    Feature.SetField(0, saNames[0]);
+    OGRMultiPoint* poMultiPoint = new OGRMultiPoint();
+    OGRPoint oPoint(1.0, 0.0);
+    poMultiPoint->addGeometry(&oPoint);
+    Feature.SetGeometry(wxGISGeometry(poMultiPoint));
+    Check(pDSet->SetFeature(Feature) == OGRERR_NONE && pDSet->CommitTransaction() == OGRERR_NONE, "the update is committed");
+    Check(CheckPayload(pServer->GetLastPatchBody(), saNames, 102), "the update payload has the feature id");
+    Check(pDSet->GetLocalName(102) == wxT("z"), "the local feature is updated");
+
+    wsDELETE(pDSet);
+
+    pServer->Stop();
+    pServer->Wait();
+    delete pServer;
+
+    return g_nFailed == 0 ? EXIT_SUCCESS : EXIT_FAILURE;
+}
@@ -0,0 +1,203 @@
+/******************************************************************************
+ * Project:  wxGIS
+ * Purpose:  wxGISTaskCategory scheduling index test. The quered tasks order
+ *           by priority and stamp, the executing groups exclusion, the
+ *           outdated heap items and the subtasks inherited priority.
+ * Author:   Dmitry Baryshnikov (aka Bishop), polimax@mail.ru
+ ******************************************************************************
+*   Copyright (C) 2014 Dmitry Baryshnikov
+*
+*    This program is free software: you can redistribute it and/or modify
+*    it under the terms of the GNU General Public License as published by
+*    the Free Software Foundation, either version 2 of the License, or
+*    (at your option) any later version.
+*
+*    This program is distributed in the hope that it will be useful,
+*    but WITHOUT ANY WARRANTY; without even the implied warranty of
+*    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+*    GNU General Public License for more details.
+*
+*    You should have received a copy of the GNU General Public License
+*    along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ ****************************************************************************/
+#include "wxgis/tskmngr_app/task.h"
+
+#include <wx/init.h>
+
+#include <stdio.h>
+#include <stdlib.h>
+
+#define TEST_CHANGE_COUNT 1000
+
+static int g_nFailed = 0;
+
+static void Check(bool bResult, const char* pszMessage)
+{
+    printf("%s: %s\n", bResult ? "PASS" : "FAIL", pszMessage);
+    if(!bResult)
+        g_nFailed++;
+}
+
+/** @class wxGISTaskTest
+
+    The task with the state, group and priority set by the test. The task is never started.
+*/
+
+class wxGISTaskTest : public wxGISTask
+{
+public:
+    wxGISTaskTest(wxGISTaskBase* pParentTask, int nGroupId, long nPriority, wxGISEnumTaskStateType eState) : wxGISTask(pParentTask, wxEmptyString)
+    {
+        m_nGroupId = nGroupId;
+        m_nPriority = nPriority;
+        m_nState = eState;
+    };
+    void SetPriority(long nPriority) { m_nPriority = nPriority; };
+    void AddSubTask(wxGISTaskTest* pTask)
+    {
+        m_omSubTasks[pTask->GetId()] = pTask;
+        m_nSubTasksRevision++;
+    };
+};
+
+/** @class wxGISTaskCategoryTest
+
+    The category without task manager exposing the scheduling index.
+*/
+
+class wxGISTaskCategoryTest : public wxGISTaskCategory
+{
+public:
+    wxGISTaskCategoryTest(void) : wxGISTaskCategory(wxT("test"), NULL) {};
+    wxGISTask* const GetNext(void) { return GetQueredTask(); };
+    int GetQueredTaskCount(void) const { return m_nQueredTaskCount; };
+    size_t GetQueredHeapSize(void) const { return m_nQueredHeapSize; };
+    wxGISTaskTest* Add(int nGroupId, long nPriority, wxGISEnumTaskStateType eState)
+    {
+        wxGISTaskTest* pTask = new wxGISTaskTest(this, nGroupId, nPriority, eState);
+        UpdateTaskIndex(pTask);
+        return pTask;
+    };
+};
+
+/** \fn void SetState(wxGISTaskCategory* pCategory, wxGISTaskTest* pTask, wxGISEnumTaskStateType eState)
+    \brief Change the task state and notify the category as the task does
+*/
+
+static void SetState(wxGISTaskCategory* pCategory, wxGISTaskTest* pTask, wxGISEnumTaskStateType eState)
+{
+    pTask->SetState(eState);
+    pCategory->UpdateTaskIndex(pTask);
+}
+
+int main(int argc, char **argv)
+{
+    wxInitializer initializer;
+    if(!initializer)
+    {
+        fprintf(stderr, "Failed to initialize the wxWidgets library\n");
+        return EXIT_FAILURE;
+    }
+
+    //the priority order, the earlier indexed task wins on equal priorities
+    wxGISTaskCategoryTest* pCategory = new wxGISTaskCategoryTest();
+    wxGISTaskTest* pTask1 = pCategory->Add(wxNOT_FOUND, 5, enumGISTaskQuered);
+    wxGISTaskTest* pTask2 = pCategory->Add(wxNOT_FOUND, 1, enumGISTaskQuered);
+    wxGISTaskTest* pTask3 = pCategory->Add(wxNOT_FOUND, 3, enumGISTaskQuered);
+    wxGISTaskTest* pTask4 = pCategory->Add(wxNOT_FOUND, 1, enumGISTaskQuered);
+    Check(pCategory->GetNext() == pTask2, "the lowerest priority value is the next");
+    Check(pCategory->GetNext() == pTask2, "the next task stays in the heap until it's state changed");
+    SetState(pCategory, pTask2, enumGISTaskWork);
+    Check(pCategory->GetNext() == pTask4, "the earlier task is the next on equal priorities");
+    Check(pCategory->GetRunningTaskCount() == 1 && pCategory->GetQueredTaskCount() == 3, "the running and quered tasks are counted");
+    Check(!pCategory->IsGroupIdExecuting(wxNOT_FOUND), "the tasks without group are not the executing group");
+    SetState(pCategory, pTask4, enumGISTaskWork);
+    SetState(pCategory, pTask3, enumGISTaskPaused);
+    Check(pCategory->GetNext() == pTask1, "the paused task is not the next");
+    SetState(pCategory, pTask2, enumGISTaskDone);
+    Check(pCategory->GetRunningTaskCount() == 1 && pCategory->GetQueredTaskCount() == 1, "the finished task is not counted");
+    wxDELETE(pTask1);
+    wxDELETE(pTask2);
+    wxDELETE(pTask3);
+    wxDELETE(pTask4);
+    wxDELETE(pCategory);
+
+    //the tasks of the executing group wait
+    pCategory = new wxGISTaskCategoryTest();
+    pTask1 = pCategory->Add(1, 1, enumGISTaskWork);
+    pTask2 = pCategory->Add(1, 2, enumGISTaskQuered);
+    pTask3 = pCategory->Add(wxNOT_FOUND, 3, enumGISTaskQuered);
+    pTask4 = pCategory->Add(2, 4, enumGISTaskQuered);
+    Check(pCategory->IsGroupIdExecuting(1) && !pCategory->IsGroupIdExecuting(2), "the group of the running task is executing");
+    Check(pCategory->GetNext() == pTask3, "the task of the executing group is skipped");
+    SetState(pCategory, pTask3, enumGISTaskWork);
+    Check(pCategory->GetNext() == pTask4, "the task of the other group is the next");
+    SetState(pCategory, pTask1, enumGISTaskDone);
+    Check(!pCategory->IsGroupIdExecuting(1), "the group is not executing after the task finished");
+    Check(pCategory->GetNext() == pTask2, "the group task is the next after the group finished");
+    Check(pCategory->GetRunningTaskCount() == 1, "the running tasks are counted over groups");
+    SetState(pCategory, pTask2, enumGISTaskWork);
+    SetState(pCategory, pTask4, enumGISTaskWork);
+    Check(pCategory->GetRunningTaskCount() == 3 && pCategory->IsGroupIdExecuting(1) && pCategory->IsGroupIdExecuting(2), "the several groups are executing");
+    Check(pCategory->GetNext() == NULL, "no quered tasks");
+    wxDELETE(pTask1);
+    wxDELETE(pTask2);
+    wxDELETE(pTask3);
+    wxDELETE(pTask4);
+    wxDELETE(pCategory);
+
+    //the outdated heap items are skipped
+    pCategory = new wxGISTaskCategoryTest();
+    pTask1 = pCategory->Add(wxNOT_FOUND, 1, enumGISTaskQuered);
+    pTask2 = pCategory->Add(wxNOT_FOUND, 2, enumGISTaskQuered);
+    pTask1->SetPriority(3);
+    pCategory->UpdateTaskIndex(pTask1);
+    Check(pCategory->GetNext() == pTask2, "the task with changed priority is reordered");
+    pTask2->SetState(enumGISTaskWork);
+    Check(pCategory->GetNext() == pTask1, "the task changed state without notify is skipped");
+    Check(pCategory->GetRunningTaskCount() == 1 && pCategory->GetQueredTaskCount() == 1, "the task changed state without notify is reindexed");
+    pCategory->RemoveFromTaskIndex(pTask1);
+    Check(pCategory->GetNext() == NULL && pCategory->GetQueredTaskCount() == 0, "the removed task is not the next");
+    pCategory->RemoveFromTaskIndex(pTask2);
+    Check(pCategory->GetRunningTaskCount() == 0, "the removed running task is not counted");
+
+    pTask3 = pCategory->Add(wxNOT_FOUND, 0, enumGISTaskQuered);
+    for(int i = 0; i < TEST_CHANGE_COUNT; ++i)
+    {
+        pTask3->SetPriority(i % 7);
+        pCategory->UpdateTaskIndex(pTask3);
+        pTask1->SetPriority(TEST_CHANGE_COUNT - i);
+        SetState(pCategory, pTask1, enumGISTaskQuered);
+    }
+    Check(pCategory->GetQueredHeapSize() <= size_t(pCategory->GetQueredTaskCount()) * 2 + 64, "the outdated items are removed from the heap");
+    Check(pCategory->GetNext() == pTask1, "the last changed priority is used");
+    wxDELETE(pTask1);
+    wxDELETE(pTask2);
+    wxDELETE(pTask3);
+    wxDELETE(pCategory);
+
+    //the subtasks inherit the parent priority
+    pCategory = new wxGISTaskCategoryTest();
+    pTask1 = new wxGISTaskTest(pCategory, wxNOT_FOUND, 2, enumGISTaskQuered);
+    pTask2 = new wxGISTaskTest(pTask1, wxNOT_FOUND, 2, enumGISTaskQuered);
+    pTask3 = new wxGISTaskTest(pTask1, wxNOT_FOUND, 1, enumGISTaskQuered);
+    pTask1->AddSubTask(pTask2);
+    pTask1->AddSubTask(pTask3);
+    pCategory->UpdateTaskIndex(pTask1);
+    pTask4 = pCategory->Add(wxNOT_FOUND, 150, enumGISTaskQuered);
+    Check(pCategory->GetQueredTaskCount() == 3, "the parent task is scheduled by the subtasks");
+    Check(pCategory->GetNext() == pTask4, "the subtask priority includes the parent one");
+    pTask1->SetPriority(1);
+    pCategory->UpdateTaskIndex(pTask1);
+    Check(pCategory->GetNext() == pTask3, "the subtasks are reindexed after the parent priority changed");
+    SetState(pCategory, pTask3, enumGISTaskWork);
+    Check(pCategory->GetNext() == pTask2 && pCategory->GetRunningTaskCount() == 1, "the subtask state is indexed");
+    pCategory->RemoveFromTaskIndex(pTask1);
+    Check(pCategory->GetNext() == pTask4 && pCategory->GetRunningTaskCount() == 0 && pCategory->GetQueredTaskCount() == 1, "the subtasks are removed with the parent");
+    //the subtasks are deleted by the parent
+    wxDELETE(pTask1);
+    wxDELETE(pTask4);
+    wxDELETE(pCategory);
+
+    return g_nFailed == 0 ? EXIT_SUCCESS : EXIT_FAILURE;
+}
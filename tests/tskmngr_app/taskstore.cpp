@@ -0,0 +1,138 @@
+/******************************************************************************
+ * Project:  wxGIS
+ * Purpose:  wxGISTaskStoreWriter test. The new configs written at once, the
+ *           joined configs written behind, the skipped rewrite of the same
+ *           config and the replace through the temporary file.
+ * Author:   Dmitry Baryshnikov (aka Bishop), polimax@mail.ru
+ ******************************************************************************
+*   Copyright (C) 2014 Dmitry Baryshnikov
+*
+*    This program is free software: you can redistribute it and/or modify
+*    it under the terms of the GNU General Public License as published by
+*    the Free Software Foundation, either version 2 of the License, or
+*    (at your option) any later version.
+*
+*    This program is distributed in the hope that it will be useful,
+*    but WITHOUT ANY WARRANTY; without even the implied warranty of
+*    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+*    GNU General Public License for more details.
+*
+*    You should have received a copy of the GNU General Public License
+*    along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ ****************************************************************************/
+#include "wxgis/tskmngr_app/task.h"
+
+#include <wx/init.h>
+#include <wx/ffile.h>
+#include <wx/filename.h>
+#include <wx/utils.h>
+
+#include <stdio.h>
+#include <stdlib.h>
+
+#define TEST_DELAY 50 //ms
+
+static int g_nFailed = 0;
+
+static void Check(bool bResult, const char* pszMessage)
+{
+    printf("%s: %s\n", bResult ? "PASS" : "FAIL", pszMessage);
+    if(!bResult)
+        g_nFailed++;
+}
+
+/** \fn bool IsFileText(const wxString &sPath, const wxString &sText)
+    \brief Check the file exists and has the text
+*/
+
+static bool IsFileText(const wxString &sPath, const wxString &sText)
+{
+    wxFFile oFile(sPath, wxT("r"));
+    if(!oFile.IsOpened())
+        return false;
+    wxString sFileText;
+    if(!oFile.ReadAll(&sFileText))
+        return false;
+    return sFileText == sText;
+}
+
+int main(int argc, char **argv)
+{
+    wxInitializer initializer;
+    if(!initializer)
+    {
+        fprintf(stderr, "Failed to initialize the wxWidgets library\n");
+        return EXIT_FAILURE;
+    }
+
+    wxString sDir = wxFileName::GetTempDir() + wxFileName::GetPathSeparator() + wxString::Format(wxT("taskstore_%lu"), wxGetProcessId());
+    if(!wxFileName::Mkdir(sDir, wxS_DIR_DEFAULT, wxPATH_MKDIR_FULL))
+    {
+        fprintf(stderr, "Failed to create the test directory\n");
+        return EXIT_FAILURE;
+    }
+    wxString sPath = sDir + wxFileName::GetPathSeparator() + wxT("1.json");
+    wxString sPath2 = sDir + wxFileName::GetPathSeparator() + wxT("2.json");
+
+    //the file is replaced through the temporary one
+    Check(wxGISTaskStoreWriter::Write(sPath, wxT("{\"a\":1}")) && IsFileText(sPath, wxT("{\"a\":1}")), "the config is written");
+    Check(wxGISTaskStoreWriter::Write(sPath, wxT("{\"a\":2}")) && IsFileText(sPath, wxT("{\"a\":2}")), "the existing config is replaced");
+    Check(!wxFileName::FileExists(sPath + wxT(".tmp")), "the temporary file is renamed");
+    Check(!wxGISTaskStoreWriter::Write(sDir + wxFileName::GetPathSeparator() + wxT("none") + wxFileName::GetPathSeparator() + wxT("1.json"), wxT("{}")), "the write to the missing directory fails");
+    wxRemoveFile(sPath);
+
+    //the writer is not run, the stored configs are written by Flush
+    wxGISTaskStoreWriter* pWriter = new wxGISTaskStoreWriter(TEST_DELAY);
+    Check(pWriter->Store(sPath, wxT("{\"v\":0}")) && IsFileText(sPath, wxT("{\"v\":0}")), "the new config is written at once");
+    Check(!pWriter->Store(sDir + wxFileName::GetPathSeparator() + wxT("none") + wxFileName::GetPathSeparator() + wxT("1.json"), wxT("{}")), "the new config write error is reported");
+
+    pWriter->Store(sPath, wxT("{\"v\":1}"));
+    pWriter->Store(sPath, wxT("{\"v\":2}"));
+    Check(IsFileText(sPath, wxT("{\"v\":0}")), "the changed config is written behind");
+    pWriter->Flush();
+    Check(IsFileText(sPath, wxT("{\"v\":2}")), "the configs stored to the same path are joined");
+
+    //the changed file shows the rewrite
+    wxGISTaskStoreWriter::Write(sPath, wxT("{\"v\":-1}"));
+    pWriter->Store(sPath, wxT("{\"v\":3}"));
+    pWriter->Store(sPath, wxT("{\"v\":2}"));
+    pWriter->Flush();
+    Check(IsFileText(sPath, wxT("{\"v\":-1}")), "the config equal to the last written one is not rewritten");
+
+    pWriter->Store(sPath, wxT("{\"v\":4}"));
+    pWriter->Forget(sPath);
+    pWriter->Flush();
+    Check(IsFileText(sPath, wxT("{\"v\":-1}")), "the forgotten config is not written");
+    pWriter->Store(sPath, wxT("{\"v\":2}"));
+    pWriter->Flush();
+    Check(IsFileText(sPath, wxT("{\"v\":2}")), "the forgotten config is written again");
+    wxDELETE(pWriter);
+
+    //the thread writes the stored configs and the last ones on shutdown
+    pWriter = new wxGISTaskStoreWriter(TEST_DELAY);
+    if(pWriter->Create() != wxTHREAD_NO_ERROR || pWriter->Run() != wxTHREAD_NO_ERROR)
+    {
+        Check(false, "the writer thread is run");
+    }
+    else
+    {
+        pWriter->Store(sPath, wxT("{\"v\":5}"));
+        pWriter->Store(sPath2, wxT("{\"w\":0}"));
+        pWriter->Store(sPath2, wxT("{\"w\":1}"));
+        wxMilliSleep(TEST_DELAY * 10);
+        Check(IsFileText(sPath, wxT("{\"v\":5}")) && IsFileText(sPath2, wxT("{\"w\":1}")), "the thread writes the configs in the delay");
+
+        pWriter->Store(sPath, wxT("{\"v\":6}"));
+        pWriter->Shutdown();
+        pWriter->Wait();
+        pWriter->Flush();
+        Check(IsFileText(sPath, wxT("{\"v\":6}")), "the config stored before shutdown is written");
+    }
+    wxDELETE(pWriter);
+
+    wxRemoveFile(sPath);
+    wxRemoveFile(sPath2);
+    wxFileName::Rmdir(sDir);
+
+    return g_nFailed == 0 ? EXIT_SUCCESS : EXIT_FAILURE;
+}